@@ -1,7 +1,10 @@
 /**
  * app.js — Martha Tent Controller Dashboard
  *
- * Connects to the ESP32 WebSocket (/ws) for live sensor data (2s push).
+ * Connects to the ESP32 WebSocket (/ws) for live sensor data, asking for
+ * binary keyframes + on-change deltas (see decodeTelemetry); JSON text
+ * frames are still understood. Charts sample the latest state every 2 s,
+ * and are backfilled from /api/history whenever the socket (re)connects.
  * Fetches initial config from /api/config on load.
  * Manages relay manual override controls.
  */
@@ -12,6 +15,9 @@
 const RELAY_NAMES  = ['Fogger','TubFan','Exhaust','Intake','UVC','Lights','Pump','Spare'];
 const CHART_POINTS = 900;  // 30 min × 2s intervals
 const WS_RECONNECT_MS = 3000;
+const WS_PROTOCOL_DELTA  = 'martha.delta.v1'; // Mirrors config.h
+const CHART_SAMPLE_MS    = 2000;
+const TELEMETRY_SCHEMA_VERSION = 1;          // Mirrors telemetry_frame.h
 
 // VPD calculation (mirrors firmware vpd.h)
 function calcSVP(tc) { return 0.6108 * Math.exp(17.27 * tc / (tc + 237.3)); }
@@ -72,6 +78,31 @@ function pushChart(key, value) {
   chart.update('none');
 }
 
+// Fill the charts' window from the device's history ring (rollup rows: avg)
+async function loadHistory() {
+  const step = CHART_SAMPLE_MS / 1000;
+  try {
+    const res = await fetch(`/api/history?series=co2,rh&from=-${CHART_POINTS * step}`);
+    if (!res.ok) return;
+    const h = await res.json();
+    [['co2', 1], ['rh', 2]].forEach(([key, col]) => {
+      const { chart, buf } = charts[key];
+      buf.fill(null);
+      for (const row of h.rows) {
+        const v = Array.isArray(row[col]) ? row[col][1] : row[col];
+        for (let t = row[0]; t < row[0] + h.res; t += step) {
+          const i = CHART_POINTS - 1 - Math.round((h.now - t) / step);
+          if (i >= 0 && i < CHART_POINTS) buf[i] = v;
+        }
+      }
+      chart.data.datasets[0].data = [...buf];
+      chart.update('none');
+    });
+  } catch (e) {
+    console.warn('History load failed:', e);
+  }
+}
+
 // ── Relay grid ────────────────────────────────────────────────────────────────
 function buildRelayGrid() {
   const grid = document.getElementById('relay-grid');
@@ -86,17 +117,27 @@ function buildRelayGrid() {
   });
 }
 
+/**
+ * relayCommand(url, body) — POST a relay action; the response arrives once the
+ * control task has applied it. Resolves to {ok, error?}; the relay state
+ * itself arrives over the WebSocket.
+ */
+async function relayCommand(url, body) {
+  const res = await fetch(url, {
+    method: 'POST',
+    headers: { 'Content-Type': 'application/json' },
+    body: JSON.stringify(body)
+  });
+  return res.json();
+}
+
 async function toggleRelay(idx, name) {
   if (!isArmed || !isManual) return;
   const card = document.getElementById(`relay-${idx}`);
   const currentlyOn = card.classList.contains('on');
   try {
-    const res = await fetch(`/api/relay/${name}/set`, {
-      method: 'POST',
-      headers: { 'Content-Type': 'application/json' },
-      body: JSON.stringify({ state: !currentlyOn })
-    });
-    if (!res.ok) console.warn(`Relay ${name} toggle failed`);
+    const r = await relayCommand(`/api/relay/${name}/set`, { state: !currentlyOn });
+    if (!r.ok) console.warn(`Relay ${name} toggle failed: ${r.error}`);
   } catch (e) {
     console.error('Relay toggle error:', e);
   }
@@ -111,16 +152,72 @@ function updateRelayCard(idx, on, armed, manual) {
 }
 
 // ── WebSocket ─────────────────────────────────────────────────────────────────
+
+/**
+ * decodeTelemetry(buf, prev) — Parse a binary telemetry frame (layout in
+ * telemetry_frame.h) into the same shape as the JSON frame. A FULL frame
+ * stands alone; a DELTA is applied on top of prev. Returns null for an
+ * unknown schema version or frame kind, or a DELTA with no prior keyframe.
+ */
+function decodeTelemetry(buf, prev) {
+  const v = new DataView(buf);
+  if (v.byteLength < 2 || v.getUint8(0) !== TELEMETRY_SCHEMA_VERSION) return null;
+  const kind = v.getUint8(1);
+
+  if (kind === 0) {  // FULL
+    if (v.byteLength < 30) return null;
+    const rh = [], tp = [];
+    for (let i = 0; i < 3; ++i) rh.push(v.getUint16(10 + 2 * i, true) / 100);
+    for (let i = 0; i < 5; ++i) tp.push(v.getInt16(16 + 2 * i, true) / 100);
+    const flags = v.getUint8(29);
+    return {
+      t:    v.getUint32(2, true),
+      co2:  v.getUint16(6, true),
+      rh_a: v.getUint16(8, true) / 100,
+      rh, tp,
+      wl:   v.getUint16(26, true) / 100,
+      rl:   v.getUint8(28),
+      am:   !!(flags & 1),
+      mm:   !!(flags & 2),
+    };
+  }
+
+  if (kind === 1) {  // DELTA: u16 mask, then the flagged fields in index order
+    if (!prev || v.byteLength < 8) return null;
+    const d = { ...prev, rh: [...prev.rh], tp: [...prev.tp], t: v.getUint32(2, true) };
+    const mask = v.getUint16(6, true);
+    let off = 8;
+    const u16 = () => { const x = v.getUint16(off, true); off += 2; return x; };
+    const i16 = () => { const x = v.getInt16(off, true);  off += 2; return x; };
+    const u8  = () => v.getUint8(off++);
+    for (let i = 0; i < 13; ++i) {
+      if (!(mask & (1 << i))) continue;
+      if (i === 0)      d.co2 = u16();
+      else if (i === 1) d.rh_a = u16() / 100;
+      else if (i < 5)   d.rh[i - 2] = u16() / 100;
+      else if (i < 10)  d.tp[i - 5] = i16() / 100;
+      else if (i === 10) d.wl = u16() / 100;
+      else if (i === 11) d.rl = u8();
+      else { const f = u8(); d.am = !!(f & 1); d.mm = !!(f & 2); }
+    }
+    return d;
+  }
+  return null;
+}
+
 function connectWs() {
   const url = `ws://${location.host}/ws`;
-  ws = new WebSocket(url);
+  ws = new WebSocket(url, WS_PROTOCOL_DELTA);
+  ws.binaryType = 'arraybuffer';
 
   ws.onopen = () => {
     document.getElementById('conn-status').className = 'conn-dot connected';
+    loadHistory();
   };
 
   ws.onclose = () => {
     document.getElementById('conn-status').className = 'conn-dot disconnected';
+    latestSnap = null;  // The next connection starts with a keyframe
     setTimeout(connectWs, WS_RECONNECT_MS);
   };
 
@@ -128,7 +225,9 @@ function connectWs() {
 
   ws.onmessage = (evt) => {
     try {
-      const d = JSON.parse(evt.data);
+      const d = typeof evt.data === 'string' ? JSON.parse(evt.data)
+                                             : decodeTelemetry(evt.data, latestSnap);
+      if (!d) { console.warn('WS: unsupported telemetry frame'); return; }
       latestSnap = d;
       updateUI(d);
     } catch (e) {
@@ -142,13 +241,11 @@ function updateUI(d) {
   const co2 = d.co2 ?? 0;
   document.getElementById('co2-val').textContent = co2.toFixed(0);
   document.getElementById(`card-co2`).style.borderColor = co2 > 950 ? '#ef4444' : '';
-  pushChart('co2', co2);
 
   // RH
   const rh = d.rh_a ?? 0;
   document.getElementById('rh-val').textContent = rh.toFixed(1);
   document.getElementById(`card-rh`).style.borderColor = rh < 80 ? '#ef4444' : '';
-  pushChart('rh', rh);
 
   // Water
   const wl = d.wl ?? 0;
@@ -263,17 +360,20 @@ async function saveConfig() {
 
 // ── Manual mode buttons ───────────────────────────────────────────────────────
 async function setManualMode(enable) {
-  await fetch('/api/relay/manual', {
-    method: 'POST',
-    headers: { 'Content-Type': 'application/json' },
-    body: JSON.stringify({ manual: enable })
-  });
+  const r = await relayCommand('/api/relay/manual', { manual: enable });
+  if (!r.ok) console.warn(`Manual mode change failed: ${r.error}`);
 }
 
 // ── Init ──────────────────────────────────────────────────────────────────────
 document.addEventListener('DOMContentLoaded', () => {
   buildRelayGrid();
   connectWs();
+  // Frames only arrive when something changes; sample on a fixed clock
+  setInterval(() => {
+    if (!latestSnap) return;
+    pushChart('co2', latestSnap.co2 ?? 0);
+    pushChart('rh',  latestSnap.rh_a ?? 0);
+  }, CHART_SAMPLE_MS);
   loadConfig();
 
   document.getElementById('btn-config-save').addEventListener('click', saveConfig);
@@ -38,13 +38,25 @@
 #define I2C_ADDR_SCD30        0x61  // CO2/temp/RH sensor
 #define I2C_ADDR_AS7341       0x39  // Spectral light sensor
 
+// ── I2C fault recovery ────────────────────────────────────────────────────────
+// A device (address + mux channel) that fails I2C_FAIL_THRESHOLD transactions
+// in a row is skipped for a backoff that doubles on every failed retry, from
+// I2C_BACKOFF_MIN_MS up to I2C_BACKOFF_MAX_MS. A successful retry re-initialises it.
+#define I2C_FAIL_THRESHOLD    3
+#define I2C_BACKOFF_MIN_MS    2000
+#define I2C_BACKOFF_MAX_MS    300000   // 5 min
+#define I2C_BUS_CLEAR_GAP_MS  1000     // Minimum spacing between SCL bus-clear attempts
+#define I2C_SUPERVISOR_SLOTS  8        // Tracked devices: SCD30, AS7341, mux, 3× SHT45
+
 // ── TCA9548A mux channel assignments ─────────────────────────────────────────
 #define MUX_CH_SHT45_SHELF1   0    // SHT45 on shelf 1
 #define MUX_CH_SHT45_SHELF2   1    // SHT45 on shelf 2
 #define MUX_CH_SHT45_SHELF3   2    // SHT45 on shelf 3
 
-// ── DS18B20 probe count ───────────────────────────────────────────────────────
+// ── DS18B20 probes ────────────────────────────────────────────────────────────
 #define DS18B20_PROBE_COUNT   5    // One per shelf + spare
+#define DS18B20_RESOLUTION_BITS   12  // 0.0625°C; 750 ms conversion
+#define DS18B20_CRC_RETRIES       2   // Re-reads of a scratchpad that fails CRC
 
 // ── Relay polarity ────────────────────────────────────────────────────────────
 // Set to 1 for active-LOW relay modules (standard PC817 boards).
@@ -68,7 +80,23 @@
 // ── Pump / water level thresholds ────────────────────────────────────────────
 #define WATER_LEVEL_LOW_PCT   20.0f  // Pump turns ON below this
 #define WATER_LEVEL_HIGH_PCT  80.0f  // Pump turns OFF above this
-#define WATER_LEVEL_SAMPLES   32     // Rolling average sample count
+
+// ── Water level acquisition ───────────────────────────────────────────────────
+// With WATER_ADC_OVERSAMPLE set, an esp_timer samples the ADC at
+// WATER_ADC_RATE_HZ in the background and a CIC decimator (order
+// WATER_ADC_CIC_ORDER) reduces each control tick's worth of samples to one.
+// Those are clean enough that a short rolling window suffices, so the pump
+// sees a level change within a few seconds. With it cleared, tick() takes a
+// single ADC read and the long window does all the smoothing.
+#define WATER_ADC_OVERSAMPLE  1
+#define WATER_ADC_RATE_HZ     500
+#define WATER_ADC_CIC_ORDER   2
+#define WATER_ADC_DECIMATION  (WATER_ADC_RATE_HZ * CONTROL_TASK_PERIOD_MS / 1000)
+#if WATER_ADC_OVERSAMPLE
+#define WATER_LEVEL_SAMPLES   4      // Rolling average sample count (decimated samples)
+#else
+#define WATER_LEVEL_SAMPLES   32     // Rolling average sample count (single reads)
+#endif
 
 // ── ADC calibration ───────────────────────────────────────────────────────────
 #define ADC_ATTEN             ADC_ATTEN_DB_11   // 0–3.6V range
@@ -76,22 +104,99 @@
 #define ADC_WATER_LEVEL_MIN_MV  200    // Voltage at 0% water level (calibrate in-situ)
 #define ADC_WATER_LEVEL_MAX_MV  3100   // Voltage at 100% water level
 
+// ── AS7341 spectral sensor ────────────────────────────────────────────────────
+// Auto-gain keeps the peak ADC count between LOW and HIGH percent of full
+// scale: gain moves first, integration time (ASTEP) only once gain is pinned.
+#define AS7341_ATIME            100
+#define AS7341_ASTEP_MAX        999    // t_int ≈ 281 ms — also the starting point
+#define AS7341_ASTEP_MIN        99     // t_int ≈ 28 ms
+#define AS7341_AGC_HIGH_PCT     80
+#define AS7341_AGC_LOW_PCT      10
+#define AS7341_SMUX_POLLS       3      // ENABLE reads before leaving SMUX to the next poll
+
 // ── SHT45 heater schedule ─────────────────────────────────────────────────────
-#define SHT45_HEATER_INTERVAL_MS  3600000  // Run on-chip heater every 60 min
+// Each shelf is heated once per interval, staggered so only one shelf is ever
+// heating or recovering. Its readings are excluded from control until the
+// recovery window (runtime value in MarthaConfig) has passed.
+#define SHT45_HEATER_INTERVAL_MS      3600000  // Run on-chip heater every 60 min per shelf
+#define SHT45_HEATER_RECOVERY_MS      30000    // Default blackout after a pulse
+#define SHT45_HEATER_RECOVERY_MAX_MS  600000
 
 // ── Sensor staleness timeout ──────────────────────────────────────────────────
 #define SENSOR_STALE_MS       30000   // Mark reading stale if not updated in 30s
 #define SCD30_STALE_ALERT_MS  300000  // Alert if SCD30 missing for 5 min
 
+// ── Sensor outlier filtering ──────────────────────────────────────────────────
+// SensorHub runs each fresh RH, CO2 and DS18B20 sample through a Hampel
+// filter (see SensorFilters in sensor_hub.h): a sample more than K robust
+// sigmas — and at least the floor — from the window median is replaced by
+// the median. Clean data passes through with no lag; a genuine step bigger
+// than the floor is held back until it fills half the window.
+#define SENSOR_HAMPEL_WINDOW      5
+#define SENSOR_HAMPEL_K           3.0f
+#define SENSOR_HAMPEL_FLOOR_RH    2.0f   // %RH
+#define SENSOR_HAMPEL_FLOOR_CO2   50.0f  // ppm
+#define SENSOR_HAMPEL_FLOOR_TEMP  0.5f   // °C
+
+// ── SCD30 measurement pacing ──────────────────────────────────────────────────
+// The SCD30 produces one sample per measurement interval. Once in phase the
+// sample is read directly when the interval has elapsed, without a readiness
+// query; now and then the read goes out SCD30_READY_LEAD_MS early so a sensor
+// clock running fast can't let read latency creep up unnoticed.
+#define SCD30_MEASUREMENT_INTERVAL_S  2     // Default; runtime value in MarthaConfig.poll
+#define SCD30_INTERVAL_MIN_S          2     // Datasheet limits
+#define SCD30_INTERVAL_MAX_S          1800
+#define SCD30_READY_LEAD_MS           500
+#define SCD30_RESYNC_EVERY            4     // Early-read spacing, samples: starts here, doubles while in phase
+#define SCD30_RESYNC_MAX              32
+
 // ── FreeRTOS task configuration ───────────────────────────────────────────────
 #define SENSOR_TASK_STACK     4096
 #define SENSOR_TASK_PRIORITY  2
-#define SENSOR_TASK_PERIOD_MS 2000
+
+// Per-driver poll cadence (defaults; runtime values live in MarthaConfig.poll).
+// Phase offsets stagger drivers so they don't all hit the bus in the same tick.
+#define SENSOR_POLL_CO2_MS      500    // Cheap: Scd30Pacer skips the bus until a sample is due
+#define SENSOR_POLL_RH_MS       1000   // SHT45 ×3 — fast, drives the humidity loop
+#define SENSOR_POLL_TEMP_MS     1000   // DS18B20 — one split-phase step per poll
+#define SENSOR_POLL_LIGHT_MS    10000  // AS7341 — static between light transitions
+#define SENSOR_PHASE_CO2_MS     0
+#define SENSOR_PHASE_RH_MS      100
+#define SENSOR_PHASE_TEMP_MS    300
+#define SENSOR_PHASE_LIGHT_MS   500
+#define SENSOR_POLL_MIN_MS      100
+#define SENSOR_POLL_MAX_MS      600000
 
 #define CONTROL_TASK_STACK    4096
 #define CONTROL_TASK_PRIORITY 3
 #define CONTROL_TASK_PERIOD_MS 1000
 
+// Control tick timing stats (see control_timing.h). Histogram buckets are
+// powers of two from CONTROL_TIMING_BUCKET0_US; the last one is open-ended.
+#define CONTROL_TIMING_BUCKETS          16
+#define CONTROL_TIMING_BUCKET0_US       64
+#define CONTROL_OVERRUN_LOG_INTERVAL_MS 60000
+
+// Tasks subscribed via SensorHub::notifyTask() get this notification bit on
+// every published snapshot; the control task wakes on it or its deadline.
+#define SENSOR_MAX_SUBSCRIBERS  4
+#define NOTIFY_SENSOR_DATA      (1u << 0)
+
+// API relay commands (relay_command.h): queued for the control task, which is
+// the only writer of relay state. NOTIFY_RELAY_CMD wakes it to apply them.
+// The HTTP response completes once the command is applied, without blocking
+// the web server task. A command not applied within RELAY_CMD_TIMEOUT_MS is
+// dropped and answered "expired"; the response gives up after twice that.
+#define NOTIFY_RELAY_CMD        (1u << 1)
+#define RELAY_CMD_QUEUE_DEPTH   8
+#define RELAY_CMD_TIMEOUT_MS    250
+
+// Publisher task (see publisher.h): all outbound serialisation and fan-out
+// (WebSocket, ...) runs here, below the control task's priority.
+#define PUBLISH_TASK_STACK     6144
+#define PUBLISH_TASK_PRIORITY  1
+#define PUBLISH_MAX_SINKS      4
+
 #define WS_BROADCAST_PERIOD_MS 2000
 
 // ── Hardware watchdog timeout (seconds) ───────────────────────────────────────
@@ -126,9 +231,73 @@
 
 // ── WebSocket ─────────────────────────────────────────────────────────────────
 #define WS_PATH               "/ws"
+// Clients that open WS_PATH with this subprotocol get packed binary frames
+// (telemetry_frame.h) instead of JSON text
+#define WS_PROTOCOL_BINARY    "martha.bin.v1"
+// ...and with this one, binary keyframes plus on-change deltas: a field is
+// re-sent once it moves by its deadband, relay/mode changes go out at once
+#define WS_PROTOCOL_DELTA     "martha.delta.v1"
+#define WS_KEYFRAME_MS        30000
+#define WS_DEADBAND_CO2_PPM   10
+#define WS_DEADBAND_RH_PCT    0.2f
+#define WS_DEADBAND_TEMP_C    0.1f
+#define WS_DEADBAND_WATER_PCT 0.5f
+// Per-client send budget (ws_backpressure.h): at most WS_CLIENT_QUEUE_MAX
+// unsent frames of up to WS_FRAME_MAX_SIZE bytes each; frames beyond that are
+// dropped for that client, and one that stays full this long is disconnected.
+// Worst-case WebSocket heap ≈ WS_MAX_CLIENTS × WS_CLIENT_QUEUE_MAX × WS_FRAME_MAX_SIZE
+#define WS_FRAME_MAX_SIZE     1024
+#define WS_CLIENT_QUEUE_MAX   2
+#define WS_CLIENT_STALL_MS    15000
+
+// ── Sensor history (history.h, GET /api/history) ──────────────────────────────
+// Tier periods and ring sizes. The full sizes (~560 KB) need PSRAM; without it
+// the *_LITE sizes (~47 KB of internal RAM) are used instead.
+#define HISTORY_RAW_PERIOD_S    2
+#define HISTORY_MID_PERIOD_S    60
+#define HISTORY_LONG_PERIOD_S   900
+#define HISTORY_RAW_ROWS        1800   // 1 h
+#define HISTORY_MID_ROWS        2880   // 48 h
+#define HISTORY_LONG_ROWS       2880   // 30 days
+#define HISTORY_RAW_ROWS_LITE   450    // 15 min
+#define HISTORY_MID_ROWS_LITE   180    // 3 h
+#define HISTORY_LONG_ROWS_LITE  192    // 48 h
+#define HISTORY_MAX_POINTS      1500   // Rows per response before a coarser tier is used
+#define HISTORY_LINE_MAX        512    // Longest JSON row (all series, min/avg/max)
+
+// ── Prometheus /metrics (metrics.h) ───────────────────────────────────────────
+#define METRICS_PATH            "/metrics"
+#define METRICS_LINE_MAX        256    // Longest exposition line (HELP text included)
+
+// ── MQTT + Home Assistant (mqtt_bridge.h) ─────────────────────────────────────
+// Broker host/port/credentials are runtime config (ConfigStore); an empty host
+// leaves MQTT off. Topics live under MQTT_TOPIC_ROOT/<node>/, discovery under
+// MQTT_DISCOVERY_PREFIX. While the broker is unreachable, one sample per
+// MQTT_STATE_PERIOD_MS is kept (MQTT_QUEUE_DEPTH × 36 B; 180 = 30 min) and
+// replayed oldest-first, MQTT_REPLAY_BATCH per flush, after reconnecting.
+#define MQTT_TOPIC_ROOT         "martha"
+#define MQTT_DISCOVERY_PREFIX   "homeassistant"
+#define MQTT_STATE_PERIOD_MS    10000
+#define MQTT_QUEUE_DEPTH        180
+#define MQTT_REPLAY_BATCH       10
+#define MQTT_RECONNECT_MIN_MS   2000
+#define MQTT_RECONNECT_MAX_MS   60000
+#define MQTT_CONNECT_TIMEOUT_MS 3000
+#define MQTT_KEEPALIVE_S        30
+#define MQTT_PAYLOAD_MAX        512    // Longest payload (a discovery config)
+#define MQTT_BATCH_MAX          1436   // Bytes coalesced per TCP write (one MSS)
+#define MQTT_TASK_STACK         4096
+#define MQTT_TASK_PRIORITY      1
+#define MQTT_SERVICE_MS         500    // Keepalive/reconnect/replay cadence
 
 // ── NVS namespace ─────────────────────────────────────────────────────────────
 #define NVS_NAMESPACE         "martha"
+#define CONFIG_BLOB_KEY       "cfg"     // Whole MarthaConfig, see config_blob.h
+// ConfigStore::set() writes to NVS once no change has arrived for
+// CONFIG_SAVE_DEBOUNCE_MS, or at most CONFIG_SAVE_MAX_DELAY_MS after the first
+// unsaved change, and then only the keys that differ from flash
+#define CONFIG_SAVE_DEBOUNCE_MS   2000
+#define CONFIG_SAVE_MAX_DELAY_MS  10000
 
 // ── Boot history ─────────────────────────────────────────────────────────────
 #define BOOT_LOG_SIZE         5    // Store last N reset reasons in NVS
@@ -0,0 +1,109 @@
+/**
+ * config_blob.cpp — Config blob encoding, validation and the migration chain.
+ */
+
+#include "config_blob.h"
+#include <cstring>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<MarthaConfig>::value,
+              "MarthaConfig is stored byte-for-byte; keep it plain data");
+static_assert(sizeof(MarthaConfig) <= UINT16_MAX, "Payload size must fit the header");
+
+const char* configBlobStatusName(ConfigBlobStatus s) {
+    switch (s) {
+        case ConfigBlobStatus::OK:        return "ok";
+        case ConfigBlobStatus::UPGRADED:  return "upgraded";
+        case ConfigBlobStatus::EMPTY:     return "empty";
+        case ConfigBlobStatus::BAD_MAGIC: return "bad_magic";
+        case ConfigBlobStatus::BAD_SIZE:  return "bad_size";
+        case ConfigBlobStatus::BAD_CRC:   return "bad_crc";
+        case ConfigBlobStatus::TOO_NEW:   return "too_new";
+        case ConfigBlobStatus::EXTENDED:  return "extended";
+    }
+    return "?";
+}
+
+uint32_t crc32(const uint8_t* data, size_t len) {
+    uint32_t crc = 0xFFFFFFFFu;
+    while (len--) {
+        crc ^= *data++;
+        for (uint8_t i = 0; i < 8; ++i) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+    return ~crc;
+}
+
+// ── Migration chain ───────────────────────────────────────────────────────────
+
+/**
+ * A step rewrites a version-v payload in buf (size bytes, room for cap) into
+ * version v+1 and returns the new size, or 0 if it can't. MIGRATIONS[v - 1]
+ * upgrades v to v+1; the chain runs from the blob's version up to
+ * CONFIG_BLOB_VERSION. Version 1 is the first blob layout, so there are no
+ * steps yet. Add one, with a frozen copy of the old struct, whenever a
+ * change is more than appending fields.
+ */
+using ConfigMigration = size_t (*)(uint8_t* buf, size_t size, size_t cap);
+
+static constexpr ConfigMigration MIGRATIONS[CONFIG_BLOB_VERSION] = {
+    nullptr,   // v1 is current
+};
+
+// ── Encode / decode ───────────────────────────────────────────────────────────
+
+size_t configBlobEncode(const MarthaConfig& cfg, uint8_t* out, size_t cap) {
+    if (cap < CONFIG_BLOB_SIZE) return 0;
+    ConfigBlobHeader h;
+    h.magic   = CONFIG_BLOB_MAGIC;
+    h.version = CONFIG_BLOB_VERSION;
+    h.size    = static_cast<uint16_t>(sizeof(MarthaConfig));
+    memcpy(out + sizeof(h), &cfg, sizeof(cfg));
+    h.crc     = crc32(out + sizeof(h), sizeof(cfg));
+    memcpy(out, &h, sizeof(h));
+    return CONFIG_BLOB_SIZE;
+}
+
+/** terminate(cfg) — Force every string field to end inside its buffer. */
+static void terminate(MarthaConfig& c) {
+    c.wifi_ssid[sizeof(c.wifi_ssid) - 1] = '\0';
+    c.wifi_pass[sizeof(c.wifi_pass) - 1] = '\0';
+    c.mqtt_host[sizeof(c.mqtt_host) - 1] = '\0';
+    c.mqtt_user[sizeof(c.mqtt_user) - 1] = '\0';
+    c.mqtt_pass[sizeof(c.mqtt_pass) - 1] = '\0';
+    c.timezone[sizeof(c.timezone) - 1]   = '\0';
+    for (auto& label : c.probe_labels) label[sizeof(label) - 1] = '\0';
+}
+
+ConfigBlobStatus configBlobDecode(const uint8_t* blob, size_t len, MarthaConfig& out) {
+    if (len == 0) return ConfigBlobStatus::EMPTY;
+    ConfigBlobHeader h;
+    if (len < sizeof(h)) return ConfigBlobStatus::BAD_SIZE;
+    memcpy(&h, blob, sizeof(h));
+    if (h.magic != CONFIG_BLOB_MAGIC)               return ConfigBlobStatus::BAD_MAGIC;
+    if (h.version > CONFIG_BLOB_VERSION)            return ConfigBlobStatus::TOO_NEW;
+    if (h.version == 0)                             return ConfigBlobStatus::BAD_MAGIC;  // 0 = legacy keys, never a blob
+    if (len != sizeof(h) + h.size)                  return ConfigBlobStatus::BAD_SIZE;
+    if (crc32(blob + sizeof(h), h.size) != h.crc)   return ConfigBlobStatus::BAD_CRC;
+
+    // Work on a copy so a failed migration leaves out as it was
+    uint8_t buf[sizeof(MarthaConfig) * 2];
+    size_t  size     = h.size;
+    bool    extended = h.version == CONFIG_BLOB_VERSION && size > sizeof(MarthaConfig);
+    if (extended) size = sizeof(MarthaConfig);   // Fields are only appended: ours are the prefix
+    if (size > sizeof(buf)) return ConfigBlobStatus::BAD_SIZE;
+    memcpy(buf, blob + sizeof(h), size);
+    for (uint16_t v = h.version; v < CONFIG_BLOB_VERSION; ++v) {
+        size = MIGRATIONS[v - 1] ? MIGRATIONS[v - 1](buf, size, sizeof(buf)) : 0;
+        if (size == 0) return ConfigBlobStatus::BAD_SIZE;
+    }
+    if (size > sizeof(MarthaConfig)) return ConfigBlobStatus::BAD_SIZE;
+
+    MarthaConfig cfg;                 // Defaults for anything the payload predates
+    memcpy(&cfg, buf, size);
+    terminate(cfg);
+    out = cfg;
+    if (extended) return ConfigBlobStatus::EXTENDED;
+    return h.version == CONFIG_BLOB_VERSION && size == sizeof(MarthaConfig)
+               ? ConfigBlobStatus::OK
+               : ConfigBlobStatus::UPGRADED;
+}
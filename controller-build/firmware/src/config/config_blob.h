@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "config_store.h"
+
+/**
+ * config_blob.h — MarthaConfig as one versioned, checksummed NVS blob.
+ *
+ *   offset  size  field
+ *     0      4    magic    CONFIG_BLOB_MAGIC ("MCFG")
+ *     4      2    version  payload layout version
+ *     6      2    size     payload bytes
+ *     8      4    crc      CRC-32 (IEEE) of the payload
+ *    12    size   payload  MarthaConfig, as laid out by that version
+ *
+ * Fields are only ever appended to MarthaConfig. A payload shorter than
+ * the current struct is an older build's config: its prefix is copied and
+ * the new fields keep their defaults. A longer payload of the current
+ * version is a newer build's config after a downgrade: its prefix is this
+ * build's struct, so that is loaded and the blob left alone. Any other
+ * layout change bumps CONFIG_BLOB_VERSION and adds a step to the
+ * migration chain in config_blob.cpp that rewrites the old payload into the
+ * next version.
+ * Version 0 is the legacy one-key-per-field layout, which ConfigStore
+ * reads once and replaces with a blob.
+ *
+ * Portable; ConfigStore does the NVS I/O.
+ */
+
+inline constexpr uint32_t CONFIG_BLOB_MAGIC   = 0x4746434Du;   // "MCFG" little-endian
+inline constexpr uint16_t CONFIG_BLOB_VERSION = 1;
+
+struct ConfigBlobHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;
+    uint32_t crc;
+};
+
+inline constexpr size_t CONFIG_BLOB_SIZE = sizeof(ConfigBlobHeader) + sizeof(MarthaConfig);
+
+enum class ConfigBlobStatus : uint8_t {
+    OK       = 0,   // Current version, loaded as is
+    UPGRADED = 1,   // Older version or shorter payload; rewrite it
+    EMPTY    = 2,   // No blob
+    BAD_MAGIC,
+    BAD_SIZE,       // Header size disagrees with the blob, or truncated
+    BAD_CRC,
+    TOO_NEW,        // Written by a newer firmware
+    EXTENDED,       // Same version, newer build's appended fields; prefix loaded, keep the blob
+};
+
+/** configBlobStatusName(s) — "ok", "bad_crc", ... for logs and /api/status. */
+const char* configBlobStatusName(ConfigBlobStatus s);
+
+/** crc32(data, len) — CRC-32/ISO-HDLC (zlib), as used in the header. */
+uint32_t crc32(const uint8_t* data, size_t len);
+
+/**
+ * configBlobEncode(cfg, out, cap) — Write the blob for cfg. Returns its
+ * length (CONFIG_BLOB_SIZE), or 0 if cap is too small.
+ */
+size_t configBlobEncode(const MarthaConfig& cfg, uint8_t* out, size_t cap);
+
+/**
+ * configBlobDecode(blob, len, out) — Validate and, if needed, migrate a
+ * blob. On OK/UPGRADED/EXTENDED out holds the config; otherwise out is
+ * left untouched. Nothing is ever half-loaded.
+ */
+ConfigBlobStatus configBlobDecode(const uint8_t* blob, size_t len, MarthaConfig& out);
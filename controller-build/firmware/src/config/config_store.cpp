@@ -1,40 +1,293 @@
 #include "config_store.h"
+#include "config_blob.h"
 #include "../util/logger.h"
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+// ── Key diff (portable) ───────────────────────────────────────────────────────
+
+uint8_t configWriteChanged(const MarthaConfig& saved, const MarthaConfig& cfg,
+                           ConfigKeyWriter* out, bool all) {
+    uint8_t n = 0;
+    auto f32 = [&](const char* key, float was, float now) {
+        if (!all && was == now) return;
+        if (out) out->putFloat(key, now);
+        n++;
+    };
+    auto u32 = [&](const char* key, uint32_t was, uint32_t now) {
+        if (!all && was == now) return;
+        if (out) out->putU32(key, now);
+        n++;
+    };
+    auto u16 = [&](const char* key, uint16_t was, uint16_t now) {
+        if (!all && was == now) return;
+        if (out) out->putU16(key, now);
+        n++;
+    };
+    auto u8 = [&](const char* key, uint8_t was, uint8_t now) {
+        if (!all && was == now) return;
+        if (out) out->putU8(key, now);
+        n++;
+    };
+    auto str = [&](const char* key, const char* was, const char* now) {
+        if (!all && strcmp(was, now) == 0) return;
+        if (out) out->putStr(key, now);
+        n++;
+    };
+
+    str("wifi_ssid", saved.wifi_ssid, cfg.wifi_ssid);
+    str("wifi_pass", saved.wifi_pass, cfg.wifi_pass);
+
+    str("mqtt_host", saved.mqtt_host, cfg.mqtt_host);
+    u16("mqtt_port", saved.mqtt_port, cfg.mqtt_port);
+    str("mqtt_user", saved.mqtt_user, cfg.mqtt_user);
+    str("mqtt_pass", saved.mqtt_pass, cfg.mqtt_pass);
+
+    f32("rh_on",    saved.rh_on_pct,      cfg.rh_on_pct);
+    f32("rh_hyst",  saved.rh_hysteresis,  cfg.rh_hysteresis);
+    f32("co2_on",   saved.co2_on_ppm,     cfg.co2_on_ppm);
+    f32("co2_off",  saved.co2_off_ppm,    cfg.co2_off_ppm);
+    f32("wl_low",   saved.water_low_pct,  cfg.water_low_pct);
+    f32("wl_high",  saved.water_high_pct, cfg.water_high_pct);
+    u32("adc_min",  saved.adc_water_min_mv, cfg.adc_water_min_mv);
+    u32("adc_max",  saved.adc_water_max_mv, cfg.adc_water_max_mv);
+    u8("rh_agg",    saved.rh_aggregation, cfg.rh_aggregation);
+    u8("rh_prec",   saved.rh_precision,   cfg.rh_precision);
+    u32("htr_rec",  saved.rh_heater_recovery_ms, cfg.rh_heater_recovery_ms);
+    u8("lt_mode",   saved.light_mode,     cfg.light_mode);
+    u8("log_lvl",   saved.log_level,      cfg.log_level);
+
+    str("timezone", saved.timezone, cfg.timezone);
+
+    u16("l_on",     saved.timer.lights_on_minute,  cfg.timer.lights_on_minute);
+    u16("l_off",    saved.timer.lights_off_minute, cfg.timer.lights_off_minute);
+    u16("uvc_on",   saved.timer.uvc_on_min,        cfg.timer.uvc_on_min);
+    u16("uvc_off",  saved.timer.uvc_off_min,       cfg.timer.uvc_off_min);
+
+    u32("p_co2",    saved.poll.co2_ms,   cfg.poll.co2_ms);
+    u32("p_rh",     saved.poll.rh_ms,    cfg.poll.rh_ms);
+    u32("p_temp",   saved.poll.temp_ms,  cfg.poll.temp_ms);
+    u32("p_light",  saved.poll.light_ms, cfg.poll.light_ms);
+    u16("co2_int",  saved.poll.scd30_interval_s, cfg.poll.scd30_interval_s);
+
+    for (int i = 0; i < 5; ++i) {
+        char key[12];
+        snprintf(key, sizeof(key), "probe_%d", i);
+        str(key, saved.probe_labels[i], cfg.probe_labels[i]);
+    }
+    return n;
+}
+
+// ── Hardware binding ──────────────────────────────────────────────────────────
 
 #ifndef NATIVE_TEST
+#include <Arduino.h>
 #include <Preferences.h>
 #include <ArduinoJson.h>
-#include <cstring>
+#include <nvs.h>
+#include <esp_system.h>
 
 ConfigStore Config;
 
+/**
+ * NvsKeyEraser — Erases each key it is given (values ignored), committed
+ * once. Clears the legacy per-key layout after it has been migrated.
+ */
+class NvsKeyEraser : public ConfigKeyWriter {
+public:
+    NvsKeyEraser() { _err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &_h); }
+    ~NvsKeyEraser() { if (_h) nvs_close(_h); }
+
+    void putFloat(const char* key, float) override       { _erase(key); }
+    void putU32(const char* key, uint32_t) override      { _erase(key); }
+    void putU16(const char* key, uint16_t) override      { _erase(key); }
+    void putU8(const char* key, uint8_t) override        { _erase(key); }
+    void putStr(const char* key, const char*) override   { _erase(key); }
+
+    bool commit() {
+        if (_err == ESP_OK) _err = nvs_commit(_h);
+        return _err == ESP_OK;
+    }
+
+private:
+    void _erase(const char* key) {
+        if (_err != ESP_OK) return;
+        esp_err_t e = nvs_erase_key(_h, key);
+        if (e != ESP_ERR_NVS_NOT_FOUND) _err = e;
+    }
+
+    nvs_handle_t _h   = 0;
+    esp_err_t    _err = ESP_OK;
+};
+
 void ConfigStore::begin() {
+    _mutex = xSemaphoreCreateMutex();
     _prefs.begin(NVS_NAMESPACE, false);
 
-    bool has_data = _prefs.isKey("rh_on");
-    if (!has_data) {
-        Log.info("cfg", "NVS empty; writing defaults");
-        loadDefaults();
-    } else {
-        _load();
-        Log.info("cfg", "Config loaded from NVS");
+    // Any esp_restart() (OTA, API, library) writes debounced changes first.
+    // Panics and watchdog resets skip shutdown handlers; nothing can help those.
+    esp_register_shutdown_handler([] { Config.flush(); });
+
+    // The whole config is one blob: a single NVS read, validated before use.
+    // A newer firmware's blob may not fit the stack buffer; read it anyway so
+    // it is recognised as TOO_NEW rather than as corrupt.
+    uint8_t                    stack_blob[CONFIG_BLOB_SIZE * 2];   // Room for an older, larger layout
+    std::unique_ptr<uint8_t[]> heap_blob;
+    uint8_t*                   blob   = stack_blob;
+    size_t                     stored = _prefs.getBytesLength(CONFIG_BLOB_KEY);
+    if (stored > sizeof(stack_blob)) {
+        heap_blob.reset(new uint8_t[stored]);
+        blob = heap_blob.get();
+    }
+    MarthaConfig     cfg;
+    uint32_t         t0  = millis();
+    size_t           len = stored ? _prefs.getBytes(CONFIG_BLOB_KEY, blob, stored) : 0;
+    ConfigBlobStatus st  = len ? configBlobDecode(blob, len, cfg)
+                               : (_prefs.isKey(CONFIG_BLOB_KEY) ? ConfigBlobStatus::BAD_SIZE
+                                                                : ConfigBlobStatus::EMPTY);
+    _load_status = configBlobStatusName(st);
+
+    switch (st) {
+        case ConfigBlobStatus::OK:
+            _cfg = _saved = cfg;
+            Log.info("cfg", "Config loaded from NVS (%u bytes, %lu ms)",
+                     static_cast<unsigned>(len), static_cast<unsigned long>(millis() - t0));
+            break;
+
+        case ConfigBlobStatus::UPGRADED:
+            _cfg = cfg;
+            _write(cfg, true);
+            Log.info("cfg", "Config upgraded to layout v%u", CONFIG_BLOB_VERSION);
+            break;
+
+        case ConfigBlobStatus::EMPTY:
+            if (_prefs.isKey("rh_on")) {
+                // First boot after the blob format: read the old keys once,
+                // save them as a blob, then drop them
+                _loadLegacy();
+                if (_write(_cfg, true)) {
+                    NvsKeyEraser eraser;
+                    configWriteChanged(_cfg, _cfg, &eraser, true);
+                    if (!eraser.commit()) Log.warn("cfg", "Could not erase legacy config keys");
+                }
+                _load_status = "legacy";
+                Log.info("cfg", "Legacy per-key config migrated to a blob");
+            } else {
+                Log.info("cfg", "NVS empty; writing defaults");
+                loadDefaults();
+            }
+            break;
+
+        case ConfigBlobStatus::EXTENDED:
+            // A newer build appended fields, then was downgraded. Ours are
+            // loaded; the blob stays until config is set, so upgrading
+            // again keeps the newer fields too.
+            _cfg = _saved = cfg;
+            Log.warn("cfg", "Stored config has fields from a newer firmware (%u bytes); "
+                     "loaded ours, blob kept until config is set", static_cast<unsigned>(len));
+            break;
+
+        case ConfigBlobStatus::TOO_NEW: {
+            // Booted after a downgrade. Run on defaults but keep the newer
+            // blob: only an explicit set() replaces it, so upgrading again
+            // gets that config back.
+            ConfigBlobHeader h;
+            memcpy(&h, blob, sizeof(h));
+            _cfg   = MarthaConfig{};
+            _saved = _cfg;
+            Log.warn("cfg", "Stored config is from a newer firmware (layout v%u > v%u); "
+                     "running on defaults, blob kept until config is set",
+                     h.version, CONFIG_BLOB_VERSION);
+            break;
+        }
+
+        default:
+            // Never run on a half-loaded config: defaults until the next save
+            // replaces the bad blob
+            _cfg         = MarthaConfig{};
+            _saved       = _cfg;
+            _blob_stale  = true;
+            Log.error("cfg", "Stored config corrupt (%s); running on defaults", _load_status);
+            break;
     }
 }
 
 void ConfigStore::loadDefaults() {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
     _cfg = MarthaConfig{};  // Zero/default-initialise
-    _save();
+    _debounce.clear();
+    xSemaphoreGive(_mutex);
+    _write(MarthaConfig{}, true);
+}
+
+MarthaConfig ConfigStore::get() const {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    MarthaConfig c = _cfg;
+    xSemaphoreGive(_mutex);
+    return c;
 }
 
-void ConfigStore::set(const MarthaConfig& cfg) {
+uint8_t ConfigStore::set(const MarthaConfig& cfg) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
     _cfg = cfg;
-    _save();
+    _debounce.touch(millis());
+    uint8_t changed = configWriteChanged(_saved, _cfg, nullptr);
+    xSemaphoreGive(_mutex);
+    return changed;
+}
+
+void ConfigStore::service(uint32_t now_ms) {
+    if (_debounce.due(now_ms)) flush();
+}
+
+uint8_t ConfigStore::flush() {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    if (!_debounce.pending()) {
+        xSemaphoreGive(_mutex);
+        return 0;
+    }
+    MarthaConfig cfg = _cfg;
+    _debounce.clear();
+    xSemaphoreGive(_mutex);
+    return _write(cfg, false);
+}
+
+uint8_t ConfigStore::_write(const MarthaConfig& cfg, bool all) {
+    uint8_t changed = configWriteChanged(_saved, cfg, nullptr, all);
+    if (changed == 0 && !_blob_stale) return 0;
+
+    uint32_t t0 = millis();
+    uint8_t  blob[CONFIG_BLOB_SIZE];
+    size_t   len = configBlobEncode(cfg, blob, sizeof(blob));
+    if (_prefs.putBytes(CONFIG_BLOB_KEY, blob, len) != len) {   // One blob, one commit
+        Log.error("cfg", "NVS write failed; will retry");
+        xSemaphoreTake(_mutex, portMAX_DELAY);
+        _debounce.touch(millis());
+        xSemaphoreGive(_mutex);
+        return 0;
+    }
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _saved = cfg;
+    xSemaphoreGive(_mutex);
+    _blob_stale = false;
+    _commits++;
+    _changed_last   = changed;
+    _changed_total += changed;
+    Log.info("cfg", "Saved config to NVS (%u setting%s changed, %lu ms)", changed,
+             changed == 1 ? "" : "s", static_cast<unsigned long>(millis() - t0));
+    return changed;
 }
 
-void ConfigStore::_load() {
+void ConfigStore::_loadLegacy() {
     _prefs.getString("wifi_ssid", _cfg.wifi_ssid, sizeof(_cfg.wifi_ssid));
     _prefs.getString("wifi_pass", _cfg.wifi_pass, sizeof(_cfg.wifi_pass));
 
+    _prefs.getString("mqtt_host", _cfg.mqtt_host, sizeof(_cfg.mqtt_host));
+    _cfg.mqtt_port = _prefs.getUShort("mqtt_port", DEFAULT_MQTT_PORT);
+    _prefs.getString("mqtt_user", _cfg.mqtt_user, sizeof(_cfg.mqtt_user));
+    _prefs.getString("mqtt_pass", _cfg.mqtt_pass, sizeof(_cfg.mqtt_pass));
+
     _cfg.rh_on_pct     = _prefs.getFloat("rh_on",    DEFAULT_RH_ON_PCT);
     _cfg.rh_hysteresis = _prefs.getFloat("rh_hyst",  DEFAULT_RH_HYSTERESIS_PCT);
     _cfg.co2_on_ppm    = _prefs.getFloat("co2_on",   DEFAULT_CO2_ON_PPM);
@@ -44,6 +297,9 @@ void ConfigStore::_load() {
     _cfg.adc_water_min_mv = _prefs.getUInt("adc_min", DEFAULT_ADC_WATER_MIN_MV);
     _cfg.adc_water_max_mv = _prefs.getUInt("adc_max", DEFAULT_ADC_WATER_MAX_MV);
     _cfg.rh_aggregation   = _prefs.getUChar("rh_agg", DEFAULT_RH_AGGREGATION);
+    _cfg.rh_precision     = _prefs.getUChar("rh_prec", DEFAULT_RH_PRECISION);
+    _cfg.rh_heater_recovery_ms = _prefs.getUInt("htr_rec", DEFAULT_HEATER_RECOVERY_MS);
+    _cfg.light_mode       = _prefs.getUChar("lt_mode", DEFAULT_LIGHT_MODE);
     _cfg.log_level        = _prefs.getUChar("log_lvl", DEFAULT_LOG_LEVEL);
 
     _prefs.getString("timezone", _cfg.timezone, sizeof(_cfg.timezone));
@@ -53,6 +309,12 @@ void ConfigStore::_load() {
     _cfg.timer.uvc_on_min        = _prefs.getUShort("uvc_on", DEFAULT_UVC_ON_MIN);
     _cfg.timer.uvc_off_min       = _prefs.getUShort("uvc_off",DEFAULT_UVC_OFF_MIN);
 
+    _cfg.poll.co2_ms   = _prefs.getUInt("p_co2",   DEFAULT_POLL_CO2_MS);
+    _cfg.poll.rh_ms    = _prefs.getUInt("p_rh",    DEFAULT_POLL_RH_MS);
+    _cfg.poll.temp_ms  = _prefs.getUInt("p_temp",  DEFAULT_POLL_TEMP_MS);
+    _cfg.poll.light_ms = _prefs.getUInt("p_light", DEFAULT_POLL_LIGHT_MS);
+    _cfg.poll.scd30_interval_s = _prefs.getUShort("co2_int", DEFAULT_SCD30_INTERVAL_S);
+
     // Probe labels
     for (int i = 0; i < 5; ++i) {
         char key[12];
@@ -61,64 +323,52 @@ void ConfigStore::_load() {
     }
 }
 
-void ConfigStore::_save() {
-    _prefs.putString("wifi_ssid", _cfg.wifi_ssid);
-    _prefs.putString("wifi_pass", _cfg.wifi_pass);
-
-    _prefs.putFloat("rh_on",    _cfg.rh_on_pct);
-    _prefs.putFloat("rh_hyst",  _cfg.rh_hysteresis);
-    _prefs.putFloat("co2_on",   _cfg.co2_on_ppm);
-    _prefs.putFloat("co2_off",  _cfg.co2_off_ppm);
-    _prefs.putFloat("wl_low",   _cfg.water_low_pct);
-    _prefs.putFloat("wl_high",  _cfg.water_high_pct);
-    _prefs.putUInt("adc_min",   _cfg.adc_water_min_mv);
-    _prefs.putUInt("adc_max",   _cfg.adc_water_max_mv);
-    _prefs.putUChar("rh_agg",   _cfg.rh_aggregation);
-    _prefs.putUChar("log_lvl",  _cfg.log_level);
-
-    _prefs.putString("timezone", _cfg.timezone);
-
-    _prefs.putUShort("l_on",    _cfg.timer.lights_on_minute);
-    _prefs.putUShort("l_off",   _cfg.timer.lights_off_minute);
-    _prefs.putUShort("uvc_on",  _cfg.timer.uvc_on_min);
-    _prefs.putUShort("uvc_off", _cfg.timer.uvc_off_min);
-
-    for (int i = 0; i < 5; ++i) {
-        char key[12];
-        snprintf(key, sizeof(key), "probe_%d", i);
-        _prefs.putString(key, _cfg.probe_labels[i]);
-    }
-}
-
 void ConfigStore::exportJson(JsonDocument& doc) const {
-    doc["rh_on_pct"]     = _cfg.rh_on_pct;
-    doc["rh_hysteresis"] = _cfg.rh_hysteresis;
-    doc["co2_on_ppm"]    = _cfg.co2_on_ppm;
-    doc["co2_off_ppm"]   = _cfg.co2_off_ppm;
-    doc["water_low_pct"] = _cfg.water_low_pct;
-    doc["water_high_pct"]= _cfg.water_high_pct;
-    doc["rh_aggregation"]= _cfg.rh_aggregation;
-    doc["log_level"]     = _cfg.log_level;
-    doc["timezone"]      = _cfg.timezone;
-    doc["wifi_ssid"]     = _cfg.wifi_ssid;
+    const MarthaConfig c = get();
+    doc["rh_on_pct"]     = c.rh_on_pct;
+    doc["rh_hysteresis"] = c.rh_hysteresis;
+    doc["co2_on_ppm"]    = c.co2_on_ppm;
+    doc["co2_off_ppm"]   = c.co2_off_ppm;
+    doc["water_low_pct"] = c.water_low_pct;
+    doc["water_high_pct"]= c.water_high_pct;
+    doc["rh_aggregation"]= c.rh_aggregation;
+    doc["rh_precision"]  = c.rh_precision;
+    doc["rh_heater_recovery_ms"] = c.rh_heater_recovery_ms;
+    doc["light_mode"]    = c.light_mode;
+    doc["log_level"]     = c.log_level;
+    doc["timezone"]      = c.timezone;
+    doc["wifi_ssid"]     = c.wifi_ssid;
     // wifi_pass intentionally omitted from export
 
+    auto mqtt = doc["mqtt"].to<JsonObject>();
+    mqtt["host"] = c.mqtt_host;
+    mqtt["port"] = c.mqtt_port;
+    mqtt["user"] = c.mqtt_user;
+    // mqtt pass intentionally omitted from export
+
     auto timer = doc["timer"].to<JsonObject>();
-    timer["lights_on_minute"]  = _cfg.timer.lights_on_minute;
-    timer["lights_off_minute"] = _cfg.timer.lights_off_minute;
-    timer["uvc_on_min"]        = _cfg.timer.uvc_on_min;
-    timer["uvc_off_min"]       = _cfg.timer.uvc_off_min;
+    timer["lights_on_minute"]  = c.timer.lights_on_minute;
+    timer["lights_off_minute"] = c.timer.lights_off_minute;
+    timer["uvc_on_min"]        = c.timer.uvc_on_min;
+    timer["uvc_off_min"]       = c.timer.uvc_off_min;
 
     auto adc = doc["adc"].to<JsonObject>();
-    adc["water_min_mv"] = _cfg.adc_water_min_mv;
-    adc["water_max_mv"] = _cfg.adc_water_max_mv;
+    adc["water_min_mv"] = c.adc_water_min_mv;
+    adc["water_max_mv"] = c.adc_water_max_mv;
+
+    auto poll = doc["poll"].to<JsonObject>();
+    poll["co2_ms"]   = c.poll.co2_ms;
+    poll["rh_ms"]    = c.poll.rh_ms;
+    poll["temp_ms"]  = c.poll.temp_ms;
+    poll["light_ms"] = c.poll.light_ms;
+    poll["scd30_interval_s"] = c.poll.scd30_interval_s;
 
     auto labels = doc["probe_labels"].to<JsonArray>();
-    for (int i = 0; i < 5; ++i) labels.add(_cfg.probe_labels[i]);
+    for (int i = 0; i < 5; ++i) labels.add(c.probe_labels[i]);
 }
 
-bool ConfigStore::importJson(const JsonDocument& doc) {
-    MarthaConfig c = _cfg;  // Start from current config
+bool ConfigStore::importJson(const JsonDocument& doc, uint8_t* changed) {
+    MarthaConfig c = get();  // Start from current config
 
     if (doc["rh_on_pct"].is<float>())      c.rh_on_pct     = doc["rh_on_pct"].as<float>();
     if (doc["rh_hysteresis"].is<float>())  c.rh_hysteresis = doc["rh_hysteresis"].as<float>();
@@ -127,6 +377,10 @@ bool ConfigStore::importJson(const JsonDocument& doc) {
     if (doc["water_low_pct"].is<float>())  c.water_low_pct = doc["water_low_pct"].as<float>();
     if (doc["water_high_pct"].is<float>()) c.water_high_pct= doc["water_high_pct"].as<float>();
     if (doc["rh_aggregation"].is<int>())   c.rh_aggregation= doc["rh_aggregation"].as<uint8_t>();
+    if (doc["rh_precision"].is<int>())     c.rh_precision  = doc["rh_precision"].as<uint8_t>();
+    if (doc["rh_heater_recovery_ms"].is<int>())
+        c.rh_heater_recovery_ms = doc["rh_heater_recovery_ms"].as<uint32_t>();
+    if (doc["light_mode"].is<int>())       c.light_mode    = doc["light_mode"].as<uint8_t>();
     if (doc["log_level"].is<int>())        c.log_level     = doc["log_level"].as<uint8_t>();
     if (doc["timezone"].is<const char*>()) {
         strlcpy(c.timezone, doc["timezone"].as<const char*>(), sizeof(c.timezone));
@@ -138,6 +392,15 @@ bool ConfigStore::importJson(const JsonDocument& doc) {
         strlcpy(c.wifi_pass, doc["wifi_pass"].as<const char*>(), sizeof(c.wifi_pass));
     }
 
+    // MQTT broker
+    if (doc["mqtt"]["host"].is<const char*>())
+        strlcpy(c.mqtt_host, doc["mqtt"]["host"].as<const char*>(), sizeof(c.mqtt_host));
+    if (doc["mqtt"]["port"].is<int>()) c.mqtt_port = doc["mqtt"]["port"].as<uint16_t>();
+    if (doc["mqtt"]["user"].is<const char*>())
+        strlcpy(c.mqtt_user, doc["mqtt"]["user"].as<const char*>(), sizeof(c.mqtt_user));
+    if (doc["mqtt"]["pass"].is<const char*>())
+        strlcpy(c.mqtt_pass, doc["mqtt"]["pass"].as<const char*>(), sizeof(c.mqtt_pass));
+
     // Timer
     if (doc["timer"]["lights_on_minute"].is<int>())
         c.timer.lights_on_minute = doc["timer"]["lights_on_minute"].as<uint16_t>();
@@ -154,6 +417,14 @@ bool ConfigStore::importJson(const JsonDocument& doc) {
     if (doc["adc"]["water_max_mv"].is<int>())
         c.adc_water_max_mv = doc["adc"]["water_max_mv"].as<uint32_t>();
 
+    // Sensor poll cadence
+    if (doc["poll"]["co2_ms"].is<int>())   c.poll.co2_ms   = doc["poll"]["co2_ms"].as<uint32_t>();
+    if (doc["poll"]["rh_ms"].is<int>())    c.poll.rh_ms    = doc["poll"]["rh_ms"].as<uint32_t>();
+    if (doc["poll"]["temp_ms"].is<int>())  c.poll.temp_ms  = doc["poll"]["temp_ms"].as<uint32_t>();
+    if (doc["poll"]["light_ms"].is<int>()) c.poll.light_ms = doc["poll"]["light_ms"].as<uint32_t>();
+    if (doc["poll"]["scd30_interval_s"].is<int>())
+        c.poll.scd30_interval_s = doc["poll"]["scd30_interval_s"].as<uint16_t>();
+
     // Probe labels
     if (doc["probe_labels"].is<JsonArrayConst>()) {
         auto arr = doc["probe_labels"].as<JsonArrayConst>();
@@ -176,8 +447,19 @@ bool ConfigStore::importJson(const JsonDocument& doc) {
     if (c.timer.uvc_on_min < 1 || c.timer.uvc_on_min > 1440)    return false;
     if (c.timer.uvc_off_min < 1 || c.timer.uvc_off_min > 1440)  return false;
     if (c.adc_water_max_mv <= c.adc_water_min_mv)                return false;
+    if (c.mqtt_port == 0)                                        return false;
+    if (c.rh_precision > 2)                                      return false;
+    if (c.rh_heater_recovery_ms > SHT45_HEATER_RECOVERY_MAX_MS)  return false;
+    if (c.light_mode > 1)                                        return false;
+    for (uint8_t i = 0; i < SENSOR_DRIVER_COUNT; ++i) {
+        uint32_t p = c.poll.periodFor(static_cast<SensorDriver>(i));
+        if (p < SENSOR_POLL_MIN_MS || p > SENSOR_POLL_MAX_MS)   return false;
+    }
+    if (c.poll.scd30_interval_s < SCD30_INTERVAL_MIN_S ||
+        c.poll.scd30_interval_s > SCD30_INTERVAL_MAX_S)          return false;
 
-    set(c);
+    uint8_t n = set(c);
+    if (changed) *changed = n;
     return true;
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 #include "../control/timer_scheduler.h"
 #include "../sensors/sensor_hub.h"
+#include "../sensors/poll_scheduler.h"
 #include "defaults.h"
 #include <cstdint>
 
@@ -8,17 +9,37 @@
  * config_store.h — Preferences NVS wrapper (namespace "martha").
  *
  * Stores all user-configurable values that must survive reboots:
- *   WiFi SSID/password, control thresholds, schedules, calibration.
+ *   WiFi SSID/password, MQTT broker, control thresholds, schedules,
+ *   calibration, sensor poll cadence.
  *
  * exportJson() / importJson() bridge to the REST /api/config endpoints.
  * loadDefaults() is called on first boot when namespace is empty.
+ *
+ * The config is stored as a single versioned, CRC-checked blob
+ * (config_blob.h), so boot is one NVS read and a damaged config is
+ * rejected whole rather than half-loaded. The old one-key-per-field layout
+ * is read once on the first boot after an upgrade and then replaced.
+ *
+ * set() only updates the in-memory config. The NVS write is debounced
+ * (CONFIG_SAVE_DEBOUNCE_MS) and done from loop() by service(), and it is
+ * skipped when nothing differs from flash. configWriteChanged() and
+ * ConfigSaveDebounce are portable so the diff and timing can be tested
+ * natively.
  */
 
+// Persisted byte-for-byte as the config blob (config_blob.h): add new fields
+// at the end only, or bump CONFIG_BLOB_VERSION and add a migration step.
 struct MarthaConfig {
     // WiFi
     char wifi_ssid[64]     = {};
     char wifi_pass[64]     = {};
 
+    // MQTT broker (empty host = MQTT disabled)
+    char     mqtt_host[64] = {};
+    uint16_t mqtt_port     = DEFAULT_MQTT_PORT;
+    char     mqtt_user[32] = {};
+    char     mqtt_pass[64] = {};
+
     // Control thresholds
     float rh_on_pct        = DEFAULT_RH_ON_PCT;
     float rh_hysteresis    = DEFAULT_RH_HYSTERESIS_PCT;
@@ -36,9 +57,21 @@ struct MarthaConfig {
     uint32_t adc_water_min_mv = DEFAULT_ADC_WATER_MIN_MV;
     uint32_t adc_water_max_mv = DEFAULT_ADC_WATER_MAX_MV;
 
+    // Per-driver sensor poll periods (ms)
+    SensorPollConfig poll;
+
     // RH aggregation (0=average, 1=min, 2=max)
     uint8_t rh_aggregation = DEFAULT_RH_AGGREGATION;
 
+    // SHT45 repeatability (0=high, 1=medium, 2=low precision)
+    uint8_t rh_precision = DEFAULT_RH_PRECISION;
+
+    // SHT45 heater blackout after each pulse (ms)
+    uint32_t rh_heater_recovery_ms = DEFAULT_HEATER_RECOVERY_MS;
+
+    // AS7341 readout (0=full spectrum, 1=reduced single pass)
+    uint8_t light_mode = DEFAULT_LIGHT_MODE;
+
     // Timezone
     char timezone[48] = DEFAULT_TIMEZONE;
 
@@ -51,9 +84,63 @@ struct MarthaConfig {
     };
 };
 
+/**
+ * ConfigKeyWriter — Visitor over the legacy per-key NVS layout: counts
+ * changes, erases the old keys after migration, or records them in tests.
+ */
+class ConfigKeyWriter {
+public:
+    virtual ~ConfigKeyWriter() = default;
+    virtual void putFloat(const char* key, float v) = 0;
+    virtual void putU32(const char* key, uint32_t v) = 0;
+    virtual void putU16(const char* key, uint16_t v) = 0;
+    virtual void putU8(const char* key, uint8_t v) = 0;
+    virtual void putStr(const char* key, const char* v) = 0;
+};
+
+/**
+ * configWriteChanged(saved, cfg, out, all) — Pass each legacy key whose value
+ * in cfg differs from saved (every key if all) to out. Returns how many
+ * there were; out may be nullptr to only count the changed settings.
+ */
+uint8_t configWriteChanged(const MarthaConfig& saved, const MarthaConfig& cfg,
+                           ConfigKeyWriter* out, bool all = false);
+
+/**
+ * ConfigSaveDebounce — When an unsaved config should go to flash: once
+ * CONFIG_SAVE_DEBOUNCE_MS pass with no further change, and no later than
+ * CONFIG_SAVE_MAX_DELAY_MS after the first unsaved change, so a steady stream
+ * of POSTs can't postpone the write indefinitely.
+ */
+class ConfigSaveDebounce {
+public:
+    /** touch(now_ms) — Config changed. */
+    void touch(uint32_t now_ms) {
+        if (!_pending) _first_ms = now_ms;
+        _pending = true;
+        _last_ms = now_ms;
+    }
+
+    /** due(now_ms) — Time to write. */
+    bool due(uint32_t now_ms) const {
+        return _pending && (now_ms - _last_ms >= CONFIG_SAVE_DEBOUNCE_MS ||
+                            now_ms - _first_ms >= CONFIG_SAVE_MAX_DELAY_MS);
+    }
+
+    bool pending() const { return _pending; }
+    void clear()         { _pending = false; }
+
+private:
+    bool     _pending  = false;
+    uint32_t _first_ms = 0;
+    uint32_t _last_ms  = 0;
+};
+
 #ifndef NATIVE_TEST
 #include <Preferences.h>
 #include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
 class ConfigStore {
 public:
@@ -62,11 +149,37 @@ public:
     /** begin() — Open NVS namespace; load saved config or write defaults. */
     void begin();
 
-    /** get() — Reference to in-memory config (read-only). */
-    const MarthaConfig& get() const { return _cfg; }
+    /**
+     * get() — Copy of the in-memory config, taken under the mutex so it never
+     * mixes two set() calls. Not for the control path; see control_config.h.
+     */
+    MarthaConfig get() const;
 
-    /** set() — Update in-memory config and persist to NVS. */
-    void set(const MarthaConfig& cfg);
+    /**
+     * set() — Update in-memory config and schedule the NVS write. Returns how
+     * many settings now differ from flash (0 = the write will be skipped).
+     */
+    uint8_t set(const MarthaConfig& cfg);
+
+    /** service(now_ms) — Write pending changes once the debounce expires. Call from loop(). */
+    void service(uint32_t now_ms);
+
+    /**
+     * flush() — Write pending changes now. Called from the OTA end hook and
+     * an esp_restart() shutdown handler. Returns settings changed.
+     */
+    uint8_t flush();
+
+    /** pending() — Changes are waiting for the debounce. */
+    bool pending() const { return _debounce.pending(); }
+
+    /** commits()/changedLast()/changedTotal() — Blob writes, settings changed in the last one and in all. */
+    uint32_t commits() const      { return _commits; }
+    uint8_t  changedLast() const  { return _changed_last; }
+    uint32_t changedTotal() const { return _changed_total; }
+
+    /** loadStatus() — How boot found the stored config: "ok", "legacy", "bad_crc", "too_new", ... */
+    const char* loadStatus() const { return _load_status; }
 
     /** loadDefaults() — Reset all values to compile-time defaults in NVS. */
     void loadDefaults();
@@ -78,17 +191,26 @@ public:
     void exportJson(JsonDocument& doc) const;
 
     /**
-     * importJson(doc) — Update config from ArduinoJson document.
-     * Used by POST /api/config. Returns false if validation fails.
+     * importJson(doc, changed) — Update config from ArduinoJson document.
+     * Used by POST /api/config. Returns false if validation fails; otherwise
+     * changed (if given) receives set()'s count of changed settings.
      */
-    bool importJson(const JsonDocument& doc);
+    bool importJson(const JsonDocument& doc, uint8_t* changed = nullptr);
 
 private:
-    Preferences  _prefs;
-    MarthaConfig _cfg;
-
-    void _load();
-    void _save();
+    Preferences        _prefs;
+    MarthaConfig       _cfg;
+    MarthaConfig       _saved;       // What NVS holds
+    SemaphoreHandle_t  _mutex = nullptr;
+    ConfigSaveDebounce _debounce;
+    bool               _blob_stale = false;   // Flash holds a corrupt blob (not a TOO_NEW one)
+    const char*        _load_status = "empty";
+    uint32_t           _commits       = 0;
+    uint8_t            _changed_last  = 0;
+    uint32_t           _changed_total = 0;
+
+    void    _loadLegacy();
+    uint8_t _write(const MarthaConfig& cfg, bool all);
 };
 
 extern ConfigStore Config;
@@ -33,6 +33,25 @@
 // RH aggregation (0=AVERAGE, 1=MIN, 2=MAX)
 #define DEFAULT_RH_AGGREGATION     0
 
+// SHT45 repeatability (0=HIGH, 1=MEDIUM, 2=LOW)
+#define DEFAULT_RH_PRECISION       0
+
+// SHT45 heater recovery window (ms) — shelf excluded from control after a pulse
+#define DEFAULT_HEATER_RECOVERY_MS 30000
+
+// AS7341 readout (0=FULL two-pass spectrum, 1=REDUCED single pass)
+#define DEFAULT_LIGHT_MODE         0
+
+// Sensor poll cadence (ms per driver)
+#define DEFAULT_POLL_CO2_MS        500
+#define DEFAULT_POLL_RH_MS         1000
+#define DEFAULT_POLL_TEMP_MS       1000
+#define DEFAULT_POLL_LIGHT_MS      10000
+#define DEFAULT_SCD30_INTERVAL_S   2
+
+// MQTT broker port (host empty = MQTT disabled)
+#define DEFAULT_MQTT_PORT          1883
+
 // NTP timezone (POSIX TZ string)
 #define DEFAULT_TIMEZONE           "UTC0"
 
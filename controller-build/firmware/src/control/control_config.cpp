@@ -0,0 +1,47 @@
+/**
+ * control_config.cpp — Control-task config snapshots.
+ */
+
+#include "control_config.h"
+
+ControlConfigBus CtrlConfig;
+
+ControlConfig controlConfigFrom(const MarthaConfig& cfg) {
+    ControlConfig c;
+    c.rh_on_pct     = cfg.rh_on_pct;
+    c.rh_hysteresis = cfg.rh_hysteresis;
+    c.co2_on_ppm    = cfg.co2_on_ppm;
+    c.co2_off_ppm   = cfg.co2_off_ppm;
+    c.water_min_mv  = cfg.adc_water_min_mv;
+    c.water_max_mv  = cfg.adc_water_max_mv;
+    c.timer         = cfg.timer;
+    return c;
+}
+
+uint8_t controlConfigDiff(const ControlConfig& a, const ControlConfig& b) {
+    uint8_t parts = 0;
+    if (a.rh_on_pct != b.rh_on_pct || a.rh_hysteresis != b.rh_hysteresis) parts |= CTRL_CFG_RH;
+    if (a.co2_on_ppm != b.co2_on_ppm || a.co2_off_ppm != b.co2_off_ppm)   parts |= CTRL_CFG_CO2;
+    if (a.water_min_mv != b.water_min_mv || a.water_max_mv != b.water_max_mv) parts |= CTRL_CFG_WATER;
+    if (a.timer.lights_on_minute  != b.timer.lights_on_minute  ||
+        a.timer.lights_off_minute != b.timer.lights_off_minute ||
+        a.timer.uvc_on_min        != b.timer.uvc_on_min        ||
+        a.timer.uvc_off_min       != b.timer.uvc_off_min) {
+        parts |= CTRL_CFG_TIMER;
+    }
+    return parts;
+}
+
+uint32_t ControlConfigBus::publish(const MarthaConfig& cfg) {
+    _slot.write(controlConfigFrom(cfg));
+    return _slot.generation();
+}
+
+uint32_t ControlConfigBus::take(ControlConfig& out) {
+    ControlConfig next;
+    uint32_t      gen = _slot.read(next);
+    if (gen == 0 || gen == _applied.load(std::memory_order_relaxed)) return 0;
+    out = next;
+    _applied.store(gen, std::memory_order_relaxed);
+    return gen;
+}
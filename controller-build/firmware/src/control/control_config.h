@@ -0,0 +1,76 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "../config/config_store.h"
+#include "../util/seqlock.h"
+
+/**
+ * control_config.h — Config snapshots handed to the control task.
+ *
+ * The settings the control task acts on (RH and CO2 thresholds, water
+ * calibration, timer schedule) are published as one immutable snapshot with
+ * a generation number. The control task takes the newest generation at the
+ * top of its loop and applies it as a unit, so a loop never runs with half
+ * of one POST and half of another, and nothing else writes loop state.
+ *
+ * Built on SeqLock: publishing fills the unpublished slot and flips the
+ * generation, taking copies without waiting. No lock on the control path.
+ * Publishers must be serialised; in practice that is setup(), then the web
+ * server task (POST /api/config).
+ *
+ * Sensor-task settings (aggregation, precision, poll periods) are not in
+ * here; SensorHub already takes those through atomics and its own SeqLock.
+ */
+
+// Defaults match MarthaConfig{}, so an untaken snapshot is still a valid one
+struct ControlConfig {
+    float       rh_on_pct     = DEFAULT_RH_ON_PCT;
+    float       rh_hysteresis = DEFAULT_RH_HYSTERESIS_PCT;
+    float       co2_on_ppm    = DEFAULT_CO2_ON_PPM;
+    float       co2_off_ppm   = DEFAULT_CO2_OFF_PPM;
+    uint32_t    water_min_mv  = DEFAULT_ADC_WATER_MIN_MV;
+    uint32_t    water_max_mv  = DEFAULT_ADC_WATER_MAX_MV;
+    TimerConfig timer;
+};
+
+/** Parts of a ControlConfig that differ between two snapshots (bit mask). */
+enum CtrlCfgPart : uint8_t {
+    CTRL_CFG_RH    = 1 << 0,
+    CTRL_CFG_CO2   = 1 << 1,
+    CTRL_CFG_WATER = 1 << 2,
+    CTRL_CFG_TIMER = 1 << 3,
+    CTRL_CFG_ALL   = 0x0F,
+};
+
+/** controlConfigFrom(cfg) — The control task's share of a MarthaConfig. */
+ControlConfig controlConfigFrom(const MarthaConfig& cfg);
+
+/** controlConfigDiff(a, b) — CtrlCfgPart bits for the parts that differ. */
+uint8_t controlConfigDiff(const ControlConfig& a, const ControlConfig& b);
+
+class ControlConfigBus {
+public:
+    ControlConfigBus() = default;
+
+    /** publish(cfg) — Post a new snapshot. Returns its generation. Serialised callers only. */
+    uint32_t publish(const MarthaConfig& cfg);
+
+    /**
+     * take(out) — Control task: copy the newest snapshot if its generation
+     * is newer than the last one taken. Returns that generation, or 0 (out
+     * untouched) if there is nothing new. Never blocks.
+     */
+    uint32_t take(ControlConfig& out);
+
+    /** published() — Latest generation posted (0 = none). */
+    uint32_t published() const { return _slot.generation(); }
+
+    /** applied() — Latest generation the control task has taken. */
+    uint32_t applied() const { return _applied.load(std::memory_order_relaxed); }
+
+private:
+    SeqLock<ControlConfig> _slot;
+    std::atomic<uint32_t>  _applied{0};
+};
+
+extern ControlConfigBus CtrlConfig;
@@ -0,0 +1,90 @@
+/**
+ * control_timing.cpp — Control task deadline schedule and timing histograms.
+ */
+
+#include "control_timing.h"
+#include "../util/logger.h"
+
+ControlTiming CtrlTiming;
+
+static void storeMax(std::atomic<uint32_t>& slot, uint32_t v) {
+    if (v > slot.load(std::memory_order_relaxed)) slot.store(v, std::memory_order_relaxed);
+}
+
+void ControlTiming::start(uint32_t now_us) {
+    _deadline_us  = now_us;
+    _warn_last_us = now_us;
+}
+
+uint32_t ControlTiming::usUntilDue(uint32_t now_us) const {
+    int32_t left = static_cast<int32_t>(_deadline_us - now_us);
+    return left > 0 ? static_cast<uint32_t>(left) : 0;
+}
+
+uint8_t ControlTiming::bucketOf(uint32_t us) {
+    uint8_t b = 0;
+    while (b + 1 < BUCKETS && us >= bucketFloorUs(b + 1)) b++;
+    return b;
+}
+
+void ControlTiming::beginTick(uint32_t now_us) {
+    int32_t  late   = static_cast<int32_t>(now_us - _deadline_us);
+    uint32_t jitter = late > 0 ? static_cast<uint32_t>(late) : 0;
+    _jitter_hist[bucketOf(jitter)].fetch_add(1, std::memory_order_relaxed);
+    storeMax(_jitter_max_us, jitter);
+
+    // Whole periods already gone by are dropped, not run back to back
+    uint32_t missed = jitter / _period_us;
+    if (missed > 0) {
+        _skipped.fetch_add(missed, std::memory_order_relaxed);
+        _warn_pending += missed;
+    }
+    _deadline_us  += (missed + 1) * _period_us;
+    _tick_start_us = now_us;
+}
+
+bool ControlTiming::endTick(uint32_t now_us) {
+    uint32_t exec = now_us - _tick_start_us;
+    _exec_hist[bucketOf(exec)].fetch_add(1, std::memory_order_relaxed);
+    _exec_last_us.store(exec, std::memory_order_relaxed);
+    storeMax(_exec_max_us, exec);
+    _ticks.fetch_add(1, std::memory_order_relaxed);
+
+    bool overrun = due(now_us);
+    if (overrun) {
+        _overruns.fetch_add(1, std::memory_order_relaxed);
+        _warn_pending++;
+    }
+    _maybeWarn(now_us);
+    return overrun;
+}
+
+void ControlTiming::_maybeWarn(uint32_t now_us) {
+    if (_warn_pending == 0) return;
+    // The first warning goes out immediately; later ones summarise an interval
+    if (_warnings > 0 &&
+        (now_us - _warn_last_us) < CONTROL_OVERRUN_LOG_INTERVAL_MS * 1000UL) {
+        return;
+    }
+    Log.warn("ctrl", "%u missed deadline(s) since last report (period %u us, last exec %u us, max exec %u us)",
+             static_cast<unsigned>(_warn_pending), static_cast<unsigned>(_period_us),
+             static_cast<unsigned>(lastExecUs()), static_cast<unsigned>(maxExecUs()));
+    _warn_pending = 0;
+    _warn_last_us = now_us;
+    _warnings++;
+}
+
+void ControlTiming::reset() {
+    _ticks.store(0, std::memory_order_relaxed);
+    _overruns.store(0, std::memory_order_relaxed);
+    _skipped.store(0, std::memory_order_relaxed);
+    _exec_last_us.store(0, std::memory_order_relaxed);
+    _exec_max_us.store(0, std::memory_order_relaxed);
+    _jitter_max_us.store(0, std::memory_order_relaxed);
+    for (uint8_t b = 0; b < BUCKETS; ++b) {
+        _exec_hist[b].store(0, std::memory_order_relaxed);
+        _jitter_hist[b].store(0, std::memory_order_relaxed);
+    }
+    _warn_pending = 0;
+    _warnings     = 0;
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "../../include/config.h"
+
+/**
+ * control_timing.h — Absolute-deadline schedule and tick timing stats for
+ * the control task.
+ *
+ * Periodic ticks run against fixed deadlines (start + n·period, the way
+ * vTaskDelayUntil works), so the tick's own cost never stretches the period.
+ * Each tick records into power-of-two histograms:
+ *   - jitter: how late the tick started relative to its deadline
+ *   - exec:   how long the tick ran
+ *
+ * A tick still running at the next deadline is an overrun. If the task was
+ * held up past a whole period, the missed deadlines are skipped (and counted)
+ * rather than run back to back; the schedule keeps its original phase.
+ * Overruns are logged as a WARN, at most once per
+ * CONTROL_OVERRUN_LOG_INTERVAL_MS, with the count since the previous warning.
+ *
+ * Times are µs on a free-running 32-bit clock (micros() on device); every
+ * comparison is wrap-safe. Written by the control task, read by the web
+ * task — counters are relaxed atomics.
+ */
+
+class ControlTiming {
+public:
+    static constexpr uint8_t BUCKETS = CONTROL_TIMING_BUCKETS;
+
+    explicit ControlTiming(uint32_t period_us = CONTROL_TASK_PERIOD_MS * 1000UL)
+        : _period_us(period_us) {}
+
+    /** start(now) — Arm the schedule; the first deadline is now. */
+    void start(uint32_t now_us);
+
+    /** due(now) — True once the current deadline has been reached. */
+    bool due(uint32_t now_us) const { return static_cast<int32_t>(now_us - _deadline_us) >= 0; }
+
+    /** usUntilDue(now) — Time left to the current deadline; 0 if already due. */
+    uint32_t usUntilDue(uint32_t now_us) const;
+
+    /**
+     * beginTick(now) — Start a periodic tick (call once due()). Records the
+     * wake-up jitter and advances the deadline by one period, or past any
+     * deadlines already missed.
+     */
+    void beginTick(uint32_t now_us);
+
+    /** endTick(now) — Finish the tick. Records exec time; true if it overran the next deadline. */
+    bool endTick(uint32_t now_us);
+
+    uint32_t periodUs() const { return _period_us; }
+
+    /** ticks() — Periodic ticks completed. */
+    uint32_t ticks() const       { return _ticks.load(std::memory_order_relaxed); }
+    /** overruns() — Ticks that ended after the following deadline. */
+    uint32_t overruns() const    { return _overruns.load(std::memory_order_relaxed); }
+    /** skipped() — Deadlines dropped because the task was a whole period (or more) late. */
+    uint32_t skipped() const     { return _skipped.load(std::memory_order_relaxed); }
+    uint32_t lastExecUs() const  { return _exec_last_us.load(std::memory_order_relaxed); }
+    uint32_t maxExecUs() const   { return _exec_max_us.load(std::memory_order_relaxed); }
+    uint32_t maxJitterUs() const { return _jitter_max_us.load(std::memory_order_relaxed); }
+
+    /** execHist(b)/jitterHist(b) — Tick count in histogram bucket b. */
+    uint32_t execHist(uint8_t b) const   { return b < BUCKETS ? _exec_hist[b].load(std::memory_order_relaxed) : 0; }
+    uint32_t jitterHist(uint8_t b) const { return b < BUCKETS ? _jitter_hist[b].load(std::memory_order_relaxed) : 0; }
+
+    /** overrunWarnings() — Rate-limited overrun warnings logged so far. */
+    uint32_t overrunWarnings() const { return _warnings; }
+
+    /**
+     * bucketFloorUs(b) — Lower bound of bucket b: 0, then
+     * CONTROL_TIMING_BUCKET0_US·2^(b−1). The last bucket is open-ended.
+     */
+    static constexpr uint32_t bucketFloorUs(uint8_t b) {
+        return b == 0 ? 0 : static_cast<uint32_t>(CONTROL_TIMING_BUCKET0_US) << (b - 1);
+    }
+
+    /** bucketOf(us) — Histogram bucket holding a duration. */
+    static uint8_t bucketOf(uint32_t us);
+
+    /** reset() — Clear all stats. Leaves the schedule running. */
+    void reset();
+
+private:
+    void _maybeWarn(uint32_t now_us);
+
+    uint32_t _period_us;
+    uint32_t _deadline_us   = 0;  // Next deadline (control task only)
+    uint32_t _tick_start_us = 0;
+
+    std::atomic<uint32_t> _ticks{0};
+    std::atomic<uint32_t> _overruns{0};
+    std::atomic<uint32_t> _skipped{0};
+    std::atomic<uint32_t> _exec_last_us{0};
+    std::atomic<uint32_t> _exec_max_us{0};
+    std::atomic<uint32_t> _jitter_max_us{0};
+    std::atomic<uint32_t> _exec_hist[BUCKETS]   = {};
+    std::atomic<uint32_t> _jitter_hist[BUCKETS] = {};
+
+    // Rate-limited overrun warning (control task only)
+    uint32_t _warn_pending = 0;      // Overruns + skips since the last warning
+    uint32_t _warn_last_us = 0;
+    uint32_t _warnings     = 0;
+};
+
+extern ControlTiming CtrlTiming;
@@ -7,10 +7,11 @@ void HumidityLoop::tick(const SensorSnapshot& snapshot,
     // Use the pre-aggregated RH value from SensorHub
     float rh = snapshot.rh_aggregate_pct;
 
-    // Check if any RH sensor is valid
+    // Check if any RH sensor is valid (and not skewed by its heater —
+    // those are already left out of the aggregate)
     bool any_valid = false;
     for (int i = 0; i < 3; ++i) {
-        if (snapshot.rh[i].valid) { any_valid = true; break; }
+        if (snapshot.rh[i].valid && !snapshot.rh[i].heater_blackout) { any_valid = true; break; }
     }
     if (!any_valid) {
         // No valid sensor data — fail safe: leave fogger in current state
@@ -6,13 +6,13 @@
  *   2. RelayManager::begin() — all relays OFF, boot lock starts
  *   3. I2C + 1-Wire bus init
  *   4. SensorHub::begin() — creates sensor polling FreeRTOS task
- *   5. NVS ConfigStore::begin() — loads persisted config
+ *   5. NVS ConfigStore::begin() — loads persisted config, published to CtrlConfig
  *   6. WiFi connect (STA) or AP fallback
  *   7. mDNS + NTP
- *   8. WebServer + WebSocket + OTA init
+ *   8. MQTT + WebServer + WebSocket + OTA init
  *   9. Hardware watchdog init
  *  10. Control FreeRTOS task started
- *  11. loop() feeds watchdog + RelayManager::tick()
+ *  11. loop() writes debounced config changes to NVS
  */
 
 #include <Arduino.h>
@@ -27,14 +27,19 @@
 #include "util/logger.h"
 #include "relay/relay_manager.h"
 #include "relay/relay_channel.h"
+#include "relay/relay_command.h"
 #include "sensors/sensor_hub.h"
 #include "sensors/water_level.h"
 #include "control/humidity_loop.h"
 #include "control/co2_loop.h"
 #include "control/timer_scheduler.h"
+#include "control/control_timing.h"
+#include "control/control_config.h"
 #include "config/config_store.h"
 #include "web/web_server.h"
-#include "web/ws_broadcaster.h"
+#include "web/publisher.h"
+#include "web/history.h"
+#include "mqtt/mqtt_bridge.h"
 
 // ── Module-level instances ────────────────────────────────────────────────────
 RelayManager  Relay;
@@ -46,48 +51,110 @@ Co2Loop       CO2Loop;
 TimerScheduler Scheduler;
 
 // ── Control task ──────────────────────────────────────────────────────────────
+
+/** applyControlConfig(cfg, parts) — Push the given parts of a snapshot into the loops. Control task only. */
+static void applyControlConfig(const ControlConfig& cfg, uint8_t parts) {
+    if (parts & CTRL_CFG_RH)    HumLoop.setThresholds(cfg.rh_on_pct, cfg.rh_hysteresis);
+    if (parts & CTRL_CFG_CO2)   CO2Loop.setThresholds(cfg.co2_on_ppm, cfg.co2_off_ppm);
+    if (parts & CTRL_CFG_WATER) WaterLevelSensor.setCalibration(cfg.water_min_mv, cfg.water_max_mv);
+    if (parts & CTRL_CFG_TIMER) Scheduler.setConfig(cfg.timer);
+}
+
+// Wakes on whichever comes first: a new sensor snapshot (NOTIFY_SENSOR_DATA
+// from SensorHub) or the CONTROL_TASK_PERIOD_MS deadline. New data runs the
+// RH/CO2 loops straight away; the deadline also runs the housekeeping (watchdog,
+// relay state machine, pump, timers) and re-evaluates the loops so their
+// time-based rules (cooldown, minimum run) still fire with no new data.
+// Outbound traffic is only posted to the publisher task (see publisher.h).
+// API relay actions arrive as RelayCmds (see relay_command.h) and are applied
+// here too, making this task the only writer of relay state; NOTIFY_RELAY_CMD
+// wakes it for them.
+// Config changes arrive as CtrlConfig snapshots (see control_config.h), taken
+// at the top of each pass so every pass runs on exactly one generation; only
+// the parts that changed are applied (a threshold edit doesn't restart UVC).
+// Deadlines are absolute (CtrlTiming), so tick cost doesn't stretch the period;
+// each periodic tick's jitter and run time land in CtrlTiming's histograms.
 static void controlTask(void* /*arg*/) {
     esp_task_wdt_add(nullptr);  // Register this task with the hardware watchdog
+    Sensors.notifyTask(xTaskGetCurrentTaskHandle());
+    RelayCmds.notifyTask(xTaskGetCurrentTaskHandle());
+
+    ControlConfig ctrl_cfg;                     // Defaults unless setup() published
+    CtrlConfig.take(ctrl_cfg);                  // Leaves ctrl_cfg alone if it didn't
+    applyControlConfig(ctrl_cfg, CTRL_CFG_ALL);
+
+    uint32_t last_gen = 0;
+    CtrlTiming.start(micros());  // Periodic ticks at fixed deadlines from here
 
     for (;;) {
-        uint32_t now = millis();
+        // Newest config snapshot, if one was published since the last pass
+        ControlConfig next;
+        if (CtrlConfig.take(next)) {
+            applyControlConfig(next, controlConfigDiff(ctrl_cfg, next));
+            ctrl_cfg = next;
+        }
 
-        // Feed watchdog
-        esp_task_wdt_reset();
+        // Relay commands from the API, in submission order
+        bool commanded = RelayCmds.drain(Relay, millis()) > 0;
 
-        // Advance relay manager state machine (BOOT_LOCKED → ARMED)
-        Relay.tick();
+        uint32_t now      = millis();
+        bool     periodic = CtrlTiming.due(micros());
+        if (periodic) {
+            CtrlTiming.beginTick(micros());
+
+            // Feed watchdog
+            esp_task_wdt_reset();
+
+            // Advance relay manager state machine (BOOT_LOCKED → ARMED)
+            Relay.tick();
+        }
 
         // Read sensor snapshot
-        SensorSnapshot snap;
-        if (Sensors.read(snap)) {
+        SensorSnapshot snap = {};
+        uint32_t gen = Sensors.readGen(snap);
+        bool     ran = gen != 0 && (periodic || gen != last_gen);
+        if (ran) {
             HumLoop.tick(snap, Relay, now);
             CO2Loop.tick(snap, Relay, now);
+            last_gen = gen;
         }
 
-        // Pump control
-        WaterLevelSensor.tick();
-        if (WaterLevelSensor.isValid()) {
-            if (WaterLevelSensor.isBelowThreshold()) {
-                Relay.set(RelayChannel::PUMP, true, RelaySource::PUMP_CTRL);
-            } else if (WaterLevelSensor.isAboveThreshold()) {
-                Relay.set(RelayChannel::PUMP, false, RelaySource::PUMP_CTRL);
+        if (periodic) {
+            // Pump control
+            WaterLevelSensor.tick();
+            if (WaterLevelSensor.isValid()) {
+                if (WaterLevelSensor.isBelowThreshold()) {
+                    Relay.set(RelayChannel::PUMP, true, RelaySource::PUMP_CTRL);
+                } else if (WaterLevelSensor.isAboveThreshold()) {
+                    Relay.set(RelayChannel::PUMP, false, RelaySource::PUMP_CTRL);
+                }
             }
+
+            // Timer-based channels (UVC, Lights)
+            Scheduler.tick(Relay, now);
         }
 
-        // Timer-based channels (UVC, Lights)
-        Scheduler.tick(Relay, now);
+        // Hand the snapshot and resulting relay state to the publisher task
+        // (WebSocket etc.) — a mailbox write, no serialisation or network I/O here.
+        // An API relay command goes out at once, not at the next periodic tick.
+        if (ran || periodic || commanded) {
+            Publish.post(makePublishFrame(snap, gen, Relay, now));
+        }
 
-        // WebSocket broadcast — reuse the same snapshot for consistency
-        WsBroadcast.tick(snap, Relay, now);
+        if (periodic) CtrlTiming.endTick(micros());
 
-        vTaskDelay(pdMS_TO_TICKS(CONTROL_TASK_PERIOD_MS));
+        // Sleep until new data or the next deadline. Rounded up to whole ms so
+        // the wait never ends before the deadline it is waiting for.
+        uint32_t wait_us = CtrlTiming.usUntilDue(micros());
+        if (wait_us > 0) {
+            xTaskNotifyWait(0, NOTIFY_SENSOR_DATA | NOTIFY_RELAY_CMD, nullptr, pdMS_TO_TICKS((wait_us + 999) / 1000));
+        }
     }
 }
 
 // ── WiFi connect helper ───────────────────────────────────────────────────────
 static void wifiConnect() {
-    const MarthaConfig& cfg = Config.get();
+    const MarthaConfig cfg = Config.get();
 
     if (cfg.wifi_ssid[0] == '\0') {
         Log.warn("wifi", "No SSID configured; starting AP mode");
@@ -139,16 +206,17 @@ void setup() {
     // 4. NVS config
     Config.begin();
 
-    // 5. Apply loaded config to control loops
-    const MarthaConfig& cfg = Config.get();
-    HumLoop.setThresholds(cfg.rh_on_pct, cfg.rh_hysteresis);
-    CO2Loop.setThresholds(cfg.co2_on_ppm, cfg.co2_off_ppm);
-    WaterLevelSensor.setCalibration(cfg.adc_water_min_mv, cfg.adc_water_max_mv);
-    Scheduler.setConfig(cfg.timer);
+    // 5. Publish loaded config for the control task (applied when it starts)
+    const MarthaConfig cfg = Config.get();
+    CtrlConfig.publish(cfg);
     Log.setLevel(static_cast<LogLevel>(cfg.log_level));
 
     // 6. Sensor hub (starts FreeRTOS polling task)
     Sensors.setRhAggregation(static_cast<RhAggregation>(cfg.rh_aggregation));
+    Sensors.setRhPrecision(static_cast<ShtPrecision>(cfg.rh_precision));
+    Sensors.setHeaterRecovery(cfg.rh_heater_recovery_ms);
+    Sensors.setLightMode(static_cast<LightMode>(cfg.light_mode));
+    Sensors.setPollConfig(cfg.poll);
     Sensors.begin();
 
     // 7. WiFi
@@ -163,7 +231,10 @@ void setup() {
     // 9. NTP
     Scheduler.begin(cfg.timezone);
 
-    // 10. Web server + WebSocket + OTA
+    // 10. Publisher task + history + MQTT + web server + WebSocket + OTA
+    Publish.begin();
+    SensorHistory.begin();
+    Mqtt.begin(cfg);
     webServerBegin();
 
     // 11. Hardware watchdog (30s timeout, panic on trigger)
@@ -195,5 +266,7 @@ void loop() {
 #ifndef NATIVE_TEST
     // ElegantOTA.loop() if using legacy (non-async) mode — check library version
 #endif
+    // Debounced NVS write of config changed via the API (off the async_tcp task)
+    Config.service(millis());
     delay(10);
 }
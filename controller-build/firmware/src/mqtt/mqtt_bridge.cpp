@@ -0,0 +1,452 @@
+/**
+ * mqtt_bridge.cpp — MQTT state/relay publishing, HA discovery and the
+ * offline replay ring.
+ */
+
+#include "mqtt_bridge.h"
+#include <cctype>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+// ── Entities ──────────────────────────────────────────────────────────────────
+
+struct SensorEntity {
+    const char* name;
+    const char* unit;
+    const char* dev_cla;   // nullptr = none
+};
+
+static const SensorEntity SENSOR_ENTITIES[HS_COUNT] = {
+    {"CO2",                   "ppm", "carbon_dioxide"},
+    {"Humidity",              "%",   "humidity"},
+    {"Shelf 1 humidity",      "%",   "humidity"},
+    {"Shelf 2 humidity",      "%",   "humidity"},
+    {"Shelf 3 humidity",      "%",   "humidity"},
+    {"Shelf 1 temperature",   "°C",  "temperature"},
+    {"Shelf 2 temperature",   "°C",  "temperature"},
+    {"Shelf 3 temperature",   "°C",  "temperature"},
+    {"Substrate 1 temperature", "°C", "temperature"},
+    {"Substrate 2 temperature", "°C", "temperature"},
+    {"Substrate 3 temperature", "°C", "temperature"},
+    {"Substrate 4 temperature", "°C", "temperature"},
+    {"Substrate 5 temperature", "°C", "temperature"},
+    {"Water level",           "%",   nullptr},
+};
+
+/** relayKey(ch, out) — JSON key for a relay: its name in lower case ("tubfan"). */
+static void relayKey(uint8_t ch, char (&out)[16]) {
+    const char* name = RELAY_CHANNEL_NAMES[ch];
+    size_t      i    = 0;
+    for (; name[i] && i < sizeof(out) - 1; ++i) {
+        out[i] = static_cast<char>(tolower(static_cast<unsigned char>(name[i])));
+    }
+    out[i] = '\0';
+}
+
+/** put(p, end, fmt, ...) — snprintf at p, clamped to end. */
+static char* put(char* p, char* end, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+static char* put(char* p, char* end, const char* fmt, ...) {
+    va_list a;
+    va_start(a, fmt);
+    int n = vsnprintf(p, end - p, fmt, a);
+    va_end(a);
+    return n > 0 && p + n < end ? p + n : end;
+}
+
+// ── MqttBridgeCore ────────────────────────────────────────────────────────────
+
+void MqttBridgeCore::setNode(const char* node) {
+    strncpy(_node, node, sizeof(_node) - 1);
+    _node[sizeof(_node) - 1] = '\0';
+}
+
+void MqttBridgeCore::handle(const PublishFrame& frame) {
+    if (frame.gen == 0) return;  // No snapshot yet
+
+    if (!_clock_started) {
+        _clock_started = true;
+        _up_ms         = frame.ts_ms;
+        _clock_ms      = frame.ts_ms;
+    } else {
+        int32_t dt = static_cast<int32_t>(frame.ts_ms - _clock_ms);
+        if (dt > 0) {
+            _up_ms   += static_cast<uint32_t>(dt);
+            _clock_ms = frame.ts_ms;
+        }
+    }
+
+    uint8_t flags = (frame.armed ? MQTT_FLAG_ARMED : 0) |
+                    (frame.manual_mode ? MQTT_FLAG_MANUAL : 0);
+    bool relays = !_have_last || frame.relay_mask != _last.relay_mask || flags != _last.flags;
+    bool state  = frame.gen != _gen &&
+                  (!_have_last || frame.ts_ms - _state_ms >= MQTT_STATE_PERIOD_MS);
+    if (!relays && !state) return;
+
+    HistorySample h = historySample(frame.snap, static_cast<uint32_t>(_up_ms / 1000));
+    MqttSample    s;
+    s.t = h.t;
+    memcpy(s.v, h.v, sizeof(s.v));
+    s.relay_mask = frame.relay_mask;
+    s.flags      = flags;
+
+    if (state) {
+        _gen      = frame.gen;
+        _state_ms = frame.ts_ms;
+    }
+    _last      = s;
+    _have_last = true;
+
+    if (_online && !_port.connected()) _offline();
+    if (!_online) {
+        _enqueue(s);
+        return;
+    }
+
+    bool ok = true;
+    if (relays)      ok = _publishRelays(s);
+    if (ok && state) ok = _publishState(s);
+    if (ok)          ok = _flush();
+    if (!ok) {
+        _offline();
+        _enqueue(s);
+    }
+}
+
+void MqttBridgeCore::service(uint32_t now_ms) {
+    if (_online && !_port.connected()) _offline();
+
+    if (!_online) {
+        if (_attempted && now_ms - _attempt_ms < _backoff_ms) return;
+        bool retry  = _attempted;
+        _attempted  = true;
+        _attempt_ms = now_ms;
+
+        snprintf(_topic, sizeof(_topic), "%s/%s/status", MQTT_TOPIC_ROOT, _node);
+        if (!_port.connect(_node, _topic, "offline")) {
+            if (retry) {
+                _backoff_ms = _backoff_ms * 2 > MQTT_RECONNECT_MAX_MS ? MQTT_RECONNECT_MAX_MS
+                                                                      : _backoff_ms * 2;
+            }
+            return;
+        }
+        _online     = true;
+        _backoff_ms = MQTT_RECONNECT_MIN_MS;
+        _connects++;
+        _announce();
+        if (!_online) return;
+    }
+
+    if (_q_len) _replay();
+    if (_online) _port.poll();
+}
+
+void MqttBridgeCore::_announce() {
+    bool ok = true;
+    for (uint8_t e = 0; ok && e < MQTT_ENTITY_COUNT; ++e) {
+        _formatDiscovery(e);   // Sets _topic itself
+        ok = _port.publish(_topic, _payload, true);
+        if (ok) _published++;
+    }
+    if (ok) {
+        snprintf(_payload, sizeof(_payload), "online");
+        ok = _publish("status", true);
+    }
+    if (ok && _have_last) ok = _publishRelays(_last) && _publishState(_last);
+    if (ok) ok = _flush();
+    if (!ok) _offline();
+}
+
+bool MqttBridgeCore::_publishState(const MqttSample& s) {
+    _formatSample(s, false);
+    return _publish("state", true);
+}
+
+bool MqttBridgeCore::_publishRelays(const MqttSample& s) {
+    _formatRelays(s);
+    return _publish("relays", true);
+}
+
+bool MqttBridgeCore::_publish(const char* suffix, bool retain) {
+    snprintf(_topic, sizeof(_topic), "%s/%s/%s", MQTT_TOPIC_ROOT, _node, suffix);
+    if (!_port.publish(_topic, _payload, retain)) return false;
+    _published++;
+    return true;
+}
+
+bool MqttBridgeCore::_flush() {
+    if (!_port.flush()) return false;
+    _flushes++;
+    return true;
+}
+
+void MqttBridgeCore::_offline() {
+    _online     = false;
+    _attempted  = false;   // Retry straight away; backoff starts if that fails
+    _backoff_ms = MQTT_RECONNECT_MIN_MS;
+}
+
+void MqttBridgeCore::_enqueue(const MqttSample& s) {
+    if (_q_len == MQTT_QUEUE_DEPTH) {
+        _q_head = static_cast<uint16_t>((_q_head + 1) % MQTT_QUEUE_DEPTH);
+        _q_len--;
+        _dropped++;
+    }
+    _queue[(_q_head + _q_len) % MQTT_QUEUE_DEPTH] = s;
+    _q_len++;
+}
+
+void MqttBridgeCore::_replay() {
+    uint16_t len = _q_len;
+    uint16_t n   = len < MQTT_REPLAY_BATCH ? len : MQTT_REPLAY_BATCH;
+    for (uint16_t i = 0; i < n; ++i) {
+        _formatSample(_queue[(_q_head + i) % MQTT_QUEUE_DEPTH], true);
+        if (!_publish("replay", false)) {
+            _offline();
+            return;
+        }
+    }
+    if (!_flush()) {
+        _offline();   // Unconfirmed; the slice is sent again after reconnecting
+        return;
+    }
+    _q_head    = static_cast<uint16_t>((_q_head + n) % MQTT_QUEUE_DEPTH);
+    _q_len    -= n;
+    _replayed += n;
+}
+
+// ── Payloads ──────────────────────────────────────────────────────────────────
+
+void MqttBridgeCore::_formatSample(const MqttSample& s, bool replay) {
+    char* p   = _payload;
+    char* end = _payload + sizeof(_payload);
+    p = put(p, end, "{\"t\":%lu", static_cast<unsigned long>(s.t));
+    for (uint8_t i = 0; i < HS_COUNT; ++i) {
+        p = put(p, end, ",\"%s\":", historySeriesName(i));
+        p = historyPutValue(p, end, s.v[i], i);
+    }
+    if (replay) {
+        p = put(p, end, ",\"relays\":%u,\"armed\":%u,\"manual\":%u", s.relay_mask,
+                (s.flags & MQTT_FLAG_ARMED) ? 1u : 0u, (s.flags & MQTT_FLAG_MANUAL) ? 1u : 0u);
+    }
+    put(p, end, "}");
+}
+
+void MqttBridgeCore::_formatRelays(const MqttSample& s) {
+    char* p   = _payload;
+    char* end = _payload + sizeof(_payload);
+    char  key[16];
+    for (uint8_t ch = 0; ch < RELAY_CHANNEL_COUNT; ++ch) {
+        relayKey(ch, key);
+        p = put(p, end, "%s\"%s\":%u", ch ? "," : "{", key, (s.relay_mask >> ch) & 1u);
+    }
+    put(p, end, ",\"armed\":%u,\"manual\":%u}",
+        (s.flags & MQTT_FLAG_ARMED) ? 1u : 0u, (s.flags & MQTT_FLAG_MANUAL) ? 1u : 0u);
+}
+
+void MqttBridgeCore::_formatDiscovery(uint8_t entity) {
+    char* p   = _payload;
+    char* end = _payload + sizeof(_payload);
+    char  key[16];
+
+    if (entity < HS_COUNT) {
+        const SensorEntity& e = SENSOR_ENTITIES[entity];
+        const char*         k = historySeriesName(entity);
+        snprintf(_topic, sizeof(_topic), "%s/sensor/%s/%s/config", MQTT_DISCOVERY_PREFIX, _node, k);
+        p = put(p, end,
+                "{\"name\":\"%s\",\"uniq_id\":\"%s_%s\",\"~\":\"%s/%s\",\"stat_t\":\"~/state\","
+                "\"val_tpl\":\"{{value_json.%s}}\",\"unit_of_meas\":\"%s\",\"stat_cla\":\"measurement\"",
+                e.name, _node, k, MQTT_TOPIC_ROOT, _node, k, e.unit);
+        if (e.dev_cla) p = put(p, end, ",\"dev_cla\":\"%s\"", e.dev_cla);
+    } else {
+        uint8_t     b = entity - HS_COUNT;
+        const char* name;
+        if (b < RELAY_CHANNEL_COUNT) {
+            relayKey(b, key);
+            name = RELAY_CHANNEL_NAMES[b];
+        } else if (b == RELAY_CHANNEL_COUNT) {
+            strcpy(key, "armed");
+            name = "Relays armed";
+        } else {
+            strcpy(key, "manual");
+            name = "Manual mode";
+        }
+        snprintf(_topic, sizeof(_topic), "%s/binary_sensor/%s/%s/config",
+                 MQTT_DISCOVERY_PREFIX, _node, key);
+        p = put(p, end,
+                "{\"name\":\"%s\",\"uniq_id\":\"%s_%s\",\"~\":\"%s/%s\",\"stat_t\":\"~/relays\","
+                "\"val_tpl\":\"{{value_json.%s}}\",\"pl_on\":\"1\",\"pl_off\":\"0\"",
+                name, _node, key, MQTT_TOPIC_ROOT, _node, key);
+    }
+    put(p, end,
+        ",\"avty_t\":\"~/status\",\"dev\":{\"ids\":[\"%s\"],\"name\":\"Martha %s\","
+        "\"mf\":\"martha-tek\",\"mdl\":\"Martha tent controller\",\"sw\":\"%s\"}}",
+        _node, _node, MARTHA_FW_VERSION);
+}
+
+// ── Hardware binding ──────────────────────────────────────────────────────────
+
+#ifndef NATIVE_TEST
+#include <Arduino.h>
+#include <WiFi.h>
+#include <PubSubClient.h>
+#include "../util/logger.h"
+
+/**
+ * BatchClient — WiFiClient wrapper that coalesces PubSubClient's writes
+ * until flush(), so a frame's publishes leave in one TCP write instead of
+ * one per message. Anything PubSubClient then waits to read (CONNACK)
+ * sends the pending bytes first.
+ */
+class BatchClient : public Client {
+public:
+    int connect(IPAddress ip, uint16_t port) override {
+        _len = 0;
+        return _net.connect(ip, port, MQTT_CONNECT_TIMEOUT_MS);
+    }
+    int connect(const char* host, uint16_t port) override {
+        _len = 0;
+        return _net.connect(host, port, MQTT_CONNECT_TIMEOUT_MS);
+    }
+    int connect(IPAddress ip, uint16_t port, int32_t timeout) { return _net.connect(ip, port, timeout); }
+    int connect(const char* host, uint16_t port, int32_t timeout) { return _net.connect(host, port, timeout); }
+
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    size_t write(const uint8_t* buf, size_t size) override {
+        if (_len + size > sizeof(_buf) && !_send()) return 0;
+        if (size > sizeof(_buf)) return _net.write(buf, size);
+        memcpy(_buf + _len, buf, size);
+        _len += size;
+        return size;
+    }
+
+    int available() override { _send(); return _net.available(); }
+    int read() override { return _net.read(); }
+    int read(uint8_t* buf, size_t size) override { return _net.read(buf, size); }
+    int peek() override { return _net.peek(); }
+
+    /** flush() — Send the batch (not the Arduino "wait for TX" meaning). */
+    void flush() override { _send(); }
+
+    void stop() override {
+        _len = 0;
+        _net.stop();
+    }
+    uint8_t connected() override { return _net.connected(); }
+    operator bool() override { return static_cast<bool>(_net); }
+
+    /** sent() — Whether the last flush went out whole. */
+    bool sent() const { return _ok; }
+
+private:
+    bool _send() {
+        if (_len) {
+            _ok  = _net.write(_buf, _len) == _len;
+            _len = 0;
+        }
+        return _ok;
+    }
+
+    WiFiClient _net;
+    uint8_t    _buf[MQTT_BATCH_MAX];
+    size_t     _len = 0;
+    bool       _ok  = true;
+};
+
+/** PubSubPort — MqttPort over PubSubClient and a BatchClient. */
+class PubSubPort : public MqttPort {
+public:
+    PubSubPort() : _mqtt(_net) {}
+
+    void configure(const MarthaConfig& cfg) {
+        strlcpy(_host, cfg.mqtt_host, sizeof(_host));
+        strlcpy(_user, cfg.mqtt_user, sizeof(_user));
+        strlcpy(_pass, cfg.mqtt_pass, sizeof(_pass));
+        _mqtt.setServer(_host, cfg.mqtt_port);
+        _mqtt.setBufferSize(MQTT_PAYLOAD_MAX + 128);   // Room for topic + header
+        _mqtt.setKeepAlive(MQTT_KEEPALIVE_S);
+        _mqtt.setSocketTimeout((MQTT_CONNECT_TIMEOUT_MS + 999) / 1000);
+    }
+
+    bool connect(const char* client_id, const char* will_topic, const char* will_msg) override {
+        return _mqtt.connect(client_id, _user[0] ? _user : nullptr, _user[0] ? _pass : nullptr,
+                             will_topic, 0, true, will_msg);
+    }
+    bool connected() override { return _mqtt.connected(); }
+    bool publish(const char* topic, const char* payload, bool retain) override {
+        return _mqtt.publish(topic, payload, retain);
+    }
+    bool flush() override {
+        _net.flush();
+        return _net.sent() && _mqtt.connected();
+    }
+    void poll() override {
+        _mqtt.loop();
+        _net.flush();   // A PINGREQ from loop() is otherwise held in the batch
+    }
+
+private:
+    BatchClient  _net;
+    PubSubClient _mqtt;
+    char         _host[64] = {};
+    char         _user[32] = {};
+    char         _pass[64] = {};
+};
+
+static PubSubPort MqttNet;
+MqttBridge Mqtt;
+
+MqttBridge::MqttBridge() : MqttBridgeCore(MqttNet) {}
+
+void MqttBridge::begin(const MarthaConfig& cfg) {
+    if (cfg.mqtt_host[0] == '\0') {
+        Log.info("mqtt", "No broker configured; MQTT disabled");
+        return;
+    }
+
+    uint8_t mac[6];
+    WiFi.macAddress(mac);
+    char node[33];
+    snprintf(node, sizeof(node), "%s-%02x%02x%02x", MDNS_HOSTNAME, mac[3], mac[4], mac[5]);
+    setNode(node);
+    MqttNet.configure(cfg);
+
+    xTaskCreatePinnedToCore(
+        _task, "mqtt",
+        MQTT_TASK_STACK, this,
+        MQTT_TASK_PRIORITY, &_task_handle,
+        0  // Core 0 — network side, away from control
+    );
+    Publish.addSink(&MqttBridge::_sink, this);
+    Log.info("mqtt", "Publishing to %s:%u as %s/%s", cfg.mqtt_host,
+             static_cast<unsigned>(cfg.mqtt_port), MQTT_TOPIC_ROOT, node);
+}
+
+void MqttBridge::_sink(void* ctx, const PublishFrame& frame) {
+    auto* self = static_cast<MqttBridge*>(ctx);
+    self->_box.post(frame);
+    xTaskNotifyGive(self->_task_handle);
+}
+
+void MqttBridge::_task(void* arg) {
+    auto*        self = static_cast<MqttBridge*>(arg);
+    PublishFrame frame;
+    bool         was_online = false;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MQTT_SERVICE_MS));
+        if (WiFi.status() == WL_CONNECTED) self->service(millis());
+        if (self->_box.take(frame)) self->handle(frame);
+
+        if (self->online() != was_online) {
+            was_online = self->online();
+            if (was_online) {
+                Log.info("mqtt", "Connected; %lu queued samples to replay",
+                         static_cast<unsigned long>(self->queued()));
+            } else {
+                Log.warn("mqtt", "Broker connection lost; queueing samples");
+            }
+        }
+    }
+}
+
+#endif  // !NATIVE_TEST
@@ -0,0 +1,160 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "mqtt_port.h"
+#include "../web/history.h"
+#include "../web/publisher.h"
+#include "../../include/config.h"
+
+/**
+ * mqtt_bridge.h — MQTT publishing with Home Assistant discovery.
+ *
+ * Topics, all under MQTT_TOPIC_ROOT/<node>/ (e.g. martha/martha-a1b2c3/):
+ *
+ *   status   "online" / "offline" (retained; "offline" is the will)
+ *   state    {"t":7260,"co2":812,"rh":88.12,"rh1":..,"tp5":..,"wl":54.20}
+ *            retained; at most once per MQTT_STATE_PERIOD_MS, and only for
+ *            a new snapshot generation
+ *   relays   {"fogger":1,"tubfan":0,..,"armed":1,"manual":0}
+ *            retained; whenever a relay or mode changes
+ *   replay   Backlog samples, state plus "relays"/"armed"/"manual" bits,
+ *            oldest first; not retained
+ *
+ * "t" is seconds since boot and uses the same series names and units as
+ * /api/history. Missing readings are null. Everything a frame produces goes
+ * out in one flush. On every connect the bridge publishes "online", the
+ * discovery configs (MQTT_DISCOVERY_PREFIX/{sensor,binary_sensor}/<node>/
+ * <key>/config, retained) and the current state and relays.
+ *
+ * While the broker is unreachable, each sample that would have been
+ * published goes into a ring of MQTT_QUEUE_DEPTH. When the ring is full the
+ * oldest sample is dropped. After a reconnect the ring is replayed in order,
+ * MQTT_REPLAY_BATCH samples per service() call, so a long backlog never
+ * holds up live state. Reconnects back off exponentially from
+ * MQTT_RECONNECT_MIN_MS to MQTT_RECONNECT_MAX_MS.
+ *
+ * MqttBridgeCore is portable and single-threaded. The hardware MqttBridge
+ * runs it on its own task, fed from a Publisher sink. Only the stats
+ * accessors (online() through replayed()) may be called from other tasks,
+ * such as /metrics and /api/status; they read atomics.
+ */
+
+/** One queued sample: quantised values plus relay state. */
+struct MqttSample {
+    uint32_t t;             // Seconds since boot
+    int16_t  v[HS_COUNT];   // HistorySeries order, HISTORY_NONE = missing
+    uint8_t  relay_mask;
+    uint8_t  flags;         // MQTT_FLAG_*
+};
+
+inline constexpr uint8_t MQTT_FLAG_ARMED  = 1u << 0;
+inline constexpr uint8_t MQTT_FLAG_MANUAL = 1u << 1;
+
+/** Discovery configs published on connect: one per series, relay, armed and manual. */
+inline constexpr uint8_t MQTT_ENTITY_COUNT = HS_COUNT + RELAY_CHANNEL_COUNT + 2;
+
+class MqttBridgeCore {
+public:
+    explicit MqttBridgeCore(MqttPort& port) : _port(port) {}
+
+    /** setNode(node) — Node id used in topics, client id and unique_ids. Call first. */
+    void setNode(const char* node);
+
+    /**
+     * handle(frame) — Publish what this frame changes (state and/or relays)
+     * in a single flush, or queue it while offline.
+     */
+    void handle(const PublishFrame& frame);
+
+    /**
+     * service(now_ms) — Reconnect when due, replay a slice of the backlog,
+     * and keep the session alive. Call every MQTT_SERVICE_MS or so.
+     */
+    void service(uint32_t now_ms);
+
+    bool        online() const     { return _online.load(std::memory_order_relaxed); }
+    const char* node() const       { return _node; }
+    uint32_t    queued() const     { return _q_len.load(std::memory_order_relaxed); }
+    uint32_t    dropped() const    { return _dropped.load(std::memory_order_relaxed); }     // Overwritten in the ring
+    uint32_t    published() const  { return _published.load(std::memory_order_relaxed); }  // Messages handed to the port
+    uint32_t    flushes() const    { return _flushes.load(std::memory_order_relaxed); }
+    uint32_t    connects() const   { return _connects.load(std::memory_order_relaxed); }
+    uint32_t    replayed() const   { return _replayed.load(std::memory_order_relaxed); }
+
+private:
+    void _announce();
+    bool _publishState(const MqttSample& s);
+    bool _publishRelays(const MqttSample& s);
+    bool _publish(const char* suffix, bool retain);
+    bool _flush();
+    void _offline();
+    void _enqueue(const MqttSample& s);
+    void _replay();
+
+    /** _formatSample(s, replay) — state (or replay, with relay bits) JSON into _payload. */
+    void _formatSample(const MqttSample& s, bool replay);
+    void _formatRelays(const MqttSample& s);
+    void _formatDiscovery(uint8_t entity);
+
+    MqttPort& _port;
+    char      _node[33]  = {};
+    char      _topic[128] = {};
+    char      _payload[MQTT_PAYLOAD_MAX] = {};
+
+    std::atomic<bool> _online{false};   // Atomic: read by other tasks, like the stats
+    bool      _attempted   = false;
+    uint32_t  _attempt_ms  = 0;
+    uint32_t  _backoff_ms  = MQTT_RECONNECT_MIN_MS;
+
+    bool        _have_last   = false;
+    MqttSample  _last        = {};   // Latest sample, published on (re)connect
+    uint32_t    _gen         = 0;
+    uint32_t    _state_ms    = 0;    // ts_ms of the last state slot
+    bool        _clock_started = false;
+    uint32_t    _clock_ms    = 0;
+    uint64_t    _up_ms       = 0;    // Wrap-extended frame time
+
+    MqttSample _queue[MQTT_QUEUE_DEPTH] = {};
+    uint16_t   _q_head = 0;          // Oldest entry
+    std::atomic<uint16_t> _q_len{0};
+
+    std::atomic<uint32_t> _dropped{0};
+    std::atomic<uint32_t> _published{0};
+    std::atomic<uint32_t> _flushes{0};
+    std::atomic<uint32_t> _connects{0};
+    std::atomic<uint32_t> _replayed{0};
+};
+
+// ── Hardware binding ──────────────────────────────────────────────────────────
+
+#ifndef NATIVE_TEST
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "../config/config_store.h"
+#include "../util/mailbox.h"
+
+class MqttBridge : public MqttBridgeCore {
+public:
+    MqttBridge();
+
+    /**
+     * begin(cfg) — If cfg.mqtt_host is set, create the MQTT task and
+     * subscribe to Publish. Broker changes take effect on the next boot.
+     */
+    void begin(const MarthaConfig& cfg);
+
+    /** enabled() — A broker is configured and the task is running. */
+    bool enabled() const { return _task_handle != nullptr; }
+
+private:
+    static void _sink(void* ctx, const PublishFrame& frame);
+    static void _task(void* arg);
+
+    Mailbox<PublishFrame> _box;
+    TaskHandle_t          _task_handle = nullptr;
+};
+
+extern MqttBridge Mqtt;
+
+#endif  // !NATIVE_TEST
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * mqtt_port.h — Minimal MQTT session port used by MqttBridgeCore.
+ *
+ * Only what the bridge needs: one session with a retained "offline" will,
+ * QoS 0 publishes collected into a batch, and an explicit flush that puts
+ * the batch on the wire. The bridge logic can therefore run against a fake
+ * broker in native tests. The hardware implementation (PubSubClient over a
+ * coalescing WiFiClient) lives in mqtt_bridge.cpp.
+ */
+
+class MqttPort {
+public:
+    virtual ~MqttPort() = default;
+
+    /**
+     * connect(client_id, will_topic, will_msg) — Open a clean session whose
+     * will (retained) is will_msg on will_topic. Blocks for at most
+     * MQTT_CONNECT_TIMEOUT_MS; false if the broker could not be reached.
+     */
+    virtual bool connect(const char* client_id, const char* will_topic, const char* will_msg) = 0;
+
+    /** connected() — Session still up. */
+    virtual bool connected() = 0;
+
+    /**
+     * publish(topic, payload, retain) — Add a QoS 0 PUBLISH to the current
+     * batch. May send early if the batch is full; false if the session dropped.
+     */
+    virtual bool publish(const char* topic, const char* payload, bool retain) = 0;
+
+    /** flush() — Send the batch. False if the session dropped. */
+    virtual bool flush() = 0;
+
+    /** poll() — Keepalive and inbound traffic; called between batches. */
+    virtual void poll() = 0;
+};
@@ -0,0 +1,84 @@
+/**
+ * relay_command.cpp — Lock-free relay command ring and its hardware binding.
+ */
+
+#include "relay_command.h"
+
+const char* relayCmdResultName(RelayCmdResult r) {
+    switch (r) {
+        case RelayCmdResult::OK:         return "ok";
+        case RelayCmdResult::REJECTED:   return "rejected";
+        case RelayCmdResult::EXPIRED:    return "expired";
+        case RelayCmdResult::QUEUE_FULL: return "queue_full";
+        case RelayCmdResult::PENDING:    return "pending";
+        case RelayCmdResult::UNKNOWN:    return "unknown";
+    }
+    return "?";
+}
+
+uint32_t RelayCommandQueue::submit(const RelayCommand& cmd) {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    if (head - _tail.load(std::memory_order_acquire) >= DEPTH) {
+        _full.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+    _ring[head % DEPTH] = cmd;
+    _head.store(head + 1, std::memory_order_release);   // Publishes the slot
+    return head + 1;
+}
+
+RelayCmdResult RelayCommandQueue::result(uint32_t ticket) const {
+    // Ticket n is command n - 1: pending until tail passes it. Its result
+    // slot is tagged with the ticket, so a slot already reused by a later
+    // command reads as UNKNOWN rather than someone else's result.
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    if (ticket == 0 || static_cast<int32_t>(head - ticket) < 0) return RelayCmdResult::UNKNOWN;
+    if (static_cast<int32_t>(_tail.load(std::memory_order_acquire) - ticket) < 0) {
+        return RelayCmdResult::PENDING;
+    }
+    uint32_t v = _results[(ticket - 1) % DEPTH].load(std::memory_order_acquire);
+    if ((v >> 4) != (ticket & 0x0FFFFFFFu)) return RelayCmdResult::UNKNOWN;
+    return static_cast<RelayCmdResult>(v & 0x0F);
+}
+
+uint8_t RelayCommandQueue::drain(RelayManager& relay, uint32_t now_ms) {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    uint32_t head = _head.load(std::memory_order_acquire);
+    uint8_t  n    = 0;
+    for (; tail != head; ++tail) {
+        const RelayCommand& cmd = _ring[tail % DEPTH];
+        RelayCmdResult      r;
+        if (now_ms - cmd.submitted_ms >= RELAY_CMD_TIMEOUT_MS) {
+            r = RelayCmdResult::EXPIRED;
+            _expired.fetch_add(1, std::memory_order_relaxed);
+        } else if (cmd.type == RelayCmdType::MANUAL) {
+            relay.setManualMode(cmd.on);
+            r = RelayCmdResult::OK;
+        } else {
+            r = relay.set(cmd.channel, cmd.on, RelaySource::API) ? RelayCmdResult::OK
+                                                                  : RelayCmdResult::REJECTED;
+        }
+        if (r != RelayCmdResult::EXPIRED) {
+            _applied.fetch_add(1, std::memory_order_relaxed);
+            n++;
+        }
+        _results[tail % DEPTH].store(((tail + 1) << 4) | static_cast<uint32_t>(r),
+                                     std::memory_order_release);
+        _tail.store(tail + 1, std::memory_order_release);   // Publishes the result, frees the slot
+    }
+    return n;
+}
+
+// ── Hardware binding ──────────────────────────────────────────────────────────
+#ifndef NATIVE_TEST
+#include <Arduino.h>
+
+RelayCommands RelayCmds;
+
+uint32_t RelayCommands::post(RelayCommand cmd) {
+    cmd.submitted_ms = millis();
+    uint32_t ticket  = submit(cmd);
+    if (ticket != 0 && _notify) xTaskNotify(_notify, NOTIFY_RELAY_CMD, eSetBits);
+    return ticket;
+}
+#endif  // !NATIVE_TEST
@@ -0,0 +1,124 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "relay_channel.h"
+#include "relay_manager.h"
+#include "../../include/config.h"
+
+/**
+ * relay_command.h — Relay actions from other tasks, applied by the control task.
+ *
+ * The control task is the only writer of relay state. The web server task
+ * doesn't call RelayManager::set()/setManualMode(); it submits a typed
+ * RelayCommand to a bounded single-producer/single-consumer ring. The control
+ * task drains the ring at the top of every pass (it is woken by
+ * NOTIFY_RELAY_CMD, so that is within a millisecond or so) and records a
+ * result per command.
+ *
+ * Nobody waits. The HTTP handler submits and returns a chunked response
+ * whose filler reads the ticket's result, retrying on later connection polls
+ * while it is PENDING (see api.cpp). The last DEPTH results stay readable;
+ * an older ticket reads as UNKNOWN.
+ *
+ * Neither side takes a lock: the ring is two atomic counters and a slot array.
+ * The producer owns head, the consumer owns tail. A command still queued
+ * RELAY_CMD_TIMEOUT_MS after submission is dropped as EXPIRED rather than
+ * applied late, so a request that timed out never changes a relay afterwards.
+ *
+ * Single producer: all HTTP handlers run on the AsyncTCP task.
+ *
+ * Usage:
+ *   uint32_t t = RelayCmds.post(RelayCommand::set(ch, true));   // web task; 0 = full
+ *   RelayCmds.drain(Relay, millis());                           // control task
+ *   RelayCmdResult r = RelayCmds.result(t);                     // web task, later
+ */
+
+enum class RelayCmdType : uint8_t {
+    SET    = 0,   // channel, on
+    MANUAL = 1,   // on = manual mode
+};
+
+enum class RelayCmdResult : uint8_t {
+    OK         = 0,
+    REJECTED   = 1,   // Boot lock, UVC guard or manual mode
+    EXPIRED    = 2,   // Not applied within RELAY_CMD_TIMEOUT_MS; dropped
+    QUEUE_FULL = 3,   // Not queued
+    PENDING    = 4,   // Queued, not drained yet
+    UNKNOWN    = 5,   // Never issued, or too old to still be held
+};
+
+/** relayCmdResultName(r) — "ok", "rejected", ... for logs and responses. */
+const char* relayCmdResultName(RelayCmdResult r);
+
+struct RelayCommand {
+    RelayCmdType type         = RelayCmdType::SET;
+    RelayChannel channel      = RelayChannel::COUNT;
+    bool         on           = false;
+    uint32_t     submitted_ms = 0;
+
+    static RelayCommand set(RelayChannel ch, bool on) { return {RelayCmdType::SET, ch, on, 0}; }
+    static RelayCommand manual(bool on) { return {RelayCmdType::MANUAL, RelayChannel::COUNT, on, 0}; }
+};
+
+class RelayCommandQueue {
+public:
+    static constexpr uint8_t DEPTH = RELAY_CMD_QUEUE_DEPTH;
+
+    RelayCommandQueue() = default;
+
+    /** submit(cmd) — Queue cmd. Returns its ticket (never 0), or 0 if the ring is full. Producer only. */
+    uint32_t submit(const RelayCommand& cmd);
+
+    /**
+     * result(ticket) — PENDING until drained, then its result while it is
+     * among the last DEPTH drained, UNKNOWN after that. Producer task only.
+     */
+    RelayCmdResult result(uint32_t ticket) const;
+
+    /**
+     * drain(relay, now_ms) — Apply every queued command in order, dropping
+     * ones older than RELAY_CMD_TIMEOUT_MS. Returns commands applied
+     * (accepted or rejected; not expired). Consumer (control task) only.
+     */
+    uint8_t drain(RelayManager& relay, uint32_t now_ms);
+
+    /** queued() — Commands waiting for the control task. */
+    uint32_t queued() const { return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire); }
+
+    /** applied()/expired()/full() — Drained and applied, dropped as stale, refused as full. */
+    uint32_t applied() const { return _applied.load(std::memory_order_relaxed); }
+    uint32_t expired() const { return _expired.load(std::memory_order_relaxed); }
+    uint32_t full() const    { return _full.load(std::memory_order_relaxed); }
+
+private:
+    RelayCommand                _ring[DEPTH];
+    std::atomic<uint32_t>       _results[DEPTH] = {};   // ticket << 4 | result
+    std::atomic<uint32_t>       _head{0};   // Commands submitted (producer)
+    std::atomic<uint32_t>       _tail{0};   // Commands drained (consumer)
+    std::atomic<uint32_t>       _applied{0};
+    std::atomic<uint32_t>       _expired{0};
+    std::atomic<uint32_t>       _full{0};
+};
+
+// ── Hardware binding ──────────────────────────────────────────────────────────
+#ifndef NATIVE_TEST
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+class RelayCommands : public RelayCommandQueue {
+public:
+    /** notifyTask(task) — Task to wake (NOTIFY_RELAY_CMD) on submit; the control task. */
+    void notifyTask(TaskHandle_t task) { _notify = task; }
+
+    /**
+     * post(cmd) — Stamp and submit cmd, then wake the control task. Returns
+     * the ticket, or 0 if the ring is full. Never waits.
+     */
+    uint32_t post(RelayCommand cmd);
+
+private:
+    TaskHandle_t _notify = nullptr;
+};
+
+extern RelayCommands RelayCmds;
+#endif  // !NATIVE_TEST
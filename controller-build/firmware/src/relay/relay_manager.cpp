@@ -17,15 +17,9 @@ static void digitalWrite(int, int) {}
 // millis()/set_millis() provided by test_clock.cpp — single definition
 extern uint32_t millis();
 
-#define portMUX_TYPE       int
-#define portMUX_INITIALIZER_UNLOCKED 0
-#define taskENTER_CRITICAL(m) (void)(m)
-#define taskEXIT_CRITICAL(m)  (void)(m)
-
 #else
 #include <Arduino.h>
 #include <freertos/FreeRTOS.h>
-#include <freertos/semphr.h>
 #endif
 
 #include "../../include/hal.h"  // includes config.h + RELAY_PIN_TABLE
@@ -43,12 +37,6 @@ void RelayManager::begin() {
     _boot_ms = millis();
     _state   = RelayManagerState::BOOT_LOCKED;
 
-#ifndef NATIVE_TEST
-    if (!_mutex) {
-        _mutex = xSemaphoreCreateMutex();
-    }
-#endif
-
     // Drive all relay pins HIGH immediately (active-LOW = OFF).
     // This overrides any pull-up or boot-state glitch.
     for (uint8_t i = 0; i < RELAY_CHANNEL_COUNT; ++i) {
@@ -74,36 +62,38 @@ void RelayManager::tick() {
 }
 
 bool RelayManager::set(RelayChannel channel, bool on, RelaySource source) {
-    _lock();
     uint32_t now = millis();
     uint8_t  idx = static_cast<uint8_t>(channel);
 
     if (_state == RelayManagerState::BOOT_LOCKED) {
         _logChange(channel, _relay[idx], _relay[idx], RelaySource::BOOT_INIT, now);
-        _unlock();
         return false;
     }
 
     if (_state == RelayManagerState::MANUAL_MODE) {
-        _unlock();
         return false;
     }
 
     if (channel == RelayChannel::UVC && _isUvcLocked(now)) {
-        _unlock();
         return false;
     }
 
     if (_relay[idx] == on) {
-        _unlock();
         return true;
     }
 
     bool prev = _relay[idx];
+    taskENTER_CRITICAL(&_on_mux);
     _relay[idx] = on;
+    if (on) {
+        _on_since[idx] = now;
+    } else {
+        _on_ms[idx] += now - _on_since[idx];
+    }
+    taskEXIT_CRITICAL(&_on_mux);
+    if (on) _switches[idx]++;
     _logChange(channel, prev, on, source, now);
     _applyPin(channel, on);
-    _unlock();
     return true;
 }
 
@@ -111,10 +101,17 @@ bool RelayManager::get(RelayChannel channel) const {
     return _relay[static_cast<uint8_t>(channel)];
 }
 
+uint64_t RelayManager::onTimeMs(RelayChannel channel) {
+    uint8_t idx = static_cast<uint8_t>(channel);
+    taskENTER_CRITICAL(&_on_mux);
+    uint64_t total = _on_ms[idx];
+    if (_relay[idx]) total += millis() - _on_since[idx];
+    taskEXIT_CRITICAL(&_on_mux);
+    return total;
+}
+
 void RelayManager::setManualMode(bool enable) {
-    _lock();
     if (enable == (_state == RelayManagerState::MANUAL_MODE)) {
-        _unlock();
         return;
     }
 
@@ -125,7 +122,6 @@ void RelayManager::setManualMode(bool enable) {
         _state = RelayManagerState::ARMED;
         _applyPins();
     }
-    _unlock();
 }
 
 // ── Private helpers ───────────────────────────────────────────────────────────
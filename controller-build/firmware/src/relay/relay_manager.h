@@ -13,6 +13,12 @@
  *  3. In MANUAL_MODE the manager releases GPIOs to INPUT (high-Z) so the physical
  *     DPDT panel switches take full control.
  *  4. Every state change is logged with timestamp, channel, old/new state, source.
+ *
+ * Single writer: the control task (and setup() before it starts) is the only
+ * caller of set(), setManualMode() and tick(). Other tasks submit a
+ * RelayCommand (relay_command.h) instead. Readers on other tasks get plain
+ * loads; the on-time bookkeeping behind onTimeMs() is guarded by a short
+ * critical section rather than a mutex, so a reader never waits on relay I/O.
  */
 
 // In native test builds we stub Arduino/FreeRTOS types
@@ -20,10 +26,13 @@
 #include <cstdio>
 // millis()/set_millis() provided by test_clock.cpp
 extern uint32_t millis();
+#define portMUX_TYPE                 int
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define taskENTER_CRITICAL(m)        (void)(m)
+#define taskEXIT_CRITICAL(m)         (void)(m)
 #else
 #include <Arduino.h>
 #include <freertos/FreeRTOS.h>
-#include <freertos/semphr.h>
 #endif
 
 enum class RelayManagerState : uint8_t {
@@ -57,7 +66,7 @@ public:
     void tick();
 
     /**
-     * set(channel, on, source) — Request relay state change.
+     * set(channel, on, source) — Request relay state change. Control task only.
      * Returns false and logs a warning if called during BOOT_LOCKED window
      * (or UVC during its extended lock). Returns true if state was applied.
      */
@@ -68,7 +77,7 @@ public:
 
     /**
      * setManualMode(enable) — When true, all GPIOs are set to INPUT (high-Z)
-     * releasing control to the physical DPDT panel switches.
+     * releasing control to the physical DPDT panel switches. Control task only.
      */
     void setManualMode(bool enable);
 
@@ -84,6 +93,15 @@ public:
     /** getBootTimestamp() — millis() value recorded in begin(). */
     uint32_t getBootTimestamp() const { return _boot_ms; }
 
+    /**
+     * onTimeMs(channel) — Cumulative time the channel has been commanded ON
+     * since boot, including the current run. Never decreases. Any task.
+     */
+    uint64_t onTimeMs(RelayChannel channel);
+
+    /** switchCount(channel) — OFF→ON transitions since boot. */
+    uint32_t switchCount(RelayChannel channel) const { return _switches[static_cast<uint8_t>(channel)]; }
+
     /** getLog() — Pointer to the recent state-change ring buffer. */
     const RelayStateEntry* getLog(size_t& out_count) const {
         out_count = _log_count;
@@ -96,14 +114,15 @@ private:
     RelayManagerState _state      = RelayManagerState::BOOT_LOCKED;
     bool              _relay[RELAY_CHANNEL_COUNT] = {};  // All OFF
     uint32_t          _boot_ms    = 0;
+    uint64_t          _on_ms[RELAY_CHANNEL_COUNT]    = {};  // Closed ON periods
+    uint32_t          _on_since[RELAY_CHANNEL_COUNT] = {};  // millis() of the current ON edge
+    uint32_t          _switches[RELAY_CHANNEL_COUNT] = {};
 
     RelayStateEntry   _log[LOG_SIZE] = {};
     size_t            _log_head  = 0;
     size_t            _log_count = 0;
 
-#ifndef NATIVE_TEST
-    SemaphoreHandle_t _mutex = nullptr;
-#endif
+    portMUX_TYPE      _on_mux = portMUX_INITIALIZER_UNLOCKED;   // _relay/_on_ms/_on_since vs onTimeMs()
 
     void _applyPins();
     void _applyPin(RelayChannel ch, bool on);
@@ -111,15 +130,4 @@ private:
     void _logChange(RelayChannel ch, bool from, bool to, RelaySource src, uint32_t ts);
     bool _isUvcLocked(uint32_t now_ms) const;
     static uint8_t _pinForChannel(RelayChannel ch);
-
-    void _lock() {
-#ifndef NATIVE_TEST
-        if (_mutex) xSemaphoreTake(_mutex, portMAX_DELAY);
-#endif
-    }
-    void _unlock() {
-#ifndef NATIVE_TEST
-        if (_mutex) xSemaphoreGive(_mutex);
-#endif
-    }
 };
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * as7341.h — AS7341 register map, SMUX tables and timing helpers.
+ *
+ * Header-only. Works in both native tests and on ESP32.
+ *
+ * The AS7341 has six ADCs and more photodiodes than that, so which diode
+ * feeds which ADC is set by writing a 20-byte SMUX table into RAM 0x00–0x13
+ * and executing it. Each table byte holds two photodiode nibbles (low =
+ * even pixel, high = odd pixel); a nibble is the ADC number + 1, 0 = off.
+ */
+
+// ── Registers ────────────────────────────────────────────────────────────────
+inline constexpr uint8_t AS7341_REG_ENABLE   = 0x80;  // PON | SP_EN | SMUXEN
+inline constexpr uint8_t AS7341_REG_ATIME    = 0x81;
+inline constexpr uint8_t AS7341_REG_ASTATUS  = 0x94;  // Latches CH0..CH5 data on read
+inline constexpr uint8_t AS7341_REG_CH0_L    = 0x95;
+inline constexpr uint8_t AS7341_REG_STATUS2  = 0xA3;
+inline constexpr uint8_t AS7341_REG_CFG1     = 0xAA;  // AGAIN[4:0]
+inline constexpr uint8_t AS7341_REG_CFG6     = 0xAF;  // SMUX_CMD[4:3]
+inline constexpr uint8_t AS7341_REG_ASTEP_L  = 0xCA;
+inline constexpr uint8_t AS7341_REG_ID       = 0x92;
+
+inline constexpr uint8_t AS7341_ENABLE_PON    = 0x01;
+inline constexpr uint8_t AS7341_ENABLE_SP_EN  = 0x02;
+inline constexpr uint8_t AS7341_ENABLE_SMUXEN = 0x10;
+inline constexpr uint8_t AS7341_STATUS2_AVALID     = 0x40;
+inline constexpr uint8_t AS7341_STATUS2_ASAT_DIG   = 0x10;
+inline constexpr uint8_t AS7341_STATUS2_ASAT_ANA   = 0x08;
+inline constexpr uint8_t AS7341_ASTATUS_ASAT       = 0x80;
+inline constexpr uint8_t AS7341_CFG6_SMUX_WRITE    = 0x10;  // RAM → SMUX
+inline constexpr uint8_t AS7341_ID_VALUE           = 0x24;  // ID[7:2] = 0b001001
+
+// ── Gain ─────────────────────────────────────────────────────────────────────
+// AGAIN code n → gain 2^(n-1): 0 = 0.5×, 1 = 1× … 10 = 512×
+inline constexpr uint8_t AS7341_GAIN_MIN   = 0;
+inline constexpr uint8_t AS7341_GAIN_MAX   = 10;
+inline constexpr uint8_t AS7341_GAIN_256X  = 9;
+
+inline float as7341GainFactor(uint8_t again) {
+    return again == 0 ? 0.5f : static_cast<float>(1u << (again - 1));
+}
+
+// ── Integration time ─────────────────────────────────────────────────────────
+// t_int = (ATIME + 1) × (ASTEP + 1) × 2.78 µs
+inline uint32_t as7341IntegrationUs(uint8_t atime, uint16_t astep) {
+    return static_cast<uint32_t>((atime + 1u) * (astep + 1u) * 278u / 100u);
+}
+
+/** as7341FullScale(atime, astep) — ADC count at saturation. */
+inline uint16_t as7341FullScale(uint8_t atime, uint16_t astep) {
+    uint32_t fs = (atime + 1u) * (astep + 1u);
+    return fs > 65535u ? 65535u : static_cast<uint16_t>(fs);
+}
+
+// ── Readout modes ────────────────────────────────────────────────────────────
+// FULL    — two SMUX passes per reading, all ten channels
+// REDUCED — one pass, AS7341_PASS_REDUCED channels only
+enum class LightMode : uint8_t { FULL = 0, REDUCED = 1 };
+
+// ── SMUX tables ──────────────────────────────────────────────────────────────
+// Output slots in LightReading.channels: 0–7 = F1–F8, 8 = Clear, 9 = NIR
+inline constexpr uint8_t AS7341_SLOT_CLEAR = 8;
+inline constexpr uint8_t AS7341_SLOT_NIR   = 9;
+
+struct As7341Pass {
+    uint8_t smux[20];
+    uint8_t slot[6];     // Output slot fed by ADC0..ADC5
+};
+
+// Full spectrum, pass A: F1 F2 F3 F4 Clear NIR
+inline constexpr As7341Pass AS7341_PASS_F1F4 = {
+    { 0x30, 0x01, 0x00, 0x00, 0x00, 0x42, 0x00, 0x00, 0x50, 0x00,
+      0x00, 0x00, 0x20, 0x04, 0x00, 0x30, 0x01, 0x50, 0x00, 0x06 },
+    { 0, 1, 2, 3, AS7341_SLOT_CLEAR, AS7341_SLOT_NIR }
+};
+
+// Full spectrum, pass B: F5 F6 F7 F8 Clear NIR
+inline constexpr As7341Pass AS7341_PASS_F5F8 = {
+    { 0x00, 0x00, 0x00, 0x40, 0x02, 0x00, 0x10, 0x03, 0x50, 0x10,
+      0x03, 0x00, 0x00, 0x00, 0x24, 0x00, 0x00, 0x50, 0x00, 0x06 },
+    { 4, 5, 6, 7, AS7341_SLOT_CLEAR, AS7341_SLOT_NIR }
+};
+
+// Reduced, single pass: F2 (445 nm) F4 (515 nm) F7 (630 nm) F8 (680 nm)
+// Clear NIR — the blue, green, red and deep-red bands grow lights are
+// specified by, plus the broadband channels.
+inline constexpr As7341Pass AS7341_PASS_REDUCED = {
+    { 0x00, 0x00, 0x00, 0x40, 0x00, 0x21, 0x00, 0x03, 0x50, 0x00,
+      0x03, 0x00, 0x10, 0x02, 0x04, 0x00, 0x00, 0x50, 0x00, 0x06 },
+    { 1, 3, 6, 7, AS7341_SLOT_CLEAR, AS7341_SLOT_NIR }
+};
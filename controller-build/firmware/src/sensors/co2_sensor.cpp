@@ -3,6 +3,8 @@
  */
 
 #include "co2_sensor.h"
+#include "i2c_stats.h"
+#include "i2c_supervisor.h"
 #include "../util/logger.h"
 #include "../../include/config.h"
 
@@ -13,50 +15,120 @@ Co2Sensor CO2Sensor;
 bool Co2Sensor::begin() {
     _scd30.begin(Wire, I2C_ADDR_SCD30);
 
-    uint16_t err = _scd30.startPeriodicMeasurement(0);
-    if (err != 0) {
-        Log.error("co2", "SCD30 init failed (err=%u)", err);
+    if (!_configure()) {
+        I2cGuard.suspend(I2C_ADDR_SCD30, I2cSupervisor::NO_CHANNEL);
         return false;
     }
-
-    // Disable auto-calibration (indoor use — no periodic outdoor air exposure)
-    _scd30.deactivateAutomaticSelfCalibration();
-
     Log.info("co2", "SCD30 initialised");
     return true;
 }
 
 std::optional<Co2Reading> Co2Sensor::read() {
-    if (!isReady()) {
-        // Check staleness
-        if (_valid && (millis() - _last.timestamp_ms) > SENSOR_STALE_MS) {
-            _valid = false;
-            Log.warn("co2", "SCD30 reading stale (>%ums)", SENSOR_STALE_MS);
+    constexpr uint8_t CH = I2cSupervisor::NO_CHANNEL;
+    uint32_t now = millis();
+
+    // Backing off, or reinit failed — fall through to the staleness check
+    bool usable = I2cGuard.allow(I2C_ADDR_SCD30, CH, now);
+    if (usable && I2cGuard.needsInit(I2C_ADDR_SCD30, CH)) {
+        usable = _configure();
+        if (!usable) I2cGuard.report(I2C_ADDR_SCD30, CH, false, now);
+    }
+
+    Scd30Step step = usable ? _pacer.next(now) : Scd30Step::WAIT;
+    if (step == Scd30Step::PROBE) {
+        // Out of phase: only read once the sensor says a sample is ready
+        uint16_t ready = 0;
+        uint16_t err   = _scd30.getDataReady(ready);
+        I2cCounters.record(I2cDevice::SCD30, 2, err == 0);  // Command write + status read
+
+        if (err != 0) {
+            Log.warn("co2", "SCD30 data-ready error=%u", err);
+            I2cGuard.report(I2C_ADDR_SCD30, CH, false, now);
+            step = Scd30Step::WAIT;
+        } else if (!ready) {
+            I2cGuard.report(I2C_ADDR_SCD30, CH, true, now);
+            step = Scd30Step::WAIT;
+        }
+    }
+
+    if (step != Scd30Step::WAIT) {
+        float    co2 = 0, temp = 0, rh = 0;
+        uint16_t err = _scd30.readMeasurementData(co2, temp, rh);
+        I2cCounters.record(I2cDevice::SCD30, 2, err == 0);
+
+        if (err != 0 && step == Scd30Step::READ) {
+            // A direct read may have beaten the sample; a probe settles it
+            // (and reports to I2cGuard if the bus really is at fault)
+            _pacer.unsync();
+        } else {
+            I2cGuard.report(I2C_ADDR_SCD30, CH, err == 0, now);
+            if (err != 0) {
+                Log.warn("co2", "SCD30 read error=%u", err);
+                _pacer.unsync();
+            } else if (step == Scd30Step::READ && _valid && co2 == _last.co2_ppm &&
+                       temp == _last.temp_c && rh == _last.rh_pct) {
+                _pacer.onStale(now);   // Read ahead of the sensor: previous sample again
+            } else {
+                _last.co2_ppm      = co2;
+                _last.temp_c       = temp;
+                _last.rh_pct       = rh;
+                _last.valid        = true;
+                _last.timestamp_ms = now;
+                _valid = true;
+                _pacer.onSample(now);
+                return _last;
+            }
         }
-        return _valid ? std::optional<Co2Reading>{_last} : std::nullopt;
     }
 
-    float co2 = 0, temp = 0, rh = 0;
-    uint16_t err = _scd30.readMeasurementData(co2, temp, rh);
+    // No new sample — check staleness
+    if (_valid && (now - _last.timestamp_ms) > SENSOR_STALE_MS) {
+        _valid = false;
+        Log.warn("co2", "SCD30 reading stale (>%ums)", SENSOR_STALE_MS);
+    }
+    return _valid ? std::optional<Co2Reading>{_last} : std::nullopt;
+}
+
+bool Co2Sensor::setMeasurementInterval(uint16_t interval_s) {
+    if (interval_s < SCD30_INTERVAL_MIN_S || interval_s > SCD30_INTERVAL_MAX_S) return false;
+    _target_s = interval_s;
+    if (interval_s == _interval_s) return true;
+    // Sensor absent or backing off — _configure() applies it on recovery
+    if (I2cGuard.needsInit(I2C_ADDR_SCD30, I2cSupervisor::NO_CHANNEL)) return true;
+    return _writeInterval(interval_s);
+}
+
+// ── Private helpers ───────────────────────────────────────────────────────────
+
+bool Co2Sensor::_configure() {
+    uint16_t err = _scd30.startPeriodicMeasurement(0);
+    I2cCounters.record(I2cDevice::SCD30, 1, err == 0);
     if (err != 0) {
-        Log.warn("co2", "SCD30 read error=%u", err);
-        return _valid ? std::optional<Co2Reading>{_last} : std::nullopt;
+        Log.error("co2", "SCD30 init failed (err=%u)", err);
+        return false;
     }
 
-    _last.co2_ppm      = co2;
-    _last.temp_c       = temp;
-    _last.rh_pct       = rh;
-    _last.valid        = true;
-    _last.timestamp_ms = millis();
-    _valid = true;
+    // Disable auto-calibration (indoor use — no periodic outdoor air exposure)
+    _scd30.deactivateAutomaticSelfCalibration();
+    I2cCounters.record(I2cDevice::SCD30, 1);
 
-    return _last;
+    // Re-apply the interval after a power cycle / bus clear
+    if (_target_s != 0) _writeInterval(_target_s);
+    _pacer.unsync();
+    return true;
 }
 
-bool Co2Sensor::isReady() {
-    uint16_t ready = 0;
-    _scd30.getDataReady(ready);
-    return ready != 0;
+bool Co2Sensor::_writeInterval(uint16_t interval_s) {
+    uint16_t err = _scd30.setMeasurementInterval(interval_s);
+    I2cCounters.record(I2cDevice::SCD30, 1, err == 0);
+    if (err != 0) {
+        Log.warn("co2", "SCD30 set interval %us failed (err=%u)", interval_s, err);
+        return false;
+    }
+    _interval_s = interval_s;
+    _pacer.setInterval(interval_s);
+    Log.info("co2", "SCD30 measurement interval %us", interval_s);
+    return true;
 }
 
 #endif  // !NATIVE_TEST
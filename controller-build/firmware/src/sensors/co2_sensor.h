@@ -1,5 +1,6 @@
 #pragma once
 #include "sensor_hub.h"
+#include "scd30_pacer.h"
 #include <optional>
 
 /**
@@ -7,6 +8,14 @@
  *
  * Auto-calibration is disabled for indoor use — the SCD30's auto-calibration
  * assumes periodic exposure to ~400 ppm outdoor air, which doesn't apply here.
+ *
+ * Reads are paced by Scd30Pacer: once in phase the sample is read directly
+ * when the measurement interval has elapsed, one read per sample, and
+ * getDataReady is only used to get back in phase. The sensor task can poll
+ * this driver often (low sample latency) without loading the bus.
+ *
+ * I2cGuard gates every read: a sensor that keeps failing (or clock-stretching
+ * past the Wire timeout) is backed off, and restarted once a retry succeeds.
  */
 #ifndef NATIVE_TEST
 #include <SensirionI2cScd30.h>
@@ -25,13 +34,22 @@ public:
      */
     std::optional<Co2Reading> read();
 
-    /** isReady() — True if the SCD30 has a new measurement available. */
-    bool isReady();
+    /**
+     * setMeasurementInterval(s) — Change the SCD30 sampling interval
+     * (SCD30_INTERVAL_MIN_S..MAX_S). Sensor task only — issues I2C.
+     */
+    bool setMeasurementInterval(uint16_t interval_s);
 
 private:
     SensirionI2cScd30 _scd30;
+    Scd30Pacer        _pacer;
     Co2Reading        _last  = {};
     bool              _valid = false;
+    uint16_t          _interval_s = 0;  // Last interval written to the sensor (0 = none yet)
+    uint16_t          _target_s   = 0;  // Last interval requested via setMeasurementInterval()
+
+    bool _configure();
+    bool _writeInterval(uint16_t interval_s);
 };
 
 extern Co2Sensor CO2Sensor;
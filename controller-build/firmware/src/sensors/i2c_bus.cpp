@@ -0,0 +1,78 @@
+/**
+ * i2c_bus.cpp — Wire-backed I2cBus for the shared sensor bus.
+ */
+
+#include "i2c_bus.h"
+#include "../../include/hal.h"
+
+#ifndef NATIVE_TEST
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+WireI2cBus I2cWire;
+
+bool WireI2cBus::write(uint8_t addr, const uint8_t* data, size_t len) {
+    Wire.beginTransmission(addr);
+    Wire.write(data, len);
+    return Wire.endTransmission() == 0;
+}
+
+bool WireI2cBus::read(uint8_t addr, uint8_t* out, size_t len) {
+    if (Wire.requestFrom(addr, len, true) != len) return false;
+    for (size_t i = 0; i < len; ++i) out[i] = static_cast<uint8_t>(Wire.read());
+    return true;
+}
+
+void WireI2cBus::sleepUs(uint32_t us) {
+    if (us < portTICK_PERIOD_MS * 1000U) {
+        delayMicroseconds(us);
+        return;
+    }
+    // Yield to other tasks. vTaskDelay(n) can return up to one tick early
+    // (the current tick is already part-way through), so add one.
+    uint32_t ms = (us + 999) / 1000;
+    vTaskDelay((ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS + 1);
+}
+
+bool WireI2cBus::busStuck() {
+    // The I2C pins stay readable through the GPIO matrix while Wire owns them
+    return digitalRead(PIN_I2C_SDA) == LOW && digitalRead(PIN_I2C_SCL) == HIGH;
+}
+
+bool WireI2cBus::clearBus() {
+    // A slave interrupted mid-byte keeps driving SDA until it has clocked out
+    // the rest of its byte. Take the pins back from the controller and supply
+    // those clocks by hand (at most 9: 8 data bits + ACK), then a STOP.
+    Wire.end();
+    pinMode(PIN_I2C_SDA, INPUT_PULLUP);
+    pinMode(PIN_I2C_SCL, OUTPUT_OPEN_DRAIN);
+    digitalWrite(PIN_I2C_SCL, HIGH);
+    delayMicroseconds(5);
+
+    for (uint8_t i = 0; i < 9 && digitalRead(PIN_I2C_SDA) == LOW; ++i) {
+        digitalWrite(PIN_I2C_SCL, LOW);
+        delayMicroseconds(5);
+        digitalWrite(PIN_I2C_SCL, HIGH);
+        delayMicroseconds(5);
+    }
+
+    // STOP: SDA rises while SCL is high
+    pinMode(PIN_I2C_SDA, OUTPUT_OPEN_DRAIN);
+    digitalWrite(PIN_I2C_SCL, LOW);
+    digitalWrite(PIN_I2C_SDA, LOW);
+    delayMicroseconds(5);
+    digitalWrite(PIN_I2C_SCL, HIGH);
+    delayMicroseconds(5);
+    digitalWrite(PIN_I2C_SDA, HIGH);
+    delayMicroseconds(5);
+
+    pinMode(PIN_I2C_SDA, INPUT_PULLUP);
+    bool released = digitalRead(PIN_I2C_SDA) == HIGH;
+    Wire.begin(PIN_I2C_SDA, PIN_I2C_SCL, I2C_CLOCK_HZ);
+    return released;
+}
+
+#endif  // !NATIVE_TEST
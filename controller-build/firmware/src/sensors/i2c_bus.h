@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * i2c_bus.h — Minimal I2C master port shared by the I2C sensor drivers.
+ *
+ * Drivers that talk raw register/command protocols (SHT45, TCA9548A) go
+ * through this instead of Wire directly, so their sequencing and timing can
+ * run against a fake bus in native tests. The hardware implementation wraps
+ * Wire and lives in i2c_bus.cpp.
+ *
+ * Each write()/read() is exactly one bus transaction (START … STOP).
+ *
+ * busStuck()/clearBus() are the recovery hooks I2cSupervisor uses when a
+ * slave has been left holding SDA low mid-byte; a bus without line access
+ * (e.g. a native fake) just reports "not stuck".
+ */
+
+class I2cBus {
+public:
+    virtual ~I2cBus() = default;
+
+    /** write(addr, data, len) — Returns false on NACK or bus error. */
+    virtual bool write(uint8_t addr, const uint8_t* data, size_t len) = 0;
+
+    /** read(addr, out, len) — Returns false on NACK or short read. */
+    virtual bool read(uint8_t addr, uint8_t* out, size_t len) = 0;
+
+    /** sleepUs(us) — Wait for a device-side operation; yields on device. */
+    virtual void sleepUs(uint32_t us) = 0;
+
+    /** busStuck() — True if SDA is held low while the bus should be idle. */
+    virtual bool busStuck() { return false; }
+
+    /** clearBus() — Clock SCL up to 9 times, send STOP, restart the controller. True if SDA released. */
+    virtual bool clearBus() { return false; }
+};
+
+#ifndef NATIVE_TEST
+
+class WireI2cBus : public I2cBus {
+public:
+    bool write(uint8_t addr, const uint8_t* data, size_t len) override;
+    bool read(uint8_t addr, uint8_t* out, size_t len) override;
+    void sleepUs(uint32_t us) override;
+    bool busStuck() override;
+    bool clearBus() override;
+};
+
+extern WireI2cBus I2cWire;
+
+#endif  // !NATIVE_TEST
@@ -0,0 +1,7 @@
+/**
+ * i2c_stats.cpp — Global per-device I2C transaction counters.
+ */
+
+#include "i2c_stats.h"
+
+I2cStats I2cCounters;
@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+/**
+ * i2c_stats.h — Per-device I2C transaction counters.
+ *
+ * Drivers record each bus transaction (one START…STOP) they issue, so bus
+ * load can be attributed per device from /api/status. Written by the sensor
+ * task, read by the web task — counters are relaxed atomics.
+ */
+
+enum class I2cDevice : uint8_t {
+    SCD30    = 0,
+    TCA9548A = 1,
+    SHT45    = 2,  // All three shelves (same address behind the mux)
+    AS7341   = 3,
+    COUNT    = 4   // Sentinel — keep last
+};
+
+inline constexpr uint8_t I2C_DEVICE_COUNT = static_cast<uint8_t>(I2cDevice::COUNT);
+
+/** Short names used as JSON keys. Indexed by I2cDevice. */
+inline constexpr const char* I2C_DEVICE_NAMES[I2C_DEVICE_COUNT] = { "scd30", "tca9548a", "sht45", "as7341" };
+
+class I2cStats {
+public:
+    I2cStats() = default;
+
+    /** record(dev, transactions, ok) — Count transactions; ok=false also counts an error. */
+    void record(I2cDevice dev, uint32_t transactions, bool ok = true) {
+        Counters& c = _dev[static_cast<uint8_t>(dev)];
+        c.transactions.fetch_add(transactions, std::memory_order_relaxed);
+        if (!ok) c.errors.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint32_t transactions(I2cDevice dev) const {
+        return _dev[static_cast<uint8_t>(dev)].transactions.load(std::memory_order_relaxed);
+    }
+
+    uint32_t errors(I2cDevice dev) const {
+        return _dev[static_cast<uint8_t>(dev)].errors.load(std::memory_order_relaxed);
+    }
+
+    void reset() {
+        for (auto& c : _dev) {
+            c.transactions.store(0, std::memory_order_relaxed);
+            c.errors.store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    struct Counters {
+        std::atomic<uint32_t> transactions{0};
+        std::atomic<uint32_t> errors{0};
+    };
+    Counters _dev[I2C_DEVICE_COUNT];
+};
+
+extern I2cStats I2cCounters;
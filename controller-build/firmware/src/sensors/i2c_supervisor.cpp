@@ -0,0 +1,131 @@
+/**
+ * i2c_supervisor.cpp — Per-device I2C backoff and SCL bus-clear recovery.
+ */
+
+#include "i2c_supervisor.h"
+#include "../util/logger.h"
+
+#ifndef NATIVE_TEST
+I2cSupervisor I2cGuard{I2cWire};
+#endif
+
+bool I2cSupervisor::allow(uint8_t addr, uint8_t ch, uint32_t now_ms) {
+    Slot* s = _find(addr, ch);
+    if (!s || !s->suspended.load(std::memory_order_relaxed)) return true;
+    if (!s->armed) {
+        s->retry_ms = now_ms + s->backoff_ms.load(std::memory_order_relaxed);
+        s->armed    = true;
+        return false;
+    }
+    // Backoff elapsed: let one poll through as the retry
+    return !_before(now_ms, s->retry_ms);
+}
+
+void I2cSupervisor::report(uint8_t addr, uint8_t ch, bool ok, uint32_t now_ms) {
+    Slot* s = _find(addr, ch);
+    if (!s) return;
+
+    if (ok) {
+        if (s->suspended.load(std::memory_order_relaxed)) {
+            Log.info("i2c", "Device 0x%02X ch%d recovered", addr, ch == NO_CHANNEL ? -1 : ch);
+        }
+        s->streak = 0;
+        s->level  = 0;
+        s->init   = false;
+        s->suspended.store(false, std::memory_order_relaxed);
+        s->backoff_ms.store(0, std::memory_order_relaxed);
+        return;
+    }
+
+    s->errors.fetch_add(1, std::memory_order_relaxed);
+    if (s->streak < UINT8_MAX) s->streak++;
+    _maybeClearBus(now_ms);
+
+    if (s->suspended.load(std::memory_order_relaxed)) {
+        // Failed retry — wait twice as long next time
+        if (s->level < UINT8_MAX) s->level++;
+        _backoff(*s);
+    } else if (s->streak >= I2C_FAIL_THRESHOLD) {
+        Log.warn("i2c", "Device 0x%02X ch%d failing; backing off", addr, ch == NO_CHANNEL ? -1 : ch);
+        s->level = 0;
+        _backoff(*s);
+    }
+    if (s->suspended.load(std::memory_order_relaxed)) {
+        s->retry_ms = now_ms + s->backoff_ms.load(std::memory_order_relaxed);
+        s->armed    = true;
+    }
+}
+
+void I2cSupervisor::suspend(uint8_t addr, uint8_t ch) {
+    Slot* s = _find(addr, ch);
+    if (!s || s->suspended.load(std::memory_order_relaxed)) return;
+    s->level = 0;
+    _backoff(*s);
+}
+
+bool I2cSupervisor::needsInit(uint8_t addr, uint8_t ch) {
+    Slot* s = _find(addr, ch);
+    return s && s->init;
+}
+
+I2cSupervisor::SlotInfo I2cSupervisor::slot(uint8_t i) const {
+    SlotInfo info = {};
+    if (i >= slotCount()) return info;
+    const Slot& s   = _slots[i];
+    info.addr       = s.addr;
+    info.channel    = s.channel;
+    info.suspended  = s.suspended.load(std::memory_order_relaxed);
+    info.errors     = s.errors.load(std::memory_order_relaxed);
+    info.backoff_ms = s.backoff_ms.load(std::memory_order_relaxed);
+    return info;
+}
+
+// ── Private helpers ───────────────────────────────────────────────────────────
+
+I2cSupervisor::Slot* I2cSupervisor::_find(uint8_t addr, uint8_t ch) {
+    uint8_t n = _count.load(std::memory_order_relaxed);
+    for (uint8_t i = 0; i < n; ++i) {
+        if (_slots[i].addr == addr && _slots[i].channel == ch) return &_slots[i];
+    }
+    if (n >= I2C_SUPERVISOR_SLOTS) return nullptr;  // Untracked — never gated
+
+    _slots[n].addr    = addr;
+    _slots[n].channel = ch;
+    _count.store(n + 1, std::memory_order_release);  // Publish after the key is set
+    return &_slots[n];
+}
+
+void I2cSupervisor::_backoff(Slot& s) {
+    uint32_t ms = I2C_BACKOFF_MIN_MS;
+    for (uint8_t i = 0; i < s.level && ms < I2C_BACKOFF_MAX_MS; ++i) ms *= 2;
+    if (ms > I2C_BACKOFF_MAX_MS) ms = I2C_BACKOFF_MAX_MS;
+    s.armed    = false;
+    s.init     = true;
+    s.backoff_ms.store(ms, std::memory_order_relaxed);
+    s.suspended.store(true, std::memory_order_relaxed);
+}
+
+void I2cSupervisor::_maybeClearBus(uint32_t now_ms) {
+    if (_clear_armed && _before(now_ms, _clear_next_ms)) return;
+    if (!_bus.busStuck()) return;
+
+    _clear_armed   = true;
+    _clear_next_ms = now_ms + I2C_BUS_CLEAR_GAP_MS;
+    _bus_clears.fetch_add(1, std::memory_order_relaxed);
+
+    bool released = _bus.clearBus();
+    Log.warn("i2c", "SDA held low — bus clear %s", released ? "succeeded" : "failed");
+    if (!released) return;
+
+    // The stuck slave was the fault, not necessarily the devices that saw it:
+    // give every device a clean slate, but re-initialise each before use
+    uint8_t n = _count.load(std::memory_order_relaxed);
+    for (uint8_t i = 0; i < n; ++i) {
+        Slot& s  = _slots[i];
+        s.streak = 0;
+        s.level  = 0;
+        s.init   = true;
+        s.suspended.store(false, std::memory_order_relaxed);
+        s.backoff_ms.store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include "i2c_bus.h"
+#include "../../include/config.h"
+#include <atomic>
+#include <cstdint>
+
+/**
+ * i2c_supervisor.h — Per-device I2C fault tracking, backoff and bus recovery.
+ *
+ * Drivers key each device by (address, mux channel) and wrap their polls:
+ *
+ *   if (!sup.allow(addr, ch, now)) return;          // backing off — no bus traffic
+ *   if (sup.needsInit(addr, ch)) reinitialise();    // after backoff or a bus clear
+ *   ... transactions ...
+ *   sup.report(addr, ch, ok, now);
+ *
+ * After I2C_FAIL_THRESHOLD consecutive failures a device is suspended for
+ * I2C_BACKOFF_MIN_MS; each failed retry doubles the wait (capped at
+ * I2C_BACKOFF_MAX_MS). While suspended allow() returns false, so a hung or
+ * missing sensor costs nothing and healthy devices keep their poll budget.
+ *
+ * Every failure also checks whether a slave is holding SDA low. If so the
+ * bus gets the standard 9-clock SCL clear (rate-limited to one per
+ * I2C_BUS_CLEAR_GAP_MS); since any device may have been mid-transaction,
+ * all devices are then flagged for re-initialisation and their backoff reset.
+ *
+ * Sensor task only, except the counters read through slot()/busClears(),
+ * which are atomics so the web task can report them.
+ */
+
+class I2cSupervisor {
+public:
+    static constexpr uint8_t NO_CHANNEL = 0xFF;  // Device not behind the mux
+
+    /** Read-only view of one tracked device, for /api/status. */
+    struct SlotInfo {
+        uint8_t  addr;
+        uint8_t  channel;
+        bool     suspended;
+        uint32_t errors;      // Failed transactions since boot
+        uint32_t backoff_ms;  // Current backoff (0 = healthy)
+    };
+
+    explicit I2cSupervisor(I2cBus& bus) : _bus(bus) {}
+
+    /** allow(addr, ch, now_ms) — False while the device is backing off. */
+    bool allow(uint8_t addr, uint8_t ch, uint32_t now_ms);
+
+    /** report(addr, ch, ok, now_ms) — Outcome of the device's transactions this poll. */
+    void report(uint8_t addr, uint8_t ch, bool ok, uint32_t now_ms);
+
+    /**
+     * suspend(addr, ch) — Back off without waiting for the failure streak
+     * (e.g. absent at begin()). The backoff starts at the next allow().
+     */
+    void suspend(uint8_t addr, uint8_t ch);
+
+    /** needsInit(addr, ch) — True until the next successful report() after a backoff or bus clear. */
+    bool needsInit(uint8_t addr, uint8_t ch);
+
+    /** busClears() — SCL bus-clear sequences run since boot. */
+    uint32_t busClears() const { return _bus_clears.load(std::memory_order_relaxed); }
+
+    /** slotCount()/slot(i) — Devices seen so far, in first-use order. Safe from any task. */
+    uint8_t  slotCount() const { return _count.load(std::memory_order_acquire); }
+    SlotInfo slot(uint8_t i) const;
+
+private:
+    struct Slot {
+        uint8_t               addr     = 0;
+        uint8_t               channel  = NO_CHANNEL;
+        uint8_t               streak   = 0;      // Consecutive failures
+        uint8_t               level    = 0;      // Backoff doublings so far
+        bool                  init     = false;  // Re-initialise before next use
+        bool                  armed    = false;  // retry_ms valid (false = start at next allow())
+        uint32_t              retry_ms = 0;
+        std::atomic<bool>     suspended{false};
+        std::atomic<uint32_t> errors{0};
+        std::atomic<uint32_t> backoff_ms{0};
+    };
+
+    I2cBus&               _bus;
+    Slot                  _slots[I2C_SUPERVISOR_SLOTS];
+    std::atomic<uint8_t>  _count{0};
+    std::atomic<uint32_t> _bus_clears{0};
+    uint32_t              _clear_next_ms = 0;
+    bool                  _clear_armed   = false;
+
+    static bool _before(uint32_t a, uint32_t b) { return static_cast<int32_t>(a - b) < 0; }
+
+    Slot* _find(uint8_t addr, uint8_t ch);
+    void  _backoff(Slot& s);
+    void  _maybeClearBus(uint32_t now_ms);
+};
+
+#ifndef NATIVE_TEST
+extern I2cSupervisor I2cGuard;
+#endif
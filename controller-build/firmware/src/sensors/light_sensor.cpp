@@ -3,51 +3,221 @@
  */
 
 #include "light_sensor.h"
+#include "i2c_stats.h"
 #include "../util/logger.h"
+#include <cstring>
 
 #ifndef NATIVE_TEST
-
-LightSensor LightSensorDev;
+LightSensor LightSensorDev{I2cWire, I2cGuard};
+#endif
 
 bool LightSensor::begin() {
-    if (!_as7341.begin()) {
+    _present = _configure();
+    if (!_present) {
         Log.warn("light", "AS7341 not found on I2C bus");
+        _sup.suspend(I2C_ADDR_AS7341, I2cSupervisor::NO_CHANNEL);
         return false;
     }
+    Log.info("light", "AS7341 initialised");
+    return true;
+}
 
-    _as7341.setATIME(100);
-    _as7341.setASTEP(999);
-    _as7341.setGain(AS7341_GAIN_256X);
+bool LightSensor::service(uint32_t now_ms) {
+    constexpr uint8_t CH = I2cSupervisor::NO_CHANNEL;
+    if (!_sup.allow(I2C_ADDR_AS7341, CH, now_ms)) return false;
 
-    _valid = true;
-    Log.info("light", "AS7341 initialised");
+    // Missing at boot, or back from a backoff / bus clear: start over
+    if (!_present || _sup.needsInit(I2C_ADDR_AS7341, CH)) {
+        _present = _configure();
+        if (!_present) {
+            _sup.report(I2C_ADDR_AS7341, CH, false, now_ms);
+            return false;
+        }
+        Log.info("light", "AS7341 reinitialised");
+    }
+
+    _fault = false;
+    bool done = _advance(now_ms);
+    _sup.report(I2C_ADDR_AS7341, CH, !_fault, now_ms);
+    return done;
+}
+
+// ── Private helpers ───────────────────────────────────────────────────────────
+
+bool LightSensor::_configure() {
+    uint8_t id = 0;
+    if (!_readReg(AS7341_REG_ID, &id, 1) || (id & 0xFC) != AS7341_ID_VALUE) return false;
+
+    // Keeps the current auto-gain settings — a reinit needn't re-converge
+    if (!_writeReg(AS7341_REG_ENABLE, AS7341_ENABLE_PON) ||
+        !_writeReg(AS7341_REG_ATIME, static_cast<uint8_t>(AS7341_ATIME)) ||
+        !_applyTiming()) {
+        return false;
+    }
+    _phase = Phase::IDLE;
+    _pass  = 0;
     return true;
 }
 
-std::optional<LightReading> LightSensor::readSpectrum() {
-    if (!_valid) return std::nullopt;
+bool LightSensor::_advance(uint32_t now_ms) {
+    bool done = false;
+    if (_phase == Phase::INTEGRATING) {
+        uint8_t status2 = 0;
+        if (!_readReg(AS7341_REG_STATUS2, &status2, 1)) { _abort("status read"); return false; }
+        if (!(status2 & AS7341_STATUS2_AVALID)) return false;  // Still integrating
+        if (!_collect(status2)) { _abort("data read"); return false; }
+
+        if (++_pass >= _passCount()) {
+            done  = _finishCycle(now_ms);
+            _pass = 0;
+        }
+        _phase = Phase::IDLE;
+    }
 
-    if (!_as7341.readAllChannels()) {
-        Log.warn("light", "AS7341 read failed");
-        return std::nullopt;
+    if (_phase == Phase::IDLE) {
+        if (!_startPass()) _abort("SMUX write");
+    } else if (_phase == Phase::SMUX) {
+        if (!_checkSmux()) _abort("SMUX poll");
     }
+    return done;
+}
 
-    LightReading reading = {};
-    reading.channels[0]  = _as7341.getChannel(AS7341_CHANNEL_415nm_F1);
-    reading.channels[1]  = _as7341.getChannel(AS7341_CHANNEL_445nm_F2);
-    reading.channels[2]  = _as7341.getChannel(AS7341_CHANNEL_480nm_F3);
-    reading.channels[3]  = _as7341.getChannel(AS7341_CHANNEL_515nm_F4);
-    reading.channels[4]  = _as7341.getChannel(AS7341_CHANNEL_555nm_F5);
-    reading.channels[5]  = _as7341.getChannel(AS7341_CHANNEL_590nm_F6);
-    reading.channels[6]  = _as7341.getChannel(AS7341_CHANNEL_630nm_F7);
-    reading.channels[7]  = _as7341.getChannel(AS7341_CHANNEL_680nm_F8);
-    reading.channels[8]  = _as7341.getChannel(AS7341_CHANNEL_CLEAR);
-    reading.channels[9]  = _as7341.getChannel(AS7341_CHANNEL_NIR);
-    reading.channels[10] = 0;  // Flicker detection (not a standard channel)
-    reading.valid        = true;
-    reading.timestamp_ms = millis();
+const As7341Pass& LightSensor::_passTable() const {
+    if (_cycle_mode == LightMode::REDUCED) return AS7341_PASS_REDUCED;
+    return _pass == 0 ? AS7341_PASS_F1F4 : AS7341_PASS_F5F8;
+}
 
-    return reading;
+bool LightSensor::_startPass() {
+    if (_pass == 0) {
+        _cycle_mode = _mode.load(std::memory_order_relaxed);
+        _cycle_sat  = false;
+        _cycle_peak = 0;
+        memset(&_work, 0, sizeof(_work));
+    }
+
+    // Load the SMUX table into RAM 0x00–0x13, then execute it
+    if (!_writeReg(AS7341_REG_CFG6, AS7341_CFG6_SMUX_WRITE)) return false;
+    if (!_writeReg(0x00, _passTable().smux, sizeof(As7341Pass::smux))) return false;
+    if (!_writeReg(AS7341_REG_ENABLE, AS7341_ENABLE_PON | AS7341_ENABLE_SMUXEN)) return false;
+    _phase = Phase::SMUX;
+    return _checkSmux();
+}
+
+bool LightSensor::_checkSmux() {
+    // SMUXEN self-clears when the table has been applied (normally well
+    // under a millisecond). If it hasn't yet, pick it up on the next poll.
+    for (uint8_t i = 0; i < AS7341_SMUX_POLLS; ++i) {
+        uint8_t enable = 0;
+        if (!_readReg(AS7341_REG_ENABLE, &enable, 1)) return false;
+        if (!(enable & AS7341_ENABLE_SMUXEN)) {
+            if (!_writeReg(AS7341_REG_ENABLE, AS7341_ENABLE_PON | AS7341_ENABLE_SP_EN)) return false;
+            _phase = Phase::INTEGRATING;
+            return true;
+        }
+    }
+    return true;
 }
 
-#endif  // !NATIVE_TEST
+bool LightSensor::_collect(uint8_t status2) {
+    // ASTATUS + CH0..CH5 in one burst; reading ASTATUS latches the data
+    uint8_t buf[13];
+    if (!_readReg(AS7341_REG_ASTATUS, buf, sizeof(buf))) return false;
+    if (!_writeReg(AS7341_REG_ENABLE, AS7341_ENABLE_PON)) return false;  // Stop measuring
+
+    if ((buf[0] & AS7341_ASTATUS_ASAT) ||
+        (status2 & (AS7341_STATUS2_ASAT_DIG | AS7341_STATUS2_ASAT_ANA))) {
+        _cycle_sat = true;
+    }
+
+    const As7341Pass& p = _passTable();
+    for (uint8_t adc = 0; adc < 6; ++adc) {
+        uint16_t v = static_cast<uint16_t>(buf[1 + 2 * adc] | (buf[2 + 2 * adc] << 8));
+        _work.channels[p.slot[adc]] = v;
+        _work.channel_mask |= static_cast<uint16_t>(1u << p.slot[adc]);
+        if (v > _cycle_peak) _cycle_peak = v;
+    }
+    return true;
+}
+
+bool LightSensor::_finishCycle(uint32_t now_ms) {
+    bool publish = !_cycle_sat;
+    if (publish) {
+        _work.again        = _again;
+        _work.tint_us      = as7341IntegrationUs(AS7341_ATIME, _astep);
+        _work.valid        = true;
+        _work.timestamp_ms = now_ms;
+        _reading = _work;
+    }
+    _autoGain();
+    return publish;
+}
+
+void LightSensor::_autoGain() {
+    uint32_t fs    = as7341FullScale(AS7341_ATIME, _astep);
+    uint32_t high  = fs * AS7341_AGC_HIGH_PCT / 100;
+    uint32_t low   = fs * AS7341_AGC_LOW_PCT / 100;
+    uint8_t  again = _again;
+    uint16_t astep = _astep;
+
+    if (_cycle_sat || _cycle_peak > high) {
+        // Too bright: drop gain (two codes if saturated — no magnitude info),
+        // then shorten integration once gain is at the floor
+        uint8_t steps = _cycle_sat ? 2 : 1;
+        if (again > AS7341_GAIN_MIN) {
+            again = again > steps ? again - steps : AS7341_GAIN_MIN;
+        } else if (astep > AS7341_ASTEP_MIN) {
+            astep = static_cast<uint16_t>((astep + 1) / 2 - 1);
+            if (astep < AS7341_ASTEP_MIN) astep = AS7341_ASTEP_MIN;
+        }
+    } else if (_cycle_peak < low) {
+        // Too dark: lengthen integration back to the ceiling first (it was
+        // only shortened because gain ran out), then raise gain towards
+        // ~40 % of full scale in one jump
+        if (astep < AS7341_ASTEP_MAX) {
+            astep = static_cast<uint16_t>((astep + 1) * 2 - 1);
+            if (astep > AS7341_ASTEP_MAX) astep = AS7341_ASTEP_MAX;
+        } else if (again < AS7341_GAIN_MAX) {
+            uint32_t target = fs * 2 / 5;
+            uint32_t peak   = _cycle_peak ? _cycle_peak : 1;
+            uint8_t  steps  = 0;
+            while (steps < AS7341_GAIN_MAX && (peak << (steps + 1)) <= target) ++steps;
+            if (steps == 0) steps = 1;
+            again = static_cast<uint8_t>(again + steps > AS7341_GAIN_MAX ? AS7341_GAIN_MAX : again + steps);
+        }
+    }
+
+    if (again == _again && astep == _astep) return;
+    Log.debug("light", "Auto-gain: AGAIN %u→%u ASTEP %u→%u (peak %u/%u%s)",
+              _again, again, _astep, astep, _cycle_peak, fs, _cycle_sat ? ", saturated" : "");
+    _again = again;
+    _astep = astep;
+    if (!_applyTiming()) _abort("gain write");
+}
+
+bool LightSensor::_applyTiming() {
+    uint8_t astep[2] = { static_cast<uint8_t>(_astep & 0xFF), static_cast<uint8_t>(_astep >> 8) };
+    return _writeReg(AS7341_REG_CFG1, _again) && _writeReg(AS7341_REG_ASTEP_L, astep, 2);
+}
+
+void LightSensor::_abort(const char* what) {
+    Log.warn("light", "AS7341 %s failed; restarting measurement", what);
+    _fault = true;
+    _phase = Phase::IDLE;
+    _pass  = 0;
+}
+
+bool LightSensor::_writeReg(uint8_t reg, const uint8_t* data, uint8_t len) {
+    uint8_t buf[1 + sizeof(As7341Pass::smux)];
+    if (len > sizeof(buf) - 1) return false;
+    buf[0] = reg;
+    memcpy(buf + 1, data, len);
+    bool ok = _bus.write(I2C_ADDR_AS7341, buf, len + 1u);
+    I2cCounters.record(I2cDevice::AS7341, 1, ok);
+    return ok;
+}
+
+bool LightSensor::_readReg(uint8_t reg, uint8_t* out, uint8_t len) {
+    bool ok = _bus.write(I2C_ADDR_AS7341, &reg, 1) && _bus.read(I2C_ADDR_AS7341, out, len);
+    I2cCounters.record(I2cDevice::AS7341, 2, ok);
+    return ok;
+}
@@ -1,31 +1,100 @@
 #pragma once
 #include "sensor_hub.h"
-#include <optional>
+#include "i2c_bus.h"
+#include "i2c_supervisor.h"
+#include "as7341.h"
+#include "../../include/config.h"
+#include <atomic>
 
 /**
  * light_sensor.h — AS7341 11-channel spectral light sensor wrapper.
  *
+ * Measurement is split-phase: each service() call does what it can without
+ * waiting — collect a finished integration (STATUS2.AVALID), reprogram the
+ * SMUX, start the next integration — and returns. The ~280 ms integration
+ * runs between sensor-task polls instead of inside one.
+ *
+ * Modes:
+ *   FULL    — two SMUX passes (F1–F4, then F5–F8; Clear/NIR in both), so a
+ *             complete spectrum every second service()
+ *   REDUCED — one pass: F2, F4, F7, F8, Clear, NIR — a reading every service()
+ *
+ * Auto-gain: after each complete reading the peak count is checked against
+ * full scale. Saturated readings are dropped and gain steps down two codes;
+ * above AS7341_AGC_HIGH_PCT it steps down one, below AS7341_AGC_LOW_PCT it
+ * steps up towards ~40 % of full scale. Integration time only moves once gain
+ * is at its limit. LightReading carries the gain and integration time so
+ * counts can be normalised.
+ *
+ * Bus faults abandon the current reading. I2cSupervisor backs the sensor
+ * off if they persist; once a retry is allowed (or if begin() failed) the
+ * sensor is reconfigured from scratch before measuring again.
+ *
  * Note: Waveshare AS7341 breakout board requires an I2C level shifter
  * (3.3V ↔ 5V) when powered from VIN. Verify your breakout pull-ups
  * reference 3.3V before connecting directly to ESP32 I2C pins.
  */
-#ifndef NATIVE_TEST
-#include <Adafruit_AS7341.h>
 
 class LightSensor {
 public:
-    LightSensor() = default;
+    LightSensor(I2cBus& bus, I2cSupervisor& sup) : _bus(bus), _sup(sup) {}
 
-    /** begin() — initialise AS7341. Returns false if not found on I2C bus. */
+    /** begin() — initialise AS7341. Returns false if not found; service() keeps retrying with backoff. */
     bool begin();
 
-    /** readSpectrum() — Read all 11 channels. Returns nullopt on failure. */
-    std::optional<LightReading> readSpectrum();
+    /**
+     * service(now_ms) — Advance the measurement; never waits for integration.
+     * Returns true when a new complete, unsaturated reading is available.
+     */
+    bool service(uint32_t now_ms);
+
+    /** reading() — Latest complete reading (valid=false until the first). */
+    const LightReading& reading() const { return _reading; }
+
+    /** setMode(m) — Takes effect at the start of the next reading. Safe from any task. */
+    void setMode(LightMode m) { _mode.store(m, std::memory_order_relaxed); }
+
+    uint8_t  gain()  const { return _again; }
+    uint16_t astep() const { return _astep; }
 
 private:
-    Adafruit_AS7341 _as7341;
-    bool            _valid = false;
+    enum class Phase : uint8_t { IDLE, SMUX, INTEGRATING };
+
+    I2cBus&                _bus;
+    I2cSupervisor&         _sup;
+    std::atomic<LightMode> _mode{LightMode::FULL};
+    bool                   _present = false;  // Configured since the last begin()/backoff
+    bool                   _fault   = false;  // Bus error during this service()
+
+    Phase     _phase      = Phase::IDLE;
+    LightMode _cycle_mode = LightMode::FULL;  // Latched at the first pass
+    uint8_t   _pass       = 0;
+    bool      _cycle_sat  = false;
+    uint16_t  _cycle_peak = 0;
+    uint8_t   _again      = AS7341_GAIN_256X;
+    uint16_t  _astep      = AS7341_ASTEP_MAX;
+
+    LightReading _work    = {};
+    LightReading _reading = {};
+
+    const As7341Pass& _passTable() const;
+    uint8_t _passCount() const { return _cycle_mode == LightMode::FULL ? 2 : 1; }
+
+    bool _configure();
+    bool _advance(uint32_t now_ms);
+    bool _startPass();
+    bool _checkSmux();
+    bool _collect(uint8_t status2);
+    bool _finishCycle(uint32_t now_ms);
+    void _autoGain();
+    bool _applyTiming();
+    void _abort(const char* what);
+
+    bool _writeReg(uint8_t reg, const uint8_t* data, uint8_t len);
+    bool _writeReg(uint8_t reg, uint8_t value) { return _writeReg(reg, &value, 1); }
+    bool _readReg(uint8_t reg, uint8_t* out, uint8_t len);
 };
 
+#ifndef NATIVE_TEST
 extern LightSensor LightSensorDev;
 #endif
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * onewire_bus.h — Minimal 1-Wire bus port used by TempProbes.
+ *
+ * Only the operations the DS18B20 split-phase read needs are exposed,
+ * so the conversion/readback state machine can run against a fake bus in
+ * native tests. The hardware implementation (OneWire + DallasTemperature)
+ * lives in temp_probe.cpp.
+ *
+ * None of these calls may wait for a temperature conversion to finish. A
+ * scratchpad read is split into selectProbe() and readScratchpad(), each
+ * well under 10 ms of bus time; 1-Wire slots have no maximum spacing, so
+ * the probe waits, selected, for the read on a later call.
+ */
+
+class OneWireBus {
+public:
+    virtual ~OneWireBus() = default;
+
+    /**
+     * search(roms, max) — Enumerate devices on the bus.
+     * Fills up to max ROM addresses (ascending order); returns the count.
+     */
+    virtual uint8_t search(uint8_t roms[][8], uint8_t max) = 0;
+
+    /** setResolution(bits) — Set conversion resolution (9–12) on all devices. */
+    virtual void setResolution(uint8_t bits) = 0;
+
+    /**
+     * startConversion() — Skip ROM + Convert T to every device on the bus.
+     * Returns immediately; false if no presence pulse was seen.
+     */
+    virtual bool startConversion() = 0;
+
+    /**
+     * selectProbe(rom) — Reset + Match ROM. Returns false if no presence
+     * pulse was seen. Must be followed by readScratchpad().
+     */
+    virtual bool selectProbe(const uint8_t rom[8]) = 0;
+
+    /**
+     * readScratchpad(out) — Read Scratchpad (9 bytes) from the probe last
+     * selected. CRC is NOT checked here.
+     */
+    virtual void readScratchpad(uint8_t out[9]) = 0;
+};
+
+/** onewireCrc8(data, len) — Dallas/Maxim CRC-8 (poly x^8+x^5+x^4+1). */
+inline uint8_t onewireCrc8(const uint8_t* data, size_t len) {
+    uint8_t crc = 0;
+    while (len--) {
+        uint8_t in = *data++;
+        for (uint8_t i = 0; i < 8; ++i) {
+            uint8_t mix = (crc ^ in) & 0x01;
+            crc >>= 1;
+            if (mix) crc ^= 0x8C;
+            in >>= 1;
+        }
+    }
+    return crc;
+}
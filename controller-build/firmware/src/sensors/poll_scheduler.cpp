@@ -0,0 +1,81 @@
+/**
+ * poll_scheduler.cpp — Deadline-ordered per-driver sensor poll table.
+ */
+
+#include "poll_scheduler.h"
+
+void PollScheduler::begin(const SensorPollConfig& cfg, uint32_t now_ms) {
+    for (uint8_t i = 0; i < SENSOR_DRIVER_COUNT; ++i) {
+        SensorDriver d = static_cast<SensorDriver>(i);
+        _table[i].driver    = d;
+        _table[i].period_ms = _clampPeriod(cfg.periodFor(d));
+        _table[i].due_ms    = now_ms + _phaseFor(d);
+    }
+    _sort();
+}
+
+void PollScheduler::setPeriods(const SensorPollConfig& cfg, uint32_t now_ms) {
+    for (auto& e : _table) {
+        e.period_ms = _clampPeriod(cfg.periodFor(e.driver));
+        uint32_t soonest = now_ms + e.period_ms;
+        if (_before(soonest, e.due_ms)) e.due_ms = soonest;
+    }
+    _sort();
+}
+
+bool PollScheduler::popDue(uint32_t now_ms, SensorDriver& out) {
+    Entry& head = _table[0];
+    if (_before(now_ms, head.due_ms)) return false;
+
+    out = head.driver;
+    head.due_ms += head.period_ms;
+    // Fell a whole period behind (long bus stall): skip, don't burst
+    if (!_before(now_ms, head.due_ms)) head.due_ms = now_ms + head.period_ms;
+    _sort();
+    return true;
+}
+
+uint32_t PollScheduler::msUntilNext(uint32_t now_ms) const {
+    const Entry& head = _table[0];
+    return _before(now_ms, head.due_ms) ? (head.due_ms - now_ms) : 0;
+}
+
+uint32_t PollScheduler::period(SensorDriver d) const {
+    for (const auto& e : _table) {
+        if (e.driver == d) return e.period_ms;
+    }
+    return 0;
+}
+
+// ── Private helpers ───────────────────────────────────────────────────────────
+
+uint32_t PollScheduler::_clampPeriod(uint32_t ms) {
+    if (ms < SENSOR_POLL_MIN_MS) return SENSOR_POLL_MIN_MS;
+    if (ms > SENSOR_POLL_MAX_MS) return SENSOR_POLL_MAX_MS;
+    return ms;
+}
+
+uint32_t PollScheduler::_phaseFor(SensorDriver d) {
+    switch (d) {
+        case SensorDriver::CO2:   return SENSOR_PHASE_CO2_MS;
+        case SensorDriver::RH:    return SENSOR_PHASE_RH_MS;
+        case SensorDriver::TEMP:  return SENSOR_PHASE_TEMP_MS;
+        case SensorDriver::LIGHT: return SENSOR_PHASE_LIGHT_MS;
+        default:                  return 0;
+    }
+}
+
+void PollScheduler::_sort() {
+    // Insertion sort — four entries, and usually only the head moved.
+    // Ties keep driver order so equal deadlines run deterministically.
+    for (uint8_t i = 1; i < SENSOR_DRIVER_COUNT; ++i) {
+        Entry e = _table[i];
+        uint8_t j = i;
+        while (j > 0 && (_before(e.due_ms, _table[j - 1].due_ms) ||
+                         (e.due_ms == _table[j - 1].due_ms && e.driver < _table[j - 1].driver))) {
+            _table[j] = _table[j - 1];
+            --j;
+        }
+        _table[j] = e;
+    }
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include "../../include/config.h"
+
+/**
+ * poll_scheduler.h — Per-driver sensor polling cadence.
+ *
+ * Each sensor driver runs on its own period and phase offset instead of all
+ * drivers running in lockstep. The table is kept ordered by next deadline so
+ * the sensor task can sleep exactly until the next driver is due.
+ *
+ * Deadlines advance by whole periods (no drift from poll duration). A driver
+ * that falls more than one period behind skips the missed slots rather than
+ * bursting to catch up.
+ */
+
+enum class SensorDriver : uint8_t {
+    CO2   = 0,  // SCD30
+    RH    = 1,  // SHT45 ×3 via TCA9548A
+    TEMP  = 2,  // DS18B20 ×5
+    LIGHT = 3,  // AS7341
+    COUNT = 4   // Sentinel — keep last
+};
+
+inline constexpr uint8_t SENSOR_DRIVER_COUNT = static_cast<uint8_t>(SensorDriver::COUNT);
+
+/** Per-driver poll periods (ms). Persisted as part of MarthaConfig. */
+struct SensorPollConfig {
+    uint32_t co2_ms   = SENSOR_POLL_CO2_MS;
+    uint32_t rh_ms    = SENSOR_POLL_RH_MS;
+    uint32_t temp_ms  = SENSOR_POLL_TEMP_MS;
+    uint32_t light_ms = SENSOR_POLL_LIGHT_MS;
+
+    // SCD30 on-chip measurement interval (s). The CO2 driver only touches
+    // the bus once per interval, however often co2_ms polls it.
+    uint16_t scd30_interval_s = SCD30_MEASUREMENT_INTERVAL_S;
+
+    uint32_t periodFor(SensorDriver d) const {
+        switch (d) {
+            case SensorDriver::CO2:   return co2_ms;
+            case SensorDriver::RH:    return rh_ms;
+            case SensorDriver::TEMP:  return temp_ms;
+            case SensorDriver::LIGHT: return light_ms;
+            default:                  return SENSOR_POLL_MAX_MS;
+        }
+    }
+};
+
+class PollScheduler {
+public:
+    PollScheduler() = default;
+
+    /** begin(cfg, now_ms) — First deadline of each driver = now + its phase offset. */
+    void begin(const SensorPollConfig& cfg, uint32_t now_ms);
+
+    /**
+     * setPeriods(cfg, now_ms) — Apply new periods at runtime. A driver whose
+     * new period is shorter than its remaining wait is pulled in.
+     */
+    void setPeriods(const SensorPollConfig& cfg, uint32_t now_ms);
+
+    /**
+     * popDue(now_ms, out) — If the earliest driver is due, write it to out,
+     * advance its deadline by one period and return true.
+     */
+    bool popDue(uint32_t now_ms, SensorDriver& out);
+
+    /** msUntilNext(now_ms) — Time until the earliest deadline (0 if overdue). */
+    uint32_t msUntilNext(uint32_t now_ms) const;
+
+    /** next() — Driver with the earliest deadline. */
+    SensorDriver next() const { return _table[0].driver; }
+
+    /** period(d) — Current period of driver d in ms. */
+    uint32_t period(SensorDriver d) const;
+
+private:
+    struct Entry {
+        SensorDriver driver;
+        uint32_t     period_ms;
+        uint32_t     due_ms;
+    };
+
+    Entry _table[SENSOR_DRIVER_COUNT] = {};  // Ordered by due_ms (earliest first)
+
+    static uint32_t _clampPeriod(uint32_t ms);
+    static uint32_t _phaseFor(SensorDriver d);
+    static bool     _before(uint32_t a, uint32_t b) { return static_cast<int32_t>(a - b) < 0; }
+    void            _sort();
+};
@@ -3,74 +3,201 @@
  */
 
 #include "rh_sensor.h"
+#include "i2c_stats.h"
 #include "../util/logger.h"
-#include "../../include/config.h"
 
 #ifndef NATIVE_TEST
-
-RhSensorArray RhSensors;
+RhSensorArray RhSensors{I2cWire, I2cGuard};
+#endif
 
 bool RhSensorArray::begin() {
     if (!_mux.begin()) {
         Log.error("rh", "TCA9548A mux not found at 0x%02X", I2C_ADDR_TCA9548A);
+        _sup.suspend(I2C_ADDR_TCA9548A, I2cSupervisor::NO_CHANNEL);
         return false;
     }
 
     bool ok = true;
-    for (uint8_t ch = 0; ch < 3; ++ch) {
-        if (!_selectChannel(ch)) { ok = false; continue; }
-
-        _sht[ch] = SHTSensor(SHTSensor::SHT4X);
-        if (!_sht[ch].init()) {
-            Log.warn("rh", "SHT45 on mux ch%u not found", ch);
+    for (uint8_t i = 0; i < SHELVES; ++i) {
+        // Serial number read doubles as a presence + CRC check
+        uint8_t frame[6];
+        if (!_command(i, SHT4X_CMD_SERIAL)) {
+            Log.warn("rh", "SHT45 on mux ch%u not found", CHANNELS[i]);
+            _sup.suspend(I2C_ADDR_SHT45, CHANNELS[i]);
+            ok = false;
+            continue;
+        }
+        _bus.sleepUs(1000);
+        if (!_readFrame(i, frame) ||
+            sht4xCrc8(frame, 2) != frame[2] || sht4xCrc8(frame + 3, 2) != frame[5]) {
+            Log.warn("rh", "SHT45 on mux ch%u not responding", CHANNELS[i]);
+            _sup.suspend(I2C_ADDR_SHT45, CHANNELS[i]);
             ok = false;
         } else {
-            Log.info("rh", "SHT45 on mux ch%u ready", ch);
+            Log.info("rh", "SHT45 on mux ch%u ready", CHANNELS[i]);
         }
     }
     return ok;
 }
 
-std::array<RhReading, 3> RhSensorArray::readAll() {
+std::array<RhReading, 3> RhSensorArray::readAll(uint32_t now_ms) {
     std::array<RhReading, 3> readings = {};
-    const uint8_t channels[] = { MUX_CH_SHT45_SHELF1, MUX_CH_SHT45_SHELF2, MUX_CH_SHT45_SHELF3 };
+    ShtPrecision prec = precision();
+    uint8_t      cmd  = sht4xMeasureCommand(prec);
+
+    _expireRecovery(now_ms);
+    _mux_fault  = false;
+    bool mux_up = _muxReady(now_ms);
+
+    // A shelf mid-pulse NACKs everything until the heater is done
+    auto heating = [this](uint8_t i) {
+        return _heat_phase == HeaterPhase::HEATING && _heat_shelf == i;
+    };
+
+    // Phase 1: start a conversion on every shelf that isn't backing off
+    bool tried[SHELVES]   = {};
+    bool started[SHELVES] = {};
+    bool any = false;
+    for (uint8_t i = 0; i < SHELVES; ++i) {
+        if (!mux_up || heating(i) || !_shelfReady(i, now_ms)) continue;
+        tried[i]   = true;
+        started[i] = _command(i, cmd);
+        any |= started[i];
+    }
 
-    for (uint8_t i = 0; i < 3; ++i) {
-        readings[i].valid = false;
+    // Phase 2: one wait covers all three — they convert in parallel
+    if (any) _bus.sleepUs(sht4xMeasureUs(prec));
 
-        if (!_selectChannel(channels[i])) continue;
+    // Phase 3: collect, last-triggered first (mux is still on that channel)
+    bool results[SHELVES] = {};
+    for (uint8_t n = SHELVES; n-- > 0;) {
+        readings[n].valid = false;
+        bool blackout = inBlackout(n);
 
-        if (_sht[i].readSample()) {
-            readings[i].rh_pct       = _sht[i].getHumidity();
-            readings[i].temp_c       = _sht[i].getTemperature();
-            readings[i].valid        = true;
-            readings[i].timestamp_ms = millis();
-            _last[i] = readings[i];
+        uint8_t frame[6];
+        float   rh = 0, tc = 0;
+        bool    ok = started[n] && _readFrame(n, frame) && sht4xDecode(frame, rh, tc);
+        results[n] = ok;
+        if (ok) {
+            readings[n].rh_pct       = rh;
+            readings[n].temp_c       = tc;
+            readings[n].valid        = true;
+            readings[n].timestamp_ms = now_ms;
+            // Heater-skewed values must not become the fallback reading
+            if (!blackout) _last[n] = readings[n];
         } else {
             // Return last known reading if available
-            if (_last[i].valid && (millis() - _last[i].timestamp_ms) < SENSOR_STALE_MS) {
-                readings[i] = _last[i];
+            if (_last[n].valid && (now_ms - _last[n].timestamp_ms) < SENSOR_STALE_MS) {
+                readings[n] = _last[n];
             }
         }
+        readings[n].heater_blackout = blackout;
+    }
+
+    // A mux fault says nothing about the shelves behind it — only blame them
+    // when their own transactions failed
+    if (mux_up) {
+        _sup.report(I2C_ADDR_TCA9548A, I2cSupervisor::NO_CHANNEL, !_mux_fault, now_ms);
+        for (uint8_t i = 0; i < SHELVES && !_mux_fault; ++i) {
+            if (tried[i]) _sup.report(I2C_ADDR_SHT45, CHANNELS[i], results[i], now_ms);
+        }
     }
     return readings;
 }
 
-void RhSensorArray::tickHeater() {
-    if ((millis() - _last_heater_ms) < SHT45_HEATER_INTERVAL_MS) return;
-    _last_heater_ms = millis();
+void RhSensorArray::tickHeater(uint32_t now_ms) {
+    const uint32_t slot_ms = SHT45_HEATER_INTERVAL_MS / SHELVES;
+    if (!_heat_armed) {
+        _heat_next_ms = now_ms + slot_ms;
+        _heat_armed   = true;
+    }
 
-    for (uint8_t i = 0; i < 3; ++i) {
-        if (_selectChannel(i)) {
-            // SHT45 medium-power heater pulse (200mW, 1s)
-            // The arduino-sht library handles this via the sensor's built-in command
-            Log.debug("rh", "Heater pulse on shelf %u", i + 1);
+    switch (_heat_phase) {
+        case HeaterPhase::HEATING: {
+            if (_before(now_ms, _heat_until_ms)) return;
+            // Drain the post-pulse measurement — it reads the heated die
+            uint8_t frame[6];
+            _readFrame(_heat_shelf, frame);
+            _heat_phase    = HeaterPhase::RECOVERING;
+            _heat_until_ms = now_ms + _heater_recovery_ms.load(std::memory_order_relaxed);
+            return;
         }
+
+        case HeaterPhase::RECOVERING:
+            _expireRecovery(now_ms);
+            return;
+
+        case HeaterPhase::IDLE:
+        default:
+            if (_before(now_ms, _heat_next_ms)) return;
+            _heat_next_ms += slot_ms;
+            if (!_before(now_ms, _heat_next_ms)) _heat_next_ms = now_ms + slot_ms;
+
+            // A shelf that's backing off skips its turn
+            if (!_sup.allow(I2C_ADDR_SHT45, CHANNELS[_heat_shelf], now_ms)) {
+                _heat_shelf = (_heat_shelf + 1) % SHELVES;
+                return;
+            }
+            _mux_fault = false;
+            if (!_command(_heat_shelf, SHT4X_CMD_HEAT_200MW_1S)) {
+                Log.warn("rh", "Heater pulse on shelf %u failed", _heat_shelf + 1);
+                if (!_mux_fault) _sup.report(I2C_ADDR_SHT45, CHANNELS[_heat_shelf], false, now_ms);
+                _heat_shelf = (_heat_shelf + 1) % SHELVES;
+                return;
+            }
+            Log.debug("rh", "Heater pulse on shelf %u", _heat_shelf + 1);
+            _heat_phase    = HeaterPhase::HEATING;
+            _heat_until_ms = now_ms + SHT4X_HEAT_PULSE_MS;
+            return;
+    }
+}
+
+// ── Private helpers ───────────────────────────────────────────────────────────
+
+void RhSensorArray::_expireRecovery(uint32_t now_ms) {
+    if (_heat_phase != HeaterPhase::RECOVERING || _before(now_ms, _heat_until_ms)) return;
+    Log.debug("rh", "Shelf %u heater recovery done", _heat_shelf + 1);
+    _heat_phase = HeaterPhase::IDLE;
+    _heat_shelf = (_heat_shelf + 1) % SHELVES;
+}
+
+bool RhSensorArray::_muxReady(uint32_t now_ms) {
+    if (!_sup.allow(I2C_ADDR_TCA9548A, I2cSupervisor::NO_CHANNEL, now_ms)) return false;
+    if (!_sup.needsInit(I2C_ADDR_TCA9548A, I2cSupervisor::NO_CHANNEL)) return true;
+    if (_mux.begin()) return true;
+    _sup.report(I2C_ADDR_TCA9548A, I2cSupervisor::NO_CHANNEL, false, now_ms);
+    return false;
+}
+
+bool RhSensorArray::_shelfReady(uint8_t shelf, uint32_t now_ms) {
+    if (!_sup.allow(I2C_ADDR_SHT45, CHANNELS[shelf], now_ms)) return false;
+    if (!_sup.needsInit(I2C_ADDR_SHT45, CHANNELS[shelf])) return true;
+
+    // Back from a backoff or bus clear — reset before trusting it again
+    if (!_command(shelf, SHT4X_CMD_SOFT_RESET)) {
+        if (!_mux_fault) _sup.report(I2C_ADDR_SHT45, CHANNELS[shelf], false, now_ms);
+        return false;
     }
+    _bus.sleepUs(1000);  // Soft reset completes within 1 ms
+    return true;
+}
+
+bool RhSensorArray::_select(uint8_t shelf) {
+    if (_mux.select(CHANNELS[shelf])) return true;
+    _mux_fault = true;
+    return false;
 }
 
-bool RhSensorArray::_selectChannel(uint8_t ch) {
-    return _mux.selectChannel(ch);
+bool RhSensorArray::_command(uint8_t shelf, uint8_t cmd) {
+    if (!_select(shelf)) return false;
+    bool ok = _bus.write(I2C_ADDR_SHT45, &cmd, 1);
+    I2cCounters.record(I2cDevice::SHT45, 1, ok);
+    return ok;
 }
 
-#endif  // !NATIVE_TEST
+bool RhSensorArray::_readFrame(uint8_t shelf, uint8_t frame[6]) {
+    if (!_select(shelf)) return false;
+    bool ok = _bus.read(I2C_ADDR_SHT45, frame, 6);
+    I2cCounters.record(I2cDevice::SHT45, 1, ok);
+    return ok;
+}
@@ -1,7 +1,12 @@
 #pragma once
 #include "sensor_hub.h"
-#include <optional>
+#include "i2c_bus.h"
+#include "tca9548_mux.h"
+#include "i2c_supervisor.h"
+#include "sht4x.h"
+#include "../../include/config.h"
 #include <array>
+#include <atomic>
 
 /**
  * rh_sensor.h — SHT45 ×3 relative humidity/temperature sensors via TCA9548A mux.
@@ -9,37 +14,85 @@
  * The three SHT45s share I2C address 0x44; the TCA9548A selects which one
  * is active by enabling the corresponding mux channel.
  *
+ * Reads are pipelined: a measure command goes to every shelf first, then one
+ * conversion wait covers all three, then the results are collected. The
+ * sensors convert in parallel, so a full read costs about one conversion time
+ * plus bus transfers instead of three. Collection walks the channels in
+ * reverse so the mux is already on the right channel at each turnaround.
+ *
  * The SHT45 on-chip heater is scheduled to run once per SHT45_HEATER_INTERVAL_MS
- * to prevent condensation on the sensor die at high RH.
+ * per shelf to prevent condensation on the sensor die at high RH. Pulses are
+ * staggered (one shelf every interval/3) and asynchronous: tickHeater() sends
+ * the heater command and returns; the sensor task keeps polling the other
+ * shelves while that one heats. The heated shelf reports heater_blackout for
+ * the pulse plus the recovery window, and its inflated temperature / deflated
+ * RH never replace the last good reading used as a fallback.
+ *
+ * The mux and each shelf are tracked separately by I2cSupervisor: a shelf
+ * that keeps failing is skipped (backoff) while the others are still read,
+ * and is soft-reset before its first read after a backoff or bus clear.
  */
-#ifndef NATIVE_TEST
-#include <SHTSensor.h>
-#include <TCA9548.h>
 
 class RhSensorArray {
 public:
-    RhSensorArray() = default;
+    RhSensorArray(I2cBus& bus, I2cSupervisor& sup)
+        : _bus(bus), _sup(sup), _mux(bus, I2C_ADDR_TCA9548A) {}
 
     /** begin() — initialise TCA9548A and all three SHT45s. */
     bool begin();
 
     /**
-     * readAll() — Read all three SHT45 sensors.
+     * readAll(now_ms) — Read all three SHT45 sensors (pipelined).
      * Returns array of 3 RhReading; individual entries have valid=false on failure.
      */
-    std::array<RhReading, 3> readAll();
+    std::array<RhReading, 3> readAll(uint32_t now_ms);
+
+    /** setPrecision(p) — Repeatability mode for subsequent reads. Safe from any task. */
+    void setPrecision(ShtPrecision p) { _precision.store(p, std::memory_order_relaxed); }
+    ShtPrecision precision() const    { return _precision.load(std::memory_order_relaxed); }
+
+    /** tickHeater(now_ms) — Call after readAll(); advances the heater schedule. Never waits. */
+    void tickHeater(uint32_t now_ms);
+
+    /** setHeaterRecovery(ms) — Blackout after each pulse. Safe from any task. */
+    void setHeaterRecovery(uint32_t ms) { _heater_recovery_ms.store(ms, std::memory_order_relaxed); }
 
-    /** tickHeater() — Call regularly; fires heater burst on schedule. */
-    void tickHeater();
+    /** inBlackout(shelf) — True while shelf (0–2) is heating or recovering. */
+    bool inBlackout(uint8_t shelf) const { return _heat_phase != HeaterPhase::IDLE && _heat_shelf == shelf; }
 
 private:
-    TCA9548   _mux;
-    SHTSensor _sht[3];
-    uint32_t  _last_heater_ms = 0;
-    RhReading _last[3]        = {};
+    static constexpr uint8_t SHELVES = 3;
+    static constexpr uint8_t CHANNELS[SHELVES] = {
+        MUX_CH_SHT45_SHELF1, MUX_CH_SHT45_SHELF2, MUX_CH_SHT45_SHELF3
+    };
 
-    bool _selectChannel(uint8_t ch);
+    enum class HeaterPhase : uint8_t { IDLE, HEATING, RECOVERING };
+
+    I2cBus&                   _bus;
+    I2cSupervisor&            _sup;
+    Tca9548Mux                _mux;
+    std::atomic<ShtPrecision> _precision{ShtPrecision::HIGH_PREC};
+    std::atomic<uint32_t>     _heater_recovery_ms{SHT45_HEATER_RECOVERY_MS};
+    RhReading                 _last[SHELVES]  = {};
+    bool                      _mux_fault      = false;  // A select failed since last cleared
+
+    // Heater schedule — sensor task only
+    HeaterPhase _heat_phase    = HeaterPhase::IDLE;
+    uint8_t     _heat_shelf    = 0;      // Shelf heating/recovering, or next to heat
+    uint32_t    _heat_until_ms = 0;      // End of current phase
+    uint32_t    _heat_next_ms  = 0;      // Next pulse slot
+    bool        _heat_armed    = false;  // _heat_next_ms initialised
+
+    static bool _before(uint32_t a, uint32_t b) { return static_cast<int32_t>(a - b) < 0; }
+
+    void _expireRecovery(uint32_t now_ms);
+    bool _muxReady(uint32_t now_ms);
+    bool _shelfReady(uint8_t shelf, uint32_t now_ms);
+    bool _select(uint8_t shelf);
+    bool _command(uint8_t shelf, uint8_t cmd);
+    bool _readFrame(uint8_t shelf, uint8_t frame[6]);
 };
 
+#ifndef NATIVE_TEST
 extern RhSensorArray RhSensors;
 #endif
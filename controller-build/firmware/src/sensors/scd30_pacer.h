@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include "../../include/config.h"
+
+/**
+ * scd30_pacer.h — Predicts when the SCD30 will have a new sample.
+ *
+ * Header-only. Works in both native tests and on ESP32.
+ *
+ * The SCD30 produces one sample per measurement interval on its own clock.
+ * Until the pacer is in phase with it (boot, interval change, bus error) it
+ * asks getDataReady on every poll. After that it skips readiness altogether:
+ * once the interval has elapsed since the last sample the driver reads the
+ * measurement directly, one read per sample.
+ *
+ * A read that finds the previous sample again means the sensor clock runs
+ * slow; the driver just reads again on the next poll. A fast clock can't
+ * show itself that way, so every so many samples the read goes out
+ * SCD30_READY_LEAD_MS early. If that early read already finds a sample the
+ * sensor is ahead and checks stay frequent (every SCD30_RESYNC_EVERY
+ * samples); each early read that finds nothing doubles the spacing, up to
+ * SCD30_RESYNC_MAX, so a sensor in phase costs almost nothing extra.
+ *
+ * Usage (per poll):
+ *   switch (pacer.next(now)) {
+ *       case Scd30Step::PROBE: if (!dataReady()) break;  // then read as below
+ *       case Scd30Step::READ:  readMeasurement();
+ *                              isNew ? pacer.onSample(now) : pacer.onStale(now);
+ *       case Scd30Step::WAIT:  break;
+ *   }
+ */
+
+enum class Scd30Step : uint8_t {
+    WAIT  = 0,   // No sample due; stay off the bus
+    PROBE = 1,   // Out of phase: ask getDataReady, read if ready
+    READ  = 2,   // Sample due: read it directly
+};
+
+class Scd30Pacer {
+public:
+    Scd30Pacer() = default;
+
+    /** setInterval(s) — Track a new measurement interval; resyncs on the next poll. */
+    void setInterval(uint16_t interval_s) {
+        _interval_ms = static_cast<uint32_t>(interval_s) * 1000U;
+        unsync();
+    }
+
+    /** next(now_ms) — What this poll should do on the bus. */
+    Scd30Step next(uint32_t now_ms) const {
+        if (!_synced) return Scd30Step::PROBE;
+        return static_cast<int32_t>(now_ms - _next_ms) >= 0 ? Scd30Step::READ : Scd30Step::WAIT;
+    }
+
+    /** onSample(now_ms) — A new sample was read at now_ms; predict the next one. */
+    void onSample(uint32_t now_ms) {
+        if (_checking) _spacing = SCD30_RESYNC_EVERY;   // Early read hit: sensor is ahead
+        _checking = false;
+        _synced   = true;
+
+        uint32_t lead = 0;
+        if (--_until_check == 0) {
+            _until_check = _spacing;
+            _checking    = SCD30_READY_LEAD_MS < _interval_ms;
+            if (_checking) lead = SCD30_READY_LEAD_MS;
+        }
+        _next_ms = now_ms + _interval_ms - lead;
+    }
+
+    /** onStale(now_ms) — A READ found no new sample; try again at the deadline or next poll. */
+    void onStale(uint32_t now_ms) {
+        if (_checking) {
+            // Early read missed: in phase, so check less often
+            _checking = false;
+            if (_spacing < SCD30_RESYNC_MAX) _spacing *= 2;
+            _until_check = _spacing;
+            _next_ms     = now_ms + SCD30_READY_LEAD_MS;
+        } else {
+            // Deadline read missed: sensor clock slow, sample is imminent
+            _spacing = SCD30_RESYNC_EVERY;
+            _next_ms = now_ms + 1;
+        }
+    }
+
+    /** unsync() — Forget the prediction (e.g. after a bus error); probe until a sample is read. */
+    void unsync() {
+        _synced      = false;
+        _checking    = false;
+        _spacing     = SCD30_RESYNC_EVERY;
+        _until_check = SCD30_RESYNC_EVERY;
+    }
+
+private:
+    uint32_t _interval_ms  = SCD30_MEASUREMENT_INTERVAL_S * 1000U;
+    uint32_t _next_ms      = 0;
+    uint16_t _spacing      = SCD30_RESYNC_EVERY;   // Samples between early reads
+    uint16_t _until_check  = SCD30_RESYNC_EVERY;
+    bool     _synced       = false;
+    bool     _checking     = false;                // Pending read is an early one
+};
@@ -1,8 +1,13 @@
 /**
- * sensor_hub.cpp — Aggregated sensor polling task implementation.
+ * sensor_hub.cpp — Sensor polling task and hardware driver binding.
  *
- * Creates a FreeRTOS task that polls all sensors at SENSOR_TASK_PERIOD_MS
- * intervals and updates the SensorSnapshot under mutex.
+ * Creates a FreeRTOS task that runs each sensor driver when its deadline in
+ * the PollScheduler table comes due, then sleeps until the next one. All bus
+ * I/O fills the private _snapshot; only the finished snapshot is published
+ * (a ~150-byte copy), so readers never contend with I/O.
+ *
+ * The polling logic itself is SensorHubCore (sensor_hub.h); this file binds
+ * it to the real driver globals.
  */
 
 #include "sensor_hub.h"
@@ -18,122 +23,84 @@
 #include "water_level.h"
 
 #include <algorithm>
-#include <cfloat>
 
 SensorHub Sensors;
 
-void SensorHub::begin() {
-    _mutex = xSemaphoreCreateMutex();
+// ── Hardware driver bundle ────────────────────────────────────────────────────
+
+uint32_t HwSensorDrivers::now() { return millis(); }
 
-    // Initialise all sensor drivers
+void HwSensorDrivers::begin() {
     CO2Sensor.begin();
     RhSensors.begin();
     TempProbeArray.begin();
     LightSensorDev.begin();
+}
 
-    // Create polling task
-    xTaskCreatePinnedToCore(
-        _task, "sensors",
-        SENSOR_TASK_STACK, this,
-        SENSOR_TASK_PRIORITY, &_task_handle,
-        0  // Core 0 — sensor I/O separate from control on Core 1
-    );
-
-    Log.info("sensors", "SensorHub started (period=%dms)", SENSOR_TASK_PERIOD_MS);
+void HwSensorDrivers::setCo2Interval(uint16_t interval_s) {
+    CO2Sensor.setMeasurementInterval(interval_s);
 }
 
-bool SensorHub::read(SensorSnapshot& out) const {
-    if (!_initialized) return false;
-    xSemaphoreTake(_mutex, portMAX_DELAY);
-    out = _snapshot;
-    xSemaphoreGive(_mutex);
-    return true;
+std::optional<Co2Reading> HwSensorDrivers::readCo2(uint32_t) {
+    return CO2Sensor.read();
 }
 
-void SensorHub::_task(void* arg) {
-    auto* self = static_cast<SensorHub*>(arg);
-    for (;;) {
-        self->_poll();
-        vTaskDelay(pdMS_TO_TICKS(SENSOR_TASK_PERIOD_MS));
-    }
+std::array<RhReading, 3> HwSensorDrivers::readRh(uint32_t now_ms, ShtPrecision p,
+                                                 uint32_t heater_recovery_ms) {
+    RhSensors.setPrecision(p);
+    RhSensors.setHeaterRecovery(heater_recovery_ms);
+    auto readings = RhSensors.readAll(now_ms);
+    RhSensors.tickHeater(now_ms);
+    return readings;
 }
 
-void SensorHub::_poll() {
-    xSemaphoreTake(_mutex, portMAX_DELAY);
+const std::array<TempProbeReading, DS18B20_PROBE_COUNT>& HwSensorDrivers::readTemps(uint32_t now_ms) {
+    TempProbeArray.service(now_ms);
+    return TempProbeArray.readings();
+}
 
-    // CO2 (SCD30)
-    auto co2 = CO2Sensor.read();
-    if (co2.has_value()) {
-        _snapshot.co2 = co2.value();
-    } else if ((millis() - _snapshot.co2.timestamp_ms) > SENSOR_STALE_MS) {
-        _snapshot.co2.valid = false;
-    }
+bool HwSensorDrivers::readLight(uint32_t now_ms, LightMode m, LightReading& out) {
+    LightSensorDev.setMode(m);
+    if (!LightSensorDev.service(now_ms)) return false;
+    out = LightSensorDev.reading();
+    return true;
+}
 
-    // RH × 3 (SHT45 via TCA9548A)
-    auto rh_readings = RhSensors.readAll();
-    for (int i = 0; i < 3; ++i) {
-        _snapshot.rh[i] = rh_readings[i];
-    }
-    RhSensors.tickHeater();
-
-    // Temperature probes (DS18B20)
-    auto temps = TempProbeArray.readAll();
-    for (int i = 0; i < DS18B20_PROBE_COUNT; ++i) {
-        _snapshot.temp_probe[i]       = temps[i].temp_c;
-        _snapshot.temp_probe_valid[i] = temps[i].valid;
-        _snapshot.temp_probe_ts[i]    = temps[i].timestamp_ms;
-    }
+bool HwSensorDrivers::readWaterLevel(float& pct) {
+    if (!WaterLevelSensor.isValid()) return false;
+    pct = WaterLevelSensor.getLevelPercent();
+    return true;
+}
 
-    // Light (AS7341)
-    auto light = LightSensorDev.readSpectrum();
-    if (light.has_value()) {
-        _snapshot.light = light.value();
-    }
+// ── SensorHub ─────────────────────────────────────────────────────────────────
 
-    // Water level is handled separately via WaterLevelSensor.tick() in controlTask
-    if (WaterLevelSensor.isValid()) {
-        _snapshot.water_level_pct   = WaterLevelSensor.getLevelPercent();
-        _snapshot.water_level_valid = true;
-        _snapshot.water_level_ts    = millis();
-    } else {
-        _snapshot.water_level_valid = false;
-    }
+void SensorHub::begin() {
+    start();
 
-    _updateAggregate();
-    _initialized = true;
+    // Create polling task
+    xTaskCreatePinnedToCore(
+        _task, "sensors",
+        SENSOR_TASK_STACK, this,
+        SENSOR_TASK_PRIORITY, &_task_handle,
+        0  // Core 0 — sensor I/O separate from control on Core 1
+    );
 
-    xSemaphoreGive(_mutex);
+    Log.info("sensors", "SensorHub started (co2=%ums rh=%ums temp=%ums light=%ums)",
+             period(SensorDriver::CO2), period(SensorDriver::RH),
+             period(SensorDriver::TEMP), period(SensorDriver::LIGHT));
 }
 
-void SensorHub::_updateAggregate() {
-    float sum = 0.0f, temp_sum = 0.0f;
-    int   count = 0;
-    float min_rh = FLT_MAX, max_rh = -FLT_MAX;
-
-    for (int i = 0; i < 3; ++i) {
-        if (!_snapshot.rh[i].valid) continue;
-        float rh = _snapshot.rh[i].rh_pct;
-        float tc = _snapshot.rh[i].temp_c;
-        sum      += rh;
-        temp_sum += tc;
-        count++;
-        if (rh < min_rh) min_rh = rh;
-        if (rh > max_rh) max_rh = rh;
-    }
-
-    if (count == 0) {
-        _snapshot.rh_aggregate_pct = 0.0f;
-        _snapshot.temp_aggregate_c = 0.0f;
-        return;
-    }
+void SensorHub::_notifyHook(void* ctx, uint32_t /*generation*/) {
+    xTaskNotify(static_cast<TaskHandle_t>(ctx), NOTIFY_SENSOR_DATA, eSetBits);
+}
 
-    switch (_rh_mode) {
-        case RhAggregation::MIN:     _snapshot.rh_aggregate_pct = min_rh;        break;
-        case RhAggregation::MAX:     _snapshot.rh_aggregate_pct = max_rh;        break;
-        case RhAggregation::AVERAGE:
-        default:                     _snapshot.rh_aggregate_pct = sum / count;   break;
+void SensorHub::_task(void* arg) {
+    auto* self = static_cast<SensorHub*>(arg);
+    for (;;) {
+        uint32_t wait_ms = self->runDue();
+        // Sleep until the next driver is due (at least one tick)
+        vTaskDelay(std::max<TickType_t>(1, pdMS_TO_TICKS(wait_ms)));
     }
-    _snapshot.temp_aggregate_c = temp_sum / count;
 }
 
 #endif  // !NATIVE_TEST
@@ -1,18 +1,34 @@
 #pragma once
+#include <array>
+#include <atomic>
+#include <cfloat>
 #include <cstdint>
 #include <optional>
 
 /**
  * sensor_hub.h — Aggregated sensor snapshot and FreeRTOS polling task.
  *
- * SensorSnapshot is a plain struct populated by the sensor task every
- * SENSOR_TASK_PERIOD_MS milliseconds. Readers access it under a mutex.
+ * SensorSnapshot is a plain struct populated by the sensor task. Each driver
+ * is polled on its own cadence (see poll_scheduler.h) and a new snapshot is
+ * published whenever a poll produced something new: a fresh CO2 sample, a
+ * new RH or probe timestamp, a finished light reading, or a channel going
+ * stale. A poll that only finds the previous values publishes nothing, so
+ * subscribers aren't woken to rerun on unchanged data. The task builds each snapshot in a
+ * private buffer and publishes it through a SeqLock, so readers (control
+ * task, web handlers) never wait on sensor I/O. Tasks that want to react to
+ * new data register with notifyTask() instead of polling.
+ *
+ * The scheduling and aggregation logic lives in SensorHubCore<Drivers>,
+ * which is templated over the driver bundle (static dispatch — no vtable on
+ * device). SensorHub binds it to the real drivers and the FreeRTOS task;
+ * native tests bind it to fakes with scripted values and latencies.
  */
 
 struct RhReading {
     float    rh_pct;
     float    temp_c;
     bool     valid;
+    bool     heater_blackout;  // Shelf heated recently — excluded from control
     uint32_t timestamp_ms;
 };
 
@@ -25,7 +41,10 @@ struct Co2Reading {
 };
 
 struct LightReading {
-    uint16_t channels[11];  // AS7341 11-channel spectral data
+    uint16_t channels[11];  // AS7341 spectral data: F1–F8, Clear, NIR, (flicker)
+    uint16_t channel_mask;  // Bit n set = channels[n] measured in this reading
+    uint8_t  again;         // AGAIN code the counts were taken at (see as7341.h)
+    uint32_t tint_us;       // Integration time the counts were taken at
     bool     valid;
     uint32_t timestamp_ms;
 };
@@ -63,12 +82,369 @@ struct SensorSnapshot {
  */
 enum class RhAggregation : uint8_t { AVERAGE = 0, MIN = 1, MAX = 2 };
 
+#include "poll_scheduler.h"
+#include "sht4x.h"
+#include "as7341.h"
+#include "temp_probe.h"
+#include "../util/seqlock.h"
+#include "../util/filters.h"
+#include "../../include/config.h"
+
+// ── Driver bundle ─────────────────────────────────────────────────────────────
+//
+// SensorHubCore<Drivers> calls these on a Drivers instance it owns. Any type
+// with these members works; nothing is virtual, so on device every call is
+// resolved (and usually inlined) at compile time.
+//
+//   uint32_t now();                                      // Clock, ms
+//   void     begin();                                    // Initialise all sensors
+//   void     setCo2Interval(uint16_t interval_s);        // SCD30 on-chip interval
+//   std::optional<Co2Reading> readCo2(uint32_t now_ms);  // nullopt = no fresh sample
+//   std::array<RhReading, 3>  readRh(uint32_t now_ms, ShtPrecision p,
+//                                    uint32_t heater_recovery_ms);
+//   const std::array<TempProbeReading, DS18B20_PROBE_COUNT>&
+//            readTemps(uint32_t now_ms);                 // One split-phase step
+//   bool     readLight(uint32_t now_ms, LightMode m,
+//                      LightReading& out);               // True = out updated
+//   bool     readWaterLevel(float& pct);                 // False = not valid yet
+
+// ── Per-channel filtering ─────────────────────────────────────────────────────
+
+/**
+ * SensorFilters — Filter chain per published channel, applied by
+ * SensorHubCore to each fresh, valid sample. Change a chain type (and its
+ * make*()) to re-tune a channel; an empty FilterChain<float> is passthrough.
+ * Shelves in a heater blackout bypass the RH chain so the hot, dry reading
+ * never enters its history.
+ */
+struct SensorFilters {
+    using Hampel = HampelFilter<float, SENSOR_HAMPEL_WINDOW>;
+    using Rh     = FilterChain<float, Hampel>;
+    using Co2    = FilterChain<float, Hampel>;
+    using Temp   = FilterChain<float, Hampel>;
+
+    static Rh   makeRh()   { return Rh(Hampel(SENSOR_HAMPEL_K, SENSOR_HAMPEL_FLOOR_RH)); }
+    static Co2  makeCo2()  { return Co2(Hampel(SENSOR_HAMPEL_K, SENSOR_HAMPEL_FLOOR_CO2)); }
+    static Temp makeTemp() { return Temp(Hampel(SENSOR_HAMPEL_K, SENSOR_HAMPEL_FLOOR_TEMP)); }
+};
+
+/**
+ * FilteredChannel<Chain> — One channel's chain plus the last sample fed in.
+ * Drivers hand back their previous reading until a new one lands, so only a
+ * new timestamp enters the chain; a gap longer than SENSOR_STALE_MS starts
+ * the history afresh.
+ */
+template <class Chain>
+struct FilteredChannel {
+    Chain    chain;
+    float    out    = 0.0f;
+    uint32_t ts_ms  = 0;
+    bool     primed = false;
+
+    float apply(float x, uint32_t sample_ts_ms) {
+        if (primed && sample_ts_ms == ts_ms) return out;
+        if (primed && (sample_ts_ms - ts_ms) > SENSOR_STALE_MS) chain.reset();
+        out    = chain.push(x);
+        ts_ms  = sample_ts_ms;
+        primed = true;
+        return out;
+    }
+};
+
+template <class Drivers, class Filters = SensorFilters>
+class SensorHubCore {
+public:
+    SensorHubCore() {
+        for (auto& f : _f_rh)   f.chain = Filters::makeRh();
+        for (auto& f : _f_temp) f.chain = Filters::makeTemp();
+        _f_co2.chain = Filters::makeCo2();
+    }
+
+    /** drivers() — The bound driver bundle (tests script fakes through this). */
+    Drivers& drivers() { return _drv; }
+
+    /**
+     * start() — Initialise all drivers and arm the poll deadlines. Call once,
+     * before the first runDue().
+     */
+    void start();
+
+    /**
+     * runDue() — Poll every driver whose deadline has passed and publish a
+     * snapshot if any of them produced new data. Returns ms until the next
+     * driver is due.
+     */
+    uint32_t runDue();
+
+    /**
+     * read(out) — Copy the latest published SensorSnapshot. Lock-free; never
+     * waits on an in-progress poll.
+     * Returns true if snapshot has been populated at least once.
+     */
+    bool read(SensorSnapshot& out) const { return _published.read(out) != 0; }
+
+    /** readGen(out) — As read(), but returns the copied snapshot's generation (0 = none yet). */
+    uint32_t readGen(SensorSnapshot& out) const { return _published.read(out); }
+
+    /** generation() — Count of snapshots published so far (0 = none yet). */
+    uint32_t generation() const { return _published.generation(); }
+
+    /** Called from the sensor task right after each snapshot is published. Must not block. */
+    using PublishHook = void (*)(void* ctx, uint32_t generation);
+
+    /**
+     * onPublish(fn, ctx) — Register a hook run after every publish. Safe from
+     * any task, concurrently too: the slot is claimed with a compare-exchange
+     * on the count, and the hook runs once its fn is stored. Up to
+     * SENSOR_MAX_SUBSCRIBERS. Returns false when full.
+     */
+    bool onPublish(PublishHook fn, void* ctx) {
+        uint8_t n = _hook_count.load(std::memory_order_relaxed);
+        do {
+            if (n >= SENSOR_MAX_SUBSCRIBERS) return false;
+        } while (!_hook_count.compare_exchange_weak(n, n + 1, std::memory_order_relaxed));
+        _hooks[n].ctx = ctx;
+        _hooks[n].fn.store(fn, std::memory_order_release);   // Ready once fn is visible
+        return true;
+    }
+
+    /** setRhAggregation() — Controls which RH value is written to rh_aggregate_pct. */
+    void setRhAggregation(RhAggregation mode) { _rh_mode.store(mode, std::memory_order_relaxed); }
+
+    /** setRhPrecision() — SHT45 repeatability mode, applied on the next RH poll. */
+    void setRhPrecision(ShtPrecision p) { _rh_precision.store(p, std::memory_order_relaxed); }
+
+    /** setHeaterRecovery() — Blackout after an SHT45 heater pulse, applied on the next RH poll. */
+    void setHeaterRecovery(uint32_t ms) { _heater_recovery_ms.store(ms, std::memory_order_relaxed); }
+
+    /** setLightMode() — AS7341 readout mode, applied from the next complete reading. */
+    void setLightMode(LightMode m) { _light_mode.store(m, std::memory_order_relaxed); }
+
+    /**
+     * setPollConfig(cfg) — Update per-driver poll periods. Safe from any task;
+     * the sensor task applies it before its next scheduling decision.
+     */
+    void setPollConfig(const SensorPollConfig& cfg) { _poll_cfg.write(cfg); }
+
+    /** lastCycleMs()/maxCycleMs() — Time spent in the latest / slowest runDue() that polled. */
+    uint32_t lastCycleMs() const { return _cycle_last_ms.load(std::memory_order_relaxed); }
+    uint32_t maxCycleMs() const  { return _cycle_max_ms.load(std::memory_order_relaxed); }
+
+    /** period(d) — Current poll period of driver d in ms. Sensor task only. */
+    uint32_t period(SensorDriver d) const { return _sched.period(d); }
+
+private:
+    bool _pollDriver(SensorDriver d, uint32_t now_ms);
+    void _updateAggregate();
+
+    Drivers                    _drv;
+    SensorSnapshot             _snapshot    = {};  // Sensor task's private work buffer
+    SeqLock<SensorSnapshot>    _published;
+    std::atomic<RhAggregation> _rh_mode{RhAggregation::AVERAGE};
+    std::atomic<ShtPrecision>  _rh_precision{ShtPrecision::HIGH_PREC};
+    std::atomic<uint32_t>      _heater_recovery_ms{SHT45_HEATER_RECOVERY_MS};
+    std::atomic<LightMode>     _light_mode{LightMode::FULL};
+    std::atomic<uint32_t>      _cycle_last_ms{0};
+    std::atomic<uint32_t>      _cycle_max_ms{0};
+
+    struct Hook {
+        std::atomic<PublishHook> fn{nullptr};
+        void*                    ctx = nullptr;
+    };
+    Hook                 _hooks[SENSOR_MAX_SUBSCRIBERS];
+    std::atomic<uint8_t> _hook_count{0};     // Slots claimed
+
+    FilteredChannel<typename Filters::Rh>   _f_rh[3];                      // Sensor task only
+    FilteredChannel<typename Filters::Co2>  _f_co2;
+    FilteredChannel<typename Filters::Temp> _f_temp[DS18B20_PROBE_COUNT];
+
+    PollScheduler              _sched;              // Sensor task only
+    SeqLock<SensorPollConfig>  _poll_cfg;           // Written by setPollConfig()
+    uint32_t                   _poll_cfg_gen = 0;   // Last generation applied
+};
+
+// ── SensorHubCore implementation ──────────────────────────────────────────────
+
+template <class Drivers, class Filters>
+void SensorHubCore<Drivers, Filters>::start() {
+    _drv.begin();
+
+    // Deadlines start after driver init so nothing begins overdue
+    SensorPollConfig cfg;
+    _poll_cfg_gen = _poll_cfg.read(cfg);  // Defaults unless setPollConfig() ran first
+    _drv.setCo2Interval(cfg.scd30_interval_s);
+    _sched.begin(cfg, _drv.now());
+}
+
+template <class Drivers, class Filters>
+uint32_t SensorHubCore<Drivers, Filters>::runDue() {
+    uint32_t start_ms = _drv.now();
+
+    // Pick up period changes from setPollConfig()
+    if (_poll_cfg.generation() != _poll_cfg_gen) {
+        SensorPollConfig cfg;
+        _poll_cfg_gen = _poll_cfg.read(cfg);
+        _drv.setCo2Interval(cfg.scd30_interval_s);
+        _sched.setPeriods(cfg, _drv.now());
+    }
+
+    bool         ran = false, fresh = false;
+    SensorDriver d;
+    while (_sched.popDue(_drv.now(), d)) {
+        fresh |= _pollDriver(d, _drv.now());
+        ran = true;
+    }
+
+    if (fresh) {
+        // Water level is sampled separately via WaterLevelSensor.tick() in controlTask
+        float pct = 0.0f;
+        if (_drv.readWaterLevel(pct)) {
+            _snapshot.water_level_pct   = pct;
+            _snapshot.water_level_valid = true;
+            _snapshot.water_level_ts    = _drv.now();
+        } else {
+            _snapshot.water_level_valid = false;
+        }
+
+        _updateAggregate();
+        _published.write(_snapshot);
+
+        uint32_t gen = _published.generation();
+        uint8_t  n   = _hook_count.load(std::memory_order_relaxed);
+        for (uint8_t i = 0; i < n; ++i) {
+            PublishHook fn = _hooks[i].fn.load(std::memory_order_acquire);
+            if (fn) fn(_hooks[i].ctx, gen);   // Null = claimed, still being filled in
+        }
+    }
+
+    if (ran) {
+        uint32_t cost = _drv.now() - start_ms;
+        _cycle_last_ms.store(cost, std::memory_order_relaxed);
+        if (cost > _cycle_max_ms.load(std::memory_order_relaxed)) {
+            _cycle_max_ms.store(cost, std::memory_order_relaxed);
+        }
+    }
+
+    return _sched.msUntilNext(_drv.now());
+}
+
+/** _pollDriver(d, now) — Poll one driver into the work snapshot. True if anything in it changed. */
+template <class Drivers, class Filters>
+bool SensorHubCore<Drivers, Filters>::_pollDriver(SensorDriver d, uint32_t now_ms) {
+    switch (d) {
+        case SensorDriver::CO2: {
+            auto co2 = _drv.readCo2(now_ms);
+            if (co2.has_value()) {
+                _snapshot.co2         = co2.value();
+                _snapshot.co2.co2_ppm = _f_co2.apply(co2->co2_ppm, co2->timestamp_ms);
+                return true;
+            }
+            if (_snapshot.co2.valid && (now_ms - _snapshot.co2.timestamp_ms) > SENSOR_STALE_MS) {
+                _snapshot.co2.valid = false;
+                return true;
+            }
+            return false;
+        }
+
+        case SensorDriver::RH: {
+            // RH × 3 (SHT45 via TCA9548A), then advance the heater schedule
+            auto rh_readings = _drv.readRh(now_ms,
+                                           _rh_precision.load(std::memory_order_relaxed),
+                                           _heater_recovery_ms.load(std::memory_order_relaxed));
+            bool changed = false;
+            for (int i = 0; i < 3; ++i) {
+                const RhReading& r    = rh_readings[i];
+                const RhReading& prev = _snapshot.rh[i];
+                changed |= r.timestamp_ms != prev.timestamp_ms || r.valid != prev.valid ||
+                           r.heater_blackout != prev.heater_blackout;
+                _snapshot.rh[i] = r;
+                if (r.valid && !r.heater_blackout) {
+                    _snapshot.rh[i].rh_pct = _f_rh[i].apply(r.rh_pct, r.timestamp_ms);
+                }
+            }
+            return changed;
+        }
+
+        case SensorDriver::TEMP: {
+            // DS18B20 — split-phase: this either starts a conversion or
+            // collects scratchpads, never waits the ~750ms out
+            const auto& temps   = _drv.readTemps(now_ms);
+            bool        changed = false;
+            for (int i = 0; i < DS18B20_PROBE_COUNT; ++i) {
+                changed |= temps[i].timestamp_ms != _snapshot.temp_probe_ts[i] ||
+                           temps[i].valid != _snapshot.temp_probe_valid[i];
+                _snapshot.temp_probe[i]       = temps[i].valid
+                                              ? _f_temp[i].apply(temps[i].temp_c, temps[i].timestamp_ms)
+                                              : temps[i].temp_c;
+                _snapshot.temp_probe_valid[i] = temps[i].valid;
+                _snapshot.temp_probe_ts[i]    = temps[i].timestamp_ms;
+            }
+            return changed;
+        }
+
+        case SensorDriver::LIGHT: {
+            // AS7341 — split-phase: collects the integration started on the
+            // previous poll (if AVALID) and starts the next SMUX pass
+            return _drv.readLight(now_ms, _light_mode.load(std::memory_order_relaxed), _snapshot.light);
+        }
+
+        default:
+            return false;
+    }
+}
+
+template <class Drivers, class Filters>
+void SensorHubCore<Drivers, Filters>::_updateAggregate() {
+    float sum = 0.0f, temp_sum = 0.0f;
+    int   count = 0;
+    float min_rh = FLT_MAX, max_rh = -FLT_MAX;
+
+    for (int i = 0; i < 3; ++i) {
+        // Shelves in a heater blackout read hot and dry — keep them out
+        if (!_snapshot.rh[i].valid || _snapshot.rh[i].heater_blackout) continue;
+        float rh = _snapshot.rh[i].rh_pct;
+        float tc = _snapshot.rh[i].temp_c;
+        sum      += rh;
+        temp_sum += tc;
+        count++;
+        if (rh < min_rh) min_rh = rh;
+        if (rh > max_rh) max_rh = rh;
+    }
+
+    if (count == 0) {
+        _snapshot.rh_aggregate_pct = 0.0f;
+        _snapshot.temp_aggregate_c = 0.0f;
+        return;
+    }
+
+    switch (_rh_mode.load(std::memory_order_relaxed)) {
+        case RhAggregation::MIN:     _snapshot.rh_aggregate_pct = min_rh;        break;
+        case RhAggregation::MAX:     _snapshot.rh_aggregate_pct = max_rh;        break;
+        case RhAggregation::AVERAGE:
+        default:                     _snapshot.rh_aggregate_pct = sum / count;   break;
+    }
+    _snapshot.temp_aggregate_c = temp_sum / count;
+}
+
+// ── Hardware binding ──────────────────────────────────────────────────────────
+
 #ifndef NATIVE_TEST
 #include <freertos/FreeRTOS.h>
-#include <freertos/semphr.h>
 #include <freertos/task.h>
 
-class SensorHub {
+/** Real sensor drivers (the CO2Sensor/RhSensors/... globals). Defined in sensor_hub.cpp. */
+struct HwSensorDrivers {
+    uint32_t now();
+    void     begin();
+    void     setCo2Interval(uint16_t interval_s);
+    std::optional<Co2Reading> readCo2(uint32_t now_ms);
+    std::array<RhReading, 3>  readRh(uint32_t now_ms, ShtPrecision p, uint32_t heater_recovery_ms);
+    const std::array<TempProbeReading, DS18B20_PROBE_COUNT>& readTemps(uint32_t now_ms);
+    bool     readLight(uint32_t now_ms, LightMode m, LightReading& out);
+    bool     readWaterLevel(float& pct);
+};
+
+class SensorHub : public SensorHubCore<HwSensorDrivers> {
 public:
     SensorHub() = default;
 
@@ -76,24 +452,16 @@ public:
     void begin();
 
     /**
-     * read(out) — Copy the latest SensorSnapshot under mutex.
-     * Returns true if snapshot has been populated at least once.
+     * notifyTask(task) — Send task the NOTIFY_SENSOR_DATA notification bit
+     * whenever a new snapshot is published (wait with xTaskNotifyWait).
      */
-    bool read(SensorSnapshot& out) const;
-
-    /** setRhAggregation() — Controls which RH value is written to rh_aggregate_pct. */
-    void setRhAggregation(RhAggregation mode) { _rh_mode = mode; }
+    bool notifyTask(TaskHandle_t task) { return onPublish(&SensorHub::_notifyHook, task); }
 
 private:
     static void _task(void* arg);
-    void        _poll();
-    void        _updateAggregate();
-
-    SemaphoreHandle_t _mutex        = nullptr;
-    TaskHandle_t      _task_handle  = nullptr;
-    SensorSnapshot    _snapshot     = {};
-    bool              _initialized  = false;
-    RhAggregation     _rh_mode      = RhAggregation::AVERAGE;
+    static void _notifyHook(void* ctx, uint32_t generation);
+
+    TaskHandle_t _task_handle = nullptr;
 };
 
 extern SensorHub Sensors;
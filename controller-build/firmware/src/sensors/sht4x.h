@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * sht4x.h — SHT4x (SHT45) command set, timing and frame decoding.
+ *
+ * Header-only. Works in both native tests and on ESP32.
+ *
+ * A measurement is one command byte, a wait for the conversion, then a
+ * 6-byte read: T[2] CRC RH[2] CRC. Conversion time depends on the
+ * repeatability (precision) mode; the values below are datasheet maxima.
+ */
+
+// Names avoid Arduino's HIGH/LOW macros
+enum class ShtPrecision : uint8_t { HIGH_PREC = 0, MEDIUM_PREC = 1, LOW_PREC = 2 };
+
+inline constexpr uint8_t SHT4X_CMD_SERIAL     = 0x89;
+inline constexpr uint8_t SHT4X_CMD_SOFT_RESET = 0x94;
+
+// Heater: 200 mW for 1 s, followed by a high-precision measurement. The
+// sensor NACKs everything until the pulse and measurement are done.
+inline constexpr uint8_t  SHT4X_CMD_HEAT_200MW_1S = 0x39;
+inline constexpr uint32_t SHT4X_HEAT_PULSE_MS     = 1100;
+
+/** sht4xMeasureCommand(p) — Measure T & RH, no heater. */
+inline uint8_t sht4xMeasureCommand(ShtPrecision p) {
+    switch (p) {
+        case ShtPrecision::MEDIUM_PREC: return 0xF6;
+        case ShtPrecision::LOW_PREC:    return 0xE0;
+        case ShtPrecision::HIGH_PREC:
+        default:                   return 0xFD;
+    }
+}
+
+/** sht4xMeasureUs(p) — Maximum conversion time for precision p. */
+inline uint32_t sht4xMeasureUs(ShtPrecision p) {
+    switch (p) {
+        case ShtPrecision::MEDIUM_PREC: return 4500;
+        case ShtPrecision::LOW_PREC:    return 1700;
+        case ShtPrecision::HIGH_PREC:
+        default:                   return 8300;
+    }
+}
+
+/** sht4xCrc8(data, len) — Sensirion CRC-8 (poly 0x31, init 0xFF). */
+inline uint8_t sht4xCrc8(const uint8_t* data, size_t len) {
+    uint8_t crc = 0xFF;
+    while (len--) {
+        crc ^= *data++;
+        for (uint8_t i = 0; i < 8; ++i) {
+            crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x31)
+                               : static_cast<uint8_t>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/**
+ * sht4xDecode(frame, rh_pct, temp_c) — Convert a 6-byte measurement frame.
+ * Returns false if either CRC fails. RH is clamped to 0–100 % as the
+ * datasheet recommends.
+ */
+inline bool sht4xDecode(const uint8_t frame[6], float& rh_pct, float& temp_c) {
+    if (sht4xCrc8(frame, 2) != frame[2] || sht4xCrc8(frame + 3, 2) != frame[5]) return false;
+    uint16_t t_raw  = static_cast<uint16_t>((frame[0] << 8) | frame[1]);
+    uint16_t rh_raw = static_cast<uint16_t>((frame[3] << 8) | frame[4]);
+    temp_c = -45.0f + 175.0f * t_raw / 65535.0f;
+    rh_pct = -6.0f + 125.0f * rh_raw / 65535.0f;
+    if (rh_pct < 0.0f)   rh_pct = 0.0f;
+    if (rh_pct > 100.0f) rh_pct = 100.0f;
+    return true;
+}
@@ -0,0 +1,26 @@
+/**
+ * tca9548_mux.cpp — TCA9548A channel selection.
+ */
+
+#include "tca9548_mux.h"
+#include "i2c_stats.h"
+
+bool Tca9548Mux::begin() {
+    _selected = NONE;
+    return _writeMask(0x00);
+}
+
+bool Tca9548Mux::select(uint8_t ch) {
+    if (ch > 7) return false;
+    if (ch == _selected) return true;
+    if (!_writeMask(static_cast<uint8_t>(1u << ch))) return false;
+    _selected = ch;
+    return true;
+}
+
+bool Tca9548Mux::_writeMask(uint8_t mask) {
+    bool ok = _bus.write(_addr, &mask, 1);
+    I2cCounters.record(I2cDevice::TCA9548A, 1, ok);
+    if (!ok) _selected = NONE;
+    return ok;
+}
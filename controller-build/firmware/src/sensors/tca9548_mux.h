@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include "i2c_bus.h"
+
+/**
+ * tca9548_mux.h — TCA9548A I2C multiplexer with a selected-channel cache.
+ *
+ * The mux's control register holds one bit per downstream channel. Only one
+ * channel is ever enabled here, and the last one written is remembered so a
+ * select() for the channel already enabled costs no bus transaction. Any
+ * failed write drops the cache so the next select() rewrites the register.
+ */
+
+class Tca9548Mux {
+public:
+    static constexpr uint8_t NONE = 0xFF;
+
+    Tca9548Mux(I2cBus& bus, uint8_t addr) : _bus(bus), _addr(addr) {}
+
+    /** begin() — Disable all channels. Returns false if the mux doesn't ACK. */
+    bool begin();
+
+    /** select(ch) — Enable channel ch (0–7) only. Skips the write if already selected. */
+    bool select(uint8_t ch);
+
+    /** invalidate() — Forget the cached channel (e.g. after a bus reset). */
+    void invalidate() { _selected = NONE; }
+
+    /** selected() — Cached channel, or NONE if unknown. */
+    uint8_t selected() const { return _selected; }
+
+private:
+    I2cBus& _bus;
+    uint8_t _addr;
+    uint8_t _selected = NONE;
+
+    bool _writeMask(uint8_t mask);
+};
@@ -4,50 +4,116 @@
 
 #include "temp_probe.h"
 #include "../util/logger.h"
+#include <cstring>
 
 #ifndef NATIVE_TEST
+#include <OneWire.h>
+#include <DallasTemperature.h>
+
+// ── Hardware bus (OneWire + DallasTemperature) ──────────────────────────────
+class DallasOneWireBus : public OneWireBus {
+public:
+    uint8_t search(uint8_t roms[][8], uint8_t max) override {
+        _dt.begin();
+        uint8_t n = 0;
+        while (n < max && _dt.getAddress(roms[n], n)) ++n;
+        return n;
+    }
 
-TempProbes TempProbeArray;
+    void setResolution(uint8_t bits) override { _dt.setResolution(bits); }
 
-uint8_t TempProbes::begin() {
-    _dt.begin();
-    _dt.setResolution(12);  // 12-bit = ~0.0625°C, ~750ms conversion
+    bool startConversion() override {
+        // Issued directly rather than via requestTemperatures(), which would
+        // spin on the bus until the conversion completes.
+        if (!_wire.reset()) return false;
+        _wire.skip();
+        _wire.write(0x44);  // Convert T
+        return true;
+    }
 
-    _count = std::min(static_cast<uint8_t>(_dt.getDeviceCount()),
-                      static_cast<uint8_t>(DS18B20_PROBE_COUNT));
+    bool selectProbe(const uint8_t rom[8]) override {
+        if (!_wire.reset()) return false;
+        _wire.select(rom);
+        return true;
+    }
 
-    // Store ROM addresses (sorted ascending for deterministic ordering)
-    for (uint8_t i = 0; i < _count; ++i) {
-        _dt.getAddress(_roms[i], i);
+    void readScratchpad(uint8_t out[9]) override {
+        _wire.write(0xBE);  // Read Scratchpad
+        for (uint8_t i = 0; i < 9; ++i) out[i] = _wire.read();
     }
 
-    Log.info("temp", "%u DS18B20 probes found on GPIO %d", _count, PIN_ONE_WIRE);
-    return _count;
-}
+private:
+    OneWire           _wire{PIN_ONE_WIRE};
+    DallasTemperature _dt{&_wire};
+};
 
-std::array<TempProbeReading, DS18B20_PROBE_COUNT> TempProbes::readAll() {
-    std::array<TempProbeReading, DS18B20_PROBE_COUNT> readings = {};
+static DallasOneWireBus _dallasBus;
+TempProbes TempProbeArray{_dallasBus};
+#endif
 
-    _dt.requestTemperatures();  // Blocking: ~750ms at 12-bit
+uint8_t TempProbes::begin() {
+    _count = _bus.search(_roms, DS18B20_PROBE_COUNT);
+    _bus.setResolution(DS18B20_RESOLUTION_BITS);
+
+    // Sort ROM addresses ascending for deterministic shelf ordering
+    for (uint8_t i = 1; i < _count; ++i) {
+        for (uint8_t j = i; j > 0 && memcmp(_roms[j - 1], _roms[j], 8) > 0; --j) {
+            uint8_t tmp[8];
+            memcpy(tmp, _roms[j], 8);
+            memcpy(_roms[j], _roms[j - 1], 8);
+            memcpy(_roms[j - 1], tmp, 8);
+        }
+    }
 
     for (uint8_t i = 0; i < DS18B20_PROBE_COUNT; ++i) {
-        readings[i].valid = false;
+        _readings[i] = {};
+        if (i < _count) memcpy(_readings[i].rom, _roms[i], 8);
+    }
+    _phase = Phase::IDLE;
 
-        if (i >= _count) continue;
+    Log.info("temp", "%u DS18B20 probes found on GPIO %d", _count, PIN_ONE_WIRE);
+    return _count;
+}
 
-        float temp = _dt.getTempC(_roms[i]);
-        if (temp == DEVICE_DISCONNECTED_C) {
-            Log.warn("temp", "Probe %u disconnected", i);
-            continue;
-        }
+bool TempProbes::service(uint32_t now_ms) {
+    if (_count == 0) return false;
 
-        readings[i].temp_c       = temp;
-        readings[i].valid        = true;
-        readings[i].timestamp_ms = millis();
-        memcpy(readings[i].rom, _roms[i], 8);
+    // A probe keeps its last good value until it goes stale, even if the
+    // bus stops answering altogether
+    for (uint8_t i = 0; i < _count; ++i) {
+        TempProbeReading& r = _readings[i];
+        if (r.valid && (now_ms - r.timestamp_ms) > SENSOR_STALE_MS) r.valid = false;
     }
 
-    return readings;
+    switch (_phase) {
+        case Phase::IDLE:
+            _startConversion(now_ms);
+            return false;
+
+        case Phase::CONVERTING:
+            if (static_cast<int32_t>(now_ms - _deadline_ms) < 0) return false;
+            _next_probe = 0;
+            _attempt    = 0;
+            [[fallthrough]];
+
+        case Phase::SELECTING:
+            if (!_bus.selectProbe(_roms[_next_probe])) {
+                Log.warn("temp", "Probe %u not answering", _next_probe);   // Retrying won't help
+                return _nextProbe();
+            }
+            _phase = Phase::READING;
+            return false;
+
+        case Phase::READING:
+            if (_readProbe(_next_probe, now_ms)) return _nextProbe();
+            if (++_attempt > DS18B20_CRC_RETRIES) {
+                Log.warn("temp", "Probe %u read failed", _next_probe);
+                return _nextProbe();
+            }
+            _phase = Phase::SELECTING;   // Re-read on the next call, not inline
+            return false;
+    }
+    return false;
 }
 
 const uint8_t* TempProbes::getRom(uint8_t idx) const {
@@ -55,4 +121,54 @@ const uint8_t* TempProbes::getRom(uint8_t idx) const {
     return _roms[idx];
 }
 
-#endif  // !NATIVE_TEST
+uint32_t TempProbes::conversionTimeMs(uint8_t bits) {
+    if (bits < 9)  bits = 9;
+    if (bits > 12) bits = 12;
+    return 750U >> (12 - bits);  // 93 / 187 / 375 / 750 ms
+}
+
+float TempProbes::decodeScratchpad(const uint8_t sp[9], uint8_t bits) {
+    int16_t raw = static_cast<int16_t>((sp[1] << 8) | sp[0]);
+    // Low bits are undefined below 12-bit resolution
+    if (bits < 12) raw &= static_cast<int16_t>(~((1 << (12 - bits)) - 1));
+    return static_cast<float>(raw) * 0.0625f;
+}
+
+// ── Private helpers ───────────────────────────────────────────────────────────
+
+void TempProbes::_startConversion(uint32_t now_ms) {
+    if (!_bus.startConversion()) {
+        Log.warn("temp", "No presence pulse on 1-Wire bus");
+        _phase = Phase::IDLE;
+        return;
+    }
+    _deadline_ms = now_ms + conversionTimeMs(DS18B20_RESOLUTION_BITS);
+    _phase       = Phase::CONVERTING;
+}
+
+bool TempProbes::_readProbe(uint8_t idx, uint32_t now_ms) {
+    uint8_t sp[9];
+    _bus.readScratchpad(sp);
+
+    // All-zero reads (bus shorted low) pass the CRC, so also require the
+    // config register's fixed bits (0bx11111, bit 7 clear).
+    if (onewireCrc8(sp, 8) != sp[8] || (sp[4] & 0x9F) != 0x1F) {
+        _crc_errors++;
+        return false;
+    }
+    TempProbeReading& r = _readings[idx];
+    r.temp_c       = decodeScratchpad(sp, DS18B20_RESOLUTION_BITS);
+    r.valid        = true;
+    r.timestamp_ms = now_ms;
+    return true;
+}
+
+bool TempProbes::_nextProbe() {
+    _attempt = 0;
+    if (++_next_probe < _count) {
+        _phase = Phase::SELECTING;
+        return false;
+    }
+    _phase = Phase::IDLE;   // Round complete; the next call starts the next conversion
+    return true;
+}
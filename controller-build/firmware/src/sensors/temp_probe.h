@@ -1,7 +1,7 @@
 #pragma once
 #include <cstdint>
 #include <array>
-#include <optional>
+#include "onewire_bus.h"
 #include "../../include/config.h"
 
 /**
@@ -11,13 +11,21 @@
  * by ROM address. If fewer than 5 are present, the missing entries have
  * valid=false. Probe order is deterministic (ROM address sorted ascending).
  *
+ * Reads are split-phase so the sensor task never blocks for the ~750 ms
+ * 12-bit conversion. Each service() call does at most one bus step, none
+ * longer than ~6 ms:
+ *   IDLE       → broadcast Convert T, arm the conversion deadline
+ *   CONVERTING → return immediately until the deadline has passed
+ *   SELECTING  → reset + Match ROM for the next probe
+ *   READING    → read its scratchpad and check the CRC. A bad CRC selects
+ *                the probe again on the next call, up to DS18B20_CRC_RETRIES
+ *                times. After the last probe the round is done, and the
+ *                next call starts the next conversion
+ *
  * Hardware notes:
  *   - Pull-up: 2.2 kΩ on GPIO 4 (not the more-common 4.7 kΩ)
  *   - 100 nF decoupling cap at the pull-up junction (close to GPIO 4)
  */
-#ifndef NATIVE_TEST
-#include <OneWire.h>
-#include <DallasTemperature.h>
 
 struct TempProbeReading {
     float    temp_c;
@@ -28,7 +36,7 @@ struct TempProbeReading {
 
 class TempProbes {
 public:
-    TempProbes() = default;
+    explicit TempProbes(OneWireBus& bus) : _bus(bus) {}
 
     /**
      * begin() — Scan 1-Wire bus, store discovered ROM addresses.
@@ -37,10 +45,17 @@ public:
     uint8_t begin();
 
     /**
-     * readAll() — Trigger conversion and read all discovered probes.
-     * Blocking: ~750ms at 12-bit resolution. Call from sensor task only.
+     * service(now_ms) — Advance the conversion state machine by one phase.
+     * Never waits on the bus. Returns true when the last probe of a round
+     * has just been read, i.e. readings() holds a fresh set.
      */
-    std::array<TempProbeReading, DS18B20_PROBE_COUNT> readAll();
+    bool service(uint32_t now_ms);
+
+    /** readings() — Latest per-probe readings (updated as each probe is read). */
+    const std::array<TempProbeReading, DS18B20_PROBE_COUNT>& readings() const { return _readings; }
+
+    /** isConverting() — True while waiting for the conversion deadline. */
+    bool isConverting() const { return _phase == Phase::CONVERTING; }
 
     /** probeCount() — Number of probes discovered at begin(). */
     uint8_t probeCount() const { return _count; }
@@ -48,12 +63,35 @@ public:
     /** getRom(idx) — 8-byte ROM address for probe idx. */
     const uint8_t* getRom(uint8_t idx) const;
 
+    /** crcErrors() — Scratchpad reads rejected by CRC since boot (incl. retried). */
+    uint32_t crcErrors() const { return _crc_errors; }
+
+    /** conversionTimeMs(bits) — Datasheet max conversion time for 9–12 bit. */
+    static uint32_t conversionTimeMs(uint8_t bits);
+
+    /** decodeScratchpad(sp, bits) — Temperature in °C from a CRC-valid scratchpad. */
+    static float decodeScratchpad(const uint8_t sp[9], uint8_t bits);
+
 private:
-    OneWire         _wire{PIN_ONE_WIRE};
-    DallasTemperature _dt{&_wire};
-    uint8_t         _roms[DS18B20_PROBE_COUNT][8] = {};
-    uint8_t         _count = 0;
+    enum class Phase : uint8_t { IDLE, CONVERTING, SELECTING, READING };
+
+    OneWireBus& _bus;
+    uint8_t     _roms[DS18B20_PROBE_COUNT][8] = {};
+    uint8_t     _count = 0;
+
+    Phase       _phase       = Phase::IDLE;
+    uint32_t    _deadline_ms = 0;
+    uint8_t     _next_probe  = 0;
+    uint8_t     _attempt     = 0;   // CRC failures on _next_probe this round
+    uint32_t    _crc_errors  = 0;
+
+    std::array<TempProbeReading, DS18B20_PROBE_COUNT> _readings = {};
+
+    void _startConversion(uint32_t now_ms);
+    bool _readProbe(uint8_t idx, uint32_t now_ms);
+    bool _nextProbe();
 };
 
+#ifndef NATIVE_TEST
 extern TempProbes TempProbeArray;
 #endif
@@ -21,6 +21,16 @@ static uint32_t adc_read_mv() {
     uint32_t raw = adc1_get_raw(ADC1_CHANNEL_6);
     return esp_adc_cal_raw_to_voltage(raw, &_adc_chars);
 }
+
+#if WATER_ADC_OVERSAMPLE
+#include <esp_timer.h>
+static esp_timer_handle_t _adc_timer = nullptr;
+
+// Runs in the esp_timer task (not an ISR), so the ADC driver calls are safe
+static void adc_timer_cb(void* arg) {
+    static_cast<WaterLevel*>(arg)->sample(adc_read_mv());
+}
+#endif
 #endif
 
 WaterLevel WaterLevelSensor;
@@ -30,25 +40,54 @@ void WaterLevel::begin() {
     adc_init();
 #endif
     _avg.reset();
+
+#if WATER_ADC_OVERSAMPLE && !defined(NATIVE_TEST)
+    if (!_adc_timer) {
+        esp_timer_create_args_t args = {};
+        args.callback = adc_timer_cb;
+        args.arg      = this;
+        args.name     = "water_adc";
+        esp_timer_create(&args, &_adc_timer);
+        esp_timer_start_periodic(_adc_timer, 1000000 / WATER_ADC_RATE_HZ);
+    }
+    Log.info("water", "WaterLevel init min=%umV max=%umV, %u Hz / %u oversampling",
+             _min_mv, _max_mv, WATER_ADC_RATE_HZ, WATER_ADC_DECIMATION);
+#else
     Log.info("water", "WaterLevel init min=%umV max=%umV", _min_mv, _max_mv);
+#endif
 }
 
 void WaterLevel::tick() {
-#ifndef NATIVE_TEST
+#if WATER_ADC_OVERSAMPLE
+    uint32_t head = _ring_head.load(std::memory_order_acquire);
+    if (head - _ring_tail > RING) _ring_tail = head - RING;  // Fell behind: keep newest
+    for (; _ring_tail != head; ++_ring_tail) {
+        _pushVoltage(_ring[_ring_tail % RING].load(std::memory_order_relaxed));
+    }
+#elif !defined(NATIVE_TEST)
     uint32_t mv = _readAdcMv();
     _pushVoltage(mv);
 #endif
 }
 
+void WaterLevel::sample(uint32_t mv) {
+    if (mv > 4095) mv = 4095;  // Decimator registers are sized for 12-bit inputs
+    uint32_t out = 0;
+    if (!_cic.push(mv, out)) return;
+    uint32_t head = _ring_head.load(std::memory_order_relaxed);
+    _ring[head % RING].store(out, std::memory_order_relaxed);
+    _ring_head.store(head + 1, std::memory_order_release);
+}
+
 void WaterLevel::_pushVoltage(uint32_t mv_raw) {
     // Clamp to calibrated range
-    uint32_t clamped = std::max(_min_mv, std::min(_max_mv, mv_raw));
-    float pct = 0.0f;
-    if (_max_mv > _min_mv) {
-        pct = 100.0f * static_cast<float>(clamped - _min_mv)
-                     / static_cast<float>(_max_mv - _min_mv);
-    }
-    _avg.push(pct);
+    _avg.push(std::max(_min_mv, std::min(_max_mv, mv_raw)));
+}
+
+float WaterLevel::_toPercent(float mv) const {
+    if (_max_mv <= _min_mv) return 0.0f;
+    return 100.0f * (mv - static_cast<float>(_min_mv))
+                  / static_cast<float>(_max_mv - _min_mv);
 }
 
 uint32_t WaterLevel::_readAdcMv() const {
@@ -61,17 +100,33 @@ uint32_t WaterLevel::_readAdcMv() const {
 
 float WaterLevel::getLevelPercent() const {
     if (_avg.count() < 4) return -1.0f;
-    return _avg.average();
+    // Mean from the exact integer sum, not the truncated integer average()
+    return _toPercent(static_cast<float>(_avg.sum()) / static_cast<float>(_avg.count()));
+}
+
+float WaterLevel::getLevelMinPercent() const {
+    if (!isValid()) return -1.0f;
+    return _toPercent(static_cast<float>(_avg.min()));
+}
+
+float WaterLevel::getLevelMaxPercent() const {
+    if (!isValid()) return -1.0f;
+    return _toPercent(static_cast<float>(_avg.max()));
+}
+
+float WaterLevel::getLevelStdDevPercent() const {
+    if (!isValid() || _max_mv <= _min_mv) return -1.0f;
+    return 100.0f * _avg.stddev() / static_cast<float>(_max_mv - _min_mv);
 }
 
 bool WaterLevel::isBelowThreshold(float low_pct) const {
     if (!isValid()) return false;
-    return _avg.average() < low_pct;
+    return getLevelPercent() < low_pct;
 }
 
 bool WaterLevel::isAboveThreshold(float high_pct) const {
     if (!isValid()) return false;
-    return _avg.average() > high_pct;
+    return getLevelPercent() > high_pct;
 }
 
 void WaterLevel::setCalibration(uint32_t min_mv, uint32_t max_mv) {
@@ -1,6 +1,9 @@
 #pragma once
 #include "../util/rolling_average.h"
+#include "../util/filters.h"
 #include "../../include/config.h"
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 
 /**
@@ -10,9 +13,16 @@
  * and 3.3V Zener (or SMBJ3V3A TVS) before connecting any water-level
  * transmitter. See build guide C3. KIT0139 boards include this protection.
  *
- * Reads ADC voltage, converts to percentage using calibrated min/max,
- * applies a 32-sample rolling average, and provides hysteretic threshold
- * checks for the pump control loop.
+ * Acquisition (WATER_ADC_OVERSAMPLE): a background esp_timer calls sample()
+ * at WATER_ADC_RATE_HZ, and a CIC decimator turns every WATER_ADC_DECIMATION
+ * readings into one sample, handed to tick() through a small lock-free ring.
+ * Without oversampling, tick() takes one ADC read itself.
+ *
+ * Each sample is clamped to the calibrated min/max and kept in a rolling
+ * window of raw millivolts (integer, so the running sum is exact however
+ * long it runs), converted to percent on read. Provides hysteretic threshold
+ * checks for the pump control loop, plus the window's extremes and spread
+ * for diagnosing slosh or a noisy transmitter.
  */
 
 class WaterLevel {
@@ -26,11 +36,18 @@ public:
     void begin();
 
     /**
-     * tick() — Sample ADC and push into rolling average.
-     * Call regularly (e.g. every SENSOR_TASK_PERIOD_MS).
+     * tick() — Push the decimated samples ready since the last call (or take
+     * one ADC read, without oversampling) into the rolling average.
+     * Call regularly (e.g. every CONTROL_TASK_PERIOD_MS).
      */
     void tick();
 
+    /**
+     * sample(mv) — Feed one high-rate ADC reading into the decimator. Called
+     * from the acquisition timer; must not run concurrently with itself.
+     */
+    void sample(uint32_t mv);
+
     /**
      * getLevelPercent() — Returns 0.0–100.0 from rolling average.
      * Returns -1.0 if fewer than 4 samples have been collected.
@@ -56,20 +73,41 @@ public:
      */
     void setCalibration(uint32_t min_mv, uint32_t max_mv);
 
+    /** getLevelMinPercent()/getLevelMaxPercent() — Extremes over the window. -1 if invalid. */
+    float getLevelMinPercent() const;
+    float getLevelMaxPercent() const;
+
+    /** getLevelStdDevPercent() — Standard deviation over the window. -1 if invalid. */
+    float getLevelStdDevPercent() const;
+
     /** isValid() — True once the rolling average has at least 4 samples. */
     bool isValid() const { return _avg.count() >= 4; }
 
 #ifdef NATIVE_TEST
     /** In native tests: inject a voltage reading directly (bypasses ADC). */
     void injectVoltage(uint32_t mv) { _pushVoltage(mv); }
+
+    /** In native tests: feed a raw high-rate stream, as the acquisition timer would. */
+    void injectSamples(const uint32_t* mv, size_t n) {
+        for (size_t i = 0; i < n; ++i) sample(mv[i]);
+    }
 #endif
 
 private:
-    RollingAverage<float, WATER_LEVEL_SAMPLES> _avg;
+    RollingAverage<uint32_t, WATER_LEVEL_SAMPLES> _avg;  // Clamped millivolts
     uint32_t _min_mv = ADC_WATER_LEVEL_MIN_MV;
     uint32_t _max_mv = ADC_WATER_LEVEL_MAX_MV;
 
+    // Acquisition timer → tick() handoff. Single producer (sample()), single
+    // consumer (tick()); if tick() falls a whole ring behind, oldest are lost.
+    static constexpr uint32_t RING = 4;
+    CicDecimator<WATER_ADC_CIC_ORDER, WATER_ADC_DECIMATION> _cic;
+    std::atomic<uint32_t> _ring[RING] = {};
+    std::atomic<uint32_t> _ring_head{0};  // Written by sample()
+    uint32_t              _ring_tail = 0; // tick() only
+
     void _pushVoltage(uint32_t mv_raw);
+    float _toPercent(float mv) const;
     uint32_t _readAdcMv() const;
 };
 
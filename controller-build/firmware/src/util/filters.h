@@ -0,0 +1,331 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+
+/**
+ * filters.h — Streaming sample filters and compile-time filter chains.
+ *
+ * Header-only templates. Works in both native tests and on ESP32.
+ * No heap: every window is a fixed array sized by a template parameter.
+ *
+ * Each filter takes one sample and returns one output:
+ *   T    push(T x);   // Filtered output for this sample
+ *   void reset();     // Forget all history
+ *
+ * Filters:
+ *   MedianFilter<T, N>  — median of the last N samples (lags ~N/2 samples)
+ *   HampelFilter<T, N>  — passes x unless it lies more than k·σ (MAD-based)
+ *                         from the window median, then outputs the median;
+ *                         no lag on clean data
+ *   EmaFilter<T>        — y += α·(x − y)
+ *   LowPassFilter<T>    — first-order Butterworth IIR (bilinear transform)
+ *                         set by cutoff and sample rate
+ *
+ * CicDecimator<ORDER, R, BITS> is the odd one out: it takes R samples per
+ * output (bool push(x, out)), for turning a fast ADC stream into one clean
+ * sample per control tick. It isn't a FilterChain stage.
+ *
+ * FilterChain<T, Stages...> runs stages left to right as one type:
+ *   FilterChain<float, HampelFilter<float, 5>, EmaFilter<float>> rh{{}, EmaFilter<float>(0.3f)};
+ *   float y = rh.push(raw);
+ *
+ * Windowed filters keep their samples sorted, so the median is O(1) and
+ * finding the slot for a sample is O(log N); the insert/evict shift and
+ * Hampel's MAD walk are O(N) with N a handful of samples.
+ */
+
+// ── SortedWindow ──────────────────────────────────────────────────────────────
+
+/** Sliding window of the last N samples, held in arrival order and in sorted order. */
+template<typename T, size_t N>
+class SortedWindow {
+    static_assert(N > 0, "SortedWindow size must be > 0");
+
+public:
+    /** push(x) — Add a sample, evicting the oldest once full. */
+    void push(T x) {
+        if (_count == N) {
+            _erase(_lowerBound(_ring[_head]));
+        } else {
+            _count++;
+        }
+        _ring[_head] = x;
+        _head = (_head + 1) % N;
+        _insert(x);
+    }
+
+    /** median() — Middle sample (mean of the middle two for even counts). T{} if empty. */
+    T median() const {
+        if (_count == 0) return T{};
+        size_t mid = _count / 2;
+        if (_count % 2) return _sorted[mid];
+        return (_sorted[mid - 1] + _sorted[mid]) / T(2);
+    }
+
+    /**
+     * mad(m) — Median absolute deviation of the window from m (normally the
+     * median). Walks outwards from m, merging the two already-sorted sides.
+     */
+    T mad(T m) const {
+        if (_count == 0) return T{};
+        size_t lo = _lowerBound(m);  // Left side: _sorted[lo-1] down to 0
+        size_t hi = lo;              // Right side: _sorted[hi] up
+        size_t want = _count / 2;    // Index of the upper middle deviation
+        T prev = T{}, cur = T{};
+        for (size_t k = 0; k <= want; ++k) {
+            prev = cur;
+            bool take_left = hi >= _count ||
+                             (lo > 0 && (m - _sorted[lo - 1]) <= (_sorted[hi] - m));
+            cur = take_left ? m - _sorted[--lo] : _sorted[hi++] - m;
+        }
+        return (_count % 2) ? cur : (prev + cur) / T(2);
+    }
+
+    size_t count() const { return _count; }
+    bool   full() const  { return _count == N; }
+
+    void reset() {
+        _count = 0;
+        _head  = 0;
+    }
+
+private:
+    T      _ring[N]   = {};  // Arrival order (_head = oldest once full)
+    T      _sorted[N] = {};  // Ascending
+    size_t _count     = 0;
+    size_t _head      = 0;
+
+    size_t _lowerBound(T x) const {
+        size_t lo = 0, hi = _count;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (_sorted[mid] < x) lo = mid + 1; else hi = mid;
+        }
+        return lo;
+    }
+
+    void _erase(size_t i) {
+        for (; i + 1 < N; ++i) _sorted[i] = _sorted[i + 1];
+    }
+
+    void _insert(T x) {
+        // _count already includes x; the tail slot is free
+        size_t i = _count - 1;
+        for (; i > 0 && x < _sorted[i - 1]; --i) _sorted[i] = _sorted[i - 1];
+        _sorted[i] = x;
+    }
+};
+
+// ── Filters ───────────────────────────────────────────────────────────────────
+
+/** MedianFilter<T, N> — Output = median of the last N samples. */
+template<typename T, size_t N>
+class MedianFilter {
+public:
+    T push(T x) {
+        _win.push(x);
+        return _win.median();
+    }
+
+    void reset() { _win.reset(); }
+
+private:
+    SortedWindow<T, N> _win;
+};
+
+/**
+ * HampelFilter<T, N> — Replace outliers with the window median.
+ *
+ * A sample is an outlier when |x − median| > max(k · 1.4826 · MAD, floor)
+ * over the last N samples including x. The floor keeps a flat window
+ * (MAD = 0, common with quantised sensors) from rejecting every real step.
+ * Samples pass through unchanged until the window holds 3.
+ */
+template<typename T, size_t N>
+class HampelFilter {
+    static_assert(N >= 3, "HampelFilter window must be >= 3");
+
+public:
+    explicit HampelFilter(T k_sigma = T(3), T floor = T{})
+        : _k(k_sigma * T(1.4826)), _floor(floor) {}
+
+    T push(T x) {
+        _win.push(x);
+        if (_win.count() < 3) return x;
+        T m     = _win.median();
+        T limit = _k * _win.mad(m);
+        if (limit < _floor) limit = _floor;
+        T dev = x > m ? x - m : m - x;
+        if (dev > limit) {
+            _rejected++;
+            return m;
+        }
+        return x;
+    }
+
+    /** rejected() — Samples replaced by the median since the last reset(). */
+    size_t rejected() const { return _rejected; }
+
+    void reset() {
+        _win.reset();
+        _rejected = 0;
+    }
+
+private:
+    SortedWindow<T, N> _win;
+    T                  _k;
+    T                  _floor;
+    size_t             _rejected = 0;
+};
+
+/** EmaFilter<T> — Exponential moving average; the first sample seeds the output. */
+template<typename T>
+class EmaFilter {
+public:
+    explicit EmaFilter(T alpha = T(0.5)) : _alpha(alpha) {}
+
+    T push(T x) {
+        _y      = _primed ? _y + _alpha * (x - _y) : x;
+        _primed = true;
+        return _y;
+    }
+
+    void reset() { _primed = false; }
+
+private:
+    T    _alpha;
+    T    _y      = T{};
+    bool _primed = false;
+};
+
+/**
+ * LowPassFilter<T> — First-order Butterworth low-pass, bilinear transform:
+ *   y[n] = b·(x[n] + x[n−1]) − a·y[n−1]
+ * with K = tan(π·fc/fs), b = K/(1+K), a = (K−1)/(K+1). Unity DC gain; the
+ * first sample seeds the state so the output starts at the input level.
+ */
+template<typename T>
+class LowPassFilter {
+public:
+    LowPassFilter(T cutoff_hz = T(0.1), T sample_hz = T(1)) { configure(cutoff_hz, sample_hz); }
+
+    /** configure(fc, fs) — Set cutoff and sample rate (fc < fs/2). Keeps state. */
+    void configure(T cutoff_hz, T sample_hz) {
+        T k = static_cast<T>(std::tan(3.14159265358979 * cutoff_hz / sample_hz));
+        _b  = k / (T(1) + k);
+        _a  = (k - T(1)) / (k + T(1));
+    }
+
+    T push(T x) {
+        if (!_primed) {
+            _x1 = _y1 = x;
+            _primed   = true;
+            return x;
+        }
+        T y = _b * (x + _x1) - _a * _y1;
+        _x1 = x;
+        _y1 = y;
+        return y;
+    }
+
+    void reset() { _primed = false; }
+
+private:
+    T    _b  = T{}, _a = T{};
+    T    _x1 = T{}, _y1 = T{};
+    bool _primed = false;
+};
+
+/**
+ * CicDecimator<ORDER, R, BITS> — Cascaded integrator-comb decimator.
+ *
+ * ORDER integrators run at the input rate, ORDER combs at the output rate;
+ * every R inputs yield one output, normalised by the gain R^ORDER and
+ * rounded. ORDER 1 is a boxcar average; each extra order deepens the nulls
+ * at multiples of the output rate (mains hum, motor PWM aliasing). Inputs
+ * are unsigned and at most BITS wide. Registers wrap modulo 2^32, which is
+ * exact as long as BITS + ORDER·log2(R) ≤ 32 (checked at compile time).
+ * The first ORDER−1 outputs only see part of the impulse response, so they
+ * are swallowed.
+ */
+template<uint8_t ORDER, uint32_t R, uint8_t BITS = 12>
+class CicDecimator {
+    static constexpr uint32_t _log2ceil(uint64_t v) { return v <= 1 ? 0 : 1 + _log2ceil((v + 1) / 2); }
+    static constexpr uint64_t _pow(uint64_t b, uint8_t e) { return e == 0 ? 1 : b * _pow(b, e - 1); }
+
+    static_assert(ORDER >= 1, "CicDecimator needs at least one stage");
+    static_assert(R >= 1, "CicDecimator decimation must be >= 1");
+    static_assert(BITS + ORDER * _log2ceil(R) <= 32, "CicDecimator register growth exceeds 32 bits");
+
+public:
+    static constexpr uint64_t GAIN = _pow(R, ORDER);
+
+    /** push(x, out) — Feed one sample; true when out holds a new decimated sample. */
+    bool push(uint32_t x, uint32_t& out) {
+        uint32_t v = x;
+        for (uint8_t i = 0; i < ORDER; ++i) v = (_integ[i] += v);
+        if (++_phase < R) return false;
+        _phase = 0;
+
+        for (uint8_t i = 0; i < ORDER; ++i) {
+            uint32_t d = v - _comb[i];
+            _comb[i]   = v;
+            v          = d;
+        }
+        if (_warmup < ORDER - 1) {
+            _warmup++;
+            return false;
+        }
+        out = static_cast<uint32_t>((static_cast<uint64_t>(v) + GAIN / 2) / GAIN);
+        return true;
+    }
+
+    void reset() {
+        for (uint8_t i = 0; i < ORDER; ++i) _integ[i] = _comb[i] = 0;
+        _phase  = 0;
+        _warmup = 0;
+    }
+
+private:
+    uint32_t _integ[ORDER] = {};
+    uint32_t _comb[ORDER]  = {};
+    uint32_t _phase        = 0;
+    uint8_t  _warmup       = 0;
+};
+
+// ── FilterChain ───────────────────────────────────────────────────────────────
+
+/** FilterChain<T, Stages...> — Stages applied left to right. No stages = passthrough. */
+template<typename T, typename... Stages>
+class FilterChain {
+public:
+    FilterChain() = default;
+
+    template<size_t S = sizeof...(Stages), std::enable_if_t<(S > 0), int> = 0>
+    explicit FilterChain(const Stages&... stages) : _stages(stages...) {}
+
+    T push(T x) { return _push<0>(x); }
+
+    void reset() { std::apply([](auto&... s) { (s.reset(), ...); }, _stages); }
+
+    /** stage<I>() — Access one stage, e.g. to read HampelFilter::rejected(). */
+    template<size_t I>
+    auto& stage() { return std::get<I>(_stages); }
+
+    static constexpr size_t size() { return sizeof...(Stages); }
+
+private:
+    std::tuple<Stages...> _stages;
+
+    template<size_t I>
+    T _push(T x) {
+        if constexpr (I == sizeof...(Stages)) {
+            return x;
+        } else {
+            return _push<I + 1>(std::get<I>(_stages).push(x));
+        }
+    }
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+
+/**
+ * line_stream.h — Copies generated lines into size-capped response chunks.
+ *
+ * Header-only template. Works in both native tests and on ESP32.
+ *
+ * Streaming endpoints format their output a line at a time into a fixed
+ * buffer, while AsyncTCP asks for chunks of whatever size it has room for.
+ * LineStream owns the line buffer and the carry-over between the two: a
+ * line that doesn't fit the chunk is finished at the start of the next one.
+ *
+ * Usage:
+ *   LineStream<128> out;
+ *   size_t n = out.read(buf, cap, [&](char* line, size_t size, size_t& len) {
+ *       if (done) return false;               // No more lines
+ *       len = format(line, size);             // < size; 0 is allowed
+ *       return true;
+ *   });
+ */
+
+template<size_t N>
+class LineStream {
+public:
+    LineStream() = default;
+
+    /**
+     * read(buf, cap, next) — Fill buf with the rest of the pending line, then
+     * lines from next(line, N, len) until cap bytes are written or next()
+     * returns false. Returns bytes written; 0 once next() has run dry.
+     */
+    template<typename Next>
+    size_t read(char* buf, size_t cap, Next&& next) {
+        size_t n = 0;
+        while (n < cap) {
+            if (_pos == _len) {
+                _pos = 0;
+                _len = 0;
+                if (!next(_line, N, _len)) break;
+                if (_len > N) _len = N;
+            }
+            size_t take = _len - _pos;
+            if (take > cap - n) take = cap - n;
+            memcpy(buf + n, _line + _pos, take);
+            _pos += take;
+            n    += take;
+        }
+        return n;
+    }
+
+private:
+    char   _line[N];
+    size_t _len = 0;
+    size_t _pos = 0;
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "seqlock.h"
+
+/**
+ * mailbox.h — Single-slot, latest-wins mailbox between two tasks.
+ *
+ * Header-only template. Works in both native tests and on ESP32.
+ *
+ * The producer overwrites the slot on every post() and never waits; the
+ * consumer takes whatever is newest and learns how many posts it missed.
+ * For handing state to a slower task that only ever cares about the latest
+ * value (a dashboard frame, not a command). Built on SeqLock, so a consumer
+ * preempting the producer mid-post still completes. Waking the consumer is
+ * left to the caller (a task notification on device).
+ *
+ * Usage:
+ *   Mailbox<Frame> box;
+ *   box.post(frame);                 // producer task only
+ *   Frame f;
+ *   if (box.take(f)) { ... }         // consumer task only
+ */
+
+template<typename T>
+class Mailbox {
+public:
+    Mailbox() = default;
+
+    /** post(value) — Replace the slot contents. Single producer; never blocks. */
+    void post(const T& value) { _slot.write(value); }
+
+    /** take(out) — Copy the newest value if it arrived since the last take(). Single consumer. */
+    bool take(T& out) {
+        uint32_t gen = _slot.read(out);
+        if (gen == _taken) return false;
+        if (gen - _taken > 1) _dropped.fetch_add(gen - _taken - 1, std::memory_order_relaxed);
+        _taken = gen;
+        return true;
+    }
+
+    /** pending() — True if a value is waiting that take() hasn't returned yet. Consumer only. */
+    bool pending() const { return _slot.generation() != _taken; }
+
+    /** posted() — Values posted so far. */
+    uint32_t posted() const { return _slot.generation(); }
+
+    /** dropped() — Values overwritten before the consumer took them. */
+    uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+    SeqLock<T>            _slot;
+    uint32_t              _taken = 0;     // Generation last returned (consumer only)
+    std::atomic<uint32_t> _dropped{0};
+};
@@ -1,43 +1,98 @@
 #pragma once
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <type_traits>
 
 /**
  * rolling_average.h — Fixed-size rolling (sliding window) average.
  *
  * Header-only template. Works in both native tests and on ESP32.
  *
+ * Besides the mean, the window tracks its minimum, maximum and variance in
+ * O(1) amortised per push, with no second buffer: min/max come from two
+ * monotonic deques of slot indices, variance from a running sum of squares.
+ *
+ * Numerical stability:
+ *   - Integral T (e.g. raw millivolts) accumulates in 64 bits — exact, so
+ *     the sums never drift however long the window runs.
+ *   - Floating T accumulates in double, and the sums are recomputed from
+ *     the buffer each time the write index wraps (every N pushes), so
+ *     add/subtract rounding can't build up over months of uptime.
+ *
  * Usage:
  *   RollingAverage<float, 32> adc;
  *   adc.push(3.14f);
  *   float avg = adc.average();
+ *   float spread = adc.max() - adc.min();
  */
 
 template<typename T, size_t N>
 class RollingAverage {
     static_assert(N > 0, "RollingAverage size must be > 0");
+    static_assert(std::is_arithmetic<T>::value, "RollingAverage needs an arithmetic type");
 
 public:
-    RollingAverage() : _sum(T{}), _count(0), _head(0) {}
+    /** Accumulator: exact 64-bit for integers, double for floating point. */
+    using Acc  = std::conditional_t<std::is_floating_point<T>::value, double,
+                 std::conditional_t<std::is_signed<T>::value, int64_t, uint64_t>>;
+    /** Type returned by variance()/stddev(). */
+    using Real = std::conditional_t<std::is_floating_point<T>::value, T, float>;
+
+    RollingAverage() = default;
 
     /** Add a new sample. Evicts oldest sample when window is full. */
     void push(T value) {
         if (_count == N) {
-            // Evict oldest
-            _sum -= _buf[_head];
+            // Evict oldest — if it was a current extreme it heads its deque
+            T old = _buf[_head];
+            _sum   -= static_cast<Acc>(old);
+            _sumsq -= static_cast<Acc>(old) * static_cast<Acc>(old);
+            if (_min_q.front() == _head) _min_q.popFront();
+            if (_max_q.front() == _head) _max_q.popFront();
         } else {
             _count++;
         }
         _buf[_head] = value;
-        _sum += value;
+        _sum   += static_cast<Acc>(value);
+        _sumsq += static_cast<Acc>(value) * static_cast<Acc>(value);
+
+        while (!_min_q.empty() && !(_buf[_min_q.back()] < value)) _min_q.popBack();
+        while (!_max_q.empty() && !(value < _buf[_max_q.back()])) _max_q.popBack();
+        _min_q.pushBack(_head);
+        _max_q.pushBack(_head);
+
         _head = (_head + 1) % N;
+        if constexpr (std::is_floating_point<T>::value) {
+            if (_head == 0) _resync();
+        }
     }
 
     /** Returns the current rolling average. Returns T{} if empty. */
     T average() const {
         if (_count == 0) return T{};
-        return _sum / static_cast<T>(_count);
+        return static_cast<T>(_sum / static_cast<Acc>(_count));
+    }
+
+    /** sum() — Sum of the window (exact for integral T). */
+    Acc sum() const { return _sum; }
+
+    /** min()/max() — Smallest/largest sample in the window. T{} if empty. */
+    T min() const { return _count ? _buf[_min_q.front()] : T{}; }
+    T max() const { return _count ? _buf[_max_q.front()] : T{}; }
+
+    /** variance() — Population variance of the window. 0 if empty. */
+    Real variance() const {
+        if (_count == 0) return Real{};
+        double n    = static_cast<double>(_count);
+        double mean = static_cast<double>(_sum) / n;
+        double var  = static_cast<double>(_sumsq) / n - mean * mean;
+        return static_cast<Real>(var > 0.0 ? var : 0.0);
     }
 
+    /** stddev() — Population standard deviation of the window. */
+    Real stddev() const { return static_cast<Real>(std::sqrt(static_cast<double>(variance()))); }
+
     /** Returns number of samples currently in the window. */
     size_t count() const { return _count; }
 
@@ -46,14 +101,44 @@ public:
 
     /** Reset — clear all samples. */
     void reset() {
-        _sum   = T{};
+        _sum   = Acc{};
+        _sumsq = Acc{};
         _count = 0;
         _head  = 0;
+        _min_q.clear();
+        _max_q.clear();
     }
 
 private:
-    T      _buf[N] = {};
-    T      _sum;
-    size_t _count;
-    size_t _head;
+    /** Fixed-capacity deque of window slot indices. */
+    struct SlotDeque {
+        size_t slots[N] = {};
+        size_t first = 0, size = 0;
+
+        bool   empty() const { return size == 0; }
+        size_t front() const { return slots[first]; }
+        size_t back() const  { return slots[(first + size - 1) % N]; }
+        void   pushBack(size_t s) { slots[(first + size) % N] = s; size++; }
+        void   popFront() { first = (first + 1) % N; size--; }
+        void   popBack()  { size--; }
+        void   clear()    { first = 0; size = 0; }
+    };
+
+    T         _buf[N] = {};
+    Acc       _sum    = Acc{};
+    Acc       _sumsq  = Acc{};
+    size_t    _count  = 0;
+    size_t    _head   = 0;
+    SlotDeque _min_q;  // Slots with ascending values, oldest first; front = min
+    SlotDeque _max_q;  // Slots with descending values, oldest first; front = max
+
+    void _resync() {
+        Acc s = Acc{}, sq = Acc{};
+        for (size_t i = 0; i < _count; ++i) {
+            s  += static_cast<Acc>(_buf[i]);
+            sq += static_cast<Acc>(_buf[i]) * static_cast<Acc>(_buf[i]);
+        }
+        _sum   = s;
+        _sumsq = sq;
+    }
 };
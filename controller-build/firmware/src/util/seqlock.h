@@ -0,0 +1,101 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * seqlock.h — Single-writer, multi-reader double-buffered seqlock.
+ *
+ * Header-only template. Works in both native tests and on ESP32.
+ *
+ * The writer fills the slot that is NOT currently published, then flips the
+ * published generation. Readers copy the published slot and retry only if
+ * that slot's sequence number moved underneath them. Because the writer never
+ * touches the published slot, a reader that preempts the writer mid-write
+ * (e.g. a higher-priority task on the same core) still completes without
+ * waiting for the writer to run — reads never block on sensor I/O.
+ *
+ * Payload is stored as relaxed atomic words so concurrent copies are
+ * well-defined; on a 32-bit core these compile to plain loads/stores.
+ *
+ * Usage:
+ *   SeqLock<SensorSnapshot> pub;
+ *   pub.write(work);                 // writer task only
+ *   SensorSnapshot s;
+ *   uint32_t gen = pub.read(s);      // any task; 0 = nothing published yet
+ */
+
+template<typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SeqLock payload must be trivially copyable");
+
+public:
+    SeqLock() = default;
+
+    /** write(value) — Publish a new generation. Single writer only. */
+    void write(const T& value) {
+        uint32_t next = _gen.load(std::memory_order_relaxed) + 1;
+        Slot&    slot = _slots[next & 1];
+
+        uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+        slot.seq.store(seq + 1, std::memory_order_relaxed);   // Odd: write in progress
+        std::atomic_thread_fence(std::memory_order_release);
+
+        uint32_t words[WORDS] = {};
+        memcpy(words, &value, sizeof(T));
+        for (size_t i = 0; i < WORDS; ++i) {
+            slot.data[i].store(words[i], std::memory_order_relaxed);
+        }
+        slot.gen.store(next, std::memory_order_relaxed);
+
+        slot.seq.store(seq + 2, std::memory_order_release);   // Even: stable
+        _gen.store(next, std::memory_order_release);
+    }
+
+    /**
+     * read(out) — Copy the latest published value into out.
+     * Returns its generation, or 0 (out untouched) if nothing published yet.
+     */
+    uint32_t read(T& out) const {
+        for (;;) {
+            uint32_t gen = _gen.load(std::memory_order_acquire);
+            if (gen == 0) return 0;
+            const Slot& slot = _slots[gen & 1];
+
+            uint32_t seq1 = slot.seq.load(std::memory_order_acquire);
+            if (seq1 & 1) continue;  // Writer lapped us; newer slot is stable
+
+            uint32_t words[WORDS];
+            for (size_t i = 0; i < WORDS; ++i) {
+                words[i] = slot.data[i].load(std::memory_order_relaxed);
+            }
+            // The writer may have lapped this slot since _gen was loaded;
+            // report the generation that matches the copied payload
+            uint32_t slot_gen = slot.gen.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (slot.seq.load(std::memory_order_relaxed) == seq1) {
+                memcpy(&out, words, sizeof(T));
+                return slot_gen;
+            }
+        }
+    }
+
+    /** generation() — Number of values published so far (0 = none). */
+    uint32_t generation() const { return _gen.load(std::memory_order_acquire); }
+
+private:
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    struct Slot {
+        std::atomic<uint32_t> seq{0};
+        std::atomic<uint32_t> gen{0};
+        std::atomic<uint32_t> data[WORDS] = {};
+    };
+
+    Slot                  _slots[2];
+    std::atomic<uint32_t> _gen{0};
+};
@@ -1,16 +1,25 @@
 #include "api.h"
 #include "../sensors/sensor_hub.h"
 #include "../sensors/water_level.h"
+#include "../sensors/i2c_stats.h"
+#include "../sensors/i2c_supervisor.h"
 #include "../relay/relay_manager.h"
+#include "../relay/relay_command.h"
 #include "../control/humidity_loop.h"
 #include "../control/co2_loop.h"
 #include "../control/timer_scheduler.h"
+#include "../control/control_timing.h"
+#include "../control/control_config.h"
+#include "ws_broadcaster.h"
+#include "history.h"
+#include "../mqtt/mqtt_bridge.h"
 #include "../config/config_store.h"
 #include "../util/logger.h"
 
 #ifndef NATIVE_TEST
 #include <ESPAsyncWebServer.h>
 #include <ArduinoJson.h>
+#include <memory>
 
 // Module instances (defined in main.cpp or their respective .cpp files)
 extern RelayManager   Relay;
@@ -59,9 +68,10 @@ static void handleGetStatus(AsyncWebServerRequest* req) {
     auto rh_arr = doc["rh"].to<JsonArray>();
     for (int i = 0; i < 3; ++i) {
         auto entry = rh_arr.add<JsonObject>();
-        entry["rh"]    = snap.rh[i].rh_pct;
-        entry["temp"]  = snap.rh[i].temp_c;
-        entry["valid"] = snap.rh[i].valid;
+        entry["rh"]     = snap.rh[i].rh_pct;
+        entry["temp"]   = snap.rh[i].temp_c;
+        entry["valid"]  = snap.rh[i].valid;
+        entry["heater"] = snap.rh[i].heater_blackout;
     }
     doc["rh_aggregate"] = snap.rh_aggregate_pct;
 
@@ -85,6 +95,76 @@ static void handleGetStatus(AsyncWebServerRequest* req) {
     relays["armed"]       = Relay.isArmed();
     relays["manual_mode"] = Relay.isManualMode();
 
+    // API relay commands handed to the control task
+    auto cmds = doc["relay_cmds"].to<JsonObject>();
+    cmds["queued"]  = RelayCmds.queued();
+    cmds["applied"] = RelayCmds.applied();
+    cmds["expired"] = RelayCmds.expired();
+    cmds["full"]    = RelayCmds.full();
+
+    // I2C bus traffic per device (cumulative since boot)
+    auto i2c = doc["i2c"].to<JsonObject>();
+    for (uint8_t i = 0; i < I2C_DEVICE_COUNT; ++i) {
+        auto dev = i2c[I2C_DEVICE_NAMES[i]].to<JsonObject>();
+        dev["tx"]  = I2cCounters.transactions(static_cast<I2cDevice>(i));
+        dev["err"] = I2cCounters.errors(static_cast<I2cDevice>(i));
+    }
+
+    // Fault tracking per address / mux channel (ch -1 = not behind the mux)
+    i2c["bus_clears"] = I2cGuard.busClears();
+    auto health = i2c["health"].to<JsonArray>();
+    for (uint8_t i = 0; i < I2cGuard.slotCount(); ++i) {
+        I2cSupervisor::SlotInfo s = I2cGuard.slot(i);
+        auto h = health.add<JsonObject>();
+        h["addr"]       = s.addr;
+        h["ch"]         = s.channel == I2cSupervisor::NO_CHANNEL ? -1 : s.channel;
+        h["err"]        = s.errors;
+        h["suspended"]  = s.suspended;
+        h["backoff_ms"] = s.backoff_ms;
+    }
+
+    // Control task timing: histograms count ticks per bucket; bucket_us holds
+    // each bucket's lower bound, the last bucket is open-ended
+    auto ctl = doc["control"].to<JsonObject>();
+    ctl["period_us"]     = CtrlTiming.periodUs();
+    ctl["ticks"]         = CtrlTiming.ticks();
+    ctl["overruns"]      = CtrlTiming.overruns();
+    ctl["skipped"]       = CtrlTiming.skipped();
+    ctl["exec_last_us"]  = CtrlTiming.lastExecUs();
+    ctl["exec_max_us"]   = CtrlTiming.maxExecUs();
+    ctl["jitter_max_us"] = CtrlTiming.maxJitterUs();
+    auto bucket_us = ctl["bucket_us"].to<JsonArray>();
+    auto exec_hist = ctl["exec_hist"].to<JsonArray>();
+    auto jit_hist  = ctl["jitter_hist"].to<JsonArray>();
+    for (uint8_t b = 0; b < ControlTiming::BUCKETS; ++b) {
+        bucket_us.add(ControlTiming::bucketFloorUs(b));
+        exec_hist.add(CtrlTiming.execHist(b));
+        jit_hist.add(CtrlTiming.jitterHist(b));
+    }
+
+    // WebSocket clients and their send budget (frames skipped while behind)
+    WsBroadcast.status(doc["ws"].to<JsonObject>());
+
+    // Config persistence
+    auto cfg = doc["config"].to<JsonObject>();
+    cfg["load"]          = Config.loadStatus();
+    cfg["save_pending"]  = Config.pending();
+    cfg["commits"]       = Config.commits();
+    cfg["changed_last"]  = Config.changedLast();
+    cfg["changed_total"] = Config.changedTotal();
+    cfg["gen"]           = CtrlConfig.published();
+    cfg["applied_gen"]   = CtrlConfig.applied();
+
+    // MQTT session and offline backlog
+    auto mqtt = doc["mqtt"].to<JsonObject>();
+    mqtt["enabled"]   = Mqtt.enabled();
+    mqtt["online"]    = Mqtt.online();
+    mqtt["queued"]    = Mqtt.queued();
+    mqtt["dropped"]   = Mqtt.dropped();
+    mqtt["replayed"]  = Mqtt.replayed();
+    mqtt["published"] = Mqtt.published();
+    mqtt["connects"]  = Mqtt.connects();
+
     sendJson(req, doc);
 }
 
@@ -95,6 +175,50 @@ static void handleGetConfig(AsyncWebServerRequest* req) {
     sendJson(req, doc);
 }
 
+// ── GET /api/history ──────────────────────────────────────────────────────────
+// ?series=co2,rh&from=-86400&to=0&res=60 — from/to in seconds since boot;
+// zero or negative values count back from now (defaults: last hour). res is
+// the coarsest acceptable row period. Streamed in chunks from the best tier.
+static int32_t intParam(AsyncWebServerRequest* req, const char* name, int32_t def) {
+    const AsyncWebParameter* p = req->getParam(name);
+    return p ? static_cast<int32_t>(p->value().toInt()) : def;
+}
+
+static void handleGetHistory(AsyncWebServerRequest* req) {
+    if (!SensorHistory.ready()) {
+        req->send(503, "application/json", "{\"error\":\"history unavailable\"}");
+        return;
+    }
+    const AsyncWebParameter* series = req->getParam("series");
+    uint32_t mask = historySeriesMask(series ? series->value().c_str() : nullptr);
+    if (mask == 0) {
+        req->send(400, "application/json", "{\"error\":\"unknown series\"}");
+        return;
+    }
+
+    SensorHistory.lock();
+    int64_t now     = SensorHistory.nowS();
+    auto    resolve = [now](int32_t v) -> uint32_t {
+        int64_t t = v <= 0 ? now + v : v;
+        return t < 0 ? 0 : static_cast<uint32_t>(t);
+    };
+    uint32_t from = resolve(intParam(req, "from", -3600));
+    uint32_t to   = resolve(intParam(req, "to", 0));
+    int32_t  res  = intParam(req, "res", 0);
+    auto query = std::make_shared<HistoryQuery>(SensorHistory, mask, from, to,
+                                                static_cast<uint32_t>(res < 0 ? 0 : res));
+    SensorHistory.unlock();
+    if (from > to) {
+        req->send(400, "application/json", "{\"error\":\"from after to\"}");
+        return;
+    }
+
+    req->send(req->beginChunkedResponse("application/json",
+        [query](uint8_t* buf, size_t max_len, size_t /*index*/) -> size_t {
+            return SensorHistory.read(*query, reinterpret_cast<char*>(buf), max_len);
+        }));
+}
+
 // ── POST /api/config (body handler) ──────────────────────────────────────────
 static void handlePostConfigBody(AsyncWebServerRequest* req,
                                   uint8_t* data, size_t len,
@@ -104,21 +228,65 @@ static void handlePostConfigBody(AsyncWebServerRequest* req,
         req->send(400, "application/json", "{\"error\":\"invalid JSON\"}");
         return;
     }
-    if (!Config.importJson(doc)) {
+    uint8_t changed = 0;
+    if (!Config.importJson(doc, &changed)) {
         req->send(422, "application/json", "{\"error\":\"validation failed\"}");
         return;
     }
 
-    // Push updated config to running control loops (W2 fix)
-    const MarthaConfig& cfg = Config.get();
-    HumLoop.setThresholds(cfg.rh_on_pct, cfg.rh_hysteresis);
-    CO2Loop.setThresholds(cfg.co2_on_ppm, cfg.co2_off_ppm);
-    WaterLevelSensor.setCalibration(cfg.adc_water_min_mv, cfg.adc_water_max_mv);
-    Scheduler.setConfig(cfg.timer);
+    // Control loops pick up the new snapshot at the top of their next pass;
+    // the sensor task's settings are atomics it reads on its next poll
+    const MarthaConfig cfg = Config.get();
+    CtrlConfig.publish(cfg);
     Sensors.setRhAggregation(static_cast<RhAggregation>(cfg.rh_aggregation));
+    Sensors.setRhPrecision(static_cast<ShtPrecision>(cfg.rh_precision));
+    Sensors.setHeaterRecovery(cfg.rh_heater_recovery_ms);
+    Sensors.setLightMode(static_cast<LightMode>(cfg.light_mode));
+    Sensors.setPollConfig(cfg.poll);
     Log.setLevel(static_cast<LogLevel>(cfg.log_level));
 
-    req->send(200, "application/json", "{\"ok\":true}");
+    // changed = settings the debounced save will write (0 = nothing to save)
+    char body[48];
+    snprintf(body, sizeof(body), "{\"ok\":true,\"changed\":%u}", changed);
+    req->send(200, "application/json", body);
+}
+
+// ── Relay commands ────────────────────────────────────────────────────────────
+// Relay actions are queued for the control task (relay_command.h). The POST
+// still answers once the command has been applied or has expired, but never
+// waits on the AsyncTCP task: the response is chunked, and its filler returns
+// RESPONSE_TRY_AGAIN while the ticket is pending, so the server asks again on
+// the connection's next poll. The status line goes out before the outcome is
+// known, so the outcome is in the body: {"ok":true}, or {"ok":false,"error":
+// "relay locked" | "expired" | "timeout"}. A full queue is known at once: 503.
+
+/** sendRelayResult(req, ticket) — Answer with the ticket's outcome once it is known. */
+static void sendRelayResult(AsyncWebServerRequest* req, uint32_t ticket) {
+    if (ticket == 0) {
+        req->send(503, "application/json", "{\"ok\":false,\"error\":\"busy\"}");
+        return;
+    }
+    uint32_t t0 = millis();
+    AsyncWebServerResponse* res = req->beginChunkedResponse("application/json",
+        [ticket, t0](uint8_t* buf, size_t max_len, size_t index) -> size_t {
+            if (index > 0) return 0;   // Body already sent
+            RelayCmdResult r = RelayCmds.result(ticket);
+            // A stalled control task: give up; the command expires unapplied
+            bool timed_out = r == RelayCmdResult::PENDING && millis() - t0 >= 2 * RELAY_CMD_TIMEOUT_MS;
+            if (r == RelayCmdResult::PENDING && !timed_out) return RESPONSE_TRY_AGAIN;
+
+            char body[64];
+            int  n = r == RelayCmdResult::OK
+                       ? snprintf(body, sizeof(body), "{\"ok\":true}")
+                       : snprintf(body, sizeof(body), "{\"ok\":false,\"error\":\"%s\"}",
+                                  timed_out ? "timeout"
+                                  : r == RelayCmdResult::REJECTED ? "relay locked"   // As before the queue
+                                  : relayCmdResultName(r));
+            size_t len = n < 0 ? 0 : static_cast<size_t>(n) < max_len ? static_cast<size_t>(n) : max_len;
+            memcpy(buf, body, len);
+            return len;
+        });
+    req->send(res);
 }
 
 // ── POST /api/relay/:ch/set (body handler) ────────────────────────────────────
@@ -158,10 +326,7 @@ static void handleRelaySetBody(AsyncWebServerRequest* req,
         return;
     }
 
-    bool state = doc["state"].as<bool>();
-    bool ok = Relay.set(ch, state, RelaySource::API);
-    String resp = ok ? "{\"ok\":true}" : "{\"ok\":false,\"error\":\"relay locked\"}";
-    req->send(ok ? 200 : 503, "application/json", resp);
+    sendRelayResult(req, RelayCmds.post(RelayCommand::set(ch, doc["state"].as<bool>())));
 }
 
 // ── POST /api/relay/manual (body handler) ────────────────────────────────────
@@ -173,8 +338,7 @@ static void handleRelayManualBody(AsyncWebServerRequest* req,
         req->send(400, "application/json", "{\"error\":\"expected {manual: bool}\"}");
         return;
     }
-    Relay.setManualMode(doc["manual"].as<bool>());
-    req->send(200, "application/json", "{\"ok\":true}");
+    sendRelayResult(req, RelayCmds.post(RelayCommand::manual(doc["manual"].as<bool>())));
 }
 
 // ── POST /api/log-level (body handler) ───────────────────────────────────────
@@ -199,6 +363,7 @@ static void handleLogLevelBody(AsyncWebServerRequest* req,
 void apiRegisterRoutes(AsyncWebServer& server) {
     server.on("/api/status", HTTP_GET, handleGetStatus);
     server.on("/api/config", HTTP_GET, handleGetConfig);
+    server.on("/api/history", HTTP_GET, handleGetHistory);
 
     server.on("/api/config", HTTP_POST,
         [](AsyncWebServerRequest*){},  // header handler (unused)
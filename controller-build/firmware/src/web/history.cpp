@@ -0,0 +1,325 @@
+/**
+ * history.cpp — Tiered sensor history rings and /api/history streaming.
+ */
+
+#include "history.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// ── Series ────────────────────────────────────────────────────────────────────
+
+static const char* const SERIES_NAMES[HS_COUNT] = {
+    "co2", "rh", "rh1", "rh2", "rh3", "t1", "t2", "t3",
+    "tp1", "tp2", "tp3", "tp4", "tp5", "wl"};
+
+const char* historySeriesName(uint8_t series) {
+    return series < HS_COUNT ? SERIES_NAMES[series] : "";
+}
+
+uint32_t historySeriesMask(const char* list) {
+    if (!list || !*list) return HISTORY_ALL;
+    uint32_t mask = 0;
+    const char* p = list;
+    while (*p) {
+        const char* end = strchr(p, ',');
+        size_t      len = end ? static_cast<size_t>(end - p) : strlen(p);
+        bool        hit = false;
+        for (uint8_t i = 0; i < HS_COUNT; ++i) {
+            if (strlen(SERIES_NAMES[i]) == len && strncmp(SERIES_NAMES[i], p, len) == 0) {
+                mask |= 1u << i;
+                hit = true;
+            }
+        }
+        if (!hit) return 0;
+        if (!end) break;
+        p = end + 1;
+    }
+    return mask;
+}
+
+/** quantise(v, scale) — round(v·scale) as int16; NaN → HISTORY_NONE, saturates. */
+static int16_t quantise(float v, float scale) {
+    if (std::isnan(v)) return HISTORY_NONE;
+    float q = std::round(v * scale);
+    if (q <= static_cast<float>(INT16_MIN + 1)) return INT16_MIN + 1;
+    if (q >= static_cast<float>(INT16_MAX)) return INT16_MAX;
+    return static_cast<int16_t>(q);
+}
+
+HistorySample historySample(const SensorSnapshot& snap, uint32_t t) {
+    HistorySample s;
+    s.t            = t;
+    s.v[HS_CO2]    = snap.co2.valid ? quantise(snap.co2.co2_ppm, 1.0f) : HISTORY_NONE;
+    s.v[HS_RH_A]   = quantise(snap.rh_aggregate_pct, 100.0f);
+    for (uint8_t i = 0; i < 3; ++i) {
+        const RhReading& r = snap.rh[i];
+        s.v[HS_RH0 + i] = r.valid ? quantise(r.rh_pct, 100.0f) : HISTORY_NONE;
+        s.v[HS_TS0 + i] = r.valid ? quantise(r.temp_c, 100.0f) : HISTORY_NONE;
+    }
+    for (uint8_t i = 0; i < 5; ++i) {
+        s.v[HS_TP0 + i] = snap.temp_probe_valid[i] ? quantise(snap.temp_probe[i], 100.0f) : HISTORY_NONE;
+    }
+    s.v[HS_WL] = snap.water_level_valid ? quantise(snap.water_level_pct, 100.0f) : HISTORY_NONE;
+    return s;
+}
+
+// ── HistoryCore ───────────────────────────────────────────────────────────────
+
+size_t HistoryCore::bytesFor(const HistoryLayout& layout) {
+    return layout.rows[0] * sizeof(HistorySample) +
+           (layout.rows[1] + layout.rows[2]) * sizeof(HistoryRollup);
+}
+
+void HistoryCore::init(const HistoryLayout& layout, void* mem) {
+    auto* p = static_cast<uint8_t*>(mem);
+    _raw  = reinterpret_cast<HistorySample*>(p);
+    p    += layout.rows[0] * sizeof(HistorySample);
+    _mid  = reinterpret_cast<HistoryRollup*>(p);
+    p    += layout.rows[1] * sizeof(HistoryRollup);
+    _long = reinterpret_cast<HistoryRollup*>(p);
+
+    for (uint8_t t = 0; t < HISTORY_TIERS; ++t) {
+        _rows[t] = layout.rows[t];
+        _end[t]  = 0;
+        _acc[t]  = {};
+    }
+    _started  = false;
+    _ms       = 0;
+    _last_raw = UINT32_MAX;
+}
+
+void HistoryCore::add(const SensorSnapshot& snap, uint32_t now_ms) {
+    if (!_raw) return;
+    if (!_started) {
+        _started = true;
+        _ms      = now_ms;
+    } else {
+        int32_t dt = static_cast<int32_t>(now_ms - _last_ms);
+        if (dt < 0) return;                       // Out of order; keep time monotonic
+        _ms += static_cast<uint32_t>(dt);
+    }
+    _last_ms = now_ms;
+
+    uint32_t bucket = nowS() / PERIOD_S[0];
+    if (bucket == _last_raw) return;
+    _last_raw = bucket;
+
+    HistorySample s = historySample(snap, bucket * PERIOD_S[0]);
+    _raw[_end[0] % _rows[0]] = s;
+    _end[0]++;
+    _accumulate(1, s);
+    _accumulate(2, s);
+}
+
+void HistoryCore::_accumulate(uint8_t tier, const HistorySample& s) {
+    Acc&     a      = _acc[tier];
+    uint32_t bucket = s.t / PERIOD_S[tier];
+    if (a.open && a.bucket != bucket) _flush(tier);
+    if (!a.open) {
+        a        = {};
+        a.open   = true;
+        a.bucket = bucket;
+        for (uint8_t i = 0; i < HS_COUNT; ++i) {
+            a.min[i] = INT16_MAX;
+            a.max[i] = INT16_MIN;
+        }
+    }
+    for (uint8_t i = 0; i < HS_COUNT; ++i) {
+        int16_t v = s.v[i];
+        if (v == HISTORY_NONE) continue;
+        a.sum[i] += v;
+        a.n[i]++;
+        if (v < a.min[i]) a.min[i] = v;
+        if (v > a.max[i]) a.max[i] = v;
+    }
+}
+
+void HistoryCore::_flush(uint8_t tier) {
+    Acc&           a   = _acc[tier];
+    HistoryRollup& row = (tier == 1 ? _mid : _long)[_end[tier] % _rows[tier]];
+    row.t = a.bucket * PERIOD_S[tier];
+    for (uint8_t i = 0; i < HS_COUNT; ++i) {
+        if (a.n[i] == 0) {
+            row.min[i] = row.avg[i] = row.max[i] = HISTORY_NONE;
+            continue;
+        }
+        // Round half away from zero
+        int32_t half = a.n[i] / 2;
+        row.avg[i]   = static_cast<int16_t>((a.sum[i] + (a.sum[i] < 0 ? -half : half)) / a.n[i]);
+        row.min[i]   = a.min[i];
+        row.max[i]   = a.max[i];
+    }
+    _end[tier]++;
+    a.open = false;
+}
+
+uint32_t HistoryCore::firstSeq(uint8_t tier) const {
+    return _end[tier] > _rows[tier] ? _end[tier] - _rows[tier] : 0;
+}
+
+uint32_t HistoryCore::rowTime(uint8_t tier, uint32_t seq) const {
+    return tier == 0 ? sample(seq).t : rollup(tier, seq).t;
+}
+
+uint32_t HistoryCore::seqAtOrAfter(uint8_t tier, uint32_t t) const {
+    uint32_t lo = firstSeq(tier), hi = _end[tier];
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (rowTime(tier, mid) < t) lo = mid + 1;
+        else                        hi = mid;
+    }
+    return lo;
+}
+
+uint8_t HistoryCore::pickTier(uint32_t from_s, uint32_t to_s, uint32_t res_s) const {
+    uint32_t span = to_s > from_s ? to_s - from_s : 0;
+    for (uint8_t t = 0; t < HISTORY_TIERS; ++t) {
+        if (_rows[t] == 0 || PERIOD_S[t] < res_s) continue;
+        if (span / PERIOD_S[t] > HISTORY_MAX_POINTS) continue;
+        // Never overwritten → holds everything since boot
+        uint32_t first = firstSeq(t);
+        if (first > 0 && rowTime(t, first) > from_s) continue;
+        return t;
+    }
+    return HISTORY_TIERS - 1;
+}
+
+// ── HistoryQuery ──────────────────────────────────────────────────────────────
+
+HistoryQuery::HistoryQuery(const HistoryCore& core, uint32_t series_mask,
+                           uint32_t from_s, uint32_t to_s, uint32_t res_s)
+    : _core(core), _mask(series_mask & HISTORY_ALL), _from(from_s), _to(to_s),
+      _tier(core.pickTier(from_s, to_s, res_s)) {}
+
+char* historyPutValue(char* p, char* end, int16_t v, uint8_t series) {
+    int n;
+    if (v == HISTORY_NONE) {
+        n = snprintf(p, end - p, "null");
+    } else if (series == HS_CO2) {
+        n = snprintf(p, end - p, "%d", v);
+    } else {
+        int32_t a = v < 0 ? -static_cast<int32_t>(v) : v;
+        n = snprintf(p, end - p, "%s%ld.%02ld", v < 0 ? "-" : "",
+                     static_cast<long>(a / 100), static_cast<long>(a % 100));
+    }
+    return n > 0 && p + n < end ? p + n : end;
+}
+
+bool HistoryQuery::_nextLine(char* line, size_t size, size_t& len) {
+    char* p   = line;
+    char* end = line + size;
+
+    switch (_stage) {
+        case Stage::HEADER: {
+            p += snprintf(p, end - p, "{\"now\":%lu,\"res\":%lu,\"from\":%lu,\"to\":%lu,\"series\":[",
+                          static_cast<unsigned long>(_core.nowS()),
+                          static_cast<unsigned long>(HistoryCore::PERIOD_S[_tier]),
+                          static_cast<unsigned long>(_from), static_cast<unsigned long>(_to));
+            bool first = true;
+            for (uint8_t i = 0; i < HS_COUNT; ++i) {
+                if (!(_mask & (1u << i))) continue;
+                p += snprintf(p, end - p, "%s\"%s\"", first ? "" : ",", SERIES_NAMES[i]);
+                first = false;
+            }
+            p += snprintf(p, end - p, "],\"rows\":[");
+            _seq   = _core.seqAtOrAfter(_tier, _from);
+            _stage = Stage::ROWS;
+            break;
+        }
+        case Stage::ROWS: {
+            // Rows overwritten since the last chunk are gone; resume at the oldest held
+            if (_seq < _core.firstSeq(_tier)) _seq = _core.firstSeq(_tier);
+            if (_seq >= _core.endSeq(_tier) || _core.rowTime(_tier, _seq) > _to) {
+                _stage = Stage::FOOTER;
+                return _nextLine(line, size, len);
+            }
+            p += snprintf(p, end - p, "%s[%lu", _first_row ? "" : ",",
+                          static_cast<unsigned long>(_core.rowTime(_tier, _seq)));
+            for (uint8_t i = 0; i < HS_COUNT; ++i) {
+                if (!(_mask & (1u << i))) continue;
+                if (p < end) *p++ = ',';
+                if (_tier == 0) {
+                    p = historyPutValue(p, end, _core.sample(_seq).v[i], i);
+                    continue;
+                }
+                const HistoryRollup& r = _core.rollup(_tier, _seq);
+                if (p < end) *p++ = '[';
+                p = historyPutValue(p, end, r.min[i], i);
+                if (p < end) *p++ = ',';
+                p = historyPutValue(p, end, r.avg[i], i);
+                if (p < end) *p++ = ',';
+                p = historyPutValue(p, end, r.max[i], i);
+                if (p < end) *p++ = ']';
+            }
+            if (p < end) *p++ = ']';
+            _first_row = false;
+            _seq++;
+            break;
+        }
+        case Stage::FOOTER:
+            p += snprintf(p, end - p, "]}");
+            _stage = Stage::DONE;
+            break;
+        case Stage::DONE:
+            return false;
+    }
+    len = p < end ? static_cast<size_t>(p - line) : size - 1;
+    return true;
+}
+
+size_t HistoryQuery::read(char* buf, size_t cap) {
+    return _out.read(buf, cap, [this](char* line, size_t size, size_t& len) {
+        return _nextLine(line, size, len);
+    });
+}
+
+// ── Hardware binding ──────────────────────────────────────────────────────────
+
+#ifndef NATIVE_TEST
+#include <esp_heap_caps.h>
+#include "../util/logger.h"
+
+History SensorHistory;
+
+void History::begin() {
+    _mutex = xSemaphoreCreateMutex();
+
+    size_t bytes = bytesFor(HISTORY_LAYOUT_FULL);
+    void*  mem   = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (mem) {
+        _psram = true;
+        init(HISTORY_LAYOUT_FULL, mem);
+    } else {
+        bytes = bytesFor(HISTORY_LAYOUT_LITE);
+        mem   = heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (!mem) {
+            Log.error("history", "No memory for history (%u bytes); /api/history disabled",
+                      static_cast<unsigned>(bytes));
+            return;
+        }
+        init(HISTORY_LAYOUT_LITE, mem);
+    }
+    Publish.addSink(&History::_sink, this);
+    Log.info("history", "%u bytes in %s; raw %lu s, 1-min %lu h, 15-min %lu h",
+             static_cast<unsigned>(bytes), _psram ? "PSRAM" : "internal RAM",
+             static_cast<unsigned long>(capacity(0) * PERIOD_S[0]),
+             static_cast<unsigned long>(capacity(1) * PERIOD_S[1] / 3600),
+             static_cast<unsigned long>(capacity(2) * PERIOD_S[2] / 3600));
+}
+
+void History::_sink(void* ctx, const PublishFrame& frame) {
+    auto* self = static_cast<History*>(ctx);
+    self->lock();
+    self->add(frame.snap, frame.ts_ms);
+    self->unlock();
+}
+
+size_t History::read(HistoryQuery& query, char* buf, size_t cap) {
+    lock();
+    size_t n = query.read(buf, cap);
+    unlock();
+    return n;
+}
+
+#endif  // !NATIVE_TEST
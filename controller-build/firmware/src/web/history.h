@@ -0,0 +1,239 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "publisher.h"
+#include "../../include/config.h"
+#include "../util/line_stream.h"
+
+/**
+ * history.h — Tiered in-RAM sensor history behind GET /api/history.
+ *
+ * Three rings, each a fixed block allocated once at boot:
+ *
+ *   tier  period  rows (PSRAM)      span     row
+ *     0     2 s   HISTORY_RAW_ROWS   1 h     one value per series
+ *     1    60 s   HISTORY_MID_ROWS   48 h    min/avg/max per series
+ *     2   900 s   HISTORY_LONG_ROWS  30 d    min/avg/max per series
+ *
+ * Without PSRAM the *_ROWS_LITE sizes are used (same tiers, shorter spans).
+ * Every tier is fed from the 2 s samples, so a rollup's avg is the mean of
+ * the raw samples in its bucket. Values are fixed-point int16 in the same
+ * units as telemetry_frame.h (ppm, 0.01 %, 0.01 °C); a missing or invalid
+ * reading is HISTORY_NONE and is left out of rollups.
+ *
+ * Time is seconds since boot, kept 64-bit internally so the 32-bit millis()
+ * wrap doesn't break the rings; rows are stamped with their bucket start.
+ *
+ * HistoryCore and HistoryQuery are portable and not thread-safe; the
+ * hardware History class feeds the core from a Publisher sink and
+ * serialises access with a mutex.
+ */
+
+/** Recorded series, in JSON column order. */
+enum HistorySeries : uint8_t {
+    HS_CO2   = 0,
+    HS_RH_A  = 1,
+    HS_RH0   = 2,   // Shelf RH 1–3  = 2..4
+    HS_TS0   = 5,   // Shelf temp 1–3 = 5..7
+    HS_TP0   = 8,   // Substrate probes 1–5 = 8..12
+    HS_WL    = 13,
+    HS_COUNT = 14
+};
+
+inline constexpr int16_t  HISTORY_NONE     = INT16_MIN;
+inline constexpr uint32_t HISTORY_ALL      = (1u << HS_COUNT) - 1;
+inline constexpr uint8_t  HISTORY_TIERS    = 3;
+
+/** historySeriesName(s) — JSON/query name of a series, e.g. "rh2", "tp5". */
+const char* historySeriesName(uint8_t series);
+
+/** historySeriesMask(list) — Bitmask for a comma-separated name list; 0 if any name is unknown. */
+uint32_t historySeriesMask(const char* list);
+
+/**
+ * historyPutValue(p, end, v, series) — Append a quantised value in display
+ * units (ppm, or two decimals), or null. Returns the new end of text.
+ */
+char* historyPutValue(char* p, char* end, int16_t v, uint8_t series);
+
+/** One 2 s sample. */
+struct HistorySample {
+    uint32_t t;
+    int16_t  v[HS_COUNT];
+};
+
+/** One rollup bucket. */
+struct HistoryRollup {
+    uint32_t t;
+    int16_t  min[HS_COUNT];
+    int16_t  avg[HS_COUNT];
+    int16_t  max[HS_COUNT];
+};
+
+/** Ring sizes, in rows per tier. */
+struct HistoryLayout {
+    uint32_t rows[HISTORY_TIERS];
+};
+
+inline constexpr HistoryLayout HISTORY_LAYOUT_FULL = {
+    {HISTORY_RAW_ROWS, HISTORY_MID_ROWS, HISTORY_LONG_ROWS}};
+inline constexpr HistoryLayout HISTORY_LAYOUT_LITE = {
+    {HISTORY_RAW_ROWS_LITE, HISTORY_MID_ROWS_LITE, HISTORY_LONG_ROWS_LITE}};
+
+/** historySample(snap, t) — Quantise a snapshot to a 2 s sample stamped t. */
+HistorySample historySample(const SensorSnapshot& snap, uint32_t t);
+
+class HistoryCore {
+public:
+    static constexpr uint32_t PERIOD_S[HISTORY_TIERS] = {
+        HISTORY_RAW_PERIOD_S, HISTORY_MID_PERIOD_S, HISTORY_LONG_PERIOD_S};
+
+    HistoryCore() = default;
+
+    /** bytesFor(layout) — Size of the block init() needs. */
+    static size_t bytesFor(const HistoryLayout& layout);
+
+    /**
+     * init(layout, mem) — Carve the rings out of mem (bytesFor(layout) bytes,
+     * 4-byte aligned, owned by the caller). Clears any previous history.
+     */
+    void init(const HistoryLayout& layout, void* mem);
+
+    /**
+     * add(snap, now_ms) — Record a snapshot. Keeps at most one sample per
+     * 2 s bucket (later calls in the same bucket are ignored) and closes any
+     * rollup bucket the new sample moves past.
+     */
+    void add(const SensorSnapshot& snap, uint32_t now_ms);
+
+    /** ready() — init() has been given memory. */
+    bool ready() const { return _raw != nullptr; }
+
+    /** nowS() — Seconds since boot of the latest add(). */
+    uint32_t nowS() const { return static_cast<uint32_t>(_ms / 1000); }
+
+    /**
+     * pickTier(from, to, res) — Finest tier that still holds `from` (or has
+     * held everything since boot), whose period is at least res and which
+     * returns at most HISTORY_MAX_POINTS rows for [from, to]. Falls back to
+     * the coarsest tier.
+     */
+    uint8_t pickTier(uint32_t from_s, uint32_t to_s, uint32_t res_s) const;
+
+    /** Row sequence numbers: [firstSeq, endSeq) are held; older rows were overwritten. */
+    uint32_t firstSeq(uint8_t tier) const;
+    uint32_t endSeq(uint8_t tier) const { return _end[tier]; }
+    uint32_t capacity(uint8_t tier) const { return _rows[tier]; }
+
+    /** seqAtOrAfter(tier, t) — First held row stamped >= t (endSeq if none). */
+    uint32_t seqAtOrAfter(uint8_t tier, uint32_t t) const;
+
+    /** rowTime(tier, seq) — Timestamp of a held row. */
+    uint32_t rowTime(uint8_t tier, uint32_t seq) const;
+
+    const HistorySample& sample(uint32_t seq) const { return _raw[seq % _rows[0]]; }
+    const HistoryRollup& rollup(uint8_t tier, uint32_t seq) const {
+        return (tier == 1 ? _mid : _long)[seq % _rows[tier]];
+    }
+
+private:
+    struct Acc {
+        bool     open;
+        uint32_t bucket;
+        int32_t  sum[HS_COUNT];
+        int16_t  min[HS_COUNT];
+        int16_t  max[HS_COUNT];
+        uint16_t n[HS_COUNT];
+    };
+
+    void _accumulate(uint8_t tier, const HistorySample& s);
+    void _flush(uint8_t tier);
+
+    HistorySample* _raw  = nullptr;
+    HistoryRollup* _mid  = nullptr;
+    HistoryRollup* _long = nullptr;
+    uint32_t       _rows[HISTORY_TIERS] = {};
+    uint32_t       _end[HISTORY_TIERS]  = {};   // Rows ever written per tier
+    Acc            _acc[HISTORY_TIERS]  = {};   // [0] unused
+
+    bool     _started  = false;
+    uint32_t _last_ms  = 0;
+    uint64_t _ms       = 0;     // Uptime, wrap-extended
+    uint32_t _last_raw = 0;     // Last 2 s bucket recorded
+};
+
+/**
+ * HistoryQuery — Streams one /api/history response as JSON, chunk by chunk:
+ *
+ *   {"now":7260,"res":60,"from":3600,"to":7260,"series":["co2","rh"],
+ *    "rows":[[3600,[812,816,820],[88.10,88.64,89.02]],...]}
+ *
+ * Raw rows carry one value per series: [t, co2, rh]. Rollup rows carry
+ * [min, avg, max]. Missing values are null. Rows the writer overwrites
+ * while a response is streaming are skipped, never sent torn.
+ */
+class HistoryQuery {
+public:
+    /** Resolves the tier; from/to are absolute seconds since boot. */
+    HistoryQuery(const HistoryCore& core, uint32_t series_mask,
+                 uint32_t from_s, uint32_t to_s, uint32_t res_s);
+
+    /**
+     * read(buf, cap) — Write the next part of the response into buf.
+     * Returns bytes written; 0 once the response is complete.
+     */
+    size_t read(char* buf, size_t cap);
+
+    uint8_t tier() const { return _tier; }
+
+private:
+    enum class Stage : uint8_t { HEADER, ROWS, FOOTER, DONE };
+
+    bool _nextLine(char* line, size_t size, size_t& len);   // Format the next piece
+
+    const HistoryCore& _core;
+    uint32_t _mask;
+    uint32_t _from, _to;
+    uint8_t  _tier;
+    Stage    _stage = Stage::HEADER;
+    uint32_t _seq   = 0;
+    bool     _first_row = true;
+    LineStream<HISTORY_LINE_MAX> _out;
+};
+
+// ── Hardware binding ──────────────────────────────────────────────────────────
+
+#ifndef NATIVE_TEST
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+class History : public HistoryCore {
+public:
+    History() = default;
+
+    /**
+     * begin() — Allocate the rings (full layout in PSRAM if present, else the
+     * lite layout in internal RAM) and subscribe to Publish.
+     */
+    void begin();
+
+    /** read(query, buf, cap) — query.read() under the history lock (web task). */
+    size_t read(HistoryQuery& query, char* buf, size_t cap);
+
+    /** lock()/unlock() — Hold the writer off while building a query. */
+    void lock()   { xSemaphoreTake(_mutex, portMAX_DELAY); }
+    void unlock() { xSemaphoreGive(_mutex); }
+
+    /** psram() — Whether the full layout is in use. */
+    bool psram() const { return _psram; }
+
+private:
+    static void _sink(void* ctx, const PublishFrame& frame);
+
+    SemaphoreHandle_t _mutex = nullptr;
+    bool              _psram = false;
+};
+
+extern History SensorHistory;
+
+#endif  // !NATIVE_TEST
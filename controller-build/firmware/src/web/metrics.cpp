@@ -0,0 +1,271 @@
+/**
+ * metrics.cpp — Prometheus /metrics: line formatter, stream, and (hardware
+ * only) the metric family table.
+ */
+
+#include "metrics.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// ── PromLine ──────────────────────────────────────────────────────────────────
+
+void PromLine::_append(const char* s) {
+    while (*s && _len + 1 < _cap) _buf[_len++] = *s++;
+    _buf[_len] = '\0';
+}
+
+void PromLine::_head(const char* key, const char* val) {
+    _append(_name);
+    if (key) {
+        _append("{");
+        _append(key);
+        _append("=\"");
+        _append(val);
+        _append("\"}");
+    }
+    _append(" ");
+}
+
+void PromLine::put(double v, const char* key, const char* val) {
+    _head(key, val);
+    char num[24];
+    if (std::isnan(v))      snprintf(num, sizeof(num), "NaN");
+    else if (std::isinf(v)) snprintf(num, sizeof(num), v > 0 ? "+Inf" : "-Inf");
+    else                    snprintf(num, sizeof(num), "%.7g", v);
+    _append(num);
+    _append("\n");
+}
+
+void PromLine::put(uint64_t v, const char* key, const char* val) {
+    _head(key, val);
+    char num[24];
+    snprintf(num, sizeof(num), "%llu", static_cast<unsigned long long>(v));
+    _append(num);
+    _append("\n");
+}
+
+// ── MetricsStream ─────────────────────────────────────────────────────────────
+
+bool MetricsStream::_nextLine(char* line, size_t size, size_t& len) {
+    while (_fam < _count) {
+        const MetricFamily& f = _fams[_fam];
+        if (_item < 0) {
+            int n = snprintf(line, size, "# HELP %s %s\n# TYPE %s %s\n",
+                             f.name, f.help, f.name, f.type);
+            len   = n < 0 ? 0 : (static_cast<size_t>(n) < size ? n : size - 1);
+            _item = 0;
+            return true;
+        }
+        PromLine out(line, size, f.name);
+        if (_item <= UINT8_MAX && f.sample(out, static_cast<uint8_t>(_item))) {
+            _item++;
+            if (out.len() == 0) continue;      // Sample not available right now
+            len = out.len();
+            return true;
+        }
+        _fam++;
+        _item = -1;
+    }
+    return false;
+}
+
+size_t MetricsStream::read(char* buf, size_t cap) {
+    return _out.read(buf, cap, [this](char* line, size_t size, size_t& len) {
+        return _nextLine(line, size, len);
+    });
+}
+
+// ── Hardware: metric families ─────────────────────────────────────────────────
+
+#ifndef NATIVE_TEST
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_timer.h>
+#include <memory>
+#include "../sensors/sensor_hub.h"
+#include "../sensors/i2c_stats.h"
+#include "../sensors/i2c_supervisor.h"
+#include "../relay/relay_manager.h"
+#include "../control/humidity_loop.h"
+#include "../control/co2_loop.h"
+#include "../control/control_timing.h"
+#include "publisher.h"
+#include "ws_broadcaster.h"
+#include "../mqtt/mqtt_bridge.h"
+
+extern RelayManager Relay;
+extern SensorHub    Sensors;
+extern HumidityLoop HumLoop;
+extern Co2Loop      CO2Loop;
+
+static const char* const INDEX_LABEL[] = {"1", "2", "3", "4", "5"};
+static const char* const TASK_NAMES[]  = {"ctrl", "sensors", "publish", "mqtt", "async_tcp", "loopTask"};
+
+static SensorSnapshot snapshot() {
+    SensorSnapshot s = {};
+    Sensors.read(s);
+    return s;
+}
+
+/** METRIC_ONCE(expr) — Sample callback for a family with one unlabelled sample. */
+#define METRIC_ONCE(expr) [](PromLine& out, uint8_t i) { if (i) return false; out.put(expr); return true; }
+
+static const MetricFamily FAMILIES[] = {
+    {"martha_build_info", "gauge", "Firmware version",
+     [](PromLine& out, uint8_t i) { if (i) return false; out.put(true, "version", MARTHA_FW_VERSION); return true; }},
+    {"martha_uptime_seconds", "gauge", "Time since boot",
+     METRIC_ONCE(static_cast<uint64_t>(esp_timer_get_time() / 1000000))},
+
+    // Sensors
+    {"martha_co2_ppm", "gauge", "SCD30 CO2 concentration",
+     METRIC_ONCE(static_cast<double>(snapshot().co2.co2_ppm))},
+    {"martha_rh_aggregate_percent", "gauge", "Shelf RH as aggregated for the humidity loop",
+     METRIC_ONCE(static_cast<double>(snapshot().rh_aggregate_pct))},
+    {"martha_shelf_rh_percent", "gauge", "SHT45 relative humidity per shelf",
+     [](PromLine& out, uint8_t i) {
+         if (i >= 3) return false;
+         out.put(static_cast<double>(snapshot().rh[i].rh_pct), "shelf", INDEX_LABEL[i]);
+         return true;
+     }},
+    {"martha_shelf_temp_celsius", "gauge", "SHT45 air temperature per shelf",
+     [](PromLine& out, uint8_t i) {
+         if (i >= 3) return false;
+         out.put(static_cast<double>(snapshot().rh[i].temp_c), "shelf", INDEX_LABEL[i]);
+         return true;
+     }},
+    {"martha_substrate_temp_celsius", "gauge", "DS18B20 substrate temperature per probe",
+     [](PromLine& out, uint8_t i) {
+         if (i >= DS18B20_PROBE_COUNT) return false;
+         out.put(static_cast<double>(snapshot().temp_probe[i]), "probe", INDEX_LABEL[i]);
+         return true;
+     }},
+    {"martha_water_level_percent", "gauge", "Reservoir water level",
+     METRIC_ONCE(static_cast<double>(snapshot().water_level_pct))},
+    {"martha_sensor_valid", "gauge", "1 if the sensor's latest reading is valid",
+     [](PromLine& out, uint8_t i) {
+         static const char* const NAMES[] = {"co2", "shelf1", "shelf2", "shelf3", "probe1",
+                                             "probe2", "probe3", "probe4", "probe5", "water"};
+         if (i >= 10) return false;
+         SensorSnapshot s = snapshot();
+         bool v = i == 0 ? s.co2.valid
+                : i < 4  ? s.rh[i - 1].valid
+                : i < 9  ? s.temp_probe_valid[i - 4]
+                : s.water_level_valid;
+         out.put(v, "sensor", NAMES[i]);
+         return true;
+     }},
+
+    // Relays
+    {"martha_relay_on", "gauge", "1 if the relay is commanded ON",
+     [](PromLine& out, uint8_t i) {
+         if (i >= RELAY_CHANNEL_COUNT) return false;
+         out.put(Relay.get(static_cast<RelayChannel>(i)), "channel", RELAY_CHANNEL_NAMES[i]);
+         return true;
+     }},
+    {"martha_relay_on_seconds_total", "counter", "Cumulative time commanded ON since boot",
+     [](PromLine& out, uint8_t i) {
+         if (i >= RELAY_CHANNEL_COUNT) return false;
+         out.put(static_cast<double>(Relay.onTimeMs(static_cast<RelayChannel>(i))) / 1000.0,
+                 "channel", RELAY_CHANNEL_NAMES[i]);
+         return true;
+     }},
+    {"martha_relay_switch_on_total", "counter", "OFF to ON transitions since boot",
+     [](PromLine& out, uint8_t i) {
+         if (i >= RELAY_CHANNEL_COUNT) return false;
+         out.put(Relay.switchCount(static_cast<RelayChannel>(i)), "channel", RELAY_CHANNEL_NAMES[i]);
+         return true;
+     }},
+    {"martha_relay_armed", "gauge", "1 once the boot lock has elapsed",
+     METRIC_ONCE(Relay.isArmed())},
+    {"martha_relay_manual_mode", "gauge", "1 while the DPDT panel override is active",
+     METRIC_ONCE(Relay.isManualMode())},
+
+    // Control loops
+    {"martha_humidity_fogging", "gauge", "1 while the humidity loop is fogging",
+     METRIC_ONCE(HumLoop.isFogging())},
+    {"martha_co2_flushing", "gauge", "1 while the CO2 loop is running fresh-air exchange",
+     METRIC_ONCE(CO2Loop.isFlushing())},
+    {"martha_control_ticks_total", "counter", "Periodic control ticks completed",
+     METRIC_ONCE(CtrlTiming.ticks())},
+    {"martha_control_overruns_total", "counter", "Control ticks that ran past the next deadline",
+     METRIC_ONCE(CtrlTiming.overruns())},
+    {"martha_control_skipped_total", "counter", "Control deadlines skipped because the task was late",
+     METRIC_ONCE(CtrlTiming.skipped())},
+    {"martha_control_exec_max_seconds", "gauge", "Longest control tick since boot",
+     METRIC_ONCE(CtrlTiming.maxExecUs() / 1e6)},
+    {"martha_control_jitter_max_seconds", "gauge", "Worst control tick wake-up delay since boot",
+     METRIC_ONCE(CtrlTiming.maxJitterUs() / 1e6)},
+
+    // Publishing
+    {"martha_publish_frames_total", "counter", "Frames handed to the publisher task, by outcome",
+     [](PromLine& out, uint8_t i) {
+         if (i >= 2) return false;
+         if (i == 0) out.put(Publish.dispatched(), "result", "dispatched");
+         else        out.put(Publish.dropped(), "result", "dropped");
+         return true;
+     }},
+    {"martha_ws_clients", "gauge", "Connected WebSocket clients",
+     METRIC_ONCE(WsBroadcast.clientCount())},
+    {"martha_ws_frames_skipped_total", "counter", "WebSocket frames skipped for clients over their send budget",
+     METRIC_ONCE(WsBroadcast.framesSkipped())},
+    {"martha_ws_disconnects_total", "counter", "WebSocket clients closed for staying over budget",
+     METRIC_ONCE(WsBroadcast.disconnects())},
+
+    // MQTT
+    {"martha_mqtt_connected", "gauge", "MQTT broker session up",
+     METRIC_ONCE(Mqtt.online())},
+    {"martha_mqtt_queued_samples", "gauge", "Samples waiting to be replayed to the broker",
+     METRIC_ONCE(Mqtt.queued())},
+    {"martha_mqtt_dropped_samples_total", "counter", "Samples lost because the offline queue was full",
+     METRIC_ONCE(Mqtt.dropped())},
+    {"martha_mqtt_messages_total", "counter", "MQTT messages published",
+     METRIC_ONCE(Mqtt.published())},
+
+    // I2C
+    {"martha_i2c_transactions_total", "counter", "I2C transactions per device",
+     [](PromLine& out, uint8_t i) {
+         if (i >= I2C_DEVICE_COUNT) return false;
+         out.put(I2cCounters.transactions(static_cast<I2cDevice>(i)), "device", I2C_DEVICE_NAMES[i]);
+         return true;
+     }},
+    {"martha_i2c_errors_total", "counter", "Failed I2C transactions per device",
+     [](PromLine& out, uint8_t i) {
+         if (i >= I2C_DEVICE_COUNT) return false;
+         out.put(I2cCounters.errors(static_cast<I2cDevice>(i)), "device", I2C_DEVICE_NAMES[i]);
+         return true;
+     }},
+    {"martha_i2c_bus_clears_total", "counter", "I2C bus recoveries (SCL clocked out)",
+     METRIC_ONCE(I2cGuard.busClears())},
+
+    // System
+    {"martha_heap_free_bytes", "gauge", "Free internal heap",
+     METRIC_ONCE(ESP.getFreeHeap())},
+    {"martha_heap_min_free_bytes", "gauge", "Lowest free internal heap since boot",
+     METRIC_ONCE(ESP.getMinFreeHeap())},
+    {"martha_heap_max_block_bytes", "gauge", "Largest allocatable internal heap block",
+     METRIC_ONCE(ESP.getMaxAllocHeap())},
+    {"martha_task_stack_free_bytes", "gauge", "Task stack never used since the task started",
+     [](PromLine& out, uint8_t i) {
+         if (i >= sizeof(TASK_NAMES) / sizeof(TASK_NAMES[0])) return false;
+         TaskHandle_t t = xTaskGetHandle(TASK_NAMES[i]);
+         if (t) out.put(static_cast<uint32_t>(uxTaskGetStackHighWaterMark(t)), "task", TASK_NAMES[i]);
+         return true;
+     }},
+    {"martha_wifi_rssi_dbm", "gauge", "WiFi signal strength",
+     METRIC_ONCE(static_cast<double>(WiFi.RSSI()))},
+};
+
+#undef METRIC_ONCE
+
+void metricsRegisterRoute(AsyncWebServer& server) {
+    server.on(METRICS_PATH, HTTP_GET, [](AsyncWebServerRequest* req) {
+        auto stream = std::make_shared<MetricsStream>(FAMILIES, sizeof(FAMILIES) / sizeof(FAMILIES[0]));
+        req->send(req->beginChunkedResponse("text/plain; version=0.0.4",
+            [stream](uint8_t* buf, size_t max_len, size_t /*index*/) -> size_t {
+                return stream->read(reinterpret_cast<char*>(buf), max_len);
+            }));
+    });
+}
+
+#endif  // !NATIVE_TEST
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "../../include/config.h"
+#include "../util/line_stream.h"
+
+/**
+ * metrics.h — Prometheus text exposition for GET /metrics.
+ *
+ * The endpoint is a static table of MetricFamily entries. Each family's
+ * sample() callback reads one live value straight from its module and
+ * formats it with PromLine into a fixed line buffer; MetricsStream copies
+ * those lines into the chunked response (via LineStream) as AsyncTCP asks
+ * for them. No
+ * JsonDocument, no String, and nothing on the heap but the stream's own
+ * small state, so a scrape costs the same whatever the interval.
+ *
+ * Values are read line by line, not as one snapshot; each sample is
+ * consistent in itself, which is all Prometheus assumes.
+ *
+ * PromLine and MetricsStream are portable; the family table and route are
+ * hardware-only (metrics.cpp).
+ */
+
+/** Formats one sample line for the family being written. */
+class PromLine {
+public:
+    PromLine(char* buf, size_t cap, const char* name) : _buf(buf), _cap(cap), _name(name) {}
+
+    /** put(v[, key, val]) — Append `name{key="val"} v`; NaN is written as NaN. */
+    void put(double v, const char* key = nullptr, const char* val = nullptr);
+    void put(uint64_t v, const char* key = nullptr, const char* val = nullptr);
+    void put(uint32_t v, const char* key = nullptr, const char* val = nullptr) {
+        put(static_cast<uint64_t>(v), key, val);
+    }
+    void put(bool v, const char* key = nullptr, const char* val = nullptr) {
+        put(static_cast<uint64_t>(v ? 1 : 0), key, val);
+    }
+
+    size_t len() const { return _len; }
+
+private:
+    void _head(const char* key, const char* val);
+    void _append(const char* s);
+
+    char*       _buf;
+    size_t      _cap;
+    size_t      _len = 0;
+    const char* _name;
+};
+
+/** One metric family: HELP/TYPE header, then its samples. */
+struct MetricFamily {
+    const char* name;
+    const char* type;   // "gauge" or "counter"
+    const char* help;
+    /** sample(out, i) — Write sample i of the family; false once i is past the last. */
+    bool (*sample)(PromLine& out, uint8_t i);
+};
+
+/** Walks a family table and streams the exposition, a line at a time. */
+class MetricsStream {
+public:
+    MetricsStream(const MetricFamily* families, size_t count) : _fams(families), _count(count) {}
+
+    /**
+     * read(buf, cap) — Write the next part of the exposition into buf.
+     * Returns bytes written; 0 once every family has been written.
+     */
+    size_t read(char* buf, size_t cap);
+
+private:
+    bool _nextLine(char* line, size_t size, size_t& len);
+
+    const MetricFamily*         _fams;
+    size_t                      _count;
+    size_t                      _fam  = 0;
+    int16_t                     _item = -1;   // -1 = HELP/TYPE header next
+    LineStream<METRICS_LINE_MAX> _out;
+};
+
+#ifndef NATIVE_TEST
+#include <ESPAsyncWebServer.h>
+
+/** metricsRegisterRoute(server) — Serve the Prometheus exposition at /metrics. */
+void metricsRegisterRoute(AsyncWebServer& server);
+#endif
@@ -0,0 +1,36 @@
+/**
+ * publisher.cpp — Publisher FreeRTOS task (hardware only; the fan-out logic
+ * is PublisherCore in publisher.h).
+ */
+
+#include "publisher.h"
+#include "../util/logger.h"
+
+#ifndef NATIVE_TEST
+
+Publisher Publish;
+
+void Publisher::begin() {
+    xTaskCreatePinnedToCore(
+        _task, "publish",
+        PUBLISH_TASK_STACK, this,
+        PUBLISH_TASK_PRIORITY, &_task_handle,
+        0  // Core 0 — with the WiFi/AsyncTCP tasks it feeds, away from control
+    );
+    Log.info("publish", "Publisher task started");
+}
+
+void Publisher::post(const PublishFrame& frame) {
+    PublisherCore::post(frame);
+    if (_task_handle) xTaskNotifyGive(_task_handle);
+}
+
+void Publisher::_task(void* arg) {
+    auto* self = static_cast<Publisher*>(arg);
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        self->dispatch();
+    }
+}
+
+#endif  // !NATIVE_TEST
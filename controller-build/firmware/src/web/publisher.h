@@ -0,0 +1,132 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "../sensors/sensor_hub.h"
+#include "../relay/relay_manager.h"
+#include "../util/mailbox.h"
+#include "../../include/config.h"
+
+/**
+ * publisher.h — Outbound fan-out, off the control task.
+ *
+ * The control task posts a PublishFrame (the snapshot it acted on, its
+ * generation and the relay state that resulted) into a single-slot mailbox
+ * and carries on; posting never blocks and never serialises anything. A
+ * low-priority publisher task takes the newest frame and hands it to every
+ * registered sink (WebSocket today). Serialisation, lwIP/AsyncTCP locks and
+ * slow clients therefore cost the publisher task, never a control tick.
+ * Frames a slow publisher can't keep up with are overwritten, not queued —
+ * sinks always see the latest state — and counted in dropped().
+ *
+ * Sinks run on the publisher task, one after another. Each does its own rate
+ * limiting (e.g. WS_BROADCAST_PERIOD_MS) from frame.ts_ms.
+ */
+
+struct PublishFrame {
+    SensorSnapshot snap;         // Snapshot the control tick acted on
+    uint32_t       gen;          // Its SensorHub generation (0 = none yet)
+    uint32_t       ts_ms;        // Control tick time, millis()
+    uint8_t        relay_mask;   // Bit N = RelayChannel N commanded ON
+    bool           armed;
+    bool           manual_mode;
+};
+
+/** makePublishFrame() — Capture the control task's view after a tick. */
+inline PublishFrame makePublishFrame(const SensorSnapshot& snap, uint32_t gen,
+                                     const RelayManager& relay, uint32_t now_ms) {
+    PublishFrame f = {};
+    f.snap  = snap;
+    f.gen   = gen;
+    f.ts_ms = now_ms;
+    for (uint8_t i = 0; i < RELAY_CHANNEL_COUNT; ++i) {
+        if (relay.get(static_cast<RelayChannel>(i))) f.relay_mask |= static_cast<uint8_t>(1u << i);
+    }
+    f.armed       = relay.isArmed();
+    f.manual_mode = relay.isManualMode();
+    return f;
+}
+
+class PublisherCore {
+public:
+    PublisherCore() = default;
+
+    /** Called on the publisher task for every frame dispatched. May block (network I/O). */
+    using Sink = void (*)(void* ctx, const PublishFrame& frame);
+
+    /**
+     * addSink(fn, ctx) — Register an outbound sink. Safe from any task,
+     * concurrently too: the slot is claimed with a compare-exchange on the
+     * count, and the sink receives frames once its fn is stored. Up to
+     * PUBLISH_MAX_SINKS. Returns false when full.
+     */
+    bool addSink(Sink fn, void* ctx) {
+        uint8_t n = _sink_count.load(std::memory_order_relaxed);
+        do {
+            if (n >= PUBLISH_MAX_SINKS) return false;
+        } while (!_sink_count.compare_exchange_weak(n, n + 1, std::memory_order_relaxed));
+        _sinks[n].ctx = ctx;
+        _sinks[n].fn.store(fn, std::memory_order_release);   // Ready once fn is visible
+        return true;
+    }
+
+    /** post(frame) — Control task: hand over the latest frame. Never blocks. */
+    void post(const PublishFrame& frame) { _box.post(frame); }
+
+    /**
+     * dispatch() — Publisher task: take the newest frame and run every sink
+     * on it. Returns false if nothing new was posted.
+     */
+    bool dispatch() {
+        if (!_box.take(_frame)) return false;
+        uint8_t n = _sink_count.load(std::memory_order_relaxed);
+        for (uint8_t i = 0; i < n; ++i) {
+            Sink fn = _sinks[i].fn.load(std::memory_order_acquire);
+            if (fn) fn(_sinks[i].ctx, _frame);   // Null = claimed, still being filled in
+        }
+        _dispatched.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /** posted()/dispatched()/dropped() — Frames handed over / fanned out / overwritten unseen. */
+    uint32_t posted() const     { return _box.posted(); }
+    uint32_t dispatched() const { return _dispatched.load(std::memory_order_relaxed); }
+    uint32_t dropped() const    { return _box.dropped(); }
+
+private:
+    struct SinkSlot {
+        std::atomic<Sink> fn{nullptr};
+        void*             ctx = nullptr;
+    };
+
+    Mailbox<PublishFrame> _box;
+    PublishFrame          _frame = {};  // Publisher task's working copy
+    SinkSlot              _sinks[PUBLISH_MAX_SINKS];
+    std::atomic<uint8_t>  _sink_count{0};   // Slots claimed
+    std::atomic<uint32_t> _dispatched{0};
+};
+
+// ── Hardware binding ──────────────────────────────────────────────────────────
+
+#ifndef NATIVE_TEST
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+class Publisher : public PublisherCore {
+public:
+    Publisher() = default;
+
+    /** begin() — Create the publisher FreeRTOS task. Call before the control task starts posting. */
+    void begin();
+
+    /** post(frame) — Hand over the latest frame and wake the publisher task. Never blocks. */
+    void post(const PublishFrame& frame);
+
+private:
+    static void _task(void* arg);
+
+    TaskHandle_t _task_handle = nullptr;
+};
+
+extern Publisher Publish;
+
+#endif  // !NATIVE_TEST
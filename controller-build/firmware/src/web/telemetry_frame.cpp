@@ -0,0 +1,198 @@
+/**
+ * telemetry_frame.cpp — Binary WebSocket telemetry encode/decode.
+ */
+
+#include "telemetry_frame.h"
+#include <cmath>
+
+// ── Quantisation ──────────────────────────────────────────────────────────────
+
+/** quantise(v, scale, lo, hi) — round(v·scale), saturated to [lo, hi]; NaN → 0. */
+static int32_t quantise(float v, float scale, int32_t lo, int32_t hi) {
+    if (std::isnan(v)) return 0;
+    float q = std::round(v * scale);
+    if (q <= static_cast<float>(lo)) return lo;
+    if (q >= static_cast<float>(hi)) return hi;
+    return static_cast<int32_t>(q);
+}
+
+static uint16_t toU16(float v, float scale) { return static_cast<uint16_t>(quantise(v, scale, 0, UINT16_MAX)); }
+static int16_t  toI16(float v, float scale) { return static_cast<int16_t>(quantise(v, scale, INT16_MIN, INT16_MAX)); }
+
+TelemetryFields telemetryFields(const PublishFrame& frame) {
+    const SensorSnapshot& s = frame.snap;
+    TelemetryFields f = {};
+    f.t    = frame.ts_ms;
+    f.co2  = toU16(s.co2.co2_ppm, 1.0f);
+    f.rh_a = toU16(s.rh_aggregate_pct, 100.0f);
+    for (int i = 0; i < 3; ++i) f.rh[i] = toU16(s.rh[i].rh_pct, 100.0f);
+    for (int i = 0; i < 5; ++i) f.tp[i] = toI16(s.temp_probe[i], 100.0f);
+    f.wl    = toU16(s.water_level_pct, 100.0f);
+    f.rl    = frame.relay_mask;
+    f.flags = static_cast<uint8_t>((frame.armed ? TELEMETRY_FLAG_ARMED : 0) |
+                                   (frame.manual_mode ? TELEMETRY_FLAG_MANUAL : 0));
+    return f;
+}
+
+// ── Wire format ───────────────────────────────────────────────────────────────
+
+static uint8_t* put16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+    return p + 2;
+}
+
+static uint8_t* put32(uint8_t* p, uint32_t v) {
+    return put16(put16(p, static_cast<uint16_t>(v)), static_cast<uint16_t>(v >> 16));
+}
+
+static uint16_t get16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+static uint32_t get32(const uint8_t* p) { return get16(p) | (static_cast<uint32_t>(get16(p + 2)) << 16); }
+
+size_t telemetryEncode(const TelemetryFields& f, uint8_t* out, size_t cap) {
+    if (cap < TELEMETRY_FULL_SIZE) return 0;
+    uint8_t* p = out;
+    *p++ = TELEMETRY_SCHEMA_VERSION;
+    *p++ = static_cast<uint8_t>(TelemetryKind::FULL);
+    p = put32(p, f.t);
+    p = put16(p, f.co2);
+    p = put16(p, f.rh_a);
+    for (uint16_t v : f.rh) p = put16(p, v);
+    for (int16_t v : f.tp)  p = put16(p, static_cast<uint16_t>(v));
+    p = put16(p, f.wl);
+    *p++ = f.rl;
+    *p++ = f.flags;
+    return static_cast<size_t>(p - out);
+}
+
+// ── Field access (DELTA) ──────────────────────────────────────────────────────
+
+static int32_t fieldValue(const TelemetryFields& f, uint8_t i) {
+    if (i == TF_CO2)  return f.co2;
+    if (i == TF_RH_A) return f.rh_a;
+    if (i < TF_TP0)   return f.rh[i - TF_RH0];
+    if (i < TF_WL)    return f.tp[i - TF_TP0];
+    if (i == TF_WL)   return f.wl;
+    if (i == TF_RL)   return f.rl;
+    return f.flags;
+}
+
+static void setField(TelemetryFields& f, uint8_t i, int32_t v) {
+    if (i == TF_CO2)       f.co2  = static_cast<uint16_t>(v);
+    else if (i == TF_RH_A) f.rh_a = static_cast<uint16_t>(v);
+    else if (i < TF_TP0)   f.rh[i - TF_RH0] = static_cast<uint16_t>(v);
+    else if (i < TF_WL)    f.tp[i - TF_TP0] = static_cast<int16_t>(v);
+    else if (i == TF_WL)   f.wl    = static_cast<uint16_t>(v);
+    else if (i == TF_RL)   f.rl    = static_cast<uint8_t>(v);
+    else                   f.flags = static_cast<uint8_t>(v);
+}
+
+/** fieldBytes(i) — Wire size of field i: relay mask and flags are one byte. */
+static size_t fieldBytes(uint8_t i) { return i >= TF_RL ? 1 : 2; }
+
+size_t telemetryEncodeDelta(const TelemetryFields& f, uint16_t mask, uint8_t* out, size_t cap) {
+    size_t need = 8;
+    for (uint8_t i = 0; i < TF_COUNT; ++i) {
+        if (mask & (1u << i)) need += fieldBytes(i);
+    }
+    if (cap < need) return 0;
+
+    uint8_t* p = out;
+    *p++ = TELEMETRY_SCHEMA_VERSION;
+    *p++ = static_cast<uint8_t>(TelemetryKind::DELTA);
+    p = put32(p, f.t);
+    p = put16(p, mask);
+    for (uint8_t i = 0; i < TF_COUNT; ++i) {
+        if (!(mask & (1u << i))) continue;
+        uint32_t v = static_cast<uint32_t>(fieldValue(f, i));
+        if (fieldBytes(i) == 1) *p++ = static_cast<uint8_t>(v);
+        else                    p = put16(p, static_cast<uint16_t>(v));
+    }
+    return static_cast<size_t>(p - out);
+}
+
+bool telemetryDecode(const uint8_t* in, size_t len, TelemetryFields& f) {
+    if (len < 2 || in[0] != TELEMETRY_SCHEMA_VERSION) return false;
+
+    if (in[1] == static_cast<uint8_t>(TelemetryKind::DELTA)) {
+        if (len < 8) return false;
+        uint16_t mask = get16(in + 6);
+        size_t   need = 8;
+        for (uint8_t i = 0; i < TF_COUNT; ++i) {
+            if (mask & (1u << i)) need += fieldBytes(i);
+        }
+        if (len < need) return false;
+        f.t = get32(in + 2);
+        const uint8_t* p = in + 8;
+        for (uint8_t i = 0; i < TF_COUNT; ++i) {
+            if (!(mask & (1u << i))) continue;
+            if (fieldBytes(i) == 1) {
+                setField(f, i, *p++);
+            } else {
+                uint16_t raw = get16(p);
+                p += 2;
+                setField(f, i, (i >= TF_TP0 && i < TF_WL) ? static_cast<int16_t>(raw) : raw);
+            }
+        }
+        return true;
+    }
+
+    if (in[1] != static_cast<uint8_t>(TelemetryKind::FULL) || len < TELEMETRY_FULL_SIZE) return false;
+    const uint8_t* p = in + 2;
+    f.t    = get32(p);  p += 4;
+    f.co2  = get16(p);  p += 2;
+    f.rh_a = get16(p);  p += 2;
+    for (uint16_t& v : f.rh) { v = get16(p); p += 2; }
+    for (int16_t& v : f.tp)  { v = static_cast<int16_t>(get16(p)); p += 2; }
+    f.wl    = get16(p); p += 2;
+    f.rl    = *p++;
+    f.flags = *p++;
+    return true;
+}
+
+// ── TelemetryStream ───────────────────────────────────────────────────────────
+
+uint16_t TelemetryStream::_changed(const TelemetryFields& f) const {
+    uint16_t mask = 0;
+    for (uint8_t i = 0; i < TF_COUNT; ++i) {
+        int32_t  d  = fieldValue(f, i) - fieldValue(_sent, i);
+        uint32_t ad = static_cast<uint32_t>(d < 0 ? -d : d);
+        uint16_t db = i == TF_CO2 ? _db.co2
+                    : i < TF_TP0  ? _db.rh
+                    : i < TF_WL   ? _db.temp
+                    : i == TF_WL  ? _db.wl
+                    : 1;                                  // Relays / flags: any change
+        if (db == 0) db = 1;
+        if (ad >= db) mask |= static_cast<uint16_t>(1u << i);
+    }
+    return mask;
+}
+
+size_t TelemetryStream::next(const TelemetryFields& f, uint8_t* out, size_t cap) {
+    uint32_t now_ms = f.t;
+    if (!_primed || (now_ms - _key_ms) >= WS_KEYFRAME_MS) {
+        size_t n = telemetryEncode(f, out, cap);
+        if (n == 0) return 0;
+        _sent      = f;
+        _primed    = true;
+        _key_ms    = now_ms;
+        _period_ms = now_ms;
+        return n;
+    }
+
+    uint16_t changed = _changed(f);
+    bool     cadence = (now_ms - _period_ms) >= WS_BROADCAST_PERIOD_MS;
+    if (cadence) _period_ms = now_ms;
+    // Relay and mode changes don't wait for the cadence
+    uint16_t mask = cadence ? changed
+                            : static_cast<uint16_t>(changed & ((1u << TF_RL) | (1u << TF_FLAGS)));
+    if (mask == 0) return 0;
+
+    size_t n = telemetryEncodeDelta(f, mask, out, cap);
+    if (n == 0) return 0;
+    for (uint8_t i = 0; i < TF_COUNT; ++i) {
+        if (mask & (1u << i)) setField(_sent, i, fieldValue(f, i));
+    }
+    _sent.t = now_ms;
+    return n;
+}
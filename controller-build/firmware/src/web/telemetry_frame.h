@@ -0,0 +1,140 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "publisher.h"
+
+/**
+ * telemetry_frame.h — Packed binary WebSocket telemetry (schema v1).
+ *
+ * Opt-in per client: a dashboard that opens /ws with the subprotocol
+ * WS_PROTOCOL_BINARY gets these binary frames instead of JSON text. Values
+ * are fixed-point integers, so the ESP32 never formats a float, and a full
+ * frame is 30 bytes against ~150 for the JSON.
+ *
+ * FULL frame, little-endian, no padding:
+ *
+ *   off  size  field
+ *     0     1  version   TELEMETRY_SCHEMA_VERSION
+ *     1     1  kind      TelemetryKind::FULL
+ *     2     4  t         control tick time, ms                  u32
+ *     6     2  co2       CO₂, ppm                               u16
+ *     8     2  rh_a      aggregate RH, 0.01 %                   u16
+ *    10     6  rh[3]     shelf RH, 0.01 %                       u16 × 3
+ *    16    10  tp[5]     substrate temps, 0.01 °C               i16 × 5
+ *    26     2  wl        water level, 0.01 %                    u16
+ *    28     1  rl        relay bitmask, bit N = RelayChannel N  u8
+ *    29     1  flags     bit 0 armed, bit 1 manual mode         u8
+ *
+ * DELTA frame (WS_PROTOCOL_DELTA clients, see TelemetryStream):
+ *
+ *     0     1  version
+ *     1     1  kind      TelemetryKind::DELTA
+ *     2     4  t
+ *     6     2  mask      bit i set = TelemetryField i follows   u16
+ *     8     …  the flagged fields in TelemetryField order, each in its FULL
+ *              encoding (u16/i16, rl and flags u8)
+ *
+ * A DELTA only makes sense applied on top of the last FULL frame.
+ * Out-of-range values saturate. A decoder must reject a version it doesn't
+ * know; new fields go in a new version, never by reinterpreting old bytes.
+ * data/app.js holds the matching decoder.
+ */
+
+inline constexpr uint8_t TELEMETRY_SCHEMA_VERSION = 1;
+inline constexpr size_t  TELEMETRY_FULL_SIZE      = 30;
+inline constexpr size_t  TELEMETRY_MAX_SIZE       = TELEMETRY_FULL_SIZE + 2;  // DELTA with every field
+
+enum class TelemetryKind : uint8_t {
+    FULL  = 0,  // Every field
+    DELTA = 1,  // Only the fields in the mask
+};
+
+enum TelemetryFlags : uint8_t {
+    TELEMETRY_FLAG_ARMED  = 1u << 0,
+    TELEMETRY_FLAG_MANUAL = 1u << 1,
+};
+
+/** Field indices for DELTA masks, in wire order. */
+enum TelemetryField : uint8_t {
+    TF_CO2   = 0,
+    TF_RH_A  = 1,
+    TF_RH0   = 2,   // rh[0..2] = 2..4
+    TF_TP0   = 5,   // tp[0..4] = 5..9
+    TF_WL    = 10,
+    TF_RL    = 11,
+    TF_FLAGS = 12,
+    TF_COUNT = 13
+};
+
+/** Dashboard field set, already quantised to wire units. */
+struct TelemetryFields {
+    uint32_t t;
+    uint16_t co2;
+    uint16_t rh_a;
+    uint16_t rh[3];
+    int16_t  tp[5];
+    uint16_t wl;
+    uint8_t  rl;
+    uint8_t  flags;
+};
+
+/** telemetryFields(frame) — Quantise a published frame to wire units. */
+TelemetryFields telemetryFields(const PublishFrame& frame);
+
+/**
+ * telemetryEncode(fields, out, cap) — Write a FULL frame into out.
+ * Returns the frame length, or 0 if cap is too small.
+ */
+size_t telemetryEncode(const TelemetryFields& fields, uint8_t* out, size_t cap);
+
+/**
+ * telemetryEncodeDelta(fields, mask, out, cap) — Write a DELTA frame carrying
+ * the TelemetryField bits set in mask. Returns the length, or 0 if cap is too small.
+ */
+size_t telemetryEncodeDelta(const TelemetryFields& fields, uint16_t mask, uint8_t* out, size_t cap);
+
+/**
+ * telemetryDecode(in, len, state) — Apply a frame to state (reference
+ * decoder, mirrors app.js): FULL replaces it, DELTA updates the flagged
+ * fields. False on unknown version/kind or short input.
+ */
+bool telemetryDecode(const uint8_t* in, size_t len, TelemetryFields& state);
+
+/** Per-field change thresholds for delta push, in wire units. */
+struct TelemetryDeadband {
+    uint16_t co2  = static_cast<uint16_t>(WS_DEADBAND_CO2_PPM);
+    uint16_t rh   = static_cast<uint16_t>(WS_DEADBAND_RH_PCT * 100.0f + 0.5f);
+    uint16_t temp = static_cast<uint16_t>(WS_DEADBAND_TEMP_C * 100.0f + 0.5f);
+    uint16_t wl   = static_cast<uint16_t>(WS_DEADBAND_WATER_PCT * 100.0f + 0.5f);
+};
+
+/**
+ * TelemetryStream — What to send one delta-mode client next.
+ *
+ * Remembers the last value sent for every field. Per frame offered:
+ *   - a FULL keyframe first, and again every WS_KEYFRAME_MS
+ *   - relay bitmask / flag changes at once, as a DELTA
+ *   - on the WS_BROADCAST_PERIOD_MS cadence, a DELTA of every field that
+ *     moved at least its deadband since it was last sent; nothing if none did
+ * Comparing against the last value *sent* (not the previous sample) means a
+ * slow drift still goes out once it adds up to the deadband.
+ */
+class TelemetryStream {
+public:
+    explicit TelemetryStream(const TelemetryDeadband& db = TelemetryDeadband{}) : _db(db) {}
+
+    /** next(fields, out, cap) — Frame to send for this publish (length), or 0 for nothing. */
+    size_t next(const TelemetryFields& fields, uint8_t* out, size_t cap);
+
+    /** reset() — Forget what was sent; the next frame is a keyframe (new client). */
+    void reset() { _primed = false; }
+
+private:
+    uint16_t _changed(const TelemetryFields& f) const;
+
+    TelemetryDeadband _db;
+    TelemetryFields   _sent      = {};
+    bool              _primed    = false;
+    uint32_t          _key_ms    = 0;   // Last keyframe
+    uint32_t          _period_ms = 0;   // Last cadence point
+};
@@ -1,6 +1,8 @@
 #include "web_server.h"
 #include "api.h"
 #include "ws_broadcaster.h"
+#include "metrics.h"
+#include "../config/config_store.h"
 #include "../util/logger.h"
 
 #ifndef NATIVE_TEST
@@ -24,8 +26,15 @@ void webServerBegin() {
     // Register REST API routes
     apiRegisterRoutes(WebServer);
 
+    // Prometheus scrape endpoint
+    metricsRegisterRoute(WebServer);
+
     // ElegantOTA (with authentication)
     ElegantOTA.begin(&WebServer, OTA_USERNAME, OTA_PASSWORD);
+    ElegantOTA.onEnd([](bool) {
+        // The reboot follows shortly: don't leave a config POST in the debounce window
+        Config.flush();
+    });
     Log.info("web", "ElegantOTA registered at /update (auth required)");
 
     // WebSocket
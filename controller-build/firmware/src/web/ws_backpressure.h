@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "../../include/config.h"
+
+/**
+ * ws_backpressure.h — Per-client WebSocket send budget.
+ *
+ * AsyncWebSocket queues every message per client until TCP acknowledges it.
+ * A phone on weak Wi-Fi drains slower than frames arrive, and without a cap
+ * its queue — and the heap — grows without bound.
+ *
+ * WsBackpressure decides, per client and per frame, from the client's
+ * current queue depth:
+ *   - SEND        queue below WS_CLIENT_QUEUE_MAX
+ *   - SKIP        queue full: this frame is dropped for that client only.
+ *                 Nothing is queued behind the backlog, so once it drains
+ *                 the client gets the newest frame, not the stale ones.
+ *   - DISCONNECT  queue has stayed full for WS_CLIENT_STALL_MS
+ * A client therefore never holds more than WS_CLIENT_QUEUE_MAX frames of at
+ * most WS_FRAME_MAX_SIZE bytes, and shared frames are counted once however
+ * many clients hold them.
+ *
+ * Portable; used by WsBroadcaster on the publisher task.
+ */
+class WsBackpressure {
+public:
+    enum class Action : uint8_t { SEND, SKIP, DISCONNECT };
+
+    WsBackpressure() = default;
+
+    /**
+     * admit(slot, id, queued, now_ms) — May client id (in table slot) take
+     * another frame, given `queued` messages still unsent? A new id in a
+     * slot starts with a clean record.
+     */
+    Action admit(uint8_t slot, uint32_t id, size_t queued, uint32_t now_ms) {
+        if (slot >= WS_MAX_CLIENTS) return Action::SKIP;
+        State& s = _state[slot];
+        if (s.id != id) s = {id, false, 0, 0};
+        s.queued = queued;
+
+        if (queued < WS_CLIENT_QUEUE_MAX) {
+            s.behind = false;
+            return Action::SEND;
+        }
+        if (!s.behind) {
+            s.behind       = true;
+            s.behind_since = now_ms;
+        }
+        if (now_ms - s.behind_since >= WS_CLIENT_STALL_MS) {
+            s = {};
+            _disconnects++;
+            return Action::DISCONNECT;
+        }
+        _skipped[slot]++;
+        _skipped_total++;
+        return Action::SKIP;
+    }
+
+    /** queued(slot) — Queue depth seen at the last admit() for that slot. */
+    size_t queued(uint8_t slot) const { return slot < WS_MAX_CLIENTS ? _state[slot].queued : 0; }
+
+    /** skipped(slot) — Frames dropped for the slot's clients since boot. */
+    uint32_t skipped(uint8_t slot) const { return slot < WS_MAX_CLIENTS ? _skipped[slot] : 0; }
+
+    /** skipped()/disconnects() — Totals across all clients. */
+    uint32_t skipped() const     { return _skipped_total; }
+    uint32_t disconnects() const { return _disconnects; }
+
+private:
+    struct State {
+        uint32_t id;
+        bool     behind;         // Queue full at the last admit()
+        uint32_t behind_since;   // When it filled
+        size_t   queued;
+    };
+
+    State    _state[WS_MAX_CLIENTS]   = {};
+    uint32_t _skipped[WS_MAX_CLIENTS] = {};
+    uint32_t _skipped_total           = 0;
+    uint32_t _disconnects             = 0;
+};
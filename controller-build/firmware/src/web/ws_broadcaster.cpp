@@ -4,54 +4,181 @@
 
 #ifndef NATIVE_TEST
 #include <ArduinoJson.h>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+static const char* const FORMAT_NAMES[] = {"json", "binary", "delta"};
 
 WsBroadcaster WsBroadcast;
 
 void WsBroadcaster::begin(AsyncWebServer& server) {
-    _ws = new AsyncWebSocket(WS_PATH);
-
-    _ws->onEvent([](AsyncWebSocket* ws,
-                    AsyncWebSocketClient* client,
-                    AwsEventType type,
-                    void* /*arg*/,
-                    uint8_t* /*data*/,
-                    size_t /*len*/) {
-        if (type == WS_EVT_CONNECT) {
-            if (ws->count() > WS_MAX_CLIENTS) {
-                Log.warn("ws", "Client #%u rejected (max %d)", client->id(), WS_MAX_CLIENTS);
-                client->close();
-                return;
-            }
-            Log.info("ws", "Client #%u connected", client->id());
-        } else if (type == WS_EVT_DISCONNECT) {
-            Log.info("ws", "Client #%u disconnected", client->id());
-        }
+    _mutex = xSemaphoreCreateMutex();
+    _ws    = new AsyncWebSocket(WS_PATH);
+
+    _ws->onEvent([this](AsyncWebSocket* /*ws*/,
+                        AsyncWebSocketClient* client,
+                        AwsEventType type,
+                        void* arg,
+                        uint8_t* /*data*/,
+                        size_t /*len*/) {
+        _onEvent(client, type, arg);
     });
 
     server.addHandler(_ws);
+    Publish.addSink(&WsBroadcaster::_sink, this);
     Log.info("ws", "WebSocket handler registered at %s", WS_PATH);
 }
 
-void WsBroadcaster::tick(const SensorSnapshot& snapshot,
-                          const RelayManager& relay,
-                          uint32_t now_ms) {
+void WsBroadcaster::_onEvent(AsyncWebSocketClient* client, AwsEventType type, void* arg) {
+    if (type == WS_EVT_CONNECT) {
+        if (_ws->count() > WS_MAX_CLIENTS) {
+            Log.warn("ws", "Client #%u rejected (max %d)", client->id(), WS_MAX_CLIENTS);
+            client->close();
+            return;
+        }
+        // arg is the upgrade request; the server echoes the subprotocol back
+        auto*  req    = static_cast<AsyncWebServerRequest*>(arg);
+        const AsyncWebHeader* proto = req ? req->getHeader("Sec-WebSocket-Protocol") : nullptr;
+        Format format = Format::JSON;
+        if (proto && proto->value() == WS_PROTOCOL_BINARY) format = Format::BINARY;
+        if (proto && proto->value() == WS_PROTOCOL_DELTA)  format = Format::DELTA;
+        if (!_addClient(client->id(), format)) {
+            Log.warn("ws", "Client #%u rejected (no free slot)", client->id());
+            client->close();
+            return;
+        }
+        Log.info("ws", "Client #%u connected (%s)", client->id(),
+                 FORMAT_NAMES[static_cast<uint8_t>(format)]);
+    } else if (type == WS_EVT_DISCONNECT) {
+        _removeClient(client->id());
+        Log.info("ws", "Client #%u disconnected", client->id());
+    }
+}
+
+bool WsBroadcaster::_addClient(uint32_t id, Format format) {
+    bool added = false;
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    for (auto& c : _clients) {
+        if (c.id == 0) {
+            c     = {id, format};
+            added = true;
+            break;
+        }
+    }
+    xSemaphoreGive(_mutex);
+    return added;
+}
+
+void WsBroadcaster::_removeClient(uint32_t id) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    for (auto& c : _clients) {
+        if (c.id == id) c = {};
+    }
+    xSemaphoreGive(_mutex);
+}
+
+void WsBroadcaster::_sink(void* ctx, const PublishFrame& frame) {
+    static_cast<WsBroadcaster*>(ctx)->publish(frame);
+}
+
+void WsBroadcaster::publish(const PublishFrame& frame) {
     if (!_ws) return;
-    if ((now_ms - _last_broadcast_ms) < WS_BROADCAST_PERIOD_MS) return;
-    if (_ws->count() == 0) {
-        _last_broadcast_ms = now_ms;
-        return;
+    uint32_t now_ms  = frame.ts_ms;
+    bool     cadence = (now_ms - _last_broadcast_ms) >= WS_BROADCAST_PERIOD_MS;
+    if (cadence) _last_broadcast_ms = now_ms;
+
+    ClientSlot clients[WS_MAX_CLIENTS];
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    memcpy(clients, _clients, sizeof(clients));
+    xSemaphoreGive(_mutex);
+
+    bool want_json = false, want_bin = false, want_fields = false;
+    for (const auto& c : clients) {
+        if (c.id == 0) continue;
+        want_json   |= cadence && c.format == Format::JSON;
+        want_bin    |= cadence && c.format == Format::BINARY;
+        want_fields |= c.format != Format::JSON;
+    }
+    if (!want_json && !want_fields) return;
+
+    // Serialise each shared format once into a reference-counted buffer; every
+    // client's queue holds the same bytes, freed when the last one is sent
+    TelemetryFields            fields = want_fields ? telemetryFields(frame) : TelemetryFields{};
+    AsyncWebSocketSharedBuffer json, bin;
+    if (want_json) json = _buildJson(frame);
+    if (want_bin) {
+        bin = std::make_shared<std::vector<uint8_t>>(TELEMETRY_FULL_SIZE);
+        if (telemetryEncode(fields, bin->data(), bin->size()) == 0) bin.reset();
+    }
+
+    for (uint8_t i = 0; i < WS_MAX_CLIENTS; ++i) {
+        const ClientSlot& c = clients[i];
+        if (c.id == 0) continue;
+        AsyncWebSocketClient* client = _ws->client(c.id);
+        if (!client || client->status() != WS_CONNECTED) continue;
+
+        // Only clients with something to send this frame are charged against their budget
+        bool due = c.format == Format::DELTA || cadence;
+        if (!due) continue;
+        switch (_budget.admit(i, c.id, client->queueLen(), now_ms)) {
+            case WsBackpressure::Action::SEND:
+                break;
+            case WsBackpressure::Action::SKIP:
+                continue;
+            case WsBackpressure::Action::DISCONNECT:
+                Log.warn("ws", "Client #%u disconnected: send queue full for %u ms",
+                         c.id, static_cast<unsigned>(WS_CLIENT_STALL_MS));
+                client->close();
+                continue;
+        }
+
+        switch (c.format) {
+            case Format::JSON:
+                if (json) client->text(json);
+                break;
+            case Format::BINARY:
+                if (bin) client->binary(bin);
+                break;
+            case Format::DELTA: {
+                // A new client in this slot starts with a keyframe. A skipped
+                // client's stream isn't advanced, so its next delta carries
+                // everything it missed.
+                if (_stream_id[i] != c.id) {
+                    _streams[i].reset();
+                    _stream_id[i] = c.id;
+                }
+                uint8_t delta[TELEMETRY_MAX_SIZE];
+                size_t  n = _streams[i].next(fields, delta, sizeof(delta));
+                if (n) client->binary(delta, n);
+                break;
+            }
+        }
     }
+}
 
-    // Reuse a static buffer to avoid heap fragmentation
-    static char buf[1024];
-    _buildJson(snapshot, relay, buf, sizeof(buf));
-    _ws->textAll(buf);
-    _last_broadcast_ms = now_ms;
+void WsBroadcaster::status(JsonObject out) const {
+    ClientSlot clients[WS_MAX_CLIENTS];
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    memcpy(clients, _clients, sizeof(clients));
+    xSemaphoreGive(_mutex);
+
+    out["queue_max"]   = WS_CLIENT_QUEUE_MAX;
+    out["skipped"]     = _budget.skipped();
+    out["disconnects"] = _budget.disconnects();
+    auto list = out["clients"].to<JsonArray>();
+    for (uint8_t i = 0; i < WS_MAX_CLIENTS; ++i) {
+        if (clients[i].id == 0) continue;
+        auto c       = list.add<JsonObject>();
+        c["id"]      = clients[i].id;
+        c["format"]  = FORMAT_NAMES[static_cast<uint8_t>(clients[i].format)];
+        c["queued"]  = _budget.queued(i);
+        c["skipped"] = _budget.skipped(i);
+    }
 }
 
-void WsBroadcaster::_buildJson(const SensorSnapshot& snap,
-                                const RelayManager& relay,
-                                char* buf, size_t len) {
+AsyncWebSocketSharedBuffer WsBroadcaster::_buildJson(const PublishFrame& frame) {
+    const SensorSnapshot& snap = frame.snap;
     static JsonDocument doc;
     doc.clear();
 
@@ -73,15 +200,19 @@ void WsBroadcaster::_buildJson(const SensorSnapshot& snap,
     doc["wl"] = snap.water_level_pct;
 
     // Relay states (bitmask: bit N = channel N state)
-    uint8_t mask = 0;
-    for (uint8_t i = 0; i < RELAY_CHANNEL_COUNT; ++i) {
-        if (relay.get(static_cast<RelayChannel>(i))) mask |= (1 << i);
+    doc["rl"] = frame.relay_mask;
+    doc["am"] = frame.armed;
+    doc["mm"] = frame.manual_mode;
+
+    // Bounded by the per-client budget; never send a truncated document
+    size_t len = measureJson(doc);
+    if (len > WS_FRAME_MAX_SIZE) {
+        Log.warn("ws", "JSON frame exceeds %u bytes; not sent", static_cast<unsigned>(WS_FRAME_MAX_SIZE));
+        return nullptr;
     }
-    doc["rl"] = mask;
-    doc["am"] = relay.isArmed();
-    doc["mm"] = relay.isManualMode();
-
-    serializeJson(doc, buf, len);
+    auto buf = std::make_shared<std::vector<uint8_t>>(len);
+    serializeJson(doc, reinterpret_cast<char*>(buf->data()), len);
+    return buf;
 }
 
 #endif  // !NATIVE_TEST
@@ -2,34 +2,79 @@
 /**
  * ws_broadcaster.h — WebSocket push broadcaster.
  *
- * Pushes a JSON SensorSnapshot to all connected WebSocket clients
- * every WS_BROADCAST_PERIOD_MS (2 seconds).
+ * Pushes the latest SensorSnapshot to all connected WebSocket clients
+ * every WS_BROADCAST_PERIOD_MS (2 seconds). Runs as a Publisher sink, so
+ * serialisation and sends happen on the publisher task, not in the
+ * control loop.
+ *
+ * Frame format is chosen per client at connect time:
+ *   - no subprotocol        → JSON text (default)
+ *   - WS_PROTOCOL_BINARY    → packed binary frames, see telemetry_frame.h
+ *   - WS_PROTOCOL_DELTA     → binary keyframes + on-change deltas
+ *                             (TelemetryStream); relay changes are pushed on
+ *                             the next published frame, not the 2 s cadence
+ * JSON and full binary frames are serialised at most once per broadcast
+ * into a shared, reference-counted buffer, whatever the number of clients
+ * using them. Each client's send queue is capped by WsBackpressure: a client
+ * that falls behind misses frames rather than queueing them, and one that
+ * stays behind is disconnected.
  *
  * WebSocket path: WS_PATH ("/ws")
  */
 #ifndef NATIVE_TEST
+#include <ArduinoJson.h>
 #include <ESPAsyncWebServer.h>
-#include "../sensors/sensor_hub.h"
-#include "../relay/relay_manager.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "publisher.h"
+#include "telemetry_frame.h"
+#include "ws_backpressure.h"
 
 class WsBroadcaster {
 public:
     WsBroadcaster() = default;
 
-    /** begin(server) — Register WebSocket handler on server at WS_PATH. */
+    /** begin(server) — Register WebSocket handler on server at WS_PATH and subscribe to Publish. */
     void begin(AsyncWebServer& server);
 
     /**
-     * tick(snapshot, relay, now_ms) — Build and broadcast JSON to all clients.
-     * Respects WS_BROADCAST_PERIOD_MS interval.
+     * publish(frame) — Serialise and send to all clients in their format.
+     * Full frames respect WS_BROADCAST_PERIOD_MS; delta clients are offered
+     * every frame. Publisher task only.
      */
-    void tick(const SensorSnapshot& snapshot, const RelayManager& relay, uint32_t now_ms);
+    void publish(const PublishFrame& frame);
+
+    /** status(out) — Client list with queue depth and drop counts, for /api/status. */
+    void status(JsonObject out) const;
+
+    /** clientCount()/framesSkipped()/disconnects() — Totals for /metrics. */
+    uint32_t clientCount() const   { return _ws ? _ws->count() : 0; }
+    uint32_t framesSkipped() const { return _budget.skipped(); }
+    uint32_t disconnects() const   { return _budget.disconnects(); }
 
 private:
-    AsyncWebSocket* _ws = nullptr;
-    uint32_t        _last_broadcast_ms = 0;
+    enum class Format : uint8_t { JSON, BINARY, DELTA };
+
+    struct ClientSlot {
+        uint32_t id;      // AsyncWebSocketClient id; 0 = free
+        Format   format;
+    };
+
+    AsyncWebSocket*   _ws = nullptr;
+    uint32_t          _last_broadcast_ms = 0;
+    ClientSlot        _clients[WS_MAX_CLIENTS] = {};  // Written on the AsyncTCP task
+    SemaphoreHandle_t _mutex = nullptr;                // Guards _clients
+
+    // Delta-mode state per client slot (publisher task only)
+    TelemetryStream   _streams[WS_MAX_CLIENTS];
+    uint32_t          _stream_id[WS_MAX_CLIENTS] = {};  // Client the stream belongs to
+    WsBackpressure    _budget;                          // Per-slot send budget
 
-    void _buildJson(const SensorSnapshot& snap, const RelayManager& relay, char* buf, size_t len);
+    static void _sink(void* ctx, const PublishFrame& frame);
+    void   _onEvent(AsyncWebSocketClient* client, AwsEventType type, void* arg);
+    bool   _addClient(uint32_t id, Format format);
+    void   _removeClient(uint32_t id);
+    AsyncWebSocketSharedBuffer _buildJson(const PublishFrame& frame);
 };
 
 extern WsBroadcaster WsBroadcast;
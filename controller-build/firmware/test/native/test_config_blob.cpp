@@ -0,0 +1,164 @@
+/**
+ * test_config_blob.cpp — Unit tests for the versioned config blob: round
+ * trip, CRC and header validation, older (shorter) layouts upgraded with
+ * defaults, longer same-version ones loaded from their prefix, newer
+ * versions refused, and nothing half-loaded on failure.
+ */
+
+#include <unity.h>
+#include "../../src/config/config_blob.h"
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+void setUp()    {}
+void tearDown() {}
+
+static MarthaConfig custom() {
+    MarthaConfig c;
+    strcpy(c.wifi_ssid, "GrowRoom");
+    strcpy(c.mqtt_host, "10.0.0.2");
+    c.co2_on_ppm          = 1200.0f;
+    c.timer.uvc_on_min    = 15;
+    c.poll.light_ms       = 30000;
+    strcpy(c.probe_labels[2], "Lion's mane");
+    return c;
+}
+
+static std::vector<uint8_t> encode(const MarthaConfig& c) {
+    std::vector<uint8_t> blob(CONFIG_BLOB_SIZE);
+    TEST_ASSERT_EQUAL(CONFIG_BLOB_SIZE, configBlobEncode(c, blob.data(), blob.size()));
+    return blob;
+}
+
+/** reseal(blob) — Recompute the CRC after editing a payload. */
+static void reseal(std::vector<uint8_t>& blob) {
+    ConfigBlobHeader h;
+    memcpy(&h, blob.data(), sizeof(h));
+    h.size = static_cast<uint16_t>(blob.size() - sizeof(h));
+    h.crc  = crc32(blob.data() + sizeof(h), h.size);
+    memcpy(blob.data(), &h, sizeof(h));
+}
+
+void test_crc32_check_value() {
+    const char* s = "123456789";
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926u, crc32(reinterpret_cast<const uint8_t*>(s), 9));
+}
+
+void test_round_trip() {
+    auto         blob = encode(custom());
+    MarthaConfig out;
+    TEST_ASSERT_EQUAL(static_cast<int>(ConfigBlobStatus::OK),
+                      static_cast<int>(configBlobDecode(blob.data(), blob.size(), out)));
+    TEST_ASSERT_EQUAL_STRING("GrowRoom", out.wifi_ssid);
+    TEST_ASSERT_EQUAL_STRING("10.0.0.2", out.mqtt_host);
+    TEST_ASSERT_EQUAL_FLOAT(1200.0f, out.co2_on_ppm);
+    TEST_ASSERT_EQUAL(15, out.timer.uvc_on_min);
+    TEST_ASSERT_EQUAL(30000u, out.poll.light_ms);
+    TEST_ASSERT_EQUAL_STRING("Lion's mane", out.probe_labels[2]);
+    TEST_ASSERT_EQUAL(0, configWriteChanged(custom(), out, nullptr));
+}
+
+void test_encode_needs_room() {
+    uint8_t small[CONFIG_BLOB_SIZE - 1];
+    TEST_ASSERT_EQUAL(0u, configBlobEncode(MarthaConfig{}, small, sizeof(small)));
+}
+
+void test_every_flipped_bit_rejected() {
+    auto blob = encode(custom());
+    // A flip in the payload fails the CRC; one in the header fails magic/size/CRC
+    for (size_t byte = 0; byte < blob.size(); byte += 7) {
+        auto bad = blob;
+        bad[byte] ^= 0x10;
+        MarthaConfig out = custom();
+        out.co2_on_ppm   = 999.0f;
+        ConfigBlobStatus st = configBlobDecode(bad.data(), bad.size(), out);
+        TEST_ASSERT_TRUE(st != ConfigBlobStatus::OK && st != ConfigBlobStatus::UPGRADED);
+        TEST_ASSERT_EQUAL_FLOAT(999.0f, out.co2_on_ppm);   // Untouched, not half-loaded
+    }
+}
+
+void test_header_errors() {
+    auto         blob = encode(custom());
+    MarthaConfig out;
+
+    TEST_ASSERT_EQUAL(static_cast<int>(ConfigBlobStatus::EMPTY),
+                      static_cast<int>(configBlobDecode(blob.data(), 0, out)));
+    TEST_ASSERT_EQUAL(static_cast<int>(ConfigBlobStatus::BAD_SIZE),
+                      static_cast<int>(configBlobDecode(blob.data(), 5, out)));
+    TEST_ASSERT_EQUAL(static_cast<int>(ConfigBlobStatus::BAD_SIZE),
+                      static_cast<int>(configBlobDecode(blob.data(), blob.size() - 1, out)));
+
+    auto bad = blob;
+    bad[0] = 'X';
+    TEST_ASSERT_EQUAL(static_cast<int>(ConfigBlobStatus::BAD_MAGIC),
+                      static_cast<int>(configBlobDecode(bad.data(), bad.size(), out)));
+
+    ConfigBlobHeader h;
+    memcpy(&h, blob.data(), sizeof(h));
+    h.version = CONFIG_BLOB_VERSION + 1;
+    bad = blob;
+    memcpy(bad.data(), &h, sizeof(h));
+    TEST_ASSERT_EQUAL(static_cast<int>(ConfigBlobStatus::TOO_NEW),
+                      static_cast<int>(configBlobDecode(bad.data(), bad.size(), out)));
+}
+
+void test_shorter_payload_keeps_new_field_defaults() {
+    // An older build's blob: same layout, but without the trailing fields
+    MarthaConfig c = custom();
+    strcpy(c.probe_labels[4], "Reishi");
+    auto   blob = encode(c);
+    size_t cut  = offsetof(MarthaConfig, probe_labels) + 4 * sizeof(c.probe_labels[4]);
+    blob.resize(sizeof(ConfigBlobHeader) + cut);
+    reseal(blob);
+
+    MarthaConfig out;
+    TEST_ASSERT_EQUAL(static_cast<int>(ConfigBlobStatus::UPGRADED),
+                      static_cast<int>(configBlobDecode(blob.data(), blob.size(), out)));
+    TEST_ASSERT_EQUAL_STRING("GrowRoom", out.wifi_ssid);
+    TEST_ASSERT_EQUAL_STRING("Lion's mane", out.probe_labels[2]);
+    TEST_ASSERT_EQUAL_STRING("Shelf5", out.probe_labels[4]);   // Default for the "new" field
+}
+
+void test_longer_payload_loads_prefix() {
+    // A newer build of the same version appended fields, then was downgraded
+    auto blob = encode(custom());
+    blob.insert(blob.end(), {0xA5, 0x5A, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06});
+    reseal(blob);
+
+    MarthaConfig out;
+    TEST_ASSERT_EQUAL(static_cast<int>(ConfigBlobStatus::EXTENDED),
+                      static_cast<int>(configBlobDecode(blob.data(), blob.size(), out)));
+    TEST_ASSERT_EQUAL(0, configWriteChanged(custom(), out, nullptr));
+
+    // Still CRC-checked over the whole payload
+    blob.back() ^= 0x01;
+    out.co2_on_ppm = 999.0f;
+    TEST_ASSERT_EQUAL(static_cast<int>(ConfigBlobStatus::BAD_CRC),
+                      static_cast<int>(configBlobDecode(blob.data(), blob.size(), out)));
+    TEST_ASSERT_EQUAL_FLOAT(999.0f, out.co2_on_ppm);
+}
+
+void test_unterminated_strings_are_terminated() {
+    MarthaConfig c;
+    memset(c.timezone, 'A', sizeof(c.timezone));        // No NUL anywhere
+    auto         blob = encode(c);
+    MarthaConfig out;
+    TEST_ASSERT_EQUAL(static_cast<int>(ConfigBlobStatus::OK),
+                      static_cast<int>(configBlobDecode(blob.data(), blob.size(), out)));
+    TEST_ASSERT_EQUAL(sizeof(out.timezone) - 1, strlen(out.timezone));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_crc32_check_value);
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_encode_needs_room);
+    RUN_TEST(test_every_flipped_bit_rejected);
+    RUN_TEST(test_header_errors);
+    RUN_TEST(test_shorter_payload_keeps_new_field_defaults);
+    RUN_TEST(test_longer_payload_loads_prefix);
+    RUN_TEST(test_unterminated_strings_are_terminated);
+    return UNITY_END();
+}
@@ -0,0 +1,117 @@
+/**
+ * test_config_store.cpp — Unit tests for ConfigStore's write path: only
+ * changed NVS keys are written, and saves are debounced but never starved.
+ */
+
+#include <unity.h>
+#include "../../src/config/config_store.h"
+
+#include <cstring>
+#include <map>
+#include <string>
+
+void setUp()    {}
+void tearDown() {}
+
+/** Records every key written, as NVS would hold it. */
+class FakeNvs : public ConfigKeyWriter {
+public:
+    std::map<std::string, std::string> keys;
+
+    void putFloat(const char* k, float v) override    { keys[k] = std::to_string(v); }
+    void putU32(const char* k, uint32_t v) override   { keys[k] = std::to_string(v); }
+    void putU16(const char* k, uint16_t v) override   { keys[k] = std::to_string(v); }
+    void putU8(const char* k, uint8_t v) override     { keys[k] = std::to_string(v); }
+    void putStr(const char* k, const char* v) override { keys[k] = v; }
+};
+
+// ── Key diff ──────────────────────────────────────────────────────────────────
+
+void test_unchanged_config_writes_nothing() {
+    MarthaConfig a, b;
+    FakeNvs      nvs;
+    TEST_ASSERT_EQUAL(0, configWriteChanged(a, b, &nvs));
+    TEST_ASSERT_EQUAL(0u, nvs.keys.size());
+}
+
+void test_single_threshold_writes_one_key() {
+    MarthaConfig saved, cfg;
+    cfg.co2_on_ppm = 1100.0f;
+    FakeNvs nvs;
+    TEST_ASSERT_EQUAL(1, configWriteChanged(saved, cfg, &nvs));
+    TEST_ASSERT_EQUAL(1u, nvs.keys.size());
+    TEST_ASSERT_EQUAL(1u, nvs.keys.count("co2_on"));
+}
+
+void test_strings_compared_by_value() {
+    MarthaConfig saved, cfg;
+    strcpy(saved.wifi_pass, "hunter22");
+    strcpy(cfg.wifi_pass, "hunter22");           // Same password, resubmitted
+    strcpy(cfg.probe_labels[3], "Oyster");
+    cfg.timer.uvc_on_min = 30;
+    FakeNvs nvs;
+    TEST_ASSERT_EQUAL(2, configWriteChanged(saved, cfg, &nvs));
+    TEST_ASSERT_EQUAL_STRING("Oyster", nvs.keys["probe_3"].c_str());
+    TEST_ASSERT_EQUAL(1u, nvs.keys.count("uvc_on"));
+    TEST_ASSERT_EQUAL(0u, nvs.keys.count("wifi_pass"));
+}
+
+void test_all_writes_every_key_once() {
+    MarthaConfig cfg;
+    FakeNvs      nvs;
+    uint8_t      n = configWriteChanged(cfg, cfg, &nvs, true);
+    TEST_ASSERT_EQUAL(nvs.keys.size(), n);     // No key written twice
+    TEST_ASSERT_TRUE(n >= 30);
+    TEST_ASSERT_EQUAL(1u, nvs.keys.count("rh_on"));
+    TEST_ASSERT_EQUAL(1u, nvs.keys.count("probe_4"));
+    TEST_ASSERT_EQUAL(1u, nvs.keys.count("mqtt_port"));
+}
+
+void test_count_only_without_writer() {
+    MarthaConfig saved, cfg;
+    cfg.rh_on_pct  = 90.0f;
+    cfg.poll.rh_ms = 2000;
+    TEST_ASSERT_EQUAL(2, configWriteChanged(saved, cfg, nullptr));
+}
+
+// ── Debounce ──────────────────────────────────────────────────────────────────
+
+void test_save_waits_for_quiet() {
+    ConfigSaveDebounce d;
+    TEST_ASSERT_FALSE(d.due(0));
+    d.touch(1000);
+    TEST_ASSERT_TRUE(d.pending());
+    TEST_ASSERT_FALSE(d.due(1000 + CONFIG_SAVE_DEBOUNCE_MS - 1));
+    d.touch(1500);                                         // Another POST restarts the wait
+    TEST_ASSERT_FALSE(d.due(1000 + CONFIG_SAVE_DEBOUNCE_MS));
+    TEST_ASSERT_TRUE(d.due(1500 + CONFIG_SAVE_DEBOUNCE_MS));
+    d.clear();
+    TEST_ASSERT_FALSE(d.due(100000));
+}
+
+void test_steady_changes_still_saved() {
+    ConfigSaveDebounce d;
+    uint32_t first = 5000, saved_at = 0;
+    for (uint32_t t = first; t < first + 3 * CONFIG_SAVE_MAX_DELAY_MS; t += CONFIG_SAVE_DEBOUNCE_MS / 2) {
+        if (d.due(t)) {
+            saved_at = t;
+            break;
+        }
+        d.touch(t);                                        // A slider dragged without pause
+    }
+    TEST_ASSERT_NOT_EQUAL(0u, saved_at);
+    TEST_ASSERT_TRUE(saved_at - first >= CONFIG_SAVE_MAX_DELAY_MS);
+    TEST_ASSERT_TRUE(saved_at - first < CONFIG_SAVE_MAX_DELAY_MS + CONFIG_SAVE_DEBOUNCE_MS);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_unchanged_config_writes_nothing);
+    RUN_TEST(test_single_threshold_writes_one_key);
+    RUN_TEST(test_strings_compared_by_value);
+    RUN_TEST(test_all_writes_every_key_once);
+    RUN_TEST(test_count_only_without_writer);
+    RUN_TEST(test_save_waits_for_quiet);
+    RUN_TEST(test_steady_changes_still_saved);
+    return UNITY_END();
+}
@@ -0,0 +1,129 @@
+/**
+ * test_control_config.cpp — Unit and stress tests for the control task's
+ * config snapshots: field mapping, change detection, generations taken once
+ * and latest-wins, and no snapshot mixing two publishes under contention.
+ */
+
+#include <unity.h>
+#include "../../src/control/control_config.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+void setUp()    {}
+void tearDown() {}
+
+void test_snapshot_maps_control_fields() {
+    MarthaConfig m;
+    m.rh_on_pct        = 82.0f;
+    m.co2_off_ppm      = 700.0f;
+    m.adc_water_max_mv = 2900;
+    m.timer.uvc_off_min = 90;
+    ControlConfig c = controlConfigFrom(m);
+    TEST_ASSERT_EQUAL_FLOAT(82.0f, c.rh_on_pct);
+    TEST_ASSERT_EQUAL_FLOAT(m.rh_hysteresis, c.rh_hysteresis);
+    TEST_ASSERT_EQUAL_FLOAT(700.0f, c.co2_off_ppm);
+    TEST_ASSERT_EQUAL(2900u, c.water_max_mv);
+    TEST_ASSERT_EQUAL(90, c.timer.uvc_off_min);
+}
+
+void test_default_snapshot_matches_default_config() {
+    ControlConfig c;
+    TEST_ASSERT_EQUAL(0, controlConfigDiff(c, controlConfigFrom(MarthaConfig{})));
+}
+
+void test_diff_reports_changed_parts_only() {
+    MarthaConfig  m;
+    ControlConfig a = controlConfigFrom(m);
+    TEST_ASSERT_EQUAL(0, controlConfigDiff(a, a));
+
+    m.co2_on_ppm = 1300.0f;
+    m.timer.lights_off_minute = 1230;
+    ControlConfig b = controlConfigFrom(m);
+    TEST_ASSERT_EQUAL(CTRL_CFG_CO2 | CTRL_CFG_TIMER, controlConfigDiff(a, b));
+
+    m.rh_hysteresis    = 4.0f;
+    m.adc_water_min_mv = 10;
+    TEST_ASSERT_EQUAL(CTRL_CFG_ALL, controlConfigDiff(a, controlConfigFrom(m)));
+}
+
+void test_take_returns_each_generation_once() {
+    ControlConfigBus bus;
+    ControlConfig    c;
+    TEST_ASSERT_EQUAL(0u, bus.take(c));          // Nothing published yet
+
+    MarthaConfig m;
+    m.rh_on_pct = 80.0f;
+    TEST_ASSERT_EQUAL(1u, bus.publish(m));
+    m.rh_on_pct = 81.0f;
+    TEST_ASSERT_EQUAL(2u, bus.publish(m));
+
+    TEST_ASSERT_EQUAL(2u, bus.take(c));          // Latest wins; generation 1 never applied
+    TEST_ASSERT_EQUAL_FLOAT(81.0f, c.rh_on_pct);
+    TEST_ASSERT_EQUAL(2u, bus.applied());
+
+    c.rh_on_pct = 0.0f;
+    TEST_ASSERT_EQUAL(0u, bus.take(c));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, c.rh_on_pct);  // Untouched when nothing new
+    TEST_ASSERT_EQUAL(2u, bus.published());
+}
+
+void test_no_mixed_snapshots_under_contention() {
+    ControlConfigBus  bus;
+    std::atomic<bool> stop{false};
+
+    // Every field of publish n derives from n, so a mix of two shows up
+    auto make = [](uint32_t n) {
+        MarthaConfig m;
+        m.rh_on_pct              = static_cast<float>(n);
+        m.rh_hysteresis          = static_cast<float>(n);
+        m.co2_on_ppm             = static_cast<float>(n + 1);
+        m.co2_off_ppm            = static_cast<float>(n);
+        m.adc_water_min_mv       = n;
+        m.adc_water_max_mv       = n + 1;
+        m.timer.lights_on_minute = static_cast<uint16_t>(n);
+        m.timer.uvc_off_min      = static_cast<uint16_t>(n);
+        return m;
+    };
+    bus.publish(make(1));
+
+    std::thread web([&] {
+        uint32_t n = 1;
+        while (!stop.load()) bus.publish(make(++n));
+    });
+
+    uint32_t mixed = 0, backwards = 0, taken = 0, last = 0;
+    auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+    while (std::chrono::steady_clock::now() < end) {
+        ControlConfig c;
+        uint32_t      gen = bus.take(c);
+        if (gen == 0) continue;
+        uint32_t n = c.water_min_mv;
+        if (c.rh_on_pct != static_cast<float>(n) || c.co2_on_ppm != static_cast<float>(n + 1) ||
+            c.water_max_mv != n + 1 || c.timer.lights_on_minute != static_cast<uint16_t>(n) ||
+            c.timer.uvc_off_min != static_cast<uint16_t>(n) || n != gen) {
+            mixed++;
+        }
+        if (gen <= last) backwards++;
+        last = gen;
+        taken++;
+    }
+    stop = true;
+    web.join();
+
+    TEST_ASSERT_GREATER_THAN_UINT32(10, taken);
+    TEST_ASSERT_GREATER_THAN_UINT32(1000, last);   // Publisher really was racing us
+    TEST_ASSERT_EQUAL_UINT32(0, mixed);
+    TEST_ASSERT_EQUAL_UINT32(0, backwards);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_snapshot_maps_control_fields);
+    RUN_TEST(test_default_snapshot_matches_default_config);
+    RUN_TEST(test_diff_reports_changed_parts_only);
+    RUN_TEST(test_take_returns_each_generation_once);
+    RUN_TEST(test_no_mixed_snapshots_under_contention);
+    return UNITY_END();
+}
@@ -133,6 +133,27 @@ void test_fogger_off_when_no_valid_sensors() {
     TEST_ASSERT_TRUE(loop.isFogging());
 }
 
+void test_fogger_holds_when_only_heated_shelf_valid() {
+    RelayManager r = make_armed_relay();
+    HumidityLoop loop;
+    uint32_t t = BOOT_LOCK_MS + UVC_EXTRA_GUARD_MS + 200;
+
+    loop.tick(make_snap(95.0f, 600.0f), r, t);
+    TEST_ASSERT_FALSE(loop.isFogging());
+
+    // Shelf 1 just ran its heater (reads dry); the others have dropped out
+    SensorSnapshot heated = make_snap(40.0f, 600.0f);
+    heated.rh[0].heater_blackout = true;
+    heated.rh[1].valid = false;
+    heated.rh[2].valid = false;
+    heated.rh_aggregate_pct = 0.0f;  // Aggregate skips the heated shelf
+
+    t += HUMIDITY_COOLDOWN_MS + 1;
+    loop.tick(heated, r, t);
+    TEST_ASSERT_FALSE(loop.isFogging());
+    TEST_ASSERT_FALSE(r.get(RelayChannel::FOGGER));
+}
+
 // ── CO2 loop ──────────────────────────────────────────────────────────────────
 
 void test_fae_on_above_co2_threshold() {
@@ -223,6 +244,7 @@ int main(int /*argc*/, char** /*argv*/) {
     RUN_TEST(test_fogger_no_chatter_at_threshold);
     RUN_TEST(test_fogger_cooldown_prevents_rapid_cycling);
     RUN_TEST(test_fogger_off_when_no_valid_sensors);
+    RUN_TEST(test_fogger_holds_when_only_heated_shelf_valid);
 
     // CO2
     RUN_TEST(test_fae_on_above_co2_threshold);
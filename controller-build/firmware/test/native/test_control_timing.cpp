@@ -0,0 +1,188 @@
+/**
+ * test_control_timing.cpp — Unit tests for the control task's deadline
+ * schedule, jitter/exec histograms and overrun accounting.
+ *
+ * Drives ControlTiming the way controlTask does (wait for the deadline,
+ * beginTick, work, endTick) in virtual µs with scripted wake-up latency and
+ * tick cost.
+ */
+
+#include <unity.h>
+#include "../../src/control/control_timing.h"
+
+static constexpr uint32_t PERIOD = 1000000;  // 1 s
+
+void setUp()    {}
+void tearDown() {}
+
+/**
+ * runTicks(t, now, n, late, cost) — n periodic ticks: wake `late` µs after each
+ * deadline, run for `cost` µs. Returns the clock after the last tick.
+ */
+static uint32_t runTicks(ControlTiming& t, uint32_t now, int n, uint32_t late, uint32_t cost) {
+    for (int i = 0; i < n; ++i) {
+        now += t.usUntilDue(now) + late;
+        t.beginTick(now);
+        now += cost;
+        t.endTick(now);
+    }
+    return now;
+}
+
+// ── Schedule ──────────────────────────────────────────────────────────────────
+
+void test_period_does_not_stretch_by_tick_cost() {
+    ControlTiming t(PERIOD);
+    t.start(0);
+    uint32_t now = runTicks(t, 0, 100, 2000, 300000);
+    // Tick 100 started at 99 s (+ wake latency); a sleep-after-work loop
+    // would have drifted ~30 s by now
+    TEST_ASSERT_EQUAL_UINT32(99u * PERIOD + 2000 + 300000, now);
+    TEST_ASSERT_EQUAL_UINT32(PERIOD - 302000, t.usUntilDue(now));
+    TEST_ASSERT_EQUAL_UINT32(100, t.ticks());
+    TEST_ASSERT_EQUAL_UINT32(0, t.overruns());
+}
+
+void test_not_due_before_deadline() {
+    ControlTiming t(PERIOD);
+    t.start(5000);
+    TEST_ASSERT_TRUE(t.due(5000));
+    t.beginTick(5000);
+    t.endTick(6000);
+    TEST_ASSERT_FALSE(t.due(5000 + PERIOD - 1));
+    TEST_ASSERT_EQUAL_UINT32(1, t.usUntilDue(5000 + PERIOD - 1));
+    TEST_ASSERT_TRUE(t.due(5000 + PERIOD));
+    TEST_ASSERT_EQUAL_UINT32(0, t.usUntilDue(5000 + PERIOD + 10));
+}
+
+void test_schedule_survives_clock_wrap() {
+    ControlTiming t(PERIOD);
+    uint32_t start = 0xFFFFFFFFu - 2500000;  // Wraps during tick 3
+    t.start(start);
+    uint32_t now = runTicks(t, start, 6, 100, 1000);
+    TEST_ASSERT_EQUAL_UINT32(start + 6 * PERIOD - now, t.usUntilDue(now));
+    TEST_ASSERT_EQUAL_UINT32(0, t.overruns());
+    TEST_ASSERT_EQUAL_UINT32(100, t.maxJitterUs());
+}
+
+// ── Histograms ────────────────────────────────────────────────────────────────
+
+void test_bucket_boundaries() {
+    TEST_ASSERT_EQUAL_UINT32(0, ControlTiming::bucketFloorUs(0));
+    TEST_ASSERT_EQUAL_UINT32(CONTROL_TIMING_BUCKET0_US, ControlTiming::bucketFloorUs(1));
+    TEST_ASSERT_EQUAL_UINT32(CONTROL_TIMING_BUCKET0_US * 2, ControlTiming::bucketFloorUs(2));
+
+    TEST_ASSERT_EQUAL_UINT8(0, ControlTiming::bucketOf(0));
+    TEST_ASSERT_EQUAL_UINT8(0, ControlTiming::bucketOf(CONTROL_TIMING_BUCKET0_US - 1));
+    TEST_ASSERT_EQUAL_UINT8(1, ControlTiming::bucketOf(CONTROL_TIMING_BUCKET0_US));
+    TEST_ASSERT_EQUAL_UINT8(2, ControlTiming::bucketOf(CONTROL_TIMING_BUCKET0_US * 2));
+    TEST_ASSERT_EQUAL_UINT8(2, ControlTiming::bucketOf(CONTROL_TIMING_BUCKET0_US * 4 - 1));
+    // Anything past the top floor lands in the open-ended last bucket
+    TEST_ASSERT_EQUAL_UINT8(ControlTiming::BUCKETS - 1, ControlTiming::bucketOf(0xFFFFFFFFu));
+}
+
+void test_histograms_record_jitter_and_exec() {
+    ControlTiming t(PERIOD);
+    t.start(0);
+    uint32_t now = runTicks(t, 0, 10, 1500, 20000);
+    now          = runTicks(t, now, 5, 30, 200000);
+
+    uint8_t jb_slow = ControlTiming::bucketOf(1500), jb_fast = ControlTiming::bucketOf(30);
+    uint8_t eb_fast = ControlTiming::bucketOf(20000), eb_slow = ControlTiming::bucketOf(200000);
+    TEST_ASSERT_EQUAL_UINT32(10, t.jitterHist(jb_slow));
+    TEST_ASSERT_EQUAL_UINT32(5, t.jitterHist(jb_fast));
+    TEST_ASSERT_EQUAL_UINT32(10, t.execHist(eb_fast));
+    TEST_ASSERT_EQUAL_UINT32(5, t.execHist(eb_slow));
+
+    uint32_t total = 0;
+    for (uint8_t b = 0; b < ControlTiming::BUCKETS; ++b) total += t.execHist(b);
+    TEST_ASSERT_EQUAL_UINT32(15, total);
+
+    TEST_ASSERT_EQUAL_UINT32(1500, t.maxJitterUs());
+    TEST_ASSERT_EQUAL_UINT32(200000, t.maxExecUs());
+    TEST_ASSERT_EQUAL_UINT32(200000, t.lastExecUs());
+    TEST_ASSERT_EQUAL_UINT32(0, t.execHist(ControlTiming::BUCKETS));  // Out of range reads 0
+}
+
+void test_reset_clears_stats_but_keeps_schedule() {
+    ControlTiming t(PERIOD);
+    t.start(0);
+    uint32_t now  = runTicks(t, 0, 3, 500, 5000);
+    uint32_t left = t.usUntilDue(now);
+    t.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, t.ticks());
+    TEST_ASSERT_EQUAL_UINT32(0, t.maxExecUs());
+    TEST_ASSERT_EQUAL_UINT32(0, t.jitterHist(ControlTiming::bucketOf(500)));
+    TEST_ASSERT_EQUAL_UINT32(left, t.usUntilDue(now));
+}
+
+// ── Overruns ──────────────────────────────────────────────────────────────────
+
+void test_tick_past_next_deadline_is_overrun() {
+    ControlTiming t(PERIOD);
+    t.start(0);
+    t.beginTick(0);
+    TEST_ASSERT_FALSE(t.endTick(PERIOD - 1));
+    t.beginTick(PERIOD);
+    TEST_ASSERT_TRUE(t.endTick(2 * PERIOD + 50000));   // Ran into the next period
+    TEST_ASSERT_EQUAL_UINT32(1, t.overruns());
+    TEST_ASSERT_EQUAL_UINT32(0, t.skipped());
+
+    // The late tick still gets its own deadline — no catch-up burst needed
+    TEST_ASSERT_TRUE(t.due(2 * PERIOD + 50000));
+    t.beginTick(2 * PERIOD + 50000);
+    TEST_ASSERT_EQUAL_UINT32(50000, t.maxJitterUs());
+    TEST_ASSERT_FALSE(t.endTick(2 * PERIOD + 60000));
+    TEST_ASSERT_EQUAL_UINT32(PERIOD - 60000, t.usUntilDue(2 * PERIOD + 60000));
+}
+
+void test_stall_skips_missed_deadlines_and_keeps_phase() {
+    ControlTiming t(PERIOD);
+    t.start(0);
+    t.beginTick(0);
+    t.endTick(1000);
+    // Blocked for 3.4 s: deadlines at 1, 2 and 3 s are gone
+    t.beginTick(3400000);
+    TEST_ASSERT_EQUAL_UINT32(2, t.skipped());
+    t.endTick(3401000);
+    TEST_ASSERT_EQUAL_UINT32(600000 - 1000, t.usUntilDue(3401000));  // Next at 4 s, not 4.4 s
+    TEST_ASSERT_EQUAL_UINT32(0, t.overruns());
+}
+
+void test_overrun_warnings_are_rate_limited() {
+    ControlTiming t(PERIOD);
+    t.start(0);
+    // Every tick overruns for 5 minutes
+    uint32_t now = 0;
+    for (int i = 0; i < 300; ++i) {
+        t.beginTick(now);
+        now += PERIOD + 1000;
+        t.endTick(now);
+    }
+    TEST_ASSERT_EQUAL_UINT32(300, t.overruns());
+    // First at once, then one per CONTROL_OVERRUN_LOG_INTERVAL_MS
+    uint32_t expect = 1 + (now / 1000) / CONTROL_OVERRUN_LOG_INTERVAL_MS;
+    TEST_ASSERT_UINT32_WITHIN(1, expect, t.overrunWarnings());
+
+    // Clean ticks: no further warnings once the backlog is reported
+    uint32_t before = t.overrunWarnings();
+    now = runTicks(t, now, 200, 100, 1000);
+    TEST_ASSERT_TRUE(t.overrunWarnings() <= before + 1);
+    uint32_t settled = t.overrunWarnings();
+    runTicks(t, now, 200, 100, 1000);
+    TEST_ASSERT_EQUAL_UINT32(settled, t.overrunWarnings());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_period_does_not_stretch_by_tick_cost);
+    RUN_TEST(test_not_due_before_deadline);
+    RUN_TEST(test_schedule_survives_clock_wrap);
+    RUN_TEST(test_bucket_boundaries);
+    RUN_TEST(test_histograms_record_jitter_and_exec);
+    RUN_TEST(test_reset_clears_stats_but_keeps_schedule);
+    RUN_TEST(test_tick_past_next_deadline_is_overrun);
+    RUN_TEST(test_stall_skips_missed_deadlines_and_keeps_phase);
+    RUN_TEST(test_overrun_warnings_are_rate_limited);
+    return UNITY_END();
+}
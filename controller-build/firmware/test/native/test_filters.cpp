@@ -0,0 +1,244 @@
+/**
+ * test_filters.cpp — Unit tests and per-sample cost benchmarks for filters.h.
+ *
+ * Windowed filters are checked against a brute-force sort of the same
+ * window. The benchmarks print ns/sample on the host; the bound asserted is
+ * loose (it only catches an accidental O(N²) or heap path).
+ */
+
+#include <unity.h>
+#include "../../src/util/filters.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+void setUp()    {}
+void tearDown() {}
+
+/** lcg(state) — Deterministic pseudo-random sample in [0, 100). */
+static float lcg(uint32_t& state) {
+    state = state * 1664525u + 1013904223u;
+    return static_cast<float>(state >> 8) / static_cast<float>(1u << 24) * 100.0f;
+}
+
+// ── SortedWindow / MedianFilter ───────────────────────────────────────────────
+
+void test_median_matches_brute_force() {
+    MedianFilter<float, 7> med;
+    std::vector<float>     hist;
+    uint32_t               seed = 1;
+    for (int i = 0; i < 500; ++i) {
+        float x = lcg(seed);
+        hist.push_back(x);
+        float got = med.push(x);
+
+        size_t n = std::min<size_t>(hist.size(), 7);
+        std::vector<float> win(hist.end() - n, hist.end());
+        std::sort(win.begin(), win.end());
+        float want = (n % 2) ? win[n / 2] : (win[n / 2 - 1] + win[n / 2]) / 2.0f;
+        TEST_ASSERT_EQUAL_FLOAT(want, got);
+    }
+}
+
+void test_median_handles_duplicates() {
+    MedianFilter<int, 5> med;
+    int in[]   = {3, 3, 3, 1, 1, 1, 3, 3};
+    int want[] = {3, 3, 3, 3, 3, 1, 1, 1};
+    for (int i = 0; i < 8; ++i) TEST_ASSERT_EQUAL_INT(want[i], med.push(in[i]));
+}
+
+void test_mad_of_window() {
+    SortedWindow<float, 5> win;
+    for (float x : {1.0f, 2.0f, 3.0f, 4.0f, 100.0f}) win.push(x);
+    // |x − 3| = 2, 1, 0, 1, 97 → MAD 1
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, win.median());
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, win.mad(win.median()));
+
+    SortedWindow<float, 4> even;
+    for (float x : {1.0f, 2.0f, 4.0f, 8.0f}) even.push(x);
+    // Median 3; deviations 2, 1, 1, 5 → MAD (1 + 2) / 2
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, even.median());
+    TEST_ASSERT_EQUAL_FLOAT(1.5f, even.mad(even.median()));
+}
+
+// ── HampelFilter ──────────────────────────────────────────────────────────────
+
+void test_hampel_passes_clean_data_unchanged() {
+    HampelFilter<float, 5> h(3.0f);
+    float in[] = {50.0f, 50.4f, 49.8f, 50.1f, 50.3f, 49.9f, 50.2f};
+    for (float x : in) TEST_ASSERT_EQUAL_FLOAT(x, h.push(x));
+    TEST_ASSERT_EQUAL_UINT32(0, h.rejected());
+}
+
+void test_hampel_replaces_spike_with_median() {
+    HampelFilter<float, 5> h(3.0f);
+    for (float x : {50.0f, 50.4f, 49.8f, 50.1f}) h.push(x);
+    float out = h.push(95.0f);
+    TEST_ASSERT_EQUAL_FLOAT(50.1f, out);
+    TEST_ASSERT_EQUAL_UINT32(1, h.rejected());
+}
+
+void test_hampel_floor_lets_small_steps_through_flat_window() {
+    HampelFilter<float, 5> strict(3.0f);
+    HampelFilter<float, 5> floored(3.0f, 1.0f);
+    for (int i = 0; i < 5; ++i) { strict.push(20.0f); floored.push(20.0f); }
+    TEST_ASSERT_EQUAL_FLOAT(20.0f, strict.push(20.5f));   // MAD 0: any change is an outlier
+    TEST_ASSERT_EQUAL_FLOAT(20.5f, floored.push(20.5f));
+}
+
+void test_hampel_reset_clears_history() {
+    HampelFilter<float, 5> h(3.0f);
+    for (int i = 0; i < 5; ++i) h.push(20.0f);
+    h.reset();
+    TEST_ASSERT_EQUAL_FLOAT(80.0f, h.push(80.0f));        // Warm-up: passes through
+    TEST_ASSERT_EQUAL_UINT32(0, h.rejected());
+}
+
+// ── EmaFilter / LowPassFilter ─────────────────────────────────────────────────
+
+void test_ema_seeds_then_converges() {
+    EmaFilter<float> ema(0.25f);
+    TEST_ASSERT_EQUAL_FLOAT(10.0f, ema.push(10.0f));
+    TEST_ASSERT_EQUAL_FLOAT(12.5f, ema.push(20.0f));
+    for (int i = 0; i < 100; ++i) ema.push(20.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 20.0f, ema.push(20.0f));
+}
+
+void test_lowpass_unity_dc_gain_and_attenuation() {
+    LowPassFilter<float> lp(0.05f, 1.0f);
+    TEST_ASSERT_EQUAL_FLOAT(5.0f, lp.push(5.0f));         // Seeds at the input level
+    for (int i = 0; i < 200; ++i) lp.push(10.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 10.0f, lp.push(10.0f));
+
+    // Nyquist-rate alternation is fully rejected by the zero at z = −1
+    lp.reset();
+    float peak = 0.0f;
+    for (int i = 0; i < 400; ++i) {
+        float y = lp.push((i % 2) ? 1.0f : -1.0f);
+        if (i > 200) peak = std::max(peak, std::fabs(y));
+    }
+    TEST_ASSERT_TRUE(peak < 0.01f);
+}
+
+// ── FilterChain ───────────────────────────────────────────────────────────────
+
+void test_chain_applies_stages_in_order() {
+    FilterChain<float, HampelFilter<float, 5>, EmaFilter<float>> chain{
+        HampelFilter<float, 5>(3.0f), EmaFilter<float>(0.5f)};
+    for (int i = 0; i < 5; ++i) chain.push(40.0f);
+    // Spike removed before it reaches the EMA
+    TEST_ASSERT_EQUAL_FLOAT(40.0f, chain.push(400.0f));
+    TEST_ASSERT_EQUAL_UINT32(1, chain.stage<0>().rejected());
+    TEST_ASSERT_EQUAL(2u, (decltype(chain)::size()));
+
+    chain.reset();
+    TEST_ASSERT_EQUAL_FLOAT(7.0f, chain.push(7.0f));
+}
+
+void test_empty_chain_is_passthrough() {
+    FilterChain<float> none;
+    TEST_ASSERT_EQUAL_FLOAT(3.25f, none.push(3.25f));
+    TEST_ASSERT_EQUAL(0u, (decltype(none)::size()));
+}
+
+// ── CicDecimator ──────────────────────────────────────────────────────────────
+
+void test_cic_boxcar_averages_each_block() {
+    CicDecimator<1, 4> cic;
+    uint32_t in[] = {10, 20, 30, 40, 1, 1, 1, 2};
+    uint32_t out = 0, outs[2], n = 0;
+    for (uint32_t x : in) if (cic.push(x, out)) outs[n++] = out;
+    TEST_ASSERT_EQUAL_UINT32(2, n);
+    TEST_ASSERT_EQUAL_UINT32(25, outs[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, outs[1]);       // 5/4 rounds down
+}
+
+void test_cic_swallows_warmup_outputs() {
+    CicDecimator<3, 8> cic;
+    uint32_t out = 0, n = 0;
+    for (int i = 0; i < 8 * 3; ++i) if (cic.push(1000, out)) n++;
+    TEST_ASSERT_EQUAL_UINT32(1, n);             // Only the first full-response output
+    TEST_ASSERT_EQUAL_UINT32(1000, out);
+}
+
+void test_cic_exact_through_register_wrap() {
+    CicDecimator<2, 500> cic;                   // Integrators wrap after ~2k samples at 4095
+    uint32_t out = 0, last = 0;
+    for (int i = 0; i < 500 * 200; ++i) if (cic.push(4095, out)) last = out;
+    TEST_ASSERT_EQUAL_UINT32(4095, last);
+}
+
+void test_cic_nulls_tone_at_output_rate() {
+    CicDecimator<2, 64> cic;
+    uint32_t out = 0;
+    for (int i = 0; i < 64 * 20; ++i) {
+        // One full sine cycle per output block, riding on 2000
+        float x = 2000.0f + 500.0f * std::sin(2.0f * 3.14159265f * static_cast<float>(i) / 64.0f);
+        if (cic.push(static_cast<uint32_t>(x + 0.5f), out)) {
+            TEST_ASSERT_TRUE(out >= 1999 && out <= 2001);
+        }
+    }
+}
+
+// ── Benchmarks ────────────────────────────────────────────────────────────────
+
+/** nsPerSample(f) — Mean host cost of f.push() over a noisy input. */
+template<typename F>
+static double nsPerSample(F& f) {
+    constexpr int SAMPLES = 200000;
+    uint32_t seed = 7;
+    volatile float sink = 0.0f;
+    auto t0 = Clock::now();
+    for (int i = 0; i < SAMPLES; ++i) sink = f.push(lcg(seed));
+    auto dt = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0);
+    (void)sink;
+    return static_cast<double>(dt.count()) / SAMPLES;
+}
+
+void test_benchmark_per_sample_cost() {
+    MedianFilter<float, 5>  med5;
+    MedianFilter<float, 15> med15;
+    HampelFilter<float, 5>  ham5(3.0f);
+    HampelFilter<float, 15> ham15(3.0f);
+    EmaFilter<float>        ema(0.2f);
+    LowPassFilter<float>    lp(0.1f, 1.0f);
+    FilterChain<float, HampelFilter<float, 5>, LowPassFilter<float>> chain;
+
+    struct { const char* name; double ns; } r[] = {
+        {"median5",  nsPerSample(med5)},
+        {"median15", nsPerSample(med15)},
+        {"hampel5",  nsPerSample(ham5)},
+        {"hampel15", nsPerSample(ham15)},
+        {"ema",      nsPerSample(ema)},
+        {"lowpass",  nsPerSample(lp)},
+        {"hampel5+lowpass", nsPerSample(chain)},
+    };
+    for (auto& e : r) {
+        printf("filter %-16s %7.1f ns/sample\n", e.name, e.ns);
+        TEST_ASSERT_TRUE(e.ns < 5000.0);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_median_matches_brute_force);
+    RUN_TEST(test_median_handles_duplicates);
+    RUN_TEST(test_mad_of_window);
+    RUN_TEST(test_hampel_passes_clean_data_unchanged);
+    RUN_TEST(test_hampel_replaces_spike_with_median);
+    RUN_TEST(test_hampel_floor_lets_small_steps_through_flat_window);
+    RUN_TEST(test_hampel_reset_clears_history);
+    RUN_TEST(test_ema_seeds_then_converges);
+    RUN_TEST(test_lowpass_unity_dc_gain_and_attenuation);
+    RUN_TEST(test_chain_applies_stages_in_order);
+    RUN_TEST(test_empty_chain_is_passthrough);
+    RUN_TEST(test_cic_boxcar_averages_each_block);
+    RUN_TEST(test_cic_swallows_warmup_outputs);
+    RUN_TEST(test_cic_exact_through_register_wrap);
+    RUN_TEST(test_cic_nulls_tone_at_output_rate);
+    RUN_TEST(test_benchmark_per_sample_cost);
+    return UNITY_END();
+}
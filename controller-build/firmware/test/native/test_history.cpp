@@ -0,0 +1,275 @@
+/**
+ * test_history.cpp — Unit tests for the tiered sensor history: quantisation,
+ * 2 s bucketing, rollups, ring wrap, tier selection and the chunked JSON
+ * stream behind /api/history.
+ */
+
+#include <unity.h>
+#include "../../src/web/history.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+void setUp()    {}
+void tearDown() {}
+
+/** Small rings so wrap-around is cheap to reach. */
+static constexpr HistoryLayout SMALL = {{30, 10, 8}};
+
+struct Rig {
+    std::vector<uint32_t> mem;
+    HistoryCore           h;
+    explicit Rig(const HistoryLayout& layout = SMALL)
+        : mem(HistoryCore::bytesFor(layout) / 4 + 1) { h.init(layout, mem.data()); }
+};
+
+static SensorSnapshot snapWith(float co2, float rh) {
+    SensorSnapshot s = {};
+    s.co2.co2_ppm  = co2;
+    s.co2.valid    = true;
+    s.rh_aggregate_pct = rh;
+    for (auto& r : s.rh) {
+        r.rh_pct = rh;
+        r.temp_c = 21.0f;
+        r.valid  = true;
+    }
+    s.water_level_pct   = 50.0f;
+    s.water_level_valid = true;
+    return s;
+}
+
+static std::string readAll(HistoryQuery& q, size_t chunk) {
+    std::string out;
+    std::vector<char> buf(chunk);
+    for (size_t n; (n = q.read(buf.data(), buf.size())) > 0;) out.append(buf.data(), n);
+    return out;
+}
+
+static size_t countRows(const std::string& json) {
+    size_t rows = 0, depth = 0;
+    size_t start = json.find("\"rows\":[");
+    for (size_t i = start + 8; i < json.size(); ++i) {
+        if (json[i] == '[' && depth++ == 0) rows++;
+        if (json[i] == ']') {
+            if (depth == 0) break;
+            depth--;
+        }
+    }
+    return rows;
+}
+
+// ── Sampling ──────────────────────────────────────────────────────────────────
+
+void test_sample_quantises_and_marks_missing() {
+    SensorSnapshot s = snapWith(812.4f, 88.125f);
+    s.rh[1].valid         = false;
+    s.temp_probe[0]       = -3.256f;
+    s.temp_probe_valid[0] = true;
+    s.water_level_valid   = false;
+    HistorySample h = historySample(s, 42);
+    TEST_ASSERT_EQUAL_UINT32(42, h.t);
+    TEST_ASSERT_EQUAL_INT16(812, h.v[HS_CO2]);
+    TEST_ASSERT_EQUAL_INT16(8813, h.v[HS_RH_A]);
+    TEST_ASSERT_EQUAL_INT16(HISTORY_NONE, h.v[HS_RH0 + 1]);
+    TEST_ASSERT_EQUAL_INT16(HISTORY_NONE, h.v[HS_TS0 + 1]);
+    TEST_ASSERT_EQUAL_INT16(2100, h.v[HS_TS0 + 2]);
+    TEST_ASSERT_EQUAL_INT16(-326, h.v[HS_TP0]);
+    TEST_ASSERT_EQUAL_INT16(HISTORY_NONE, h.v[HS_TP0 + 1]);
+    TEST_ASSERT_EQUAL_INT16(HISTORY_NONE, h.v[HS_WL]);
+
+    s.rh_aggregate_pct = NAN;
+    TEST_ASSERT_EQUAL_INT16(HISTORY_NONE, historySample(s, 0).v[HS_RH_A]);
+}
+
+void test_one_sample_per_two_second_bucket() {
+    Rig r;
+    r.h.add(snapWith(800, 80), 1000);
+    r.h.add(snapWith(900, 80), 1500);    // Same bucket: ignored
+    r.h.add(snapWith(950, 80), 2100);
+    r.h.add(snapWith(990, 80), 3900);    // Same bucket as 2100
+    TEST_ASSERT_EQUAL_UINT32(2, r.h.endSeq(0));
+    TEST_ASSERT_EQUAL_UINT32(0, r.h.sample(0).t);
+    TEST_ASSERT_EQUAL_INT16(800, r.h.sample(0).v[HS_CO2]);
+    TEST_ASSERT_EQUAL_UINT32(2, r.h.sample(1).t);
+    TEST_ASSERT_EQUAL_INT16(950, r.h.sample(1).v[HS_CO2]);
+}
+
+void test_minute_rollup_min_avg_max() {
+    Rig r;
+    // 30 samples in minute 0 (co2 = 800..829), then one in minute 1 closes it
+    for (uint32_t i = 0; i < 30; ++i) {
+        SensorSnapshot s = snapWith(800.0f + i, 80);
+        s.co2.valid = i != 5;           // A gap is left out, not averaged as zero
+        r.h.add(s, i * 2000);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, r.h.endSeq(1));
+    r.h.add(snapWith(500, 80), 60000);
+    TEST_ASSERT_EQUAL_UINT32(1, r.h.endSeq(1));
+
+    const HistoryRollup& row = r.h.rollup(1, 0);
+    TEST_ASSERT_EQUAL_UINT32(0, row.t);
+    TEST_ASSERT_EQUAL_INT16(800, row.min[HS_CO2]);
+    TEST_ASSERT_EQUAL_INT16(829, row.max[HS_CO2]);
+    TEST_ASSERT_EQUAL_INT16(815, row.avg[HS_CO2]);        // (Σ 800..829 − 805) / 29 = 814.8
+    TEST_ASSERT_EQUAL_INT16(8000, row.avg[HS_RH_A]);
+    TEST_ASSERT_EQUAL_INT16(HISTORY_NONE, row.avg[HS_TP0]);   // Never valid
+}
+
+void test_raw_ring_wraps_and_stays_sorted() {
+    Rig r;
+    for (uint32_t i = 0; i < 100; ++i) r.h.add(snapWith(static_cast<float>(i), 80), i * 2000);
+    TEST_ASSERT_EQUAL_UINT32(100, r.h.endSeq(0));
+    TEST_ASSERT_EQUAL_UINT32(70, r.h.firstSeq(0));
+    TEST_ASSERT_EQUAL_UINT32(140, r.h.rowTime(0, 70));
+    TEST_ASSERT_EQUAL_UINT32(75, r.h.seqAtOrAfter(0, 149));
+    TEST_ASSERT_EQUAL_UINT32(70, r.h.seqAtOrAfter(0, 0));
+    TEST_ASSERT_EQUAL_UINT32(100, r.h.seqAtOrAfter(0, 1000));
+}
+
+void test_time_continues_across_millis_wrap() {
+    Rig r;
+    uint32_t t0 = 0xFFFFFFFFu - 3000;
+    r.h.add(snapWith(1, 80), t0);
+    r.h.add(snapWith(2, 80), t0 + 2000);
+    r.h.add(snapWith(3, 80), t0 + 4000);   // Wrapped
+    TEST_ASSERT_EQUAL_UINT32(3, r.h.endSeq(0));
+    TEST_ASSERT_TRUE(r.h.rowTime(0, 2) > r.h.rowTime(0, 1));
+    TEST_ASSERT_EQUAL_UINT32(4, r.h.rowTime(0, 2) - r.h.rowTime(0, 0));
+}
+
+// ── Tier selection ────────────────────────────────────────────────────────────
+
+void test_pick_tier_uses_finest_covering_tier() {
+    Rig r;   // raw 60 s, 1-min 10 min, 15-min 2 h
+    for (uint32_t t = 0; t <= 40; t += 2) r.h.add(snapWith(800, 80), t * 1000);
+    // Nothing overwritten yet: raw covers everything since boot
+    TEST_ASSERT_EQUAL_UINT8(0, r.h.pickTier(0, 40, 0));
+    TEST_ASSERT_EQUAL_UINT8(1, r.h.pickTier(0, 40, 30));         // res asks for coarser
+    TEST_ASSERT_EQUAL_UINT8(2, r.h.pickTier(0, 40, 61));
+
+    for (uint32_t t = 42; t <= 300; t += 2) r.h.add(snapWith(800, 80), t * 1000);
+    TEST_ASSERT_EQUAL_UINT8(0, r.h.pickTier(250, 300, 0));       // Recent: still raw
+    TEST_ASSERT_EQUAL_UINT8(1, r.h.pickTier(100, 300, 0));       // Raw no longer holds 100
+    TEST_ASSERT_EQUAL_UINT8(2, r.h.pickTier(0, 300, 2000));      // Fallback: coarsest
+}
+
+void test_pick_tier_caps_points_per_response() {
+    Rig r(HISTORY_LAYOUT_FULL);
+    r.h.add(snapWith(800, 80), 0);
+    uint32_t day = 86400;
+    TEST_ASSERT_EQUAL_UINT8(1, r.h.pickTier(0, day, 0));          // 1440 rows
+    TEST_ASSERT_EQUAL_UINT8(2, r.h.pickTier(0, 7 * day, 0));      // 672 rows
+}
+
+// ── Query stream ──────────────────────────────────────────────────────────────
+
+void test_query_json_raw_rows() {
+    Rig r;
+    SensorSnapshot s = snapWith(812, 88.5f);
+    r.h.add(s, 0);
+    s.co2.valid = false;
+    r.h.add(s, 2000);
+    HistoryQuery q(r.h, historySeriesMask("co2,rh"), 0, 10, 0);
+    TEST_ASSERT_EQUAL_UINT8(0, q.tier());
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"now\":2,\"res\":2,\"from\":0,\"to\":10,\"series\":[\"co2\",\"rh\"],"
+        "\"rows\":[[0,812,88.50],[2,null,88.50]]}",
+        readAll(q, 256).c_str());
+}
+
+void test_query_json_rollup_rows_and_negative_values() {
+    Rig r;
+    SensorSnapshot s = snapWith(800, 80);
+    s.temp_probe_valid[0] = true;
+    for (uint32_t i = 0; i < 31; ++i) {
+        s.temp_probe[0] = -1.0f - 0.01f * static_cast<float>(i % 3);
+        r.h.add(s, i * 2000);
+    }
+    HistoryQuery q(r.h, historySeriesMask("tp1"), 0, 100, 60);
+    TEST_ASSERT_EQUAL_UINT8(1, q.tier());
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"now\":60,\"res\":60,\"from\":0,\"to\":100,\"series\":[\"tp1\"],"
+        "\"rows\":[[0,[-1.02,-1.01,-1.00]]]}",
+        readAll(q, 256).c_str());
+}
+
+void test_query_chunk_size_does_not_change_output() {
+    Rig r(HISTORY_LAYOUT_LITE);
+    for (uint32_t t = 0; t < 3600; t += 2) r.h.add(snapWith(800.0f + t % 50, 80), t * 1000);
+    HistoryQuery a(r.h, HISTORY_ALL, 0, 3600, 60);
+    HistoryQuery b(r.h, HISTORY_ALL, 0, 3600, 60);
+    std::string big = readAll(a, 4096);
+    TEST_ASSERT_EQUAL_STRING(big.c_str(), readAll(b, 7).c_str());
+    TEST_ASSERT_EQUAL(59u, countRows(big));    // Minute 59 is still open
+}
+
+void test_unknown_series_rejected() {
+    TEST_ASSERT_EQUAL_UINT32(0, historySeriesMask("co2,bogus"));
+    TEST_ASSERT_EQUAL_UINT32(HISTORY_ALL, historySeriesMask(""));
+    TEST_ASSERT_EQUAL_UINT32((1u << HS_TP0) | (1u << HS_WL), historySeriesMask("tp1,wl"));
+    TEST_ASSERT_EQUAL_STRING("tp5", historySeriesName(HS_TP0 + 4));
+}
+
+void test_rows_overwritten_mid_stream_are_skipped() {
+    Rig r;   // Raw ring of 30 rows
+    for (uint32_t t = 0; t < 60; t += 2) r.h.add(snapWith(static_cast<float>(t), 80), t * 1000);
+    HistoryQuery q(r.h, historySeriesMask("co2"), 0, 1000, 0);
+    char   buf[64];
+    std::string out(buf, q.read(buf, sizeof(buf)));   // Header + first rows
+    for (uint32_t t = 60; t < 120; t += 2) r.h.add(snapWith(static_cast<float>(t), 80), t * 1000);
+    out += readAll(q, 64);
+
+    // Every row is [t,t] (co2 == time), so any torn row would show up here
+    size_t rows = 0;
+    long   prev = -1;
+    for (size_t p = out.find("[[") + 1; (p = out.find('[', p)) != std::string::npos; ++p) {
+        long t = 0, v = 0;
+        TEST_ASSERT_EQUAL_INT(2, sscanf(out.c_str() + p, "[%ld,%ld]", &t, &v));
+        TEST_ASSERT_EQUAL_INT32(t, v);
+        TEST_ASSERT_TRUE(t > prev);
+        prev = t;
+        rows++;
+    }
+    TEST_ASSERT_EQUAL_INT32(118, prev);
+    TEST_ASSERT_TRUE(rows < 60);
+}
+
+void test_day_chart_after_thirty_days_is_one_bounded_response() {
+    Rig r(HISTORY_LAYOUT_FULL);
+    uint32_t ms = 0;
+    for (uint32_t i = 0; i < 30u * 86400 / 2; ++i, ms += 2000) {
+        r.h.add(snapWith(800.0f + static_cast<float>(i % 100), 85), ms);
+    }
+    uint32_t now = r.h.nowS();
+    HistoryQuery day(r.h, historySeriesMask("co2,rh"), now - 86400, now, 0);
+    TEST_ASSERT_EQUAL_UINT8(1, day.tier());
+    std::string json = readAll(day, 1460);
+    TEST_ASSERT_TRUE(countRows(json) >= 1439 && countRows(json) <= 1440);
+
+    HistoryQuery month(r.h, historySeriesMask("co2"), 0, now, 0);
+    TEST_ASSERT_EQUAL_UINT8(2, month.tier());
+    TEST_ASSERT_TRUE(countRows(readAll(month, 1460)) >= 2878);
+    printf("history: 24 h chart (co2,rh) %u bytes, %u rows\n",
+           static_cast<unsigned>(json.size()), static_cast<unsigned>(countRows(json)));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_sample_quantises_and_marks_missing);
+    RUN_TEST(test_one_sample_per_two_second_bucket);
+    RUN_TEST(test_minute_rollup_min_avg_max);
+    RUN_TEST(test_raw_ring_wraps_and_stays_sorted);
+    RUN_TEST(test_time_continues_across_millis_wrap);
+    RUN_TEST(test_pick_tier_uses_finest_covering_tier);
+    RUN_TEST(test_pick_tier_caps_points_per_response);
+    RUN_TEST(test_query_json_raw_rows);
+    RUN_TEST(test_query_json_rollup_rows_and_negative_values);
+    RUN_TEST(test_query_chunk_size_does_not_change_output);
+    RUN_TEST(test_unknown_series_rejected);
+    RUN_TEST(test_rows_overwritten_mid_stream_are_skipped);
+    RUN_TEST(test_day_chart_after_thirty_days_is_one_bounded_response);
+    return UNITY_END();
+}
@@ -0,0 +1,177 @@
+/**
+ * test_i2c_supervisor.cpp — Unit tests for I2C per-device backoff and bus clear.
+ *
+ * The supervisor only touches the bus through busStuck()/clearBus(), so the
+ * fake here models just an SDA line that can be held low by a wedged slave.
+ */
+
+#include <unity.h>
+#include "../../src/sensors/i2c_supervisor.h"
+#include "../../include/config.h"
+
+// ── Fake bus ──────────────────────────────────────────────────────────────────
+
+class FakeLineBus : public I2cBus {
+public:
+    bool     sda_low      = false;
+    bool     clear_frees  = true;   // clearBus() releases SDA
+    uint32_t clears       = 0;
+
+    bool write(uint8_t, const uint8_t*, size_t) override { return !sda_low; }
+    bool read(uint8_t, uint8_t*, size_t) override       { return !sda_low; }
+    void sleepUs(uint32_t) override {}
+    bool busStuck() override { return sda_low; }
+    bool clearBus() override {
+        clears++;
+        if (clear_frees) sda_low = false;
+        return !sda_low;
+    }
+};
+
+static constexpr uint8_t A  = 0x44;
+static constexpr uint8_t B  = 0x61;
+static constexpr uint8_t NC = I2cSupervisor::NO_CHANNEL;
+
+static FakeLineBus*   bus;
+static I2cSupervisor* sup;
+
+/** fail(addr, ch, now, n) — Report n consecutive failures at time now. */
+static void fail(uint8_t addr, uint8_t ch, uint32_t now, int n = 1) {
+    for (int i = 0; i < n; ++i) sup->report(addr, ch, false, now);
+}
+
+void setUp() {
+    bus = new FakeLineBus();
+    sup = new I2cSupervisor(*bus);
+}
+
+void tearDown() {
+    delete sup;
+    delete bus;
+}
+
+// ── Tests ─────────────────────────────────────────────────────────────────────
+
+void test_isolated_failures_do_not_back_off() {
+    fail(A, NC, 1000, I2C_FAIL_THRESHOLD - 1);
+    sup->report(A, NC, true, 1000);
+    fail(A, NC, 2000, I2C_FAIL_THRESHOLD - 1);
+    TEST_ASSERT_TRUE(sup->allow(A, NC, 2000));
+    TEST_ASSERT_FALSE(sup->needsInit(A, NC));
+    TEST_ASSERT_EQUAL_UINT32(2 * (I2C_FAIL_THRESHOLD - 1), sup->slot(0).errors);
+}
+
+void test_streak_triggers_backoff() {
+    fail(A, NC, 1000, I2C_FAIL_THRESHOLD);
+    TEST_ASSERT_FALSE(sup->allow(A, NC, 1000));
+    TEST_ASSERT_FALSE(sup->allow(A, NC, 1000 + I2C_BACKOFF_MIN_MS - 1));
+    TEST_ASSERT_TRUE(sup->allow(A, NC, 1000 + I2C_BACKOFF_MIN_MS));
+    TEST_ASSERT_TRUE(sup->needsInit(A, NC));
+
+    I2cSupervisor::SlotInfo s = sup->slot(0);
+    TEST_ASSERT_TRUE(s.suspended);
+    TEST_ASSERT_EQUAL_UINT32(I2C_BACKOFF_MIN_MS, s.backoff_ms);
+}
+
+void test_backoff_doubles_up_to_cap() {
+    uint32_t now = 0;
+    fail(A, NC, now, I2C_FAIL_THRESHOLD);
+    uint32_t expect = I2C_BACKOFF_MIN_MS;
+    for (int i = 0; i < 12; ++i) {
+        TEST_ASSERT_EQUAL_UINT32(expect, sup->slot(0).backoff_ms);
+        TEST_ASSERT_FALSE(sup->allow(A, NC, now + expect - 1));
+        now += expect;
+        TEST_ASSERT_TRUE(sup->allow(A, NC, now));
+        fail(A, NC, now);                         // Retry fails
+        expect = expect * 2 > I2C_BACKOFF_MAX_MS ? I2C_BACKOFF_MAX_MS : expect * 2;
+    }
+    TEST_ASSERT_EQUAL_UINT32(I2C_BACKOFF_MAX_MS, sup->slot(0).backoff_ms);
+}
+
+void test_successful_retry_clears_state() {
+    fail(A, NC, 0, I2C_FAIL_THRESHOLD);
+    TEST_ASSERT_TRUE(sup->allow(A, NC, I2C_BACKOFF_MIN_MS));
+    sup->report(A, NC, true, I2C_BACKOFF_MIN_MS);
+    TEST_ASSERT_FALSE(sup->needsInit(A, NC));
+    TEST_ASSERT_FALSE(sup->slot(0).suspended);
+    TEST_ASSERT_EQUAL_UINT32(0, sup->slot(0).backoff_ms);
+
+    // A fresh streak starts from the minimum again
+    fail(A, NC, 10000, I2C_FAIL_THRESHOLD);
+    TEST_ASSERT_EQUAL_UINT32(I2C_BACKOFF_MIN_MS, sup->slot(0).backoff_ms);
+}
+
+void test_devices_tracked_per_address_and_channel() {
+    fail(A, 1, 0, I2C_FAIL_THRESHOLD);
+    TEST_ASSERT_FALSE(sup->allow(A, 1, 100));
+    TEST_ASSERT_TRUE(sup->allow(A, 0, 100));   // Same address, other mux channel
+    TEST_ASSERT_TRUE(sup->allow(A, 2, 100));
+    TEST_ASSERT_TRUE(sup->allow(B, NC, 100));
+    TEST_ASSERT_EQUAL_UINT8(4, sup->slotCount());
+}
+
+void test_suspend_starts_backoff_at_next_allow() {
+    sup->suspend(B, NC);
+    TEST_ASSERT_TRUE(sup->needsInit(B, NC));
+    TEST_ASSERT_FALSE(sup->allow(B, NC, 50000));                  // Clock starts here
+    TEST_ASSERT_FALSE(sup->allow(B, NC, 50000 + I2C_BACKOFF_MIN_MS - 1));
+    TEST_ASSERT_TRUE(sup->allow(B, NC, 50000 + I2C_BACKOFF_MIN_MS));
+}
+
+void test_backoff_survives_millis_wraparound() {
+    uint32_t now = 0xFFFFFFFFu - 500;
+    fail(A, NC, now, I2C_FAIL_THRESHOLD);
+    TEST_ASSERT_FALSE(sup->allow(A, NC, now + 1000));            // Wrapped past 0
+    TEST_ASSERT_TRUE(sup->allow(A, NC, now + I2C_BACKOFF_MIN_MS));
+}
+
+void test_stuck_sda_triggers_bus_clear() {
+    fail(A, NC, 0, I2C_FAIL_THRESHOLD);       // A backing off already
+    sup->report(B, NC, true, 0);
+
+    bus->sda_low = true;
+    fail(B, NC, 100);
+    TEST_ASSERT_EQUAL_UINT32(1, bus->clears);
+    TEST_ASSERT_EQUAL_UINT32(1, sup->busClears());
+
+    // Every device gets a clean slate but must re-initialise first
+    TEST_ASSERT_TRUE(sup->allow(A, NC, 200));
+    TEST_ASSERT_TRUE(sup->needsInit(A, NC));
+    TEST_ASSERT_TRUE(sup->needsInit(B, NC));
+    TEST_ASSERT_FALSE(sup->slot(0).suspended);
+}
+
+void test_bus_clear_rate_limited() {
+    bus->sda_low     = true;
+    bus->clear_frees = false;
+    fail(A, NC, 0);
+    fail(A, NC, I2C_BUS_CLEAR_GAP_MS - 1);
+    TEST_ASSERT_EQUAL_UINT32(1, bus->clears);
+    fail(A, NC, I2C_BUS_CLEAR_GAP_MS);
+    TEST_ASSERT_EQUAL_UINT32(2, bus->clears);
+
+    // Clear didn't free the bus: the streak still backs the device off
+    TEST_ASSERT_TRUE(sup->slot(0).suspended);
+}
+
+void test_untracked_devices_never_gated() {
+    for (uint8_t i = 0; i < I2C_SUPERVISOR_SLOTS; ++i) sup->report(0x10 + i, NC, true, 0);
+    fail(0x7E, NC, 0, I2C_FAIL_THRESHOLD + 2);
+    TEST_ASSERT_TRUE(sup->allow(0x7E, NC, 0));
+    TEST_ASSERT_EQUAL_UINT8(I2C_SUPERVISOR_SLOTS, sup->slotCount());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_isolated_failures_do_not_back_off);
+    RUN_TEST(test_streak_triggers_backoff);
+    RUN_TEST(test_backoff_doubles_up_to_cap);
+    RUN_TEST(test_successful_retry_clears_state);
+    RUN_TEST(test_devices_tracked_per_address_and_channel);
+    RUN_TEST(test_suspend_starts_backoff_at_next_allow);
+    RUN_TEST(test_backoff_survives_millis_wraparound);
+    RUN_TEST(test_stuck_sda_triggers_bus_clear);
+    RUN_TEST(test_bus_clear_rate_limited);
+    RUN_TEST(test_untracked_devices_never_gated);
+    return UNITY_END();
+}
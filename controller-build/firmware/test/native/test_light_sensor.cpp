@@ -0,0 +1,384 @@
+/**
+ * test_light_sensor.cpp — Unit tests for the split-phase AS7341 driver.
+ *
+ * Runs LightSensor against a fake I2C bus carrying a register-level AS7341
+ * model. The fake models 100 kHz transfer time, applies SMUX tables after a
+ * short delay, integrates for (ATIME+1)(ASTEP+1)·2.78 µs and only raises
+ * STATUS2.AVALID once that time has passed. Counts scale with the light level
+ * of whichever channel the executed SMUX table routes to each ADC, with gain
+ * and ASTEP, and clip (with ASAT) at full scale.
+ */
+
+#include <unity.h>
+#include "../../src/sensors/light_sensor.h"
+#include "../../src/sensors/i2c_stats.h"
+#include "../../include/config.h"
+#include <cstring>
+
+// ── Fake bus ──────────────────────────────────────────────────────────────────
+
+class FakeAs7341Bus : public I2cBus {
+public:
+    static constexpr uint32_t BYTE_US = 90;  // 9 clocks at 100 kHz
+
+    bool     present  = true;
+    uint8_t  regs[256] = {};
+    uint32_t light[10] = {};      // Counts per slot at 1× gain, ASTEP 999
+    uint32_t smux_us   = 200;     // SMUXEN self-clear delay
+    uint64_t now_us    = 0;
+    uint64_t slept_us  = 0;
+    uint32_t integrations = 0;
+    uint32_t smux_loads   = 0;
+
+    bool write(uint8_t addr, const uint8_t* data, size_t len) override {
+        now_us += (1 + len) * BYTE_US;
+        if (addr != I2C_ADDR_AS7341 || !present || len == 0) return false;
+        _ptr = data[0];
+        for (size_t i = 1; i < len; ++i) _store(static_cast<uint8_t>(_ptr++), data[i]);
+        return true;
+    }
+
+    bool read(uint8_t addr, uint8_t* out, size_t len) override {
+        now_us += (1 + len) * BYTE_US;
+        if (addr != I2C_ADDR_AS7341 || !present) return false;
+        if (_ptr == AS7341_REG_ASTATUS) _latch();
+        for (size_t i = 0; i < len; ++i) out[i] = _load(static_cast<uint8_t>(_ptr++));
+        return true;
+    }
+
+    void sleepUs(uint32_t us) override { now_us += us; slept_us += us; }
+
+    /** applied() — SMUX table currently routed to the ADCs (nullptr = unknown). */
+    const As7341Pass* applied() const { return _applied; }
+
+private:
+    uint8_t           _ptr      = 0;
+    uint8_t           _ram[20]  = {};
+    bool              _smux_cmd = false;
+    uint64_t          _smux_done_us = 0;
+    uint64_t          _int_done_us  = 0;
+    bool              _integrating  = false;
+    uint8_t           _int_gain     = 0;
+    uint16_t          _int_astep    = 0;
+    const As7341Pass* _applied  = nullptr;
+    const As7341Pass* _pending  = nullptr;
+
+    uint16_t _astep() const { return static_cast<uint16_t>(regs[AS7341_REG_ASTEP_L] | (regs[AS7341_REG_ASTEP_L + 1] << 8)); }
+
+    void _store(uint8_t reg, uint8_t v) {
+        if (reg < sizeof(_ram)) { _ram[reg] = v; return; }
+        regs[reg] = v;
+        if (reg == AS7341_REG_CFG6) _smux_cmd = (v & AS7341_CFG6_SMUX_WRITE) != 0;
+        if (reg != AS7341_REG_ENABLE) return;
+
+        if ((v & AS7341_ENABLE_SMUXEN) && _smux_cmd) {
+            _pending = nullptr;
+            for (const As7341Pass* p : { &AS7341_PASS_F1F4, &AS7341_PASS_F5F8, &AS7341_PASS_REDUCED }) {
+                if (memcmp(_ram, p->smux, sizeof(_ram)) == 0) _pending = p;
+            }
+            _smux_done_us = now_us + smux_us;
+            _smux_cmd     = false;
+            smux_loads++;
+        }
+        if (v & AS7341_ENABLE_SP_EN) {
+            _integrating = true;
+            _int_gain    = regs[AS7341_REG_CFG1];
+            _int_astep   = _astep();
+            _int_done_us = now_us + as7341IntegrationUs(regs[AS7341_REG_ATIME], _int_astep);
+            regs[AS7341_REG_STATUS2] = 0;
+            integrations++;
+        } else {
+            _integrating = false;
+        }
+    }
+
+    uint8_t _load(uint8_t reg) {
+        if (reg == AS7341_REG_ID) return present ? 0x24 : 0x00;
+        if (reg == AS7341_REG_ENABLE) {
+            if ((regs[reg] & AS7341_ENABLE_SMUXEN) && now_us >= _smux_done_us) {
+                regs[reg] &= static_cast<uint8_t>(~AS7341_ENABLE_SMUXEN);
+                _applied = _pending;
+            }
+            return regs[reg];
+        }
+        if (reg == AS7341_REG_STATUS2 && _integrating && now_us >= _int_done_us) {
+            regs[reg] |= AS7341_STATUS2_AVALID;
+        }
+        return regs[reg];
+    }
+
+    void _latch() {
+        uint16_t fs   = as7341FullScale(regs[AS7341_REG_ATIME], _int_astep);
+        bool     sat  = false;
+        for (uint8_t adc = 0; adc < 6; ++adc) {
+            double c = 0;
+            if (_applied) {
+                c = light[_applied->slot[adc]] * as7341GainFactor(_int_gain) * (_int_astep + 1) / 1000.0;
+            }
+            uint16_t v = c >= fs ? fs : static_cast<uint16_t>(c);
+            if (c >= fs) sat = true;
+            regs[AS7341_REG_CH0_L + 2 * adc]     = v & 0xFF;
+            regs[AS7341_REG_CH0_L + 2 * adc + 1] = v >> 8;
+        }
+        regs[AS7341_REG_ASTATUS] = sat ? AS7341_ASTATUS_ASAT : 0;
+    }
+};
+
+static FakeAs7341Bus* bus;
+static I2cSupervisor* sup;
+static LightSensor*   light;
+
+static constexpr uint64_t POLL_US = 1000000;  // Sensor task poll spacing in these tests
+
+/** poll() — Advance the fake clock by one poll period, then service the driver. */
+static bool poll() {
+    bus->now_us += POLL_US;
+    return light->service(static_cast<uint32_t>(bus->now_us / 1000));
+}
+
+void setUp() {
+    I2cCounters.reset();
+    bus = new FakeAs7341Bus();
+    for (uint8_t i = 0; i < 10; ++i) bus->light[i] = 40 + i;  // ~15–20 % of FS at 256×
+    sup   = new I2cSupervisor(*bus);
+    light = new LightSensor(*bus, *sup);
+    TEST_ASSERT_TRUE(light->begin());
+}
+
+void tearDown() {
+    delete light;
+    delete sup;
+    delete bus;
+}
+
+// ── Tests ─────────────────────────────────────────────────────────────────────
+
+void test_begin_configures_timing() {
+    TEST_ASSERT_EQUAL_UINT8(AS7341_ATIME, bus->regs[AS7341_REG_ATIME]);
+    TEST_ASSERT_EQUAL_UINT8(AS7341_GAIN_256X, bus->regs[AS7341_REG_CFG1]);
+    TEST_ASSERT_EQUAL_UINT8(AS7341_ASTEP_MAX & 0xFF, bus->regs[AS7341_REG_ASTEP_L]);
+    TEST_ASSERT_EQUAL_UINT8(AS7341_ASTEP_MAX >> 8, bus->regs[AS7341_REG_ASTEP_L + 1]);
+    TEST_ASSERT_FALSE(light->reading().valid);
+}
+
+void test_begin_fails_without_sensor() {
+    bus->present = false;
+    I2cSupervisor absent_sup(*bus);
+    LightSensor   absent(*bus, absent_sup);
+    TEST_ASSERT_FALSE(absent.begin());
+    TEST_ASSERT_FALSE(absent.service(0));
+    TEST_ASSERT_EQUAL_UINT32(0, bus->integrations);
+}
+
+void test_full_mode_takes_two_passes() {
+    TEST_ASSERT_FALSE(poll());                 // Starts pass A (F1–F4)
+    TEST_ASSERT_EQUAL_PTR(&AS7341_PASS_F1F4, bus->applied());
+    TEST_ASSERT_FALSE(poll());                 // Collects A, starts B (F5–F8)
+    TEST_ASSERT_EQUAL_PTR(&AS7341_PASS_F5F8, bus->applied());
+    TEST_ASSERT_TRUE(poll());                  // Collects B — complete
+
+    const LightReading& r = light->reading();
+    TEST_ASSERT_TRUE(r.valid);
+    TEST_ASSERT_EQUAL_HEX16(0x03FF, r.channel_mask);   // F1–F8, Clear, NIR
+    for (uint8_t i = 0; i < 10; ++i) {
+        // 256× gain, ASTEP 999 → light × 256
+        TEST_ASSERT_EQUAL_UINT32(bus->light[i] * 256, r.channels[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT8(AS7341_GAIN_256X, r.again);
+    TEST_ASSERT_EQUAL_UINT32(as7341IntegrationUs(AS7341_ATIME, AS7341_ASTEP_MAX), r.tint_us);
+    TEST_ASSERT_EQUAL_UINT32(3, bus->integrations);   // Next cycle's pass A already running
+}
+
+void test_reduced_mode_reads_in_one_pass() {
+    light->setMode(LightMode::REDUCED);
+    TEST_ASSERT_FALSE(poll());
+    TEST_ASSERT_EQUAL_PTR(&AS7341_PASS_REDUCED, bus->applied());
+    TEST_ASSERT_TRUE(poll());
+
+    const LightReading& r = light->reading();
+    TEST_ASSERT_TRUE(r.valid);
+    uint16_t expect = (1u << 1) | (1u << 3) | (1u << 6) | (1u << 7) |
+                      (1u << AS7341_SLOT_CLEAR) | (1u << AS7341_SLOT_NIR);
+    TEST_ASSERT_EQUAL_HEX16(expect, r.channel_mask);
+    TEST_ASSERT_EQUAL_UINT32(bus->light[6] * 256, r.channels[6]);
+    TEST_ASSERT_EQUAL_UINT16(0, r.channels[0]);        // F1 not measured
+
+    // Every poll after the first yields a reading
+    TEST_ASSERT_TRUE(poll());
+    TEST_ASSERT_TRUE(poll());
+    TEST_ASSERT_EQUAL_UINT32(4, bus->integrations);
+}
+
+void test_mode_change_waits_for_cycle_boundary() {
+    TEST_ASSERT_FALSE(poll());                 // FULL pass A in flight
+    light->setMode(LightMode::REDUCED);
+    TEST_ASSERT_FALSE(poll());                 // Still FULL: pass B
+    TEST_ASSERT_EQUAL_PTR(&AS7341_PASS_F5F8, bus->applied());
+    TEST_ASSERT_TRUE(poll());                  // FULL completes, REDUCED starts
+    TEST_ASSERT_EQUAL_HEX16(0x03FF, light->reading().channel_mask);
+    TEST_ASSERT_EQUAL_PTR(&AS7341_PASS_REDUCED, bus->applied());
+}
+
+void test_service_never_waits_for_integration() {
+    for (int i = 0; i < 6; ++i) {
+        uint64_t t0 = bus->now_us + POLL_US;
+        poll();
+        // Bus transfers only — the ~281 ms integration happens between polls
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(10000, static_cast<uint32_t>(bus->now_us - t0));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, static_cast<uint32_t>(bus->slept_us));
+}
+
+void test_no_collect_before_avalid() {
+    TEST_ASSERT_FALSE(poll());                 // Starts integration
+    uint32_t tx = I2cCounters.transactions(I2cDevice::AS7341);
+
+    // Polled again well inside the integration window
+    bus->now_us += 50000;
+    TEST_ASSERT_FALSE(light->service(static_cast<uint32_t>(bus->now_us / 1000)));
+    TEST_ASSERT_EQUAL_UINT32(tx + 2, I2cCounters.transactions(I2cDevice::AS7341));  // STATUS2 only
+    TEST_ASSERT_EQUAL_UINT32(1, bus->integrations);
+    TEST_ASSERT_EQUAL_PTR(&AS7341_PASS_F1F4, bus->applied());
+
+    TEST_ASSERT_FALSE(poll());                 // Now collects A and starts B
+    TEST_ASSERT_TRUE(poll());
+}
+
+void test_slow_smux_finishes_next_poll() {
+    bus->smux_us = 20000;                      // Longer than the in-call polls
+    light->setMode(LightMode::REDUCED);
+    TEST_ASSERT_FALSE(poll());
+    TEST_ASSERT_EQUAL_UINT32(0, bus->integrations);  // Left in SMUX phase
+    TEST_ASSERT_FALSE(poll());                 // SMUX done → integration starts
+    TEST_ASSERT_EQUAL_UINT32(1, bus->integrations);
+    TEST_ASSERT_TRUE(poll());
+}
+
+void test_saturated_reading_dropped_and_gain_reduced() {
+    light->setMode(LightMode::REDUCED);
+    for (auto& l : bus->light) l = 2000;       // 512 000 counts at 256× — clips
+    TEST_ASSERT_FALSE(poll());
+    TEST_ASSERT_FALSE(poll());                 // Saturated — not published
+    TEST_ASSERT_FALSE(light->reading().valid);
+    TEST_ASSERT_EQUAL_UINT8(AS7341_GAIN_256X - 2, light->gain());
+    TEST_ASSERT_EQUAL_UINT8(AS7341_GAIN_256X - 2, bus->regs[AS7341_REG_CFG1]);
+}
+
+void test_autogain_converges_under_grow_lights() {
+    light->setMode(LightMode::REDUCED);
+    for (auto& l : bus->light) l = 2000;
+    poll();
+    bool published = false;
+    for (int i = 0; i < 10 && !published; ++i) published = poll();
+    TEST_ASSERT_TRUE(published);
+
+    const LightReading& r = light->reading();
+    uint32_t fs = as7341FullScale(AS7341_ATIME, light->astep());
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(fs * AS7341_AGC_HIGH_PCT / 100, r.channels[AS7341_SLOT_CLEAR]);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(fs * AS7341_AGC_LOW_PCT / 100, r.channels[AS7341_SLOT_CLEAR]);
+    TEST_ASSERT_EQUAL_UINT32(2000u * (1u << (r.again - 1)), r.channels[AS7341_SLOT_CLEAR]);
+
+    // Settled: another cycle leaves gain alone
+    uint8_t g = light->gain();
+    TEST_ASSERT_TRUE(poll());
+    TEST_ASSERT_EQUAL_UINT8(g, light->gain());
+}
+
+void test_autogain_shortens_integration_at_min_gain() {
+    light->setMode(LightMode::REDUCED);
+    for (auto& l : bus->light) l = 150000;     // Clips even at 0.5×
+    poll();
+    for (int i = 0; i < 12; ++i) poll();
+    TEST_ASSERT_EQUAL_UINT8(AS7341_GAIN_MIN, light->gain());
+    TEST_ASSERT_LESS_THAN_UINT32(AS7341_ASTEP_MAX, light->astep());
+    TEST_ASSERT_TRUE(light->reading().valid);
+    TEST_ASSERT_EQUAL_UINT32(as7341IntegrationUs(AS7341_ATIME, light->astep()), light->reading().tint_us);
+}
+
+void test_autogain_raises_gain_in_dim_light() {
+    light->setMode(LightMode::REDUCED);
+    for (auto& l : bus->light) l = 2000;       // Drive gain down first
+    poll();
+    for (int i = 0; i < 8; ++i) poll();
+    uint8_t bright_gain = light->gain();
+
+    for (auto& l : bus->light) l = 20;         // Lights off
+    for (int i = 0; i < 8; ++i) poll();
+    TEST_ASSERT_GREATER_THAN_UINT32(bright_gain, light->gain());
+    TEST_ASSERT_EQUAL_UINT8(AS7341_GAIN_MAX, light->gain());
+}
+
+void test_bus_error_restarts_measurement() {
+    TEST_ASSERT_FALSE(poll());
+    bus->present = false;
+    TEST_ASSERT_FALSE(poll());
+    TEST_ASSERT_GREATER_THAN_UINT32(0, I2cCounters.errors(I2cDevice::AS7341));
+
+    bus->present = true;
+    TEST_ASSERT_FALSE(poll());                 // Pass A again from scratch
+    TEST_ASSERT_EQUAL_PTR(&AS7341_PASS_F1F4, bus->applied());
+    TEST_ASSERT_FALSE(poll());
+    TEST_ASSERT_TRUE(poll());
+    TEST_ASSERT_EQUAL_HEX16(0x03FF, light->reading().channel_mask);
+}
+
+void test_persistent_fault_backs_off() {
+    poll();
+    bus->present = false;
+    for (int i = 0; i < I2C_FAIL_THRESHOLD; ++i) poll();
+
+    // Backing off: polls cost no bus transactions
+    uint32_t tx = I2cCounters.transactions(I2cDevice::AS7341);
+    TEST_ASSERT_FALSE(poll());
+    TEST_ASSERT_EQUAL_UINT32(tx, I2cCounters.transactions(I2cDevice::AS7341));
+
+    // Sensor back (e.g. power-cycled): retry reconfigures, then measures
+    bus->present = true;
+    memset(bus->regs, 0, sizeof(bus->regs));
+    bus->now_us += uint64_t(I2C_BACKOFF_MIN_MS) * 1000;
+    poll();
+    TEST_ASSERT_EQUAL_UINT8(AS7341_ATIME, bus->regs[AS7341_REG_ATIME]);
+    TEST_ASSERT_EQUAL_UINT8(light->gain(), bus->regs[AS7341_REG_CFG1]);
+    TEST_ASSERT_FALSE(poll());
+    TEST_ASSERT_TRUE(poll());
+}
+
+void test_absent_at_begin_retried_after_backoff() {
+    bus->present = false;
+    I2cSupervisor late_sup(*bus);
+    LightSensor   late(*bus, late_sup);
+    TEST_ASSERT_FALSE(late.begin());
+
+    bus->present = true;
+    uint32_t t = static_cast<uint32_t>(bus->now_us / 1000);
+    TEST_ASSERT_FALSE(late.service(t));                      // Backoff starts here
+    TEST_ASSERT_FALSE(late.service(t + I2C_BACKOFF_MIN_MS - 1));
+    TEST_ASSERT_EQUAL_UINT32(0, bus->integrations);
+
+    bus->now_us = uint64_t(t + I2C_BACKOFF_MIN_MS) * 1000;
+    late.setMode(LightMode::REDUCED);
+    TEST_ASSERT_FALSE(late.service(t + I2C_BACKOFF_MIN_MS)); // Configures, starts a pass
+    TEST_ASSERT_EQUAL_UINT32(1, bus->integrations);
+    bus->now_us += POLL_US;
+    TEST_ASSERT_TRUE(late.service(static_cast<uint32_t>(bus->now_us / 1000)));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_begin_configures_timing);
+    RUN_TEST(test_begin_fails_without_sensor);
+    RUN_TEST(test_full_mode_takes_two_passes);
+    RUN_TEST(test_reduced_mode_reads_in_one_pass);
+    RUN_TEST(test_mode_change_waits_for_cycle_boundary);
+    RUN_TEST(test_service_never_waits_for_integration);
+    RUN_TEST(test_no_collect_before_avalid);
+    RUN_TEST(test_slow_smux_finishes_next_poll);
+    RUN_TEST(test_saturated_reading_dropped_and_gain_reduced);
+    RUN_TEST(test_autogain_converges_under_grow_lights);
+    RUN_TEST(test_autogain_shortens_integration_at_min_gain);
+    RUN_TEST(test_autogain_raises_gain_in_dim_light);
+    RUN_TEST(test_bus_error_restarts_measurement);
+    RUN_TEST(test_persistent_fault_backs_off);
+    RUN_TEST(test_absent_at_begin_retried_after_backoff);
+    return UNITY_END();
+}
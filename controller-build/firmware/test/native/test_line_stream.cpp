@@ -0,0 +1,116 @@
+/**
+ * test_line_stream.cpp — Unit tests for LineStream (line carry-over between
+ * size-capped chunks).
+ */
+
+#include <unity.h>
+#include "../../src/util/line_stream.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+void setUp()    {}
+void tearDown() {}
+
+/** Produces "line 0\n" .. "line <count-1>\n", with an empty line after each even one. */
+struct Lines {
+    int  count;
+    int  i     = 0;
+    bool blank = false;
+    int  calls = 0;
+
+    bool operator()(char* line, size_t size, size_t& len) {
+        calls++;
+        if (blank) {
+            blank = false;
+            len   = 0;
+            return true;
+        }
+        if (i >= count) return false;
+        int n = snprintf(line, size, "line %d\n", i);
+        len   = static_cast<size_t>(n) < size ? n : size - 1;
+        blank = i % 2 == 0;
+        i++;
+        return true;
+    }
+};
+
+template<size_t N>
+static std::string drain(LineStream<N>& s, Lines& lines, size_t chunk) {
+    std::string out;
+    std::vector<char> buf(chunk);
+    for (size_t n; (n = s.read(buf.data(), buf.size(), lines)) > 0;) {
+        TEST_ASSERT_TRUE(n <= chunk);
+        out.append(buf.data(), n);
+    }
+    return out;
+}
+
+void test_lines_copied_in_order() {
+    LineStream<32> s;
+    Lines lines{3};
+    TEST_ASSERT_EQUAL_STRING("line 0\nline 1\nline 2\n", drain(s, lines, 256).c_str());
+}
+
+void test_output_independent_of_chunk_size() {
+    for (size_t chunk : {1u, 2u, 5u, 7u, 64u}) {
+        LineStream<32> s;
+        Lines lines{12};
+        std::string expected;
+        for (int i = 0; i < 12; ++i) expected += "line " + std::to_string(i) + "\n";
+        TEST_ASSERT_EQUAL_STRING(expected.c_str(), drain(s, lines, chunk).c_str());
+    }
+}
+
+void test_pending_line_finished_before_next_is_formatted() {
+    LineStream<32> s;
+    Lines lines{2};
+    char buf[4];
+    TEST_ASSERT_EQUAL(4u, s.read(buf, sizeof(buf), lines));   // "line" of "line 0\n"
+    TEST_ASSERT_EQUAL(1, lines.calls);
+    TEST_ASSERT_EQUAL(3u, s.read(buf, 3, lines));             // " 0\n" from the carry-over
+    TEST_ASSERT_EQUAL(1, lines.calls);
+    TEST_ASSERT_EQUAL(0, memcmp(buf, " 0\n", 3));
+}
+
+void test_overlong_length_clamped_to_buffer() {
+    LineStream<8> s;
+    bool more = true;
+    auto next = [&](char* line, size_t size, size_t& len) {
+        if (!more) return false;
+        memset(line, 'x', size);
+        len  = size + 100;   // Producer miscounted
+        more = false;
+        return true;
+    };
+    char buf[64];
+    TEST_ASSERT_EQUAL(8u, s.read(buf, sizeof(buf), next));
+}
+
+void test_zero_cap_writes_nothing() {
+    LineStream<32> s;
+    Lines lines{1};
+    char buf[1];
+    TEST_ASSERT_EQUAL(0u, s.read(buf, 0, lines));
+    TEST_ASSERT_EQUAL(0, lines.calls);
+}
+
+void test_stays_finished() {
+    LineStream<32> s;
+    Lines lines{1};
+    drain(s, lines, 64);
+    char buf[16];
+    TEST_ASSERT_EQUAL(0u, s.read(buf, sizeof(buf), lines));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_lines_copied_in_order);
+    RUN_TEST(test_output_independent_of_chunk_size);
+    RUN_TEST(test_pending_line_finished_before_next_is_formatted);
+    RUN_TEST(test_overlong_length_clamped_to_buffer);
+    RUN_TEST(test_zero_cap_writes_nothing);
+    RUN_TEST(test_stays_finished);
+    return UNITY_END();
+}
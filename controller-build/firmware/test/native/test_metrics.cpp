@@ -0,0 +1,107 @@
+/**
+ * test_metrics.cpp — Unit tests for the Prometheus exposition formatter
+ * (PromLine) and the chunked family stream (MetricsStream).
+ */
+
+#include <unity.h>
+#include "../../src/web/metrics.h"
+
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+void setUp()    {}
+void tearDown() {}
+
+static std::string line(void (*fill)(PromLine&), const char* name = "m") {
+    char     buf[METRICS_LINE_MAX];
+    PromLine out(buf, sizeof(buf), name);
+    fill(out);
+    return std::string(buf, out.len());
+}
+
+// ── PromLine ──────────────────────────────────────────────────────────────────
+
+void test_unlabelled_integer_sample() {
+    TEST_ASSERT_EQUAL_STRING("m 42\n", line([](PromLine& o) { o.put(static_cast<uint32_t>(42)); }).c_str());
+    TEST_ASSERT_EQUAL_STRING("m 18446744073709551615\n",
+                             line([](PromLine& o) { o.put(UINT64_MAX); }).c_str());
+    TEST_ASSERT_EQUAL_STRING("m 1\n", line([](PromLine& o) { o.put(true); }).c_str());
+}
+
+void test_labelled_float_sample() {
+    TEST_ASSERT_EQUAL_STRING("rh{shelf=\"2\"} 88.125\n",
+                             line([](PromLine& o) { o.put(88.125, "shelf", "2"); }, "rh").c_str());
+    TEST_ASSERT_EQUAL_STRING("m -3.25\n", line([](PromLine& o) { o.put(-3.25); }).c_str());
+}
+
+void test_non_finite_values_use_prometheus_spelling() {
+    TEST_ASSERT_EQUAL_STRING("m NaN\n", line([](PromLine& o) { o.put(static_cast<double>(NAN)); }).c_str());
+    TEST_ASSERT_EQUAL_STRING("m +Inf\n", line([](PromLine& o) { o.put(static_cast<double>(INFINITY)); }).c_str());
+}
+
+void test_line_truncates_instead_of_overflowing() {
+    char     buf[8] = {};
+    PromLine out(buf, sizeof(buf), "a_long_metric_name");
+    out.put(static_cast<uint32_t>(1));
+    TEST_ASSERT_EQUAL(7u, out.len());
+    TEST_ASSERT_EQUAL('\0', buf[7]);
+}
+
+// ── MetricsStream ─────────────────────────────────────────────────────────────
+
+static const char* const CH[] = {"a", "b", "c"};
+
+static const MetricFamily TABLE[] = {
+    {"t_up", "gauge", "Always one",
+     [](PromLine& out, uint8_t i) { if (i) return false; out.put(true); return true; }},
+    {"t_on_total", "counter", "Per channel",
+     [](PromLine& out, uint8_t i) {
+         if (i >= 3) return false;
+         if (i != 1) out.put(static_cast<uint32_t>(i * 10), "ch", CH[i]);   // "b" unavailable
+         return true;
+     }},
+    {"t_empty", "gauge", "No samples",
+     [](PromLine&, uint8_t) { return false; }},
+};
+
+static const char* const EXPECTED =
+    "# HELP t_up Always one\n# TYPE t_up gauge\n"
+    "t_up 1\n"
+    "# HELP t_on_total Per channel\n# TYPE t_on_total counter\n"
+    "t_on_total{ch=\"a\"} 0\n"
+    "t_on_total{ch=\"c\"} 20\n"
+    "# HELP t_empty No samples\n# TYPE t_empty gauge\n";
+
+static std::string drain(MetricsStream& s, size_t chunk) {
+    std::string out;
+    std::vector<char> buf(chunk);
+    for (size_t n; (n = s.read(buf.data(), buf.size())) > 0;) out.append(buf.data(), n);
+    return out;
+}
+
+void test_stream_writes_headers_and_samples() {
+    MetricsStream s(TABLE, 3);
+    TEST_ASSERT_EQUAL_STRING(EXPECTED, drain(s, 1024).c_str());
+    char buf[16];
+    TEST_ASSERT_EQUAL(0u, s.read(buf, sizeof(buf)));   // Stays finished
+}
+
+void test_stream_output_independent_of_chunk_size() {
+    for (size_t chunk : {1u, 3u, 17u, 64u}) {
+        MetricsStream s(TABLE, 3);
+        TEST_ASSERT_EQUAL_STRING(EXPECTED, drain(s, chunk).c_str());
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_unlabelled_integer_sample);
+    RUN_TEST(test_labelled_float_sample);
+    RUN_TEST(test_non_finite_values_use_prometheus_spelling);
+    RUN_TEST(test_line_truncates_instead_of_overflowing);
+    RUN_TEST(test_stream_writes_headers_and_samples);
+    RUN_TEST(test_stream_output_independent_of_chunk_size);
+    return UNITY_END();
+}
@@ -0,0 +1,335 @@
+/**
+ * test_mqtt_bridge.cpp — Unit tests for the MQTT bridge against a fake
+ * broker: Home Assistant discovery, retained state/relay topics, one flush
+ * per frame, the bounded offline ring and its in-order replay, and
+ * reconnect backoff.
+ */
+
+#include <unity.h>
+#include "../../src/mqtt/mqtt_bridge.h"
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * FakeBroker — Stand-in for a local mosquitto: keeps retained messages,
+ * logs every delivered publish with the flush that carried it, and can be
+ * taken down and brought back.
+ */
+class FakeBroker : public MqttPort {
+public:
+    struct Msg {
+        std::string topic;
+        std::string payload;
+        bool        retain;
+        uint32_t    flush;
+    };
+
+    bool up       = true;
+    bool session  = false;
+    int  connects = 0;
+    int  attempts = 0;
+    std::string will_topic, will_msg;
+    std::vector<Msg> log;
+    std::map<std::string, std::string> retained;
+
+    bool connect(const char*, const char* wt, const char* wm) override {
+        attempts++;
+        if (!up) return false;
+        session    = true;
+        will_topic = wt;
+        will_msg   = wm;
+        connects++;
+        return true;
+    }
+    bool connected() override { return session; }
+    bool publish(const char* topic, const char* payload, bool retain) override {
+        if (!session) return false;
+        _batch.push_back({topic, payload, retain, 0});
+        return true;
+    }
+    bool flush() override {
+        if (!session) {
+            _batch.clear();
+            return false;
+        }
+        _flushes++;
+        for (auto& m : _batch) {
+            m.flush = _flushes;
+            if (m.retain) retained[m.topic] = m.payload;
+            log.push_back(m);
+        }
+        _batch.clear();
+        return true;
+    }
+    void poll() override {}
+
+    /** drop() — Broker goes away: the will fires and the session ends. */
+    void drop() {
+        up      = false;
+        session = false;
+        retained[will_topic] = will_msg;
+    }
+
+    std::vector<Msg> on(const std::string& topic) const {
+        std::vector<Msg> out;
+        for (const auto& m : log) if (m.topic == topic) out.push_back(m);
+        return out;
+    }
+
+    uint32_t flushes() const { return _flushes; }
+
+private:
+    std::vector<Msg> _batch;
+    uint32_t         _flushes = 0;
+};
+
+static FakeBroker*     broker;
+static MqttBridgeCore* mqtt;
+
+void setUp() {
+    broker = new FakeBroker();
+    mqtt   = new MqttBridgeCore(*broker);
+    mqtt->setNode("martha-abc123");
+}
+
+void tearDown() {
+    delete mqtt;
+    delete broker;
+}
+
+static PublishFrame frameAt(uint32_t gen, uint32_t ts_ms, float co2 = 800.0f, uint8_t relays = 0) {
+    PublishFrame f = {};
+    f.gen   = gen;
+    f.ts_ms = ts_ms;
+    f.snap.co2.co2_ppm = co2;
+    f.snap.co2.valid   = true;
+    f.snap.rh_aggregate_pct = 88.5f;
+    for (auto& r : f.snap.rh) {
+        r.rh_pct = 88.5f;
+        r.temp_c = 21.25f;
+        r.valid  = true;
+    }
+    f.snap.water_level_pct   = 60.0f;
+    f.snap.water_level_valid = true;
+    f.relay_mask = relays;
+    f.armed      = true;
+    return f;
+}
+
+static const char* STATE  = "martha/martha-abc123/state";
+static const char* RELAYS = "martha/martha-abc123/relays";
+static const char* REPLAY = "martha/martha-abc123/replay";
+static const char* STATUS = "martha/martha-abc123/status";
+
+/** tOf(payload) — The "t" field of a state/replay payload. */
+static long tOf(const std::string& payload) {
+    long t = -1;
+    sscanf(payload.c_str(), "{\"t\":%ld", &t);
+    return t;
+}
+
+// ── Discovery ─────────────────────────────────────────────────────────────────
+
+void test_connect_publishes_discovery_and_online() {
+    mqtt->service(0);
+    TEST_ASSERT_TRUE(mqtt->online());
+    TEST_ASSERT_EQUAL_STRING("offline", broker->will_msg.c_str());
+    TEST_ASSERT_EQUAL_STRING(STATUS, broker->will_topic.c_str());
+    TEST_ASSERT_EQUAL_STRING("online", broker->retained[STATUS].c_str());
+
+    size_t configs = 0;
+    for (const auto& kv : broker->retained) {
+        if (kv.first.rfind("homeassistant/", 0) == 0) configs++;
+    }
+    TEST_ASSERT_EQUAL(MQTT_ENTITY_COUNT, configs);
+
+    const std::string& co2 = broker->retained["homeassistant/sensor/martha-abc123/co2/config"];
+    TEST_ASSERT_TRUE(co2.find("\"uniq_id\":\"martha-abc123_co2\"") != std::string::npos);
+    TEST_ASSERT_TRUE(co2.find("\"~\":\"martha/martha-abc123\"") != std::string::npos);
+    TEST_ASSERT_TRUE(co2.find("\"stat_t\":\"~/state\"") != std::string::npos);
+    TEST_ASSERT_TRUE(co2.find("{{value_json.co2}}") != std::string::npos);
+    TEST_ASSERT_TRUE(co2.find("\"dev_cla\":\"carbon_dioxide\"") != std::string::npos);
+    TEST_ASSERT_EQUAL('}', co2.back());
+
+    const std::string& fan = broker->retained["homeassistant/binary_sensor/martha-abc123/tubfan/config"];
+    TEST_ASSERT_TRUE(fan.find("\"stat_t\":\"~/relays\"") != std::string::npos);
+    TEST_ASSERT_TRUE(fan.find("{{value_json.tubfan}}") != std::string::npos);
+
+    // Every config fits the payload buffer and goes out in a single flush
+    for (const auto& m : broker->log) TEST_ASSERT_TRUE(m.payload.size() < MQTT_PAYLOAD_MAX - 1);
+    TEST_ASSERT_EQUAL(1, broker->flushes());
+}
+
+// ── State and relays ──────────────────────────────────────────────────────────
+
+void test_state_once_per_generation_and_period() {
+    mqtt->service(0);
+    uint32_t base = broker->flushes();
+
+    mqtt->handle(frameAt(1, 1000));
+    TEST_ASSERT_EQUAL(1u, broker->on(STATE).size());
+    TEST_ASSERT_EQUAL(1u, broker->on(RELAYS).size());
+    TEST_ASSERT_EQUAL(base + 1, broker->flushes());   // State and relays in one flush
+
+    mqtt->handle(frameAt(1, 1200));                        // Same generation
+    mqtt->handle(frameAt(2, 1000 + MQTT_STATE_PERIOD_MS - 1));   // Too soon
+    TEST_ASSERT_EQUAL(1u, broker->on(STATE).size());
+
+    mqtt->handle(frameAt(3, 1000 + MQTT_STATE_PERIOD_MS, 950.0f));
+    TEST_ASSERT_EQUAL(2u, broker->on(STATE).size());
+    TEST_ASSERT_EQUAL(1u, broker->on(RELAYS).size());     // Unchanged relays not re-sent
+    TEST_ASSERT_EQUAL(base + 2, broker->flushes());
+
+    const std::string& s = broker->retained[STATE];
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"t\":11,\"co2\":950,\"rh\":88.50,\"rh1\":88.50,\"rh2\":88.50,\"rh3\":88.50,"
+        "\"t1\":21.25,\"t2\":21.25,\"t3\":21.25,\"tp1\":null,\"tp2\":null,\"tp3\":null,"
+        "\"tp4\":null,\"tp5\":null,\"wl\":60.00}",
+        s.c_str());
+}
+
+void test_relay_change_published_immediately() {
+    mqtt->service(0);
+    mqtt->handle(frameAt(1, 1000));
+    uint32_t base = broker->flushes();
+
+    mqtt->handle(frameAt(1, 1500, 800.0f, 0x03));   // Fogger + tub fan on, same generation
+    TEST_ASSERT_EQUAL(base + 1, broker->flushes());
+    TEST_ASSERT_EQUAL(2u, broker->on(RELAYS).size());
+    TEST_ASSERT_EQUAL(1u, broker->on(STATE).size());
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"fogger\":1,\"tubfan\":1,\"exhaust\":0,\"intake\":0,\"uvc\":0,\"lights\":0,"
+        "\"pump\":0,\"spare\":0,\"armed\":1,\"manual\":0}",
+        broker->retained[RELAYS].c_str());
+}
+
+// ── Offline ring ──────────────────────────────────────────────────────────────
+
+void test_offline_samples_replayed_in_order() {
+    mqtt->service(0);
+    mqtt->handle(frameAt(1, 0));
+    broker->drop();
+    TEST_ASSERT_EQUAL_STRING("offline", broker->retained[STATUS].c_str());
+
+    const uint32_t n = 25;
+    for (uint32_t i = 1; i <= n; ++i) mqtt->handle(frameAt(1 + i, i * MQTT_STATE_PERIOD_MS));
+    TEST_ASSERT_FALSE(mqtt->online());
+    TEST_ASSERT_EQUAL(n, mqtt->queued());
+
+    broker->up = true;
+    uint32_t now = n * MQTT_STATE_PERIOD_MS;
+    mqtt->service(now);
+    TEST_ASSERT_TRUE(mqtt->online());
+    TEST_ASSERT_EQUAL_STRING("online", broker->retained[STATUS].c_str());
+    // Latest state is retained straight away, before the backlog drains
+    TEST_ASSERT_EQUAL(static_cast<long>(n * MQTT_STATE_PERIOD_MS / 1000), tOf(broker->retained[STATE]));
+
+    for (int i = 0; i < 10 && mqtt->queued(); ++i) mqtt->service(now += MQTT_SERVICE_MS);
+    TEST_ASSERT_EQUAL(0u, mqtt->queued());
+    TEST_ASSERT_EQUAL(n, mqtt->replayed());
+
+    auto replay = broker->on(REPLAY);
+    TEST_ASSERT_EQUAL(n, replay.size());
+    for (uint32_t i = 0; i < n; ++i) {
+        TEST_ASSERT_FALSE(replay[i].retain);
+        TEST_ASSERT_EQUAL(static_cast<long>((i + 1) * MQTT_STATE_PERIOD_MS / 1000), tOf(replay[i].payload));
+    }
+    TEST_ASSERT_TRUE(replay[0].payload.find("\"relays\":0,\"armed\":1,\"manual\":0}") != std::string::npos);
+    // Replayed in slices, never more than MQTT_REPLAY_BATCH per flush
+    TEST_ASSERT_EQUAL(replay[MQTT_REPLAY_BATCH - 1].flush, replay[0].flush);
+    TEST_ASSERT_NOT_EQUAL(replay[MQTT_REPLAY_BATCH].flush, replay[0].flush);
+}
+
+void test_offline_ring_drops_oldest() {
+    broker->up = false;
+    const uint32_t extra = 7;
+    for (uint32_t i = 0; i < MQTT_QUEUE_DEPTH + extra; ++i) {
+        mqtt->handle(frameAt(1 + i, i * MQTT_STATE_PERIOD_MS));
+    }
+    TEST_ASSERT_EQUAL(MQTT_QUEUE_DEPTH, mqtt->queued());
+    TEST_ASSERT_EQUAL(extra, mqtt->dropped());
+
+    broker->up = true;
+    uint32_t now = 0;
+    for (int i = 0; i < 100 && (mqtt->queued() || !mqtt->online()); ++i) {
+        mqtt->service(now += MQTT_RECONNECT_MIN_MS);
+    }
+    auto replay = broker->on(REPLAY);
+    TEST_ASSERT_EQUAL(MQTT_QUEUE_DEPTH, replay.size());
+    TEST_ASSERT_EQUAL(static_cast<long>(extra * MQTT_STATE_PERIOD_MS / 1000), tOf(replay.front().payload));
+    for (size_t i = 1; i < replay.size(); ++i) {
+        TEST_ASSERT_TRUE(tOf(replay[i].payload) > tOf(replay[i - 1].payload));
+    }
+}
+
+void test_relay_changes_while_offline_are_queued() {
+    mqtt->service(0);
+    mqtt->handle(frameAt(1, 0));
+    broker->drop();
+    mqtt->handle(frameAt(1, 500, 800.0f, 0x01));
+    mqtt->handle(frameAt(1, 900, 800.0f, 0x00));
+    TEST_ASSERT_EQUAL(2u, mqtt->queued());
+
+    broker->up = true;
+    mqtt->service(1000);
+    mqtt->service(1500);
+    auto replay = broker->on(REPLAY);
+    TEST_ASSERT_EQUAL(2u, replay.size());
+    TEST_ASSERT_TRUE(replay[0].payload.find("\"relays\":1,") != std::string::npos);
+    TEST_ASSERT_TRUE(replay[1].payload.find("\"relays\":0,") != std::string::npos);
+}
+
+// ── Reconnect ─────────────────────────────────────────────────────────────────
+
+void test_reconnect_backs_off() {
+    broker->up = false;
+    std::vector<uint32_t> at;
+    for (uint32_t now = 0; now <= 200000; now += 100) {
+        int before = broker->attempts;
+        mqtt->service(now);
+        if (broker->attempts != before) at.push_back(now);
+    }
+    // 0, +2 s, +4 s, +8 s ... capped at MQTT_RECONNECT_MAX_MS
+    TEST_ASSERT_TRUE(at.size() >= 6);
+    TEST_ASSERT_EQUAL(0u, at[0]);
+    TEST_ASSERT_EQUAL(MQTT_RECONNECT_MIN_MS, at[1] - at[0]);
+    TEST_ASSERT_EQUAL(2 * MQTT_RECONNECT_MIN_MS, at[2] - at[1]);
+    TEST_ASSERT_EQUAL(4 * MQTT_RECONNECT_MIN_MS, at[3] - at[2]);
+    TEST_ASSERT_EQUAL(MQTT_RECONNECT_MAX_MS, at.back() - at[at.size() - 2]);
+
+    broker->up = true;
+    mqtt->service(at.back() + MQTT_RECONNECT_MAX_MS);
+    TEST_ASSERT_TRUE(mqtt->online());
+    TEST_ASSERT_EQUAL(1u, mqtt->connects());
+}
+
+void test_session_loss_during_flush_requeues() {
+    mqtt->service(0);
+    mqtt->handle(frameAt(1, 0));
+    broker->session = false;   // Drops without the bridge noticing yet
+    mqtt->handle(frameAt(2, MQTT_STATE_PERIOD_MS));
+    TEST_ASSERT_FALSE(mqtt->online());
+    TEST_ASSERT_EQUAL(1u, mqtt->queued());
+
+    mqtt->service(MQTT_STATE_PERIOD_MS + 100);   // Immediate retry after a drop
+    TEST_ASSERT_TRUE(mqtt->online());
+    TEST_ASSERT_EQUAL(2, broker->connects);
+    TEST_ASSERT_EQUAL(1u, broker->on(REPLAY).size());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_connect_publishes_discovery_and_online);
+    RUN_TEST(test_state_once_per_generation_and_period);
+    RUN_TEST(test_relay_change_published_immediately);
+    RUN_TEST(test_offline_samples_replayed_in_order);
+    RUN_TEST(test_offline_ring_drops_oldest);
+    RUN_TEST(test_relay_changes_while_offline_are_queued);
+    RUN_TEST(test_reconnect_backs_off);
+    RUN_TEST(test_session_loss_during_flush_requeues);
+    return UNITY_END();
+}
@@ -0,0 +1,165 @@
+/**
+ * test_poll_scheduler.cpp — Unit tests for per-driver sensor poll cadence.
+ *
+ * Simulates the sensor task's loop (pop every due driver, then sleep for
+ * msUntilNext()) in virtual time and counts how often each driver ran.
+ */
+
+#include <unity.h>
+#include "../../src/sensors/poll_scheduler.h"
+#include "../../include/config.h"
+
+void setUp()    {}
+void tearDown() {}
+
+struct RunCounts {
+    uint32_t polls[SENSOR_DRIVER_COUNT] = {};
+    uint32_t wakeups = 0;
+};
+
+// Run the sensor-task loop from `start` for `duration_ms` of virtual time
+static RunCounts simulate(PollScheduler& s, uint32_t start, uint32_t duration_ms) {
+    RunCounts rc;
+    uint32_t now = start;
+    while (now - start < duration_ms) {
+        SensorDriver d;
+        while (s.popDue(now, d)) rc.polls[static_cast<uint8_t>(d)]++;
+        uint32_t wait = s.msUntilNext(now);
+        now += (wait > 0 ? wait : 1);
+        rc.wakeups++;
+    }
+    return rc;
+}
+
+void test_first_deadlines_follow_phase_offsets() {
+    PollScheduler s;
+    s.begin(SensorPollConfig{}, 1000);
+    TEST_ASSERT_EQUAL(static_cast<uint8_t>(SensorDriver::CO2), static_cast<uint8_t>(s.next()));
+    TEST_ASSERT_EQUAL_UINT32(SENSOR_PHASE_CO2_MS, s.msUntilNext(1000));
+
+    SensorDriver d;
+    TEST_ASSERT_TRUE(s.popDue(1000 + SENSOR_PHASE_CO2_MS, d));
+    TEST_ASSERT_EQUAL(static_cast<uint8_t>(SensorDriver::CO2), static_cast<uint8_t>(d));
+    TEST_ASSERT_EQUAL(static_cast<uint8_t>(SensorDriver::RH), static_cast<uint8_t>(s.next()));
+    TEST_ASSERT_EQUAL_UINT32(SENSOR_PHASE_RH_MS - SENSOR_PHASE_CO2_MS,
+                             s.msUntilNext(1000 + SENSOR_PHASE_CO2_MS));
+}
+
+void test_nothing_due_before_deadline() {
+    PollScheduler s;
+    s.begin(SensorPollConfig{}, 0);
+    SensorDriver d;
+    TEST_ASSERT_TRUE(s.popDue(0, d));    // CO2 at phase 0
+    TEST_ASSERT_FALSE(s.popDue(SENSOR_PHASE_RH_MS - 1, d));
+}
+
+void test_each_driver_runs_at_its_own_rate() {
+    PollScheduler s;
+    s.begin(SensorPollConfig{}, 0);
+    RunCounts rc = simulate(s, 0, 60000);
+
+    TEST_ASSERT_EQUAL_UINT32(60000 / SENSOR_POLL_RH_MS,    rc.polls[static_cast<uint8_t>(SensorDriver::RH)]);
+    TEST_ASSERT_EQUAL_UINT32(60000 / SENSOR_POLL_CO2_MS,   rc.polls[static_cast<uint8_t>(SensorDriver::CO2)]);
+    TEST_ASSERT_EQUAL_UINT32(60000 / SENSOR_POLL_TEMP_MS,  rc.polls[static_cast<uint8_t>(SensorDriver::TEMP)]);
+    TEST_ASSERT_EQUAL_UINT32(60000 / SENSOR_POLL_LIGHT_MS, rc.polls[static_cast<uint8_t>(SensorDriver::LIGHT)]);
+}
+
+void test_rh_at_1hz_does_not_drag_light_along() {
+    SensorPollConfig cfg;
+    cfg.rh_ms    = 1000;
+    cfg.light_ms = 30000;
+    PollScheduler s;
+    s.begin(cfg, 0);
+    RunCounts rc = simulate(s, 0, 60000);
+    TEST_ASSERT_EQUAL_UINT32(60, rc.polls[static_cast<uint8_t>(SensorDriver::RH)]);
+    TEST_ASSERT_EQUAL_UINT32(2,  rc.polls[static_cast<uint8_t>(SensorDriver::LIGHT)]);
+}
+
+void test_task_sleeps_between_deadlines() {
+    PollScheduler s;
+    s.begin(SensorPollConfig{}, 0);
+    RunCounts rc = simulate(s, 0, 60000);
+    // Wakes only when something is due: at most one wakeup per poll
+    uint32_t total = 0;
+    for (auto p : rc.polls) total += p;
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(total, rc.wakeups);
+}
+
+void test_late_poll_does_not_drift_or_burst() {
+    SensorPollConfig cfg;
+    cfg.co2_ms = 2000;
+    PollScheduler s;
+    s.begin(cfg, 0);
+    SensorDriver d;
+
+    for (uint32_t t = 0; t <= 2000 - 1; ++t) while (s.popDue(t, d)) {}
+
+    // Serviced 150 ms late at 2150: the next CO2 deadline stays on the grid
+    while (s.popDue(2150, d)) {}
+    uint32_t next_co2 = 0;
+    for (uint32_t t = 2151; t <= 5000 && next_co2 == 0; ++t) {
+        while (s.popDue(t, d)) if (d == SensorDriver::CO2) next_co2 = t;
+    }
+    TEST_ASSERT_EQUAL_UINT32(4000, next_co2);
+
+    // Stalled for 10 s: CO2 fires once, not five times
+    uint32_t co2 = 0;
+    while (s.popDue(15000, d)) if (d == SensorDriver::CO2) co2++;
+    TEST_ASSERT_EQUAL_UINT32(1, co2);
+    TEST_ASSERT_FALSE(s.popDue(15000, d));
+}
+
+void test_shorter_period_pulls_deadline_in() {
+    PollScheduler s;
+    s.begin(SensorPollConfig{}, 0);
+    SensorDriver d;
+    while (s.popDue(SENSOR_PHASE_LIGHT_MS, d)) {}  // Light next due at 10.5 s
+
+    SensorPollConfig cfg;
+    cfg.light_ms = 1000;
+    s.setPeriods(cfg, 600);
+    TEST_ASSERT_EQUAL_UINT32(1000, s.period(SensorDriver::LIGHT));
+
+    uint32_t light = 0;
+    for (uint32_t t = 600; t <= 1600; ++t) {
+        while (s.popDue(t, d)) if (d == SensorDriver::LIGHT) light++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, light);
+}
+
+void test_period_clamped_to_limits() {
+    SensorPollConfig cfg;
+    cfg.rh_ms  = 1;
+    cfg.co2_ms = SENSOR_POLL_MAX_MS * 2;
+    PollScheduler s;
+    s.begin(cfg, 0);
+    TEST_ASSERT_EQUAL_UINT32(SENSOR_POLL_MIN_MS, s.period(SensorDriver::RH));
+    TEST_ASSERT_EQUAL_UINT32(SENSOR_POLL_MAX_MS, s.period(SensorDriver::CO2));
+}
+
+void test_millis_wraparound() {
+    PollScheduler s;
+    uint32_t start = 0xFFFFFFFFu - 1500;
+    SensorPollConfig cfg;
+    cfg.co2_ms = 2000;
+    s.begin(cfg, start);
+    RunCounts rc = simulate(s, start, 10000);
+    TEST_ASSERT_EQUAL_UINT32(10, rc.polls[static_cast<uint8_t>(SensorDriver::RH)]);
+    TEST_ASSERT_EQUAL_UINT32(5,  rc.polls[static_cast<uint8_t>(SensorDriver::CO2)]);
+}
+
+int main(int /*argc*/, char** /*argv*/) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_first_deadlines_follow_phase_offsets);
+    RUN_TEST(test_nothing_due_before_deadline);
+    RUN_TEST(test_each_driver_runs_at_its_own_rate);
+    RUN_TEST(test_rh_at_1hz_does_not_drag_light_along);
+    RUN_TEST(test_task_sleeps_between_deadlines);
+    RUN_TEST(test_late_poll_does_not_drift_or_burst);
+    RUN_TEST(test_shorter_period_pulls_deadline_in);
+    RUN_TEST(test_period_clamped_to_limits);
+    RUN_TEST(test_millis_wraparound);
+
+    return UNITY_END();
+}
@@ -0,0 +1,226 @@
+/**
+ * test_publisher.cpp — Unit and stress tests for the single-slot Mailbox and
+ * the publisher fan-out (PublisherCore).
+ *
+ * The stress tests run the "control task" (producer) against a publisher
+ * thread whose sinks are deliberately slow, and check that posting stays
+ * cheap and that sinks only ever see whole, newest-first frames.
+ */
+
+#include <unity.h>
+#include "../../src/util/mailbox.h"
+#include "../../src/web/publisher.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+extern void set_millis(uint32_t v);
+
+void setUp()    {}
+void tearDown() {}
+
+/** frameWithTag(n) — Frame whose generation and several payload fields all carry n. */
+static PublishFrame frameWithTag(uint32_t n) {
+    PublishFrame f = {};
+    f.gen              = n;
+    f.ts_ms            = n;
+    f.snap.co2.co2_ppm = static_cast<float>(n);
+    f.snap.rh[2].rh_pct = static_cast<float>(n);
+    f.snap.temp_probe[DS18B20_PROBE_COUNT - 1] = static_cast<float>(n);
+    return f;
+}
+
+static bool isConsistent(const PublishFrame& f) {
+    float tag = static_cast<float>(f.gen);
+    return f.ts_ms == f.gen && f.snap.co2.co2_ppm == tag && f.snap.rh[2].rh_pct == tag &&
+           f.snap.temp_probe[DS18B20_PROBE_COUNT - 1] == tag;
+}
+
+// ── Mailbox ───────────────────────────────────────────────────────────────────
+
+void test_mailbox_empty_take_returns_false() {
+    Mailbox<uint32_t> box;
+    uint32_t v = 7;
+    TEST_ASSERT_FALSE(box.pending());
+    TEST_ASSERT_FALSE(box.take(v));
+    TEST_ASSERT_EQUAL_UINT32(7, v);
+}
+
+void test_mailbox_take_once_per_post() {
+    Mailbox<uint32_t> box;
+    uint32_t v = 0;
+    box.post(11);
+    TEST_ASSERT_TRUE(box.pending());
+    TEST_ASSERT_TRUE(box.take(v));
+    TEST_ASSERT_EQUAL_UINT32(11, v);
+    TEST_ASSERT_FALSE(box.pending());
+    TEST_ASSERT_FALSE(box.take(v));       // Same value isn't delivered twice
+    TEST_ASSERT_EQUAL_UINT32(0, box.dropped());
+}
+
+void test_mailbox_latest_wins_and_counts_drops() {
+    Mailbox<uint32_t> box;
+    uint32_t v = 0;
+    for (uint32_t n = 1; n <= 5; ++n) box.post(n);
+    TEST_ASSERT_TRUE(box.take(v));
+    TEST_ASSERT_EQUAL_UINT32(5, v);
+    TEST_ASSERT_EQUAL_UINT32(4, box.dropped());
+    TEST_ASSERT_EQUAL_UINT32(5, box.posted());
+
+    box.post(6);
+    TEST_ASSERT_TRUE(box.take(v));
+    TEST_ASSERT_EQUAL_UINT32(6, v);
+    TEST_ASSERT_EQUAL_UINT32(4, box.dropped());
+}
+
+// ── PublisherCore ─────────────────────────────────────────────────────────────
+
+struct SinkLog {
+    uint32_t calls    = 0;
+    uint32_t last_gen = 0;
+};
+
+static void recordSink(void* ctx, const PublishFrame& f) {
+    auto* log = static_cast<SinkLog*>(ctx);
+    log->calls++;
+    log->last_gen = f.gen;
+}
+
+void test_dispatch_fans_out_newest_frame_to_every_sink() {
+    PublisherCore pub;
+    SinkLog a, b;
+    TEST_ASSERT_TRUE(pub.addSink(&recordSink, &a));
+    TEST_ASSERT_TRUE(pub.addSink(&recordSink, &b));
+
+    TEST_ASSERT_FALSE(pub.dispatch());    // Nothing posted yet
+    pub.post(frameWithTag(1));
+    pub.post(frameWithTag(2));
+    TEST_ASSERT_TRUE(pub.dispatch());
+    TEST_ASSERT_FALSE(pub.dispatch());
+
+    TEST_ASSERT_EQUAL_UINT32(1, a.calls);
+    TEST_ASSERT_EQUAL_UINT32(2, a.last_gen);
+    TEST_ASSERT_EQUAL_UINT32(1, b.calls);
+    TEST_ASSERT_EQUAL_UINT32(2, b.last_gen);
+    TEST_ASSERT_EQUAL_UINT32(2, pub.posted());
+    TEST_ASSERT_EQUAL_UINT32(1, pub.dispatched());
+    TEST_ASSERT_EQUAL_UINT32(1, pub.dropped());
+}
+
+void test_post_never_runs_sinks() {
+    PublisherCore pub;
+    SinkLog a;
+    pub.addSink(&recordSink, &a);
+    for (uint32_t n = 1; n <= 10; ++n) pub.post(frameWithTag(n));
+    TEST_ASSERT_EQUAL_UINT32(0, a.calls);
+}
+
+void test_sink_table_capacity() {
+    PublisherCore pub;
+    SinkLog logs[PUBLISH_MAX_SINKS + 1];
+    for (uint8_t i = 0; i < PUBLISH_MAX_SINKS; ++i) TEST_ASSERT_TRUE(pub.addSink(&recordSink, &logs[i]));
+    TEST_ASSERT_FALSE(pub.addSink(&recordSink, &logs[PUBLISH_MAX_SINKS]));
+}
+
+void test_frame_captures_relay_state() {
+    RelayManager relay;
+    set_millis(0);
+    relay.begin();
+    set_millis(BOOT_LOCK_MS + 1);
+    relay.tick();
+    relay.set(RelayChannel::FOGGER, true, RelaySource::API);
+    relay.set(RelayChannel::PUMP, true, RelaySource::API);
+
+    SensorSnapshot snap = {};
+    snap.co2.co2_ppm = 950.0f;
+    PublishFrame f = makePublishFrame(snap, 42, relay, 1234);
+    TEST_ASSERT_EQUAL_UINT32(42, f.gen);
+    TEST_ASSERT_EQUAL_UINT32(1234, f.ts_ms);
+    TEST_ASSERT_EQUAL_FLOAT(950.0f, f.snap.co2.co2_ppm);
+    uint8_t want = static_cast<uint8_t>((1u << static_cast<uint8_t>(RelayChannel::FOGGER)) |
+                                        (1u << static_cast<uint8_t>(RelayChannel::PUMP)));
+    TEST_ASSERT_EQUAL_UINT8(want, f.relay_mask);
+    TEST_ASSERT_TRUE(f.armed);
+    TEST_ASSERT_FALSE(f.manual_mode);
+}
+
+// ── Producer vs slow publisher ────────────────────────────────────────────────
+
+struct SlowSink {
+    std::atomic<uint32_t> calls{0};
+    std::atomic<uint32_t> torn{0};
+    std::atomic<uint32_t> backwards{0};
+    std::atomic<uint32_t> last_gen{0};
+};
+
+static void slowSink(void* ctx, const PublishFrame& f) {
+    auto* s = static_cast<SlowSink*>(ctx);
+    if (!isConsistent(f)) s->torn++;
+    if (f.gen <= s->last_gen.load()) s->backwards++;
+    s->last_gen.store(f.gen);
+    s->calls++;
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));  // Serialisation + socket I/O
+}
+
+void test_post_cost_independent_of_sink_cost() {
+    PublisherCore pub;
+    SlowSink      sinks[3];
+    for (auto& s : sinks) pub.addSink(&slowSink, &s);
+
+    std::atomic<bool> stop{false};
+    std::thread publisher([&] {
+        while (!stop.load()) {
+            if (!pub.dispatch()) std::this_thread::yield();
+        }
+    });
+
+    constexpr uint32_t POSTS = 2000;
+    int64_t total_ns = 0, worst_ns = 0;
+    for (uint32_t n = 1; n <= POSTS; ++n) {
+        auto t0 = Clock::now();
+        pub.post(frameWithTag(n));
+        auto dt = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count();
+        total_ns += dt;
+        worst_ns  = std::max<int64_t>(worst_ns, dt);
+        if (n % 50 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // Let the publisher catch up with the last frame
+    auto deadline = Clock::now() + std::chrono::seconds(2);
+    while (sinks[0].last_gen.load() != POSTS && Clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    stop = true;
+    publisher.join();
+
+    printf("publisher post mean %lld ns, worst %lld ns, %u dispatched, %u dropped\n",
+           static_cast<long long>(total_ns / POSTS), static_cast<long long>(worst_ns),
+           pub.dispatched(), pub.dropped());
+    // Running the sinks inline would cost 2000 × 3 × 2 ms = 12 s
+    TEST_ASSERT_TRUE(total_ns < 200000000);
+    TEST_ASSERT_EQUAL_UINT32(POSTS, pub.dispatched() + pub.dropped());
+    TEST_ASSERT_TRUE(pub.dropped() > 0);                  // Slow sinks see fewer, newer frames
+    for (auto& s : sinks) {
+        TEST_ASSERT_EQUAL_UINT32(0, s.torn.load());
+        TEST_ASSERT_EQUAL_UINT32(0, s.backwards.load());
+        TEST_ASSERT_EQUAL_UINT32(POSTS, s.last_gen.load());    // The final frame always gets out
+        TEST_ASSERT_EQUAL_UINT32(pub.dispatched(), s.calls.load());
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_mailbox_empty_take_returns_false);
+    RUN_TEST(test_mailbox_take_once_per_post);
+    RUN_TEST(test_mailbox_latest_wins_and_counts_drops);
+    RUN_TEST(test_dispatch_fans_out_newest_frame_to_every_sink);
+    RUN_TEST(test_post_never_runs_sinks);
+    RUN_TEST(test_sink_table_capacity);
+    RUN_TEST(test_frame_captures_relay_state);
+    RUN_TEST(test_post_cost_independent_of_sink_cost);
+    return UNITY_END();
+}
@@ -0,0 +1,165 @@
+/**
+ * test_relay_command.cpp — Unit and stress tests for the relay command ring:
+ * in-order application by the consumer, per-ticket results (pending, done,
+ * aged out), boot-lock and
+ * manual-mode rejection, bounded depth, stale commands dropped unapplied,
+ * and no lost or reordered commands with a racing producer.
+ */
+
+#include <unity.h>
+#include "../../src/relay/relay_command.h"
+
+#include <atomic>
+#include <thread>
+
+extern void set_millis(uint32_t v);
+
+static RelayManager       relay;
+static RelayCommandQueue* q = nullptr;   // Fresh per test
+
+void setUp() {
+    relay = RelayManager{};
+    q     = new RelayCommandQueue();
+    set_millis(0);
+    relay.begin();
+}
+
+void tearDown() {
+    delete q;
+    q = nullptr;
+}
+
+static void arm() {
+    set_millis(BOOT_LOCK_MS + UVC_EXTRA_GUARD_MS + 1);
+    relay.tick();
+}
+
+static RelayCommand at(RelayCommand cmd, uint32_t ms) {
+    cmd.submitted_ms = ms;
+    return cmd;
+}
+
+static RelayCmdResult resultOf(uint32_t ticket) {
+    return q->result(ticket);
+}
+
+void test_nothing_applied_until_drained() {
+    arm();
+    uint32_t t = q->submit(at(RelayCommand::set(RelayChannel::FOGGER, true), millis()));
+    TEST_ASSERT_NOT_EQUAL(0u, t);
+    TEST_ASSERT_EQUAL(static_cast<int>(RelayCmdResult::PENDING), static_cast<int>(resultOf(t)));
+    TEST_ASSERT_FALSE(relay.get(RelayChannel::FOGGER));   // Web task never wrote it
+    TEST_ASSERT_EQUAL(1u, q->queued());
+
+    TEST_ASSERT_EQUAL(1, q->drain(relay, millis()));
+    TEST_ASSERT_TRUE(relay.get(RelayChannel::FOGGER));
+    TEST_ASSERT_EQUAL(static_cast<int>(RelayCmdResult::OK), static_cast<int>(resultOf(t)));
+    TEST_ASSERT_EQUAL(0u, q->queued());
+}
+
+void test_results_in_submission_order() {
+    arm();
+    uint32_t now = millis();
+    uint32_t a   = q->submit(at(RelayCommand::set(RelayChannel::LIGHTS, true), now));
+    uint32_t b   = q->submit(at(RelayCommand::manual(true), now));
+    uint32_t c   = q->submit(at(RelayCommand::set(RelayChannel::LIGHTS, false), now));
+    TEST_ASSERT_EQUAL(3, q->drain(relay, now));
+
+    TEST_ASSERT_EQUAL(static_cast<int>(RelayCmdResult::OK), static_cast<int>(resultOf(a)));
+    TEST_ASSERT_EQUAL(static_cast<int>(RelayCmdResult::OK), static_cast<int>(resultOf(b)));
+    TEST_ASSERT_EQUAL(static_cast<int>(RelayCmdResult::REJECTED), static_cast<int>(resultOf(c)));
+    TEST_ASSERT_TRUE(relay.isManualMode());
+    TEST_ASSERT_TRUE(relay.get(RelayChannel::LIGHTS));    // Set before manual mode, kept
+    TEST_ASSERT_EQUAL(3u, q->applied());
+}
+
+void test_boot_lock_rejected() {
+    uint32_t t = q->submit(at(RelayCommand::set(RelayChannel::PUMP, true), 0));
+    q->drain(relay, 0);
+    TEST_ASSERT_EQUAL(static_cast<int>(RelayCmdResult::REJECTED), static_cast<int>(resultOf(t)));
+    TEST_ASSERT_FALSE(relay.get(RelayChannel::PUMP));
+}
+
+void test_full_ring_refuses() {
+    arm();
+    for (uint8_t i = 0; i < RelayCommandQueue::DEPTH; ++i) {
+        TEST_ASSERT_NOT_EQUAL(0u, q->submit(at(RelayCommand::set(RelayChannel::FOGGER, i & 1), millis())));
+    }
+    TEST_ASSERT_EQUAL(0u, q->submit(at(RelayCommand::set(RelayChannel::FOGGER, true), millis())));
+    TEST_ASSERT_EQUAL(1u, q->full());
+
+    q->drain(relay, millis());
+    TEST_ASSERT_NOT_EQUAL(0u, q->submit(at(RelayCommand::set(RelayChannel::FOGGER, true), millis())));
+}
+
+void test_old_tickets_read_unknown() {
+    arm();
+    TEST_ASSERT_EQUAL(static_cast<int>(RelayCmdResult::UNKNOWN), static_cast<int>(resultOf(0)));
+    TEST_ASSERT_EQUAL(static_cast<int>(RelayCmdResult::UNKNOWN), static_cast<int>(resultOf(1)));   // Not issued
+
+    uint32_t first = q->submit(at(RelayCommand::set(RelayChannel::SPARE, true), millis()));
+    q->drain(relay, millis());
+    for (uint8_t i = 1; i < RelayCommandQueue::DEPTH; ++i) {
+        q->submit(at(RelayCommand::set(RelayChannel::SPARE, i & 1), millis()));
+        q->drain(relay, millis());
+    }
+    TEST_ASSERT_EQUAL(static_cast<int>(RelayCmdResult::OK), static_cast<int>(resultOf(first)));   // Last DEPTH kept
+
+    uint32_t last = q->submit(at(RelayCommand::set(RelayChannel::SPARE, true), millis()));
+    q->drain(relay, millis());
+    TEST_ASSERT_EQUAL(static_cast<int>(RelayCmdResult::UNKNOWN), static_cast<int>(resultOf(first)));   // Slot reused
+    TEST_ASSERT_EQUAL(static_cast<int>(RelayCmdResult::OK), static_cast<int>(resultOf(last)));
+}
+
+void test_stale_command_dropped_not_applied() {
+    arm();
+    uint32_t t0 = millis();
+    uint32_t t  = q->submit(at(RelayCommand::set(RelayChannel::EXHAUST, true), t0));
+    TEST_ASSERT_EQUAL(0, q->drain(relay, t0 + RELAY_CMD_TIMEOUT_MS));   // Control task was stalled
+    TEST_ASSERT_EQUAL(static_cast<int>(RelayCmdResult::EXPIRED), static_cast<int>(resultOf(t)));
+    TEST_ASSERT_FALSE(relay.get(RelayChannel::EXHAUST));
+    TEST_ASSERT_EQUAL(1u, q->expired());
+    TEST_ASSERT_EQUAL(0u, q->applied());
+}
+
+void test_racing_producer_loses_nothing() {
+    arm();
+    constexpr uint32_t N = 2000;
+    std::atomic<bool>  done{false};
+
+    std::thread control([&] {
+        while (!done.load() || q->queued() > 0) q->drain(relay, millis());
+    });
+
+    // Web client: alternate the fogger, polling each ticket until it is done
+    uint32_t bad = 0, refused = 0;
+    for (uint32_t i = 0; i < N; ++i) {
+        uint32_t t = q->submit(at(RelayCommand::set(RelayChannel::FOGGER, i & 1), millis()));
+        if (t == 0) {
+            refused++;
+            continue;
+        }
+        RelayCmdResult r;
+        while ((r = q->result(t)) == RelayCmdResult::PENDING) std::this_thread::yield();
+        if (r != RelayCmdResult::OK || relay.get(RelayChannel::FOGGER) != static_cast<bool>(i & 1)) bad++;
+    }
+    done = true;
+    control.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, refused);
+    TEST_ASSERT_EQUAL_UINT32(0, bad);
+    TEST_ASSERT_EQUAL_UINT32(N, q->applied());
+    TEST_ASSERT_EQUAL_UINT32(N / 2, relay.switchCount(RelayChannel::FOGGER));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_nothing_applied_until_drained);
+    RUN_TEST(test_results_in_submission_order);
+    RUN_TEST(test_boot_lock_rejected);
+    RUN_TEST(test_full_ring_refuses);
+    RUN_TEST(test_old_tickets_read_unknown);
+    RUN_TEST(test_stale_command_dropped_not_applied);
+    RUN_TEST(test_racing_producer_loses_nothing);
+    return UNITY_END();
+}
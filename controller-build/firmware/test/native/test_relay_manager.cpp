@@ -2,7 +2,8 @@
  * test_relay_manager.cpp — Unit tests for RelayManager safety logic.
  *
  * Runs on PC via Unity (no ESP32 needed).
- * Tests: boot lock rejection, UVC extra guard, all-channel toggle, manual mode.
+ * Tests: boot lock rejection, UVC extra guard, all-channel toggle, manual mode,
+ * cumulative on-time.
  */
 
 #include <unity.h>
@@ -160,6 +161,27 @@ void test_relay_channel_count() {
     TEST_ASSERT_EQUAL(8, RELAY_CHANNEL_COUNT);
 }
 
+// ── On-time accounting ────────────────────────────────────────────────────────
+
+void test_on_time_accumulates_across_runs() {
+    uint32_t t = BOOT_LOCK_MS + 1;
+    set_millis(t);
+    mgr.tick();
+
+    mgr.set(RelayChannel::FOGGER, true, RelaySource::API);
+    set_millis(t + 1000);
+    TEST_ASSERT_EQUAL_UINT32(1000, mgr.onTimeMs(RelayChannel::FOGGER));   // Live run counts
+    mgr.set(RelayChannel::FOGGER, false, RelaySource::API);
+    set_millis(t + 5000);
+    TEST_ASSERT_EQUAL_UINT32(1000, mgr.onTimeMs(RelayChannel::FOGGER));   // OFF time doesn't
+    mgr.set(RelayChannel::FOGGER, true, RelaySource::API);
+    mgr.set(RelayChannel::FOGGER, true, RelaySource::API);                // Repeat is a no-op
+    set_millis(t + 5500);
+    TEST_ASSERT_EQUAL_UINT32(1500, mgr.onTimeMs(RelayChannel::FOGGER));
+    TEST_ASSERT_EQUAL_UINT32(2, mgr.switchCount(RelayChannel::FOGGER));
+    TEST_ASSERT_EQUAL_UINT32(0, mgr.onTimeMs(RelayChannel::PUMP));
+}
+
 // ── Main ──────────────────────────────────────────────────────────────────────
 
 int main(int /*argc*/, char** /*argv*/) {
@@ -174,6 +196,7 @@ int main(int /*argc*/, char** /*argv*/) {
     RUN_TEST(test_manual_mode_rejects_commands);
     RUN_TEST(test_manual_mode_exit_resumes_normal_operation);
     RUN_TEST(test_relay_channel_count);
+    RUN_TEST(test_on_time_accumulates_across_runs);
 
     return UNITY_END();
 }
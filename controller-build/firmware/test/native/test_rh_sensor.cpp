@@ -0,0 +1,399 @@
+/**
+ * test_rh_sensor.cpp — Unit tests for pipelined SHT45 reads behind the mux.
+ *
+ * Runs RhSensorArray against a fake I2C bus carrying a TCA9548A and three
+ * SHT45s. The fake models 100 kHz transfer time (9 bits per byte), converts
+ * in parallel on each sensor, and NACKs a read issued before the conversion
+ * has finished — so the timing and mux traffic of a read can be checked.
+ * A heater command keeps the sensor busy (NACKing everything) for ~1 s.
+ * Each test gets its own I2cSupervisor so backoff state doesn't leak.
+ */
+
+#include <unity.h>
+#include "../../src/sensors/rh_sensor.h"
+#include "../../src/sensors/i2c_stats.h"
+#include "../../include/config.h"
+#include <cmath>
+
+// ── Fake bus ──────────────────────────────────────────────────────────────────
+
+class FakeShtBus : public I2cBus {
+public:
+    static constexpr uint32_t BYTE_US = 90;  // 9 clocks at 100 kHz
+
+    struct Sht {
+        bool     present   = true;
+        float    rh        = 50.0f;
+        float    temp      = 20.0f;
+        uint8_t  last_cmd  = 0;
+        uint64_t ready_us  = 0;
+        bool     pending   = false;
+        bool     corrupt   = false;   // Next frame gets a bad CRC
+        uint32_t heats     = 0;
+        uint32_t resets    = 0;
+        uint32_t busy_naks = 0;       // Addressed while still converting/heating
+        uint32_t addressed = 0;       // Transactions on this channel, ACKed or not
+    };
+
+    Sht      sht[8];
+    uint8_t  mux_mask     = 0;
+    bool     mux_fail     = false;
+    uint64_t now_us       = 0;
+    uint32_t mux_writes   = 0;
+
+    bool write(uint8_t addr, const uint8_t* data, size_t len) override {
+        now_us += (1 + len) * BYTE_US;
+        if (addr == I2C_ADDR_TCA9548A) {
+            mux_writes++;
+            if (mux_fail) return false;
+            mux_mask = data[0];
+            return true;
+        }
+        Sht* s = _selected(addr);
+        if (!s || len != 1) return false;
+        if (s->pending && now_us < s->ready_us) { s->busy_naks++; return false; }
+        if (data[0] == SHT4X_CMD_HEAT_200MW_1S) s->heats++;
+        if (data[0] == SHT4X_CMD_SOFT_RESET)    s->resets++;
+        s->last_cmd = data[0];
+        s->pending  = true;
+        s->ready_us = now_us + _convUs(data[0]);
+        return true;
+    }
+
+    bool read(uint8_t addr, uint8_t* out, size_t len) override {
+        now_us += BYTE_US;
+        Sht* s = _selected(addr);
+        if (!s || !s->pending || len != 6) return false;
+        if (now_us < s->ready_us) { s->busy_naks++; return false; }
+        now_us += len * BYTE_US;
+        s->pending = false;
+
+        uint16_t t_raw  = static_cast<uint16_t>(std::lround((s->temp + 45.0f) * 65535.0f / 175.0f));
+        uint16_t rh_raw = static_cast<uint16_t>(std::lround((s->rh + 6.0f) * 65535.0f / 125.0f));
+        out[0] = t_raw >> 8;  out[1] = t_raw & 0xFF;  out[2] = sht4xCrc8(out, 2);
+        out[3] = rh_raw >> 8; out[4] = rh_raw & 0xFF; out[5] = sht4xCrc8(out + 3, 2);
+        if (s->corrupt) { out[5] ^= 0x01; s->corrupt = false; }
+        return true;
+    }
+
+    void sleepUs(uint32_t us) override { now_us += us; }
+
+private:
+    Sht* _selected(uint8_t addr) {
+        if (addr != I2C_ADDR_SHT45) return nullptr;
+        // Exactly one channel enabled, and a sensor present on it
+        if (mux_mask == 0 || (mux_mask & (mux_mask - 1))) return nullptr;
+        uint8_t ch = 0;
+        while (!(mux_mask & (1u << ch))) ++ch;
+        sht[ch].addressed++;
+        return sht[ch].present ? &sht[ch] : nullptr;
+    }
+
+    // Typical conversion times, below the datasheet maxima the driver waits
+    static uint32_t _convUs(uint8_t cmd) {
+        switch (cmd) {
+            case SHT4X_CMD_HEAT_200MW_1S: return 1050000;
+            case 0xFD: return 6900;
+            case 0xF6: return 3700;
+            case 0xE0: return 1300;
+            default:   return 200;   // Serial number / other
+        }
+    }
+};
+
+static FakeShtBus*    bus;
+static I2cSupervisor* sup;
+static RhSensorArray* rh;
+
+void setUp() {
+    I2cCounters.reset();
+    bus = new FakeShtBus();
+    bus->sht[MUX_CH_SHT45_SHELF1].rh = 85.0f; bus->sht[MUX_CH_SHT45_SHELF1].temp = 21.0f;
+    bus->sht[MUX_CH_SHT45_SHELF2].rh = 88.5f; bus->sht[MUX_CH_SHT45_SHELF2].temp = 22.0f;
+    bus->sht[MUX_CH_SHT45_SHELF3].rh = 91.0f; bus->sht[MUX_CH_SHT45_SHELF3].temp = 23.0f;
+    sup = new I2cSupervisor(*bus);
+    rh  = new RhSensorArray(*bus, *sup);
+    rh->begin();
+}
+
+void tearDown() {
+    delete rh;
+    delete sup;
+    delete bus;
+}
+
+// ── Tests ─────────────────────────────────────────────────────────────────────
+
+void test_reads_all_three_shelves() {
+    auto r = rh->readAll(1000);
+    TEST_ASSERT_TRUE(r[0].valid);
+    TEST_ASSERT_TRUE(r[1].valid);
+    TEST_ASSERT_TRUE(r[2].valid);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 85.0f, r[0].rh_pct);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 88.5f, r[1].rh_pct);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 23.0f, r[2].temp_c);
+    TEST_ASSERT_EQUAL_UINT32(1000, r[2].timestamp_ms);
+}
+
+void test_three_shelves_cost_about_one_conversion() {
+    rh->readAll(0);  // Warm the mux cache
+    uint64_t t0 = bus->now_us;
+    auto r = rh->readAll(1000);
+    uint32_t elapsed = static_cast<uint32_t>(bus->now_us - t0);
+
+    TEST_ASSERT_TRUE(r[0].valid && r[1].valid && r[2].valid);
+    // One high-precision wait plus transfers (~3.2 ms at 100 kHz), vs ~28 ms
+    // for three back-to-back blocking reads
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(sht4xMeasureUs(ShtPrecision::HIGH_PREC) + 4000, elapsed);
+}
+
+void test_mux_skips_redundant_selects() {
+    rh->readAll(0);
+    uint32_t before = bus->mux_writes;
+    rh->readAll(1000);
+    // Trigger 0→2, collect 2→0: ch2 and (next round) ch0 are already selected
+    TEST_ASSERT_EQUAL_UINT32(4, bus->mux_writes - before);
+}
+
+void test_failed_mux_write_drops_cache() {
+    rh->readAll(0);
+    bus->mux_fail = true;
+    auto r = rh->readAll(1000);
+    // Nothing fresh; last readings are reused within the staleness window
+    TEST_ASSERT_TRUE(r[0].valid && r[1].valid && r[2].valid);
+    TEST_ASSERT_EQUAL_UINT32(0, r[0].timestamp_ms);
+
+    // The cache was dropped, so the first select rewrites the register
+    bus->mux_fail = false;
+    uint32_t before = bus->mux_writes;
+    r = rh->readAll(2000);
+    TEST_ASSERT_EQUAL_UINT32(5, bus->mux_writes - before);
+    TEST_ASSERT_EQUAL_UINT32(2000, r[0].timestamp_ms);
+}
+
+void test_precision_selectable_at_runtime() {
+    rh->setPrecision(ShtPrecision::LOW_PREC);
+    rh->readAll(0);
+    uint64_t t0 = bus->now_us;
+    auto r = rh->readAll(1000);
+    TEST_ASSERT_TRUE(r[1].valid);
+    TEST_ASSERT_EQUAL_HEX8(0xE0, bus->sht[MUX_CH_SHT45_SHELF2].last_cmd);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(sht4xMeasureUs(ShtPrecision::LOW_PREC) + 4000,
+                                     static_cast<uint32_t>(bus->now_us - t0));
+
+    rh->setPrecision(ShtPrecision::MEDIUM_PREC);
+    rh->readAll(2000);
+    TEST_ASSERT_EQUAL_HEX8(0xF6, bus->sht[MUX_CH_SHT45_SHELF2].last_cmd);
+}
+
+void test_missing_shelf_does_not_block_others() {
+    bus->sht[MUX_CH_SHT45_SHELF2].present = false;
+    auto r = rh->readAll(1000);
+    TEST_ASSERT_TRUE(r[0].valid);
+    TEST_ASSERT_FALSE(r[1].valid);
+    TEST_ASSERT_TRUE(r[2].valid);
+}
+
+void test_failing_shelf_backs_off() {
+    FakeShtBus::Sht& s2 = bus->sht[MUX_CH_SHT45_SHELF2];
+    s2.present = false;
+    for (uint32_t t = 1000; t <= 1000 * I2C_FAIL_THRESHOLD; t += 1000) rh->readAll(t);
+
+    // Backing off: shelf 2 is not addressed at all, the others still read
+    uint32_t addressed = s2.addressed;
+    uint32_t t_fail    = 1000 * I2C_FAIL_THRESHOLD;
+    for (uint32_t t = t_fail + 1000; t < t_fail + I2C_BACKOFF_MIN_MS; t += 500) {
+        auto r = rh->readAll(t);
+        TEST_ASSERT_TRUE(r[0].valid && r[2].valid);
+        TEST_ASSERT_EQUAL_UINT32(t, r[2].timestamp_ms);
+    }
+    TEST_ASSERT_EQUAL_UINT32(addressed, s2.addressed);
+
+    // Retry after the backoff: sensor is back, soft-reset then read
+    s2.present = true;
+    auto r = rh->readAll(t_fail + I2C_BACKOFF_MIN_MS);
+    TEST_ASSERT_EQUAL_UINT32(1, s2.resets);
+    TEST_ASSERT_TRUE(r[1].valid);
+    TEST_ASSERT_EQUAL_UINT32(t_fail + I2C_BACKOFF_MIN_MS, r[1].timestamp_ms);
+
+    // Healthy again — no further resets
+    rh->readAll(t_fail + I2C_BACKOFF_MIN_MS + 1000);
+    TEST_ASSERT_EQUAL_UINT32(1, s2.resets);
+}
+
+void test_failed_retry_doubles_backoff() {
+    FakeShtBus::Sht& s3 = bus->sht[MUX_CH_SHT45_SHELF3];
+    s3.present = false;
+    for (uint32_t t = 1000; t <= 1000 * I2C_FAIL_THRESHOLD; t += 1000) rh->readAll(t);
+    uint32_t retry = 1000 * I2C_FAIL_THRESHOLD + I2C_BACKOFF_MIN_MS;
+
+    rh->readAll(retry);                          // Retry fails
+    uint32_t addressed = s3.addressed;
+    rh->readAll(retry + I2C_BACKOFF_MIN_MS);     // Old backoff would retry here
+    TEST_ASSERT_EQUAL_UINT32(addressed, s3.addressed);
+    rh->readAll(retry + 2 * I2C_BACKOFF_MIN_MS); // Doubled backoff elapsed
+    TEST_ASSERT_GREATER_THAN_UINT32(addressed, s3.addressed);
+}
+
+void test_shelf_missing_at_begin_not_polled() {
+    bus->sht[MUX_CH_SHT45_SHELF1].present = false;
+    I2cSupervisor fresh_sup(*bus);
+    RhSensorArray fresh(*bus, fresh_sup);
+    TEST_ASSERT_FALSE(fresh.begin());
+
+    uint32_t addressed = bus->sht[MUX_CH_SHT45_SHELF1].addressed;
+    auto r = fresh.readAll(1000);
+    TEST_ASSERT_TRUE(r[1].valid && r[2].valid);
+    r = fresh.readAll(1000 + I2C_BACKOFF_MIN_MS - 1);
+    TEST_ASSERT_EQUAL_UINT32(addressed, bus->sht[MUX_CH_SHT45_SHELF1].addressed);
+
+    bus->sht[MUX_CH_SHT45_SHELF1].present = true;
+    r = fresh.readAll(1000 + I2C_BACKOFF_MIN_MS);
+    TEST_ASSERT_TRUE(r[0].valid);
+}
+
+void test_crc_error_falls_back_to_last_reading() {
+    rh->readAll(1000);
+    bus->sht[MUX_CH_SHT45_SHELF3].corrupt = true;
+    bus->sht[MUX_CH_SHT45_SHELF3].rh = 40.0f;
+    auto r = rh->readAll(2000);
+    TEST_ASSERT_TRUE(r[2].valid);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 91.0f, r[2].rh_pct);
+    TEST_ASSERT_EQUAL_UINT32(1000, r[2].timestamp_ms);
+
+    // Past the staleness window the fallback expires
+    bus->sht[MUX_CH_SHT45_SHELF3].corrupt = true;
+    r = rh->readAll(1000 + SENSOR_STALE_MS);
+    TEST_ASSERT_FALSE(r[2].valid);
+}
+
+// ── Heater ────────────────────────────────────────────────────────────────────
+
+// One sensor-task RH poll at virtual time t_ms (bus clock follows)
+static std::array<RhReading, 3> poll(uint32_t t_ms) {
+    if (bus->now_us < uint64_t(t_ms) * 1000) bus->now_us = uint64_t(t_ms) * 1000;
+    auto r = rh->readAll(t_ms);
+    rh->tickHeater(t_ms);
+    return r;
+}
+
+static uint32_t first_pulse_ms() { return SHT45_HEATER_INTERVAL_MS / 3; }
+
+void test_heater_pulses_staggered_one_shelf_at_a_time() {
+    uint32_t pulse_at[3][2] = {};
+    for (uint32_t t = 0; t <= 2 * SHT45_HEATER_INTERVAL_MS; t += 1000) {
+        auto r = poll(t);
+        uint8_t in_blackout = 0;
+        for (uint8_t i = 0; i < 3; ++i) {
+            if (r[i].heater_blackout) in_blackout++;
+            uint32_t h = bus->sht[i].heats;
+            if (h >= 1 && h <= 2 && pulse_at[i][h - 1] == 0) pulse_at[i][h - 1] = t;
+        }
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(1, in_blackout);
+    }
+    // Each shelf heated once per interval, a third of an interval apart
+    for (uint8_t i = 0; i < 3; ++i) TEST_ASSERT_EQUAL_UINT32(2, bus->sht[i].heats);
+    TEST_ASSERT_EQUAL_UINT32(first_pulse_ms(), pulse_at[0][0]);
+    TEST_ASSERT_EQUAL_UINT32(2 * first_pulse_ms(), pulse_at[1][0]);
+    TEST_ASSERT_EQUAL_UINT32(3 * first_pulse_ms(), pulse_at[2][0]);
+    TEST_ASSERT_EQUAL_UINT32(SHT45_HEATER_INTERVAL_MS, pulse_at[0][1] - pulse_at[0][0]);
+    // The driver never addressed a sensor while it was heating
+    for (uint8_t i = 0; i < 3; ++i) TEST_ASSERT_EQUAL_UINT32(0, bus->sht[i].busy_naks);
+}
+
+void test_heated_shelf_excluded_for_recovery_window() {
+    rh->setHeaterRecovery(5000);
+    uint32_t t = first_pulse_ms();
+    poll(0);  // Arms the schedule
+    poll(t - 1000);
+    poll(t);  // Pulse starts on shelf 1
+    TEST_ASSERT_TRUE(rh->inBlackout(0));
+
+    // Heated die: hot and dry
+    bus->sht[MUX_CH_SHT45_SHELF1].rh   = 40.0f;
+    bus->sht[MUX_CH_SHT45_SHELF1].temp = 45.0f;
+
+    auto r = poll(t + 1000);  // Still heating: last good reading, flagged
+    TEST_ASSERT_TRUE(r[0].heater_blackout);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 85.0f, r[0].rh_pct);
+    TEST_ASSERT_FALSE(r[1].heater_blackout);
+    TEST_ASSERT_EQUAL_UINT32(t + 1000, r[1].timestamp_ms);
+
+    poll(t + 2000);           // Pulse over: drained, recovery starts
+    r = poll(t + 3000);       // Recovering: fresh but skewed, flagged
+    TEST_ASSERT_TRUE(r[0].heater_blackout);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 40.0f, r[0].rh_pct);
+
+    // Recovery window runs from the end of the pulse (polled at t+2000)
+    r = poll(t + 2000 + 5000 - 1000);
+    TEST_ASSERT_TRUE(r[0].heater_blackout);
+    bus->sht[MUX_CH_SHT45_SHELF1].rh = 86.0f;
+    r = poll(t + 2000 + 5000);
+    TEST_ASSERT_FALSE(r[0].heater_blackout);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 86.0f, r[0].rh_pct);
+}
+
+void test_heater_pulse_does_not_stall_poll() {
+    uint32_t t = first_pulse_ms();
+    poll(0);  // Arms the schedule
+    poll(t - 1000);
+    bus->now_us = uint64_t(t) * 1000;
+    rh->readAll(t);
+    uint64_t before = bus->now_us;
+    rh->tickHeater(t);  // Sends the heater command and returns
+    TEST_ASSERT_EQUAL_UINT32(1, bus->sht[MUX_CH_SHT45_SHELF1].heats);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(1000, static_cast<uint32_t>(bus->now_us - before));
+}
+
+void test_skewed_reading_never_becomes_fallback() {
+    rh->setHeaterRecovery(5000);
+    uint32_t t = first_pulse_ms();
+    poll(0);  // Arms the schedule
+    poll(t - 1000);
+    poll(t);
+    poll(t + 1000);
+    bus->sht[MUX_CH_SHT45_SHELF1].rh = 40.0f;
+    poll(t + 2000);
+    poll(t + 3000);            // Skewed read during recovery
+    bus->sht[MUX_CH_SHT45_SHELF1].present = false;
+    auto r = poll(t + 10000);  // Recovery over, sensor gone: pre-heat fallback
+    TEST_ASSERT_FALSE(r[0].heater_blackout);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 85.0f, r[0].rh_pct);
+}
+
+void test_decode_known_frame() {
+    // Datasheet-style example: T raw 0x6666, RH raw 0x8000
+    uint8_t f[6] = { 0x66, 0x66, 0, 0x80, 0x00, 0 };
+    f[2] = sht4xCrc8(f, 2);
+    f[5] = sht4xCrc8(f + 3, 2);
+    float rh_pct = 0, temp_c = 0;
+    TEST_ASSERT_TRUE(sht4xDecode(f, rh_pct, temp_c));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 25.0f, temp_c);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 56.5f, rh_pct);
+
+    // Sensirion reference vector: CRC(0xBEEF) = 0x92
+    uint8_t ref[2] = { 0xBE, 0xEF };
+    TEST_ASSERT_EQUAL_HEX8(0x92, sht4xCrc8(ref, 2));
+}
+
+int main(int /*argc*/, char** /*argv*/) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_reads_all_three_shelves);
+    RUN_TEST(test_three_shelves_cost_about_one_conversion);
+    RUN_TEST(test_mux_skips_redundant_selects);
+    RUN_TEST(test_failed_mux_write_drops_cache);
+    RUN_TEST(test_precision_selectable_at_runtime);
+    RUN_TEST(test_missing_shelf_does_not_block_others);
+    RUN_TEST(test_failing_shelf_backs_off);
+    RUN_TEST(test_failed_retry_doubles_backoff);
+    RUN_TEST(test_shelf_missing_at_begin_not_polled);
+    RUN_TEST(test_crc_error_falls_back_to_last_reading);
+    RUN_TEST(test_heater_pulses_staggered_one_shelf_at_a_time);
+    RUN_TEST(test_heated_shelf_excluded_for_recovery_window);
+    RUN_TEST(test_heater_pulse_does_not_stall_poll);
+    RUN_TEST(test_skewed_reading_never_becomes_fallback);
+    RUN_TEST(test_decode_known_frame);
+
+    return UNITY_END();
+}
@@ -4,6 +4,10 @@
 
 #include <unity.h>
 #include "../../src/util/rolling_average.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
 
 void setUp()    {}
 void tearDown() {}
@@ -81,6 +85,55 @@ void test_large_window_partial_fill() {
     TEST_ASSERT_FALSE(avg.full());
 }
 
+// ── Window statistics ─────────────────────────────────────────────────────────
+
+void test_min_max_track_sliding_window() {
+    RollingAverage<int, 4> avg;
+    std::deque<int>        win;
+    uint32_t               seed = 11;
+    for (int i = 0; i < 2000; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        int x = static_cast<int>(seed >> 26) - 32;  // Many duplicates
+        avg.push(x);
+        win.push_back(x);
+        if (win.size() > 4) win.pop_front();
+        TEST_ASSERT_EQUAL_INT(*std::min_element(win.begin(), win.end()), avg.min());
+        TEST_ASSERT_EQUAL_INT(*std::max_element(win.begin(), win.end()), avg.max());
+    }
+}
+
+void test_variance_of_window() {
+    RollingAverage<float, 4> avg;
+    for (float x : {2.0f, 4.0f, 4.0f, 4.0f, 5.0f, 5.0f, 7.0f, 9.0f}) avg.push(x);
+    // Window {5, 5, 7, 9}: mean 6.5, population variance 2.75
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 2.75f, avg.variance());
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, std::sqrt(2.75f), avg.stddev());
+}
+
+void test_integer_sum_is_exact() {
+    RollingAverage<uint32_t, 32> mv;
+    for (int i = 0; i < 32; ++i) mv.push(3300);
+    TEST_ASSERT_EQUAL_UINT64(105600u, mv.sum());
+    mv.push(3301);
+    TEST_ASSERT_EQUAL_UINT64(105601u, mv.sum());
+    TEST_ASSERT_EQUAL_UINT32(3301, mv.max());
+}
+
+void test_float_sum_does_not_drift() {
+    // Large values with small fluctuations: naive float add/subtract loses
+    // the fractions and the sum walks away from the window contents
+    RollingAverage<float, 32> avg;
+    uint32_t seed = 5;
+    for (int i = 0; i < 2000000; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        avg.push(10000.0f + static_cast<float>(seed >> 20) * 0.001f);
+    }
+    for (int i = 0; i < 31; ++i) avg.push(1.0f);
+    avg.push(2.0f);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 33.0f / 32.0f, avg.average());
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 31.0f / 1024.0f, avg.variance());
+}
+
 int main(int /*argc*/, char** /*argv*/) {
     UNITY_BEGIN();
 
@@ -92,6 +145,10 @@ int main(int /*argc*/, char** /*argv*/) {
     RUN_TEST(test_integer_type);
     RUN_TEST(test_window_size_one);
     RUN_TEST(test_large_window_partial_fill);
+    RUN_TEST(test_min_max_track_sliding_window);
+    RUN_TEST(test_variance_of_window);
+    RUN_TEST(test_integer_sum_is_exact);
+    RUN_TEST(test_float_sum_does_not_drift);
 
     return UNITY_END();
 }
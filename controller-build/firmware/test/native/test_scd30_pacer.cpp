@@ -0,0 +1,250 @@
+/**
+ * test_scd30_pacer.cpp — Unit tests for SCD30 data-ready prediction.
+ *
+ * Drives a fake SCD30 (samples on its own, possibly drifting, clock; a read
+ * ahead of it returns the previous sample again) from a simulated CO2 poll
+ * loop and counts I2C transactions with I2cStats, so the paced driver can be compared against the pre-pacing baseline: data-ready
+ * queried, then read, on every SCD30_BASELINE_POLL_MS poll.
+ */
+
+#include <unity.h>
+#include "../../src/sensors/scd30_pacer.h"
+#include "../../src/sensors/i2c_stats.h"
+#include "../../include/config.h"
+
+// Sensor task period before pacing; read() queried data-ready on every call
+static constexpr uint32_t SCD30_BASELINE_POLL_MS = 2000;
+static constexpr uint32_t RUN_MS                 = 600000;   // 10 minutes
+
+// ── Fake sensor ───────────────────────────────────────────────────────────────
+
+class FakeScd30 {
+public:
+    FakeScd30(uint32_t interval_ms, float clock_ratio, uint32_t first_ms)
+        : _interval_ms(interval_ms), _ratio(clock_ratio), _first_ms(first_ms) {}
+
+    // Index of the newest sample produced by now_ms (-1 = none yet)
+    int32_t latest(uint32_t now_ms) const {
+        if (now_ms < _first_ms) return -1;
+        return static_cast<int32_t>((now_ms - _first_ms) / (_interval_ms * _ratio));
+    }
+
+    uint32_t sampleTime(int32_t k) const {
+        return _first_ms + static_cast<uint32_t>(k * _interval_ms * _ratio);
+    }
+
+    bool getDataReady(uint32_t now_ms) {
+        I2cCounters.record(I2cDevice::SCD30, 2);
+        return latest(now_ms) > _read;
+    }
+
+    int32_t readMeasurement(uint32_t now_ms) {
+        I2cCounters.record(I2cDevice::SCD30, 2);
+        _read = latest(now_ms);
+        return _read;
+    }
+
+private:
+    uint32_t _interval_ms;
+    float    _ratio;
+    uint32_t _first_ms;
+    int32_t  _read = -1;
+};
+
+struct RunResult {
+    uint32_t transactions = 0;
+    uint32_t samples      = 0;  // Distinct samples read
+    uint32_t skipped      = 0;  // Samples overwritten before being read
+    uint32_t max_lag_ms   = 0;  // Worst sample-ready → read latency
+};
+
+// Poll the fake every poll_ms for duration_ms; paced = use Scd30Pacer
+static RunResult run(FakeScd30& dev, uint32_t poll_ms, uint32_t duration_ms, bool paced,
+                     uint16_t interval_s = SCD30_MEASUREMENT_INTERVAL_S) {
+    I2cCounters.reset();
+    Scd30Pacer pacer;
+    pacer.setInterval(interval_s);
+
+    RunResult r;
+    int32_t   last = -1;
+    for (uint32_t now = 0; now < duration_ms; now += poll_ms) {
+        Scd30Step step = paced ? pacer.next(now) : Scd30Step::PROBE;
+        if (step == Scd30Step::WAIT) continue;
+        if (step == Scd30Step::PROBE && !dev.getDataReady(now)) continue;
+
+        int32_t k = dev.readMeasurement(now);
+        if (k == last) {                       // Read ahead of the sensor
+            pacer.onStale(now);
+            continue;
+        }
+        if (last >= 0 && k > last + 1) r.skipped += k - last - 1;
+        uint32_t lag = now - dev.sampleTime(k);
+        if (lag > r.max_lag_ms) r.max_lag_ms = lag;
+        r.samples++;
+        last = k;
+        if (paced) pacer.onSample(now);
+    }
+    r.transactions = I2cCounters.transactions(I2cDevice::SCD30);
+    return r;
+}
+
+void setUp()    { I2cCounters.reset(); }
+void tearDown() {}
+
+// ── Tests ─────────────────────────────────────────────────────────────────────
+
+static int stepAt(const Scd30Pacer& p, uint32_t now) { return static_cast<int>(p.next(now)); }
+
+static constexpr int WAIT  = static_cast<int>(Scd30Step::WAIT);
+static constexpr int PROBE = static_cast<int>(Scd30Step::PROBE);
+static constexpr int READ  = static_cast<int>(Scd30Step::READ);
+
+void test_unsynced_pacer_probes_every_poll() {
+    Scd30Pacer p;
+    TEST_ASSERT_EQUAL(PROBE, stepAt(p, 0));
+    TEST_ASSERT_EQUAL(PROBE, stepAt(p, 12345));
+}
+
+void test_in_phase_reads_directly_at_deadline() {
+    Scd30Pacer p;
+    p.setInterval(2);
+    p.onSample(1000);
+    TEST_ASSERT_EQUAL(WAIT, stepAt(p, 1001));
+    TEST_ASSERT_EQUAL(WAIT, stepAt(p, 2999));
+    TEST_ASSERT_EQUAL(READ, stepAt(p, 3000));    // No getDataReady once in phase
+}
+
+void test_stale_read_retries_next_poll() {
+    Scd30Pacer p;
+    p.setInterval(2);
+    p.onSample(0);
+    p.onStale(2000);                             // Sensor clock slow
+    TEST_ASSERT_EQUAL(READ, stepAt(p, 2500));
+    p.onSample(2500);
+    TEST_ASSERT_EQUAL(WAIT, stepAt(p, 4499));
+    TEST_ASSERT_EQUAL(READ, stepAt(p, 4500));
+}
+
+void test_periodic_early_read() {
+    Scd30Pacer p;
+    p.setInterval(2);
+    uint32_t t = 0;
+    for (int i = 1; i < SCD30_RESYNC_EVERY; ++i) { p.onSample(t); t += 2000; }
+    p.onSample(t);  // Every Nth sample reads early
+    TEST_ASSERT_EQUAL(READ, stepAt(p, t + 2000 - SCD30_READY_LEAD_MS));
+    TEST_ASSERT_EQUAL(WAIT, stepAt(p, t + 2000 - SCD30_READY_LEAD_MS - 1));
+
+    // Nothing there yet: read again at the normal deadline
+    t += 2000 - SCD30_READY_LEAD_MS;
+    p.onStale(t);
+    TEST_ASSERT_EQUAL(WAIT, stepAt(p, t + SCD30_READY_LEAD_MS - 1));
+    TEST_ASSERT_EQUAL(READ, stepAt(p, t + SCD30_READY_LEAD_MS));
+}
+
+void test_early_reads_back_off_while_in_phase() {
+    // Sensor exactly in phase: every early read finds nothing, and each miss
+    // doubles the spacing to the next one, up to SCD30_RESYNC_MAX
+    Scd30Pacer p;
+    p.setInterval(2);
+    uint32_t t = 0, last_early = 0, want = SCD30_RESYNC_EVERY;
+    for (uint32_t n = 1; n <= 200; ++n, t += 2000) {
+        p.onSample(t);
+        if (stepAt(p, t + 2000 - SCD30_READY_LEAD_MS) != READ) continue;
+        TEST_ASSERT_EQUAL_UINT32(want, n - last_early);
+        p.onStale(t + 2000 - SCD30_READY_LEAD_MS);
+        last_early = n;
+        if (want < SCD30_RESYNC_MAX) want *= 2;
+    }
+    TEST_ASSERT_EQUAL_UINT32(SCD30_RESYNC_MAX, want);
+}
+
+void test_set_interval_resyncs() {
+    Scd30Pacer p;
+    p.setInterval(2);
+    p.onSample(0);
+    TEST_ASSERT_EQUAL(WAIT, stepAt(p, 500));
+    p.setInterval(5);
+    TEST_ASSERT_EQUAL(PROBE, stepAt(p, 500));
+    p.onSample(500);
+    TEST_ASSERT_EQUAL(WAIT, stepAt(p, 5499));
+    TEST_ASSERT_EQUAL(READ, stepAt(p, 5500));
+}
+
+void test_wraparound() {
+    Scd30Pacer p;
+    p.setInterval(2);
+    p.onSample(0xFFFFFFFFu - 500);
+    TEST_ASSERT_EQUAL(WAIT, stepAt(p, 0xFFFFFFFFu));
+    TEST_ASSERT_EQUAL(WAIT, stepAt(p, 1000));
+    TEST_ASSERT_EQUAL(READ, stepAt(p, 1500));
+}
+
+void test_default_interval_one_read_per_sample() {
+    // 2 s samples: the baseline asked data-ready and then read, two commands
+    // (four transactions) per sample. In phase the paced driver only reads;
+    // the backed-off early reads add a few percent on top.
+    FakeScd30 a(SCD30_MEASUREMENT_INTERVAL_S * 1000, 1.0f, 130);
+    FakeScd30 b(SCD30_MEASUREMENT_INTERVAL_S * 1000, 1.0f, 130);
+    RunResult baseline = run(a, SCD30_BASELINE_POLL_MS, RUN_MS, false);
+    RunResult paced    = run(b, SENSOR_POLL_CO2_MS, RUN_MS, true);
+
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(baseline.samples, paced.samples);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(2 * paced.samples * 110 / 100, paced.transactions);   // ~1 read/sample
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(baseline.transactions * 55 / 100, paced.transactions);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(SENSOR_POLL_CO2_MS, paced.max_lag_ms);
+    TEST_ASSERT_GREATER_THAN_UINT32(SENSOR_POLL_CO2_MS, baseline.max_lag_ms);
+}
+
+void test_long_interval_traffic_per_minute_halved() {
+    // 10 s samples: the baseline still queried every 2 s; the paced driver
+    // stays off the bus until a sample is due
+    constexpr uint16_t INTERVAL_S = 10;
+    FakeScd30 a(INTERVAL_S * 1000, 1.0f, 130);
+    FakeScd30 b(INTERVAL_S * 1000, 1.0f, 130);
+    RunResult baseline = run(a, SCD30_BASELINE_POLL_MS, RUN_MS, false, INTERVAL_S);
+    RunResult paced    = run(b, SENSOR_POLL_CO2_MS, RUN_MS, true, INTERVAL_S);
+
+    uint32_t baseline_per_min = baseline.transactions * 60000 / RUN_MS;
+    uint32_t paced_per_min    = paced.transactions * 60000 / RUN_MS;
+    TEST_ASSERT_EQUAL_UINT32(baseline.samples, paced.samples);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(baseline_per_min / 2, paced_per_min);
+}
+
+void test_drifting_sensor_clock_loses_no_samples() {
+    // SCD30 clock ±3% off: every sample still read. A fast clock lets latency
+    // creep between early reads, by at most the read lead.
+    const float ratios[] = { 0.97f, 1.03f };
+    for (float ratio : ratios) {
+        FakeScd30 dev(SCD30_MEASUREMENT_INTERVAL_S * 1000, ratio, 130);
+        RunResult r = run(dev, SENSOR_POLL_CO2_MS, RUN_MS, true);
+        TEST_ASSERT_EQUAL_UINT32(0, r.skipped);
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(SENSOR_POLL_CO2_MS + SCD30_READY_LEAD_MS, r.max_lag_ms);
+    }
+}
+
+void test_counters_track_errors_per_device() {
+    I2cCounters.record(I2cDevice::SCD30, 2, false);
+    I2cCounters.record(I2cDevice::SHT45, 2);
+    TEST_ASSERT_EQUAL_UINT32(2, I2cCounters.transactions(I2cDevice::SCD30));
+    TEST_ASSERT_EQUAL_UINT32(1, I2cCounters.errors(I2cDevice::SCD30));
+    TEST_ASSERT_EQUAL_UINT32(0, I2cCounters.errors(I2cDevice::SHT45));
+    TEST_ASSERT_EQUAL_UINT32(0, I2cCounters.transactions(I2cDevice::TCA9548A));
+}
+
+int main(int /*argc*/, char** /*argv*/) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_unsynced_pacer_probes_every_poll);
+    RUN_TEST(test_in_phase_reads_directly_at_deadline);
+    RUN_TEST(test_stale_read_retries_next_poll);
+    RUN_TEST(test_periodic_early_read);
+    RUN_TEST(test_early_reads_back_off_while_in_phase);
+    RUN_TEST(test_set_interval_resyncs);
+    RUN_TEST(test_wraparound);
+    RUN_TEST(test_default_interval_one_read_per_sample);
+    RUN_TEST(test_long_interval_traffic_per_minute_halved);
+    RUN_TEST(test_drifting_sensor_clock_loses_no_samples);
+    RUN_TEST(test_counters_track_errors_per_device);
+
+    return UNITY_END();
+}
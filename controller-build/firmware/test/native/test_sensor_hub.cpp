@@ -0,0 +1,383 @@
+/**
+ * test_sensor_hub.cpp — Unit tests for SensorHubCore scheduling and aggregation.
+ *
+ * Binds the hub to fake drivers that return scripted readings and advance a
+ * virtual clock by a scripted latency per call, so poll cadence, per-cycle
+ * cost, per-channel filtering and RH aggregation can be checked without any
+ * sensor hardware.
+ */
+
+#include <unity.h>
+#include "../../src/sensors/sensor_hub.h"
+#include "../../include/config.h"
+
+// ── Fake drivers ──────────────────────────────────────────────────────────────
+
+struct FakeDrivers {
+    uint32_t clock_ms = 0;
+
+    // Scripted per-call latency (ms the virtual clock advances)
+    uint32_t co2_cost = 0, rh_cost = 0, temp_cost = 0, light_cost = 0;
+
+    // Scripted readings
+    bool                     co2_fresh = true;
+    Co2Reading               co2       = {800.0f, 22.0f, 60.0f, true, 0};
+    std::array<RhReading, 3> rh        = {};
+    bool                     rh_fresh  = true;    // False = SHT45s hand back their last reading
+    uint32_t                 rh_ts     = 0;
+    std::array<TempProbeReading, DS18B20_PROBE_COUNT> temps = {};
+    bool                     light_ready = false;
+    bool                     water_valid = false;
+    float                    water_pct   = 0.0f;
+
+    // Observations
+    uint32_t     begins = 0, co2_calls = 0, rh_calls = 0, temp_calls = 0, light_calls = 0;
+    uint16_t     co2_interval_s = 0;
+    ShtPrecision rh_precision   = ShtPrecision::LOW_PREC;
+    uint32_t     rh_recovery_ms = 0;
+    LightMode    light_mode     = LightMode::REDUCED;
+
+    uint32_t now() { return clock_ms; }
+    void     begin() { begins++; }
+    void     setCo2Interval(uint16_t s) { co2_interval_s = s; }
+
+    std::optional<Co2Reading> readCo2(uint32_t now_ms) {
+        co2_calls++;
+        clock_ms += co2_cost;
+        if (!co2_fresh) return std::nullopt;
+        Co2Reading r   = co2;
+        r.timestamp_ms = now_ms;
+        return r;
+    }
+
+    std::array<RhReading, 3> readRh(uint32_t now_ms, ShtPrecision p, uint32_t recovery_ms) {
+        rh_calls++;
+        clock_ms      += rh_cost;
+        rh_precision   = p;
+        rh_recovery_ms = recovery_ms;
+        if (rh_fresh) rh_ts = now_ms;
+        std::array<RhReading, 3> out = rh;
+        for (auto& r : out) r.timestamp_ms = rh_ts;
+        return out;
+    }
+
+    const std::array<TempProbeReading, DS18B20_PROBE_COUNT>& readTemps(uint32_t) {
+        temp_calls++;
+        clock_ms += temp_cost;
+        return temps;
+    }
+
+    bool readLight(uint32_t now_ms, LightMode m, LightReading& out) {
+        light_calls++;
+        clock_ms  += light_cost;
+        light_mode = m;
+        if (!light_ready) return false;
+        out              = {};
+        out.channels[0]  = 1234;
+        out.valid        = true;
+        out.timestamp_ms = now_ms;
+        return true;
+    }
+
+    bool readWaterLevel(float& pct) {
+        pct = water_pct;
+        return water_valid;
+    }
+};
+
+using Hub = SensorHubCore<FakeDrivers>;
+
+static Hub*         hub;
+static FakeDrivers* drv;
+
+/** setRh(shelf, rh, temp, valid, blackout) — Script one shelf's reading. */
+static void setRh(int shelf, float rh, float temp, bool valid = true, bool blackout = false) {
+    drv->rh[shelf] = {rh, temp, valid, blackout, 0};
+}
+
+/** runFor(ms) — Run the sensor task loop against the virtual clock. */
+static void runFor(uint32_t ms) {
+    uint32_t end = drv->clock_ms + ms;
+    while (static_cast<int32_t>(drv->clock_ms - end) < 0) {
+        uint32_t wait = hub->runDue();
+        drv->clock_ms += wait ? wait : 1;
+    }
+}
+
+static SensorSnapshot snapshot() {
+    SensorSnapshot s = {};
+    TEST_ASSERT_TRUE(hub->read(s));
+    return s;
+}
+
+void setUp() {
+    hub = new Hub();
+    drv = &hub->drivers();
+    setRh(0, 60.0f, 20.0f);
+    setRh(1, 70.0f, 22.0f);
+    setRh(2, 80.0f, 24.0f);
+}
+
+void tearDown() {
+    delete hub;
+}
+
+// ── Tests ─────────────────────────────────────────────────────────────────────
+
+void test_start_initialises_drivers_without_polling() {
+    hub->start();
+    TEST_ASSERT_EQUAL_UINT32(1, drv->begins);
+    TEST_ASSERT_EQUAL_UINT16(SCD30_MEASUREMENT_INTERVAL_S, drv->co2_interval_s);
+    TEST_ASSERT_EQUAL_UINT32(0, hub->generation());
+
+    SensorSnapshot s;
+    TEST_ASSERT_FALSE(hub->read(s));
+}
+
+void test_drivers_run_at_their_own_cadence() {
+    hub->start();
+    runFor(60000);
+    TEST_ASSERT_EQUAL_UINT32(60000 / SENSOR_POLL_CO2_MS,   drv->co2_calls);
+    TEST_ASSERT_EQUAL_UINT32(60000 / SENSOR_POLL_RH_MS,    drv->rh_calls);
+    TEST_ASSERT_EQUAL_UINT32(60000 / SENSOR_POLL_TEMP_MS,  drv->temp_calls);
+    TEST_ASSERT_EQUAL_UINT32(60000 / SENSOR_POLL_LIGHT_MS, drv->light_calls);
+}
+
+void test_publishes_once_per_runDue_with_work() {
+    hub->start();
+    hub->runDue();                                    // CO2 due at phase 0
+    TEST_ASSERT_EQUAL_UINT32(1, hub->generation());
+    hub->runDue();                                    // Nothing due yet
+    TEST_ASSERT_EQUAL_UINT32(1, hub->generation());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 800.0f, snapshot().co2.co2_ppm);
+}
+
+void test_rh_average_excludes_invalid_shelves() {
+    setRh(2, 99.0f, 30.0f, false);
+    hub->start();
+    runFor(SENSOR_PHASE_RH_MS + 1);
+    SensorSnapshot s = snapshot();
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 65.0f, s.rh_aggregate_pct);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 21.0f, s.temp_aggregate_c);
+}
+
+void test_rh_min_and_max_modes() {
+    hub->start();
+    hub->setRhAggregation(RhAggregation::MIN);
+    runFor(SENSOR_PHASE_RH_MS + 1);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 60.0f, snapshot().rh_aggregate_pct);
+
+    hub->setRhAggregation(RhAggregation::MAX);
+    runFor(SENSOR_POLL_RH_MS);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 80.0f, snapshot().rh_aggregate_pct);
+}
+
+void test_heater_blackout_shelf_excluded() {
+    setRh(2, 40.0f, 35.0f, true, true);               // Hot and dry after a pulse
+    hub->start();
+    hub->setRhAggregation(RhAggregation::MIN);
+    runFor(SENSOR_PHASE_RH_MS + 1);
+    SensorSnapshot s = snapshot();
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 60.0f, s.rh_aggregate_pct);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 21.0f, s.temp_aggregate_c);
+    TEST_ASSERT_TRUE(s.rh[2].heater_blackout);        // Still reported per shelf
+}
+
+void test_no_valid_shelves_zeroes_aggregate() {
+    for (int i = 0; i < 3; ++i) setRh(i, 50.0f, 20.0f, false);
+    hub->start();
+    runFor(SENSOR_PHASE_RH_MS + 1);
+    SensorSnapshot s = snapshot();
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, s.rh_aggregate_pct);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, s.temp_aggregate_c);
+}
+
+void test_co2_goes_stale_without_fresh_samples() {
+    hub->start();
+    runFor(1000);
+    TEST_ASSERT_TRUE(snapshot().co2.valid);
+
+    drv->co2_fresh = false;
+    runFor(SENSOR_STALE_MS - 1000);
+    TEST_ASSERT_TRUE(snapshot().co2.valid);           // Last sample < SENSOR_STALE_MS old
+    runFor(2000);
+    TEST_ASSERT_FALSE(snapshot().co2.valid);
+}
+
+void test_cycle_cost_measured_from_driver_latency() {
+    drv->co2_cost   = 5;
+    drv->rh_cost    = 20;
+    drv->light_cost = 30;
+    hub->start();
+
+    hub->runDue();                                    // t=0: CO2 alone
+    TEST_ASSERT_EQUAL_UINT32(5, hub->lastCycleMs());
+
+    drv->clock_ms = SENSOR_PHASE_RH_MS;
+    hub->runDue();
+    TEST_ASSERT_EQUAL_UINT32(20, hub->lastCycleMs());
+
+    drv->clock_ms = SENSOR_PHASE_LIGHT_MS;            // TEMP, CO2 and LIGHT all due
+    hub->runDue();
+    TEST_ASSERT_EQUAL_UINT32(35, hub->lastCycleMs());
+
+    drv->clock_ms = 2 * SENSOR_POLL_CO2_MS;
+    hub->runDue();
+    TEST_ASSERT_EQUAL_UINT32(5, hub->lastCycleMs());
+    TEST_ASSERT_EQUAL_UINT32(35, hub->maxCycleMs());
+}
+
+void test_slow_driver_delays_others_but_keeps_cadence() {
+    drv->temp_cost = 400;                             // Pathological blocking driver
+    hub->start();
+    runFor(60000);
+    // Deadlines advance by whole periods, so nothing drifts or bursts
+    TEST_ASSERT_EQUAL_UINT32(60000 / SENSOR_POLL_RH_MS,   drv->rh_calls);
+    TEST_ASSERT_EQUAL_UINT32(60000 / SENSOR_POLL_TEMP_MS, drv->temp_calls);
+    TEST_ASSERT_EQUAL_UINT32(400, hub->maxCycleMs());
+}
+
+void test_runtime_settings_forwarded_to_drivers() {
+    hub->start();
+    hub->setRhPrecision(ShtPrecision::MEDIUM_PREC);
+    hub->setHeaterRecovery(12345);
+    hub->setLightMode(LightMode::FULL);
+    SensorPollConfig cfg;
+    cfg.scd30_interval_s = 10;
+    hub->setPollConfig(cfg);
+
+    runFor(SENSOR_PHASE_LIGHT_MS + 1);
+    TEST_ASSERT_EQUAL_UINT16(10, drv->co2_interval_s);
+    TEST_ASSERT_TRUE(drv->rh_precision == ShtPrecision::MEDIUM_PREC);
+    TEST_ASSERT_EQUAL_UINT32(12345, drv->rh_recovery_ms);
+    TEST_ASSERT_TRUE(drv->light_mode == LightMode::FULL);
+}
+
+void test_light_and_water_level_only_update_when_ready() {
+    hub->start();
+    runFor(SENSOR_PHASE_LIGHT_MS + 1);
+    SensorSnapshot s = snapshot();
+    TEST_ASSERT_FALSE(s.light.valid);
+    TEST_ASSERT_FALSE(s.water_level_valid);
+
+    drv->light_ready = true;
+    drv->water_valid = true;
+    drv->water_pct   = 42.0f;
+    runFor(SENSOR_POLL_LIGHT_MS);
+    s = snapshot();
+    TEST_ASSERT_TRUE(s.light.valid);
+    TEST_ASSERT_EQUAL_UINT16(1234, s.light.channels[0]);
+    TEST_ASSERT_TRUE(s.water_level_valid);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 42.0f, s.water_level_pct);
+}
+
+void test_co2_spike_replaced_by_window_median() {
+    hub->start();
+    runFor(2000);                                     // Four clean samples
+    drv->co2.co2_ppm = 5000.0f;                       // One glitched frame
+    runFor(SENSOR_POLL_CO2_MS);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 800.0f, snapshot().co2.co2_ppm);
+
+    drv->co2.co2_ppm = 900.0f;                        // Real step: held until the window agrees
+    runFor(SENSOR_POLL_CO2_MS);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 800.0f, snapshot().co2.co2_ppm);
+    runFor(SENSOR_POLL_CO2_MS);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 900.0f, snapshot().co2.co2_ppm);
+}
+
+void test_blackout_shelf_bypasses_rh_filter() {
+    hub->start();
+    runFor(SENSOR_PHASE_RH_MS + 4 * SENSOR_POLL_RH_MS);
+    setRh(0, 40.0f, 35.0f, true, true);               // Heater pulse: raw value published
+    runFor(SENSOR_POLL_RH_MS);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 40.0f, snapshot().rh[0].rh_pct);
+
+    setRh(0, 60.5f, 20.0f);                           // History unaffected by the pulse
+    runFor(SENSOR_POLL_RH_MS);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 60.5f, snapshot().rh[0].rh_pct);
+}
+
+// ── Publish hooks ─────────────────────────────────────────────────────────────
+
+struct HookLog {
+    uint32_t calls    = 0;
+    uint32_t last_gen = 0;
+};
+
+static void recordHook(void* ctx, uint32_t gen) {
+    auto* log = static_cast<HookLog*>(ctx);
+    log->calls++;
+    log->last_gen = gen;
+}
+
+void test_publish_hooks_fire_once_per_snapshot() {
+    HookLog a, b;
+    TEST_ASSERT_TRUE(hub->onPublish(&recordHook, &a));
+    TEST_ASSERT_TRUE(hub->onPublish(&recordHook, &b));
+    hub->start();
+
+    hub->runDue();                                    // Publishes generation 1
+    hub->runDue();                                    // Nothing due — no hook
+    TEST_ASSERT_EQUAL_UINT32(1, a.calls);
+    TEST_ASSERT_EQUAL_UINT32(1, a.last_gen);
+
+    runFor(10000);
+    TEST_ASSERT_EQUAL_UINT32(hub->generation(), a.calls);
+    TEST_ASSERT_EQUAL_UINT32(hub->generation(), b.last_gen);
+
+    SensorSnapshot s;
+    TEST_ASSERT_EQUAL_UINT32(hub->generation(), hub->readGen(s));
+}
+
+void test_poll_without_new_data_publishes_nothing() {
+    HookLog log;
+    TEST_ASSERT_TRUE(hub->onPublish(&recordHook, &log));
+    hub->start();
+    runFor(2000);                                     // Every driver has run at least once
+    uint32_t gen   = hub->generation();
+    uint32_t calls = drv->co2_calls + drv->rh_calls + drv->temp_calls + drv->light_calls;
+    TEST_ASSERT_TRUE(gen > 0);
+
+    // SCD30 has no sample, SHT45s repeat theirs, probes and AS7341 idle
+    drv->co2_fresh = false;
+    drv->rh_fresh  = false;
+    runFor(SENSOR_STALE_MS / 2);
+    TEST_ASSERT_TRUE(drv->co2_calls + drv->rh_calls + drv->temp_calls + drv->light_calls > calls + 10);
+    TEST_ASSERT_EQUAL_UINT32(gen, hub->generation());
+    TEST_ASSERT_EQUAL_UINT32(gen, log.calls);         // Subscribers not woken
+
+    drv->rh_fresh = true;                             // One new RH sample publishes again
+    runFor(SENSOR_POLL_RH_MS);
+    TEST_ASSERT_EQUAL_UINT32(gen + 1, hub->generation());
+}
+
+void test_publish_hooks_capped() {
+    HookLog log;
+    for (int i = 0; i < SENSOR_MAX_SUBSCRIBERS; ++i) TEST_ASSERT_TRUE(hub->onPublish(&recordHook, &log));
+    TEST_ASSERT_FALSE(hub->onPublish(&recordHook, &log));
+    hub->start();
+    hub->runDue();
+    TEST_ASSERT_EQUAL_UINT32(SENSOR_MAX_SUBSCRIBERS, log.calls);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_start_initialises_drivers_without_polling);
+    RUN_TEST(test_drivers_run_at_their_own_cadence);
+    RUN_TEST(test_publishes_once_per_runDue_with_work);
+    RUN_TEST(test_rh_average_excludes_invalid_shelves);
+    RUN_TEST(test_rh_min_and_max_modes);
+    RUN_TEST(test_heater_blackout_shelf_excluded);
+    RUN_TEST(test_no_valid_shelves_zeroes_aggregate);
+    RUN_TEST(test_co2_goes_stale_without_fresh_samples);
+    RUN_TEST(test_cycle_cost_measured_from_driver_latency);
+    RUN_TEST(test_slow_driver_delays_others_but_keeps_cadence);
+    RUN_TEST(test_runtime_settings_forwarded_to_drivers);
+    RUN_TEST(test_light_and_water_level_only_update_when_ready);
+    RUN_TEST(test_co2_spike_replaced_by_window_median);
+    RUN_TEST(test_blackout_shelf_bypasses_rh_filter);
+    RUN_TEST(test_publish_hooks_fire_once_per_snapshot);
+    RUN_TEST(test_poll_without_new_data_publishes_nothing);
+    RUN_TEST(test_publish_hooks_capped);
+    return UNITY_END();
+}
@@ -0,0 +1,278 @@
+/**
+ * test_telemetry_frame.cpp — Unit tests for the binary WebSocket telemetry
+ * frames: quantisation, exact byte layout, round trip, version checks, and
+ * the per-client delta stream (keyframes, deadbands, immediate relay changes).
+ */
+
+#include <unity.h>
+#include "../../src/web/telemetry_frame.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+void setUp()    {}
+void tearDown() {}
+
+static PublishFrame sampleFrame() {
+    PublishFrame f = {};
+    f.ts_ms                 = 0x01020304;
+    f.snap.co2.co2_ppm      = 812.4f;
+    f.snap.rh_aggregate_pct = 88.125f;
+    f.snap.rh[0].rh_pct     = 87.5f;
+    f.snap.rh[1].rh_pct     = 88.0f;
+    f.snap.rh[2].rh_pct     = 88.875f;
+    f.snap.temp_probe[0]    = 21.5f;
+    f.snap.temp_probe[4]    = -3.25f;
+    f.snap.water_level_pct  = 55.55f;
+    f.relay_mask            = 0x41;
+    f.armed                 = true;
+    f.manual_mode           = false;
+    return f;
+}
+
+// ── Quantisation ──────────────────────────────────────────────────────────────
+
+void test_fields_are_fixed_point_wire_units() {
+    TelemetryFields t = telemetryFields(sampleFrame());
+    TEST_ASSERT_EQUAL_UINT32(0x01020304, t.t);
+    TEST_ASSERT_EQUAL_UINT32(812, t.co2);
+    TEST_ASSERT_EQUAL_UINT32(8813, t.rh_a);           // 88.125 rounds half away from zero
+    TEST_ASSERT_EQUAL_UINT32(8750, t.rh[0]);
+    TEST_ASSERT_EQUAL_UINT32(8888, t.rh[2]);
+    TEST_ASSERT_EQUAL_INT(2150, t.tp[0]);
+    TEST_ASSERT_EQUAL_INT(-325, t.tp[4]);
+    TEST_ASSERT_EQUAL_UINT32(5555, t.wl);
+    TEST_ASSERT_EQUAL_UINT32(0x41, t.rl);
+    TEST_ASSERT_EQUAL_UINT32(TELEMETRY_FLAG_ARMED, t.flags);
+}
+
+void test_out_of_range_values_saturate() {
+    PublishFrame f = {};
+    f.snap.co2.co2_ppm      = 70000.0f;
+    f.snap.rh_aggregate_pct = -5.0f;
+    f.snap.temp_probe[0]    = 1000.0f;               // ×100 overflows int16
+    f.snap.temp_probe[1]    = -1000.0f;
+    f.snap.temp_probe[2]    = NAN;
+    f.manual_mode           = true;
+    TelemetryFields t = telemetryFields(f);
+    TEST_ASSERT_EQUAL_UINT32(65535, t.co2);
+    TEST_ASSERT_EQUAL_UINT32(0, t.rh_a);
+    TEST_ASSERT_EQUAL_INT(32767, t.tp[0]);
+    TEST_ASSERT_EQUAL_INT(-32768, t.tp[1]);
+    TEST_ASSERT_EQUAL_INT(0, t.tp[2]);
+    TEST_ASSERT_EQUAL_UINT32(TELEMETRY_FLAG_MANUAL, t.flags);
+}
+
+// ── Wire format ───────────────────────────────────────────────────────────────
+
+void test_encoded_layout_is_packed_little_endian() {
+    uint8_t buf[64];
+    size_t  n = telemetryEncode(telemetryFields(sampleFrame()), buf, sizeof(buf));
+    TEST_ASSERT_EQUAL(TELEMETRY_FULL_SIZE, n);
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_SCHEMA_VERSION, buf[0]);
+    TEST_ASSERT_EQUAL_UINT8(0, buf[1]);                          // FULL
+    const uint8_t t[] = {0x04, 0x03, 0x02, 0x01};
+    TEST_ASSERT_EQUAL_MEMORY(t, buf + 2, 4);
+    TEST_ASSERT_EQUAL_UINT32(812, buf[6] | (buf[7] << 8));
+    TEST_ASSERT_EQUAL_UINT32(8750, buf[10] | (buf[11] << 8));     // rh[0]
+    TEST_ASSERT_EQUAL_INT(-325, static_cast<int16_t>(buf[24] | (buf[25] << 8)));  // tp[4]
+    TEST_ASSERT_EQUAL_UINT32(5555, buf[26] | (buf[27] << 8));
+    TEST_ASSERT_EQUAL_UINT8(0x41, buf[28]);
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_FLAG_ARMED, buf[29]);
+}
+
+void test_encode_refuses_short_buffer() {
+    uint8_t buf[TELEMETRY_FULL_SIZE - 1];
+    TEST_ASSERT_EQUAL(0u, telemetryEncode(telemetryFields(sampleFrame()), buf, sizeof(buf)));
+}
+
+void test_round_trip() {
+    TelemetryFields in = telemetryFields(sampleFrame());
+    uint8_t buf[TELEMETRY_FULL_SIZE];
+    telemetryEncode(in, buf, sizeof(buf));
+
+    TelemetryFields out = {};
+    TEST_ASSERT_TRUE(telemetryDecode(buf, sizeof(buf), out));
+    TEST_ASSERT_EQUAL_UINT32(in.t, out.t);
+    TEST_ASSERT_EQUAL_UINT32(in.co2, out.co2);
+    TEST_ASSERT_EQUAL_UINT32(in.rh_a, out.rh_a);
+    for (int i = 0; i < 3; ++i) TEST_ASSERT_EQUAL_UINT32(in.rh[i], out.rh[i]);
+    for (int i = 0; i < 5; ++i) TEST_ASSERT_EQUAL_INT(in.tp[i], out.tp[i]);
+    TEST_ASSERT_EQUAL_UINT32(in.wl, out.wl);
+    TEST_ASSERT_EQUAL_UINT8(in.rl, out.rl);
+    TEST_ASSERT_EQUAL_UINT8(in.flags, out.flags);
+}
+
+void test_decoder_rejects_unknown_version_and_short_frames() {
+    uint8_t buf[TELEMETRY_FULL_SIZE];
+    telemetryEncode(telemetryFields(sampleFrame()), buf, sizeof(buf));
+    TelemetryFields out = {};
+
+    TEST_ASSERT_FALSE(telemetryDecode(buf, sizeof(buf) - 1, out));
+    buf[0] = TELEMETRY_SCHEMA_VERSION + 1;
+    TEST_ASSERT_FALSE(telemetryDecode(buf, sizeof(buf), out));
+    buf[0] = TELEMETRY_SCHEMA_VERSION;
+    buf[1] = 0x7F;                                               // Unknown kind
+    TEST_ASSERT_FALSE(telemetryDecode(buf, sizeof(buf), out));
+}
+
+void test_binary_frame_is_several_times_smaller_than_json() {
+    // Same fields as WsBroadcaster::_buildJson(), as ArduinoJson prints them
+    char json[256];
+    int  n = snprintf(json, sizeof(json),
+                      "{\"t\":%u,\"co2\":%g,\"rh_a\":%g,\"rh\":[%g,%g,%g],\"tp\":[%g,%g,%g,%g,%g],"
+                      "\"wl\":%g,\"rl\":65,\"am\":true,\"mm\":false}",
+                      123456789u, 812.4321, 88.12345, 87.51234, 88.01234, 88.87654,
+                      21.5625, 21.4375, 20.9375, 21.0625, 21.1875, 55.55123);
+    printf("telemetry frame: json %d bytes, binary %u bytes\n", n, static_cast<unsigned>(TELEMETRY_FULL_SIZE));
+    TEST_ASSERT_TRUE(static_cast<size_t>(n) >= 3 * TELEMETRY_FULL_SIZE);
+}
+
+// ── DELTA frames ──────────────────────────────────────────────────────────────
+
+void test_delta_carries_only_masked_fields() {
+    TelemetryFields f = telemetryFields(sampleFrame());
+    uint8_t  buf[TELEMETRY_MAX_SIZE];
+    uint16_t mask = (1u << TF_CO2) | (1u << (TF_TP0 + 4)) | (1u << TF_RL);
+    size_t   n    = telemetryEncodeDelta(f, mask, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL(8u + 2 + 2 + 1, n);
+    TEST_ASSERT_EQUAL_UINT8(1, buf[1]);                          // DELTA
+    TEST_ASSERT_EQUAL_UINT32(mask, buf[6] | (buf[7] << 8));
+
+    // Applied on top of an older state, only the masked fields change
+    TelemetryFields state = {};
+    state.rh_a = 1234;
+    TEST_ASSERT_TRUE(telemetryDecode(buf, n, state));
+    TEST_ASSERT_EQUAL_UINT32(f.t, state.t);
+    TEST_ASSERT_EQUAL_UINT32(812, state.co2);
+    TEST_ASSERT_EQUAL_INT(-325, state.tp[4]);
+    TEST_ASSERT_EQUAL_UINT8(0x41, state.rl);
+    TEST_ASSERT_EQUAL_UINT32(1234, state.rh_a);
+    TEST_ASSERT_FALSE(telemetryDecode(buf, n - 1, state));       // Truncated payload
+}
+
+/** offer(s, f, t) — Offer fields at time t; returns the frame kind sent, or -1 for none. */
+static int offer(TelemetryStream& s, TelemetryFields& f, uint32_t t, size_t* len = nullptr) {
+    uint8_t buf[TELEMETRY_MAX_SIZE];
+    f.t      = t;
+    size_t n = s.next(f, buf, sizeof(buf));
+    if (len) *len = n;
+    return n ? buf[1] : -1;
+}
+
+void test_stream_starts_with_keyframe_and_repeats_it() {
+    TelemetryStream s;
+    TelemetryFields f = telemetryFields(sampleFrame());
+    TEST_ASSERT_EQUAL_INT(0, offer(s, f, 1000));                 // First frame: FULL
+    TEST_ASSERT_EQUAL_INT(-1, offer(s, f, 3000));                // Nothing changed
+    TEST_ASSERT_EQUAL_INT(0, offer(s, f, 1000 + WS_KEYFRAME_MS));
+    s.reset();
+    TEST_ASSERT_EQUAL_INT(0, offer(s, f, 2000 + WS_KEYFRAME_MS));
+}
+
+void test_stream_applies_deadband_against_last_sent() {
+    TelemetryStream s;
+    TelemetryFields f = telemetryFields(sampleFrame());
+    offer(s, f, 0);
+
+    f.rh[0] += 10;                                               // 0.1 % < 0.2 % deadband
+    TEST_ASSERT_EQUAL_INT(-1, offer(s, f, WS_BROADCAST_PERIOD_MS));
+    f.rh[0] += 10;                                               // Drifted 0.2 % since last sent
+    size_t n = 0;
+    TEST_ASSERT_EQUAL_INT(1, offer(s, f, 2 * WS_BROADCAST_PERIOD_MS, &n));
+    TEST_ASSERT_EQUAL(8u + 2, n);                                // Just rh[0]
+    TEST_ASSERT_EQUAL_INT(-1, offer(s, f, 3 * WS_BROADCAST_PERIOD_MS));
+}
+
+void test_stream_holds_analog_changes_to_cadence() {
+    TelemetryStream s;
+    TelemetryFields f = telemetryFields(sampleFrame());
+    offer(s, f, 0);
+    f.co2 += 100;
+    TEST_ASSERT_EQUAL_INT(-1, offer(s, f, 500));                 // Mid-period: wait
+    TEST_ASSERT_EQUAL_INT(1, offer(s, f, WS_BROADCAST_PERIOD_MS));
+}
+
+void test_stream_pushes_relay_changes_immediately() {
+    TelemetryStream s;
+    TelemetryFields f = telemetryFields(sampleFrame());
+    offer(s, f, 0);
+    f.rl ^= 0x01;
+    f.co2 += 100;                                                // Not due until the cadence
+    uint8_t buf[TELEMETRY_MAX_SIZE];
+    f.t      = 300;
+    size_t n = s.next(f, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL(8u + 1, n);
+    TEST_ASSERT_EQUAL_UINT32(1u << TF_RL, buf[6] | (buf[7] << 8));
+
+    f.flags |= TELEMETRY_FLAG_MANUAL;
+    TEST_ASSERT_EQUAL_INT(1, offer(s, f, 400));
+    TEST_ASSERT_EQUAL_INT(1, offer(s, f, WS_BROADCAST_PERIOD_MS));   // Now the CO₂
+    TEST_ASSERT_EQUAL_INT(-1, offer(s, f, 2 * WS_BROADCAST_PERIOD_MS));
+}
+
+void test_stream_decodes_to_current_state() {
+    // Whatever the stream sends, a decoder following it stays within the deadband
+    TelemetryStream s;
+    TelemetryFields f = telemetryFields(sampleFrame());
+    TelemetryFields view = {};
+    TelemetryDeadband db;
+    uint32_t seed = 3;
+    for (uint32_t t = 0; t < 600000; t += 1000) {
+        seed = seed * 1664525u + 1013904223u;
+        f.co2   = static_cast<uint16_t>(f.co2 + (seed >> 29) - 3);
+        f.rh[1] = static_cast<uint16_t>(f.rh[1] + ((seed >> 20) & 15) - 7);
+        if ((seed >> 8) % 37 == 0) f.rl ^= 0x04;
+        f.t = t;
+        uint8_t buf[TELEMETRY_MAX_SIZE];
+        size_t  n = s.next(f, buf, sizeof(buf));
+        if (n) TEST_ASSERT_TRUE(telemetryDecode(buf, n, view));
+        TEST_ASSERT_EQUAL_UINT8(f.rl, view.rl);                  // Relays never lag
+        if (t % WS_BROADCAST_PERIOD_MS == 0) {
+            TEST_ASSERT_TRUE(std::abs(f.co2 - view.co2) < db.co2);
+            TEST_ASSERT_TRUE(std::abs(f.rh[1] - view.rh[1]) < db.rh);
+        }
+    }
+}
+
+void test_steady_state_bandwidth_drops() {
+    // One hour at 1 frame/s with sensor-noise-sized wobble
+    TelemetryStream s;
+    TelemetryFields f = telemetryFields(sampleFrame());
+    uint32_t seed = 11;
+    size_t   delta_bytes = 0, full_bytes = 0;
+    for (uint32_t t = 0; t < 3600000; t += 1000) {
+        seed = seed * 1664525u + 1013904223u;
+        TelemetryFields g = f;
+        g.co2   = static_cast<uint16_t>(f.co2 + (seed >> 30));           // ±3 ppm
+        g.rh_a  = static_cast<uint16_t>(f.rh_a + ((seed >> 24) & 7));     // < 0.1 %
+        g.tp[0] = static_cast<int16_t>(f.tp[0] + ((seed >> 16) & 3));     // 0.03 °C
+        size_t n = 0;
+        offer(s, g, t, &n);
+        delta_bytes += n;
+        if (t % WS_BROADCAST_PERIOD_MS == 0) full_bytes += TELEMETRY_FULL_SIZE;
+    }
+    printf("telemetry 1 h steady state: full %u bytes, delta %u bytes\n",
+           static_cast<unsigned>(full_bytes), static_cast<unsigned>(delta_bytes));
+    TEST_ASSERT_TRUE(delta_bytes * 10 < full_bytes);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_fields_are_fixed_point_wire_units);
+    RUN_TEST(test_out_of_range_values_saturate);
+    RUN_TEST(test_encoded_layout_is_packed_little_endian);
+    RUN_TEST(test_encode_refuses_short_buffer);
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_decoder_rejects_unknown_version_and_short_frames);
+    RUN_TEST(test_binary_frame_is_several_times_smaller_than_json);
+    RUN_TEST(test_delta_carries_only_masked_fields);
+    RUN_TEST(test_stream_starts_with_keyframe_and_repeats_it);
+    RUN_TEST(test_stream_applies_deadband_against_last_sent);
+    RUN_TEST(test_stream_holds_analog_changes_to_cadence);
+    RUN_TEST(test_stream_pushes_relay_changes_immediately);
+    RUN_TEST(test_stream_decodes_to_current_state);
+    RUN_TEST(test_steady_state_bandwidth_drops);
+    return UNITY_END();
+}
@@ -0,0 +1,250 @@
+/**
+ * test_temp_probe.cpp — Unit tests for split-phase DS18B20 reads.
+ *
+ * Runs TempProbes against a fake 1-Wire bus that models standard-speed bus
+ * time (reset ≈ 960 µs, byte ≈ 530 µs) and can corrupt scratchpads, so the
+ * per-call bus cost (under 10 ms), CRC retries on later calls and the retry
+ * bound can be checked without hardware.
+ */
+
+#include <unity.h>
+#include "../../src/sensors/temp_probe.h"
+#include "../../include/config.h"
+#include <algorithm>
+#include <cstring>
+
+// ── Fake bus ──────────────────────────────────────────────────────────────────
+
+class FakeOneWireBus : public OneWireBus {
+public:
+    static constexpr uint32_t RESET_US = 960;
+    static constexpr uint32_t BYTE_US  = 530;
+
+    uint8_t  count          = 3;
+    float    temps[DS18B20_PROBE_COUNT] = { 21.5f, 22.0f, -3.25f, 0.0f, 0.0f };
+    int      corrupt_reads  = 0;      // Next N scratchpad reads get a bad CRC
+    bool     present        = true;
+    uint32_t bus_us         = 0;      // Accumulated simulated bus time
+    uint32_t conversions    = 0;
+    uint32_t scratchpad_reads = 0;
+
+    uint8_t search(uint8_t roms[][8], uint8_t max) override {
+        uint8_t n = count < max ? count : max;
+        // Report in descending order so begin() has to sort
+        for (uint8_t i = 0; i < n; ++i) _rom(n - 1 - i, roms[i]);
+        return n;
+    }
+
+    void setResolution(uint8_t) override {}
+
+    bool startConversion() override {
+        bus_us += RESET_US + 2 * BYTE_US;  // Skip ROM + Convert T
+        if (!present) return false;
+        conversions++;
+        return true;
+    }
+
+    bool selectProbe(const uint8_t rom[8]) override {
+        bus_us += RESET_US + 9 * BYTE_US;   // Match ROM + address
+        _selected = rom[1];
+        return present;
+    }
+
+    void readScratchpad(uint8_t out[9]) override {
+        bus_us += 10 * BYTE_US;             // Read Scratchpad + 9 bytes
+        scratchpad_reads++;
+
+        int16_t raw = static_cast<int16_t>(temps[_selected] * 16.0f);
+        memset(out, 0, 9);
+        out[0] = static_cast<uint8_t>(raw & 0xFF);
+        out[1] = static_cast<uint8_t>((raw >> 8) & 0xFF);
+        out[4] = 0x7F;  // 12-bit config register
+        out[5] = 0xFF;
+        out[7] = 0x10;
+        out[8] = onewireCrc8(out, 8);
+        if (corrupt_reads > 0) { corrupt_reads--; out[8] ^= 0x5A; }
+    }
+
+private:
+    uint8_t _selected = 0;
+
+    static void _rom(uint8_t idx, uint8_t out[8]) {
+        memset(out, 0, 8);
+        out[0] = 0x28;   // DS18B20 family code
+        out[1] = idx;    // Index doubles as sort key and temps[] lookup
+    }
+};
+
+static FakeOneWireBus* bus;
+static TempProbes*     probes = nullptr;
+
+void setUp() {
+    static FakeOneWireBus b;
+    b   = FakeOneWireBus{};
+    bus = &b;
+    delete probes;
+    probes = new TempProbes(b);   // Fresh counters per test
+    probes->begin();
+}
+void tearDown() {}
+
+// Run service() until a round completes; returns the max bus time of any call
+static uint32_t run_round(uint32_t& now, uint32_t period_ms) {
+    uint32_t worst = 0;
+    for (int i = 0; i < 50; ++i) {
+        uint32_t before = bus->bus_us;
+        bool done = probes->service(now);
+        if (bus->bus_us - before > worst) worst = bus->bus_us - before;
+        if (done) break;
+        now += period_ms;
+    }
+    return worst;
+}
+
+// ── Helpers ───────────────────────────────────────────────────────────────────
+
+void test_crc8_known_vector() {
+    // ROM from the DS18B20 datasheet example: CRC byte is the last of 8
+    const uint8_t rom[8] = { 0x02, 0x1C, 0xB8, 0x01, 0x00, 0x00, 0x00, 0xA2 };
+    TEST_ASSERT_EQUAL_HEX8(rom[7], onewireCrc8(rom, 7));
+}
+
+void test_conversion_time_by_resolution() {
+    TEST_ASSERT_EQUAL_UINT32(750, TempProbes::conversionTimeMs(12));
+    TEST_ASSERT_EQUAL_UINT32(375, TempProbes::conversionTimeMs(11));
+    TEST_ASSERT_EQUAL_UINT32(187, TempProbes::conversionTimeMs(10));
+    TEST_ASSERT_EQUAL_UINT32(93,  TempProbes::conversionTimeMs(9));
+}
+
+void test_decode_negative_and_masked() {
+    uint8_t sp[9] = { 0x5E, 0xFF };          // -10.125 °C
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, -10.125f, TempProbes::decodeScratchpad(sp, 12));
+    uint8_t sp2[9] = { 0x9F, 0x01 };         // 25.9375 °C; 9-bit drops low bits
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 25.5f, TempProbes::decodeScratchpad(sp2, 9));
+}
+
+// ── Split-phase behaviour ─────────────────────────────────────────────────────
+
+void test_begin_sorts_roms_ascending() {
+    TEST_ASSERT_EQUAL(3, probes->probeCount());
+    for (uint8_t i = 0; i < 3; ++i) TEST_ASSERT_EQUAL(i, probes->getRom(i)[1]);
+    TEST_ASSERT_NULL(probes->getRom(3));
+}
+
+void test_first_service_only_starts_conversion() {
+    TEST_ASSERT_FALSE(probes->service(0));
+    TEST_ASSERT_TRUE(probes->isConverting());
+    TEST_ASSERT_EQUAL_UINT32(1, bus->conversions);
+    TEST_ASSERT_EQUAL_UINT32(0, bus->scratchpad_reads);
+}
+
+void test_no_bus_traffic_before_deadline() {
+    probes->service(0);
+    uint32_t before = bus->bus_us;
+    TEST_ASSERT_FALSE(probes->service(TempProbes::conversionTimeMs(12) - 1));
+    TEST_ASSERT_EQUAL_UINT32(before, bus->bus_us);
+    TEST_ASSERT_EQUAL_UINT32(0, bus->scratchpad_reads);
+}
+
+void test_collects_all_probes_after_deadline() {
+    uint32_t now = 0;
+    run_round(now, SENSOR_POLL_TEMP_MS);
+
+    const auto& r = probes->readings();
+    TEST_ASSERT_TRUE(r[0].valid);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 21.5f,  r[0].temp_c);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 22.0f,  r[1].temp_c);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, -3.25f, r[2].temp_c);
+    TEST_ASSERT_FALSE(r[3].valid);  // Not present
+    TEST_ASSERT_FALSE(r[4].valid);
+    // Next conversion starts on the following call, not in the last read's
+    TEST_ASSERT_EQUAL_UINT32(1, bus->conversions);
+    probes->service(now + SENSOR_POLL_TEMP_MS);
+    TEST_ASSERT_TRUE(probes->isConverting());
+    TEST_ASSERT_EQUAL_UINT32(2, bus->conversions);
+}
+
+void test_per_poll_bus_time_is_one_step() {
+    // The blocking path cost ~750 ms of conversion plus every readback in
+    // one call. Split-phase: no call spends more than one bus step, with
+    // CRC retries included.
+    bus->count = DS18B20_PROBE_COUNT;
+    probes->begin();
+    bus->corrupt_reads = DS18B20_CRC_RETRIES;
+    uint32_t now = 0;
+    uint32_t worst_us = run_round(now, SENSOR_POLL_TEMP_MS);
+    now += SENSOR_POLL_TEMP_MS;
+    worst_us = std::max(worst_us, run_round(now, SENSOR_POLL_TEMP_MS));
+
+    const uint32_t select_us = FakeOneWireBus::RESET_US + 9 * FakeOneWireBus::BYTE_US;
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(select_us, worst_us);
+    TEST_ASSERT_LESS_THAN_UINT32(10000, worst_us);
+}
+
+void test_crc_retry_runs_on_later_calls() {
+    uint32_t now = 0;
+    probes->service(now);                         // Convert T
+    bus->corrupt_reads = 1;
+    now += SENSOR_POLL_TEMP_MS;
+
+    TEST_ASSERT_FALSE(probes->service(now));      // Select probe 0
+    TEST_ASSERT_EQUAL_UINT32(0, bus->scratchpad_reads);
+    TEST_ASSERT_FALSE(probes->service(now += SENSOR_POLL_TEMP_MS));   // Bad CRC
+    TEST_ASSERT_EQUAL_UINT32(1, bus->scratchpad_reads);
+    TEST_ASSERT_FALSE(probes->readings()[0].valid);
+    TEST_ASSERT_FALSE(probes->service(now += SENSOR_POLL_TEMP_MS));   // Select it again
+    TEST_ASSERT_EQUAL_UINT32(1, bus->scratchpad_reads);
+    TEST_ASSERT_FALSE(probes->service(now += SENSOR_POLL_TEMP_MS));   // Re-read
+    TEST_ASSERT_EQUAL_UINT32(2, bus->scratchpad_reads);
+    TEST_ASSERT_TRUE(probes->readings()[0].valid);
+    TEST_ASSERT_EQUAL_UINT32(1, probes->crcErrors());
+}
+
+void test_crc_failure_retried_then_accepted() {
+    uint32_t now = 0;
+    bus->corrupt_reads = DS18B20_CRC_RETRIES;  // Last allowed attempt succeeds
+    run_round(now, SENSOR_POLL_TEMP_MS);
+    TEST_ASSERT_TRUE(probes->readings()[0].valid);
+    TEST_ASSERT_EQUAL_UINT32(DS18B20_CRC_RETRIES, probes->crcErrors());
+}
+
+void test_crc_retries_are_bounded() {
+    uint32_t now = 0;
+    bus->corrupt_reads = 1000;
+    run_round(now, SENSOR_POLL_TEMP_MS);
+    // Each of 3 probes: 1 read + DS18B20_CRC_RETRIES re-reads, then give up
+    TEST_ASSERT_EQUAL_UINT32(3 * (1 + DS18B20_CRC_RETRIES), bus->scratchpad_reads);
+    TEST_ASSERT_FALSE(probes->readings()[0].valid);
+}
+
+void test_last_good_reading_held_until_stale() {
+    uint32_t now = 0;
+    run_round(now, SENSOR_POLL_TEMP_MS);
+    TEST_ASSERT_TRUE(probes->readings()[0].valid);
+    uint32_t t_good = probes->readings()[0].timestamp_ms;
+
+    bus->present = false;
+    probes->service(t_good + SENSOR_STALE_MS);       // Still within window
+    TEST_ASSERT_TRUE(probes->readings()[0].valid);
+    probes->service(t_good + SENSOR_STALE_MS + 1);   // Now stale
+    TEST_ASSERT_FALSE(probes->readings()[0].valid);
+}
+
+int main(int /*argc*/, char** /*argv*/) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_crc8_known_vector);
+    RUN_TEST(test_conversion_time_by_resolution);
+    RUN_TEST(test_decode_negative_and_masked);
+    RUN_TEST(test_begin_sorts_roms_ascending);
+    RUN_TEST(test_first_service_only_starts_conversion);
+    RUN_TEST(test_no_bus_traffic_before_deadline);
+    RUN_TEST(test_collects_all_probes_after_deadline);
+    RUN_TEST(test_per_poll_bus_time_is_one_step);
+    RUN_TEST(test_crc_retry_runs_on_later_calls);
+    RUN_TEST(test_crc_failure_retried_then_accepted);
+    RUN_TEST(test_crc_retries_are_bounded);
+    RUN_TEST(test_last_good_reading_held_until_stale);
+
+    return UNITY_END();
+}
@@ -9,13 +9,14 @@
 #include "../../include/config.h"
 
 // Each test creates a fresh WaterLevel instance
-static WaterLevel wl;
+static WaterLevel* wlp;
+#define wl (*wlp)
 
 void setUp() {
-    wl = WaterLevel{};
+    wlp = new WaterLevel();
     wl.begin();
 }
-void tearDown() {}
+void tearDown() { delete wlp; }
 
 // ── ADC voltage-to-level mapping ──────────────────────────────────────────────
 
@@ -96,6 +97,95 @@ void test_custom_calibration_remaps_range() {
     TEST_ASSERT_FLOAT_WITHIN(2.0f, 50.0f, wl.getLevelPercent());
 }
 
+// ── Window statistics ─────────────────────────────────────────────────────────
+
+void test_window_extremes_and_spread() {
+    wl.setCalibration(1000, 2000);
+    for (int i = 0; i < 32; ++i) wl.injectVoltage(i % 2 ? 1600 : 1400);  // ±10 % slosh
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 50.0f, wl.getLevelPercent());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 40.0f, wl.getLevelMinPercent());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 60.0f, wl.getLevelMaxPercent());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 10.0f, wl.getLevelStdDevPercent());
+
+    for (int i = 0; i < 32; ++i) wl.injectVoltage(1500);                 // Settled
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 50.0f, wl.getLevelMinPercent());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 50.0f, wl.getLevelMaxPercent());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, wl.getLevelStdDevPercent());
+}
+
+void test_level_exact_after_long_run() {
+    wl.setCalibration(1000, 2000);
+    uint32_t seed = 3;
+    for (int i = 0; i < 1000000; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        wl.injectVoltage(1000 + (seed >> 22));             // Noisy, 1000–2023 mV
+    }
+    for (int i = 0; i < 32; ++i) wl.injectVoltage(1250);
+    TEST_ASSERT_EQUAL_FLOAT(25.0f, wl.getLevelPercent());
+}
+
+// ── Oversampled acquisition ───────────────────────────────────────────────────
+
+/** stream(mv_at, ticks) — Feed ticks × WATER_ADC_DECIMATION samples, tick() after each block. */
+template<typename F>
+static void stream(F mv_at, int ticks) {
+    static uint32_t block[WATER_ADC_DECIMATION];
+    static uint32_t n = 0;
+    for (int t = 0; t < ticks; ++t) {
+        for (uint32_t i = 0; i < WATER_ADC_DECIMATION; ++i) block[i] = mv_at(n++);
+        wl.injectSamples(block, WATER_ADC_DECIMATION);
+        wl.tick();
+    }
+}
+
+void test_decimated_stream_rejects_adc_noise() {
+    wl.setCalibration(1000, 2000);
+    uint32_t seed = 9;
+    stream([&](uint32_t) {
+        seed = seed * 1664525u + 1013904223u;
+        return 1500u - 200u + (seed >> 16) % 401u;                // 1500 ± 200 mV noise
+    }, WATER_LEVEL_SAMPLES + WATER_ADC_CIC_ORDER);
+    TEST_ASSERT_TRUE(wl.isValid());
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 50.0f, wl.getLevelPercent());
+    TEST_ASSERT_TRUE(wl.getLevelStdDevPercent() < 1.0f);
+}
+
+void test_decimated_stream_nulls_output_rate_ripple() {
+    wl.setCalibration(1000, 2000);
+    // Square-wave pickup with a period of half a tick: cancels within each block
+    stream([](uint32_t n) { return (n / (WATER_ADC_DECIMATION / 4)) % 2 ? 1800u : 1200u; },
+           WATER_LEVEL_SAMPLES + WATER_ADC_CIC_ORDER);
+    TEST_ASSERT_FLOAT_WITHIN(0.2f, 50.0f, wl.getLevelMinPercent());
+    TEST_ASSERT_FLOAT_WITHIN(0.2f, 50.0f, wl.getLevelMaxPercent());
+}
+
+void test_pump_decision_follows_level_within_seconds() {
+    uint32_t mv_10 = ADC_WATER_LEVEL_MIN_MV + (ADC_WATER_LEVEL_MAX_MV - ADC_WATER_LEVEL_MIN_MV) / 10;
+    uint32_t mv_90 = ADC_WATER_LEVEL_MIN_MV + (ADC_WATER_LEVEL_MAX_MV - ADC_WATER_LEVEL_MIN_MV) * 9 / 10;
+    stream([&](uint32_t) { return mv_10; }, 20);
+    TEST_ASSERT_TRUE(wl.isBelowThreshold());
+
+    // Tank refills: the pump-off threshold must trip within a few ticks
+    int ticks = 0;
+    while (!wl.isAboveThreshold() && ticks < 60) {
+        stream([&](uint32_t) { return mv_90; }, 1);
+        ticks++;
+    }
+    TEST_ASSERT_TRUE(ticks <= WATER_LEVEL_SAMPLES + WATER_ADC_CIC_ORDER);
+}
+
+void test_ring_overflow_keeps_newest_samples() {
+    wl.setCalibration(1000, 2000);
+    static uint32_t block[WATER_ADC_DECIMATION];
+    for (int t = 0; t < 10; ++t) {                                  // tick() stalled 10 blocks
+        for (auto& b : block) b = t < 5 ? 1000 : 2000;
+        wl.injectSamples(block, WATER_ADC_DECIMATION);
+    }
+    wl.tick();
+    TEST_ASSERT_TRUE(wl.isValid());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 100.0f, wl.getLevelPercent());  // Only the newest 4 outputs survive
+}
+
 int main(int /*argc*/, char** /*argv*/) {
     UNITY_BEGIN();
 
@@ -110,6 +200,12 @@ int main(int /*argc*/, char** /*argv*/) {
     RUN_TEST(test_above_threshold_at_high_level);
     RUN_TEST(test_not_valid_returns_false_for_both_thresholds);
     RUN_TEST(test_custom_calibration_remaps_range);
+    RUN_TEST(test_window_extremes_and_spread);
+    RUN_TEST(test_level_exact_after_long_run);
+    RUN_TEST(test_decimated_stream_rejects_adc_noise);
+    RUN_TEST(test_decimated_stream_nulls_output_rate_ripple);
+    RUN_TEST(test_pump_decision_follows_level_within_seconds);
+    RUN_TEST(test_ring_overflow_keeps_newest_samples);
 
     return UNITY_END();
 }
@@ -0,0 +1,145 @@
+/**
+ * test_ws_backpressure.cpp — Unit tests for the per-client WebSocket send
+ * budget (WsBackpressure), plus a simulation of shared frames fanned out to
+ * fast, slow and dead clients that checks the heap bound.
+ */
+
+#include <unity.h>
+#include "../../src/web/ws_backpressure.h"
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <set>
+#include <vector>
+
+using Action = WsBackpressure::Action;
+
+void setUp()    {}
+void tearDown() {}
+
+void test_sends_while_queue_below_limit() {
+    WsBackpressure bp;
+    for (size_t q = 0; q < WS_CLIENT_QUEUE_MAX; ++q) {
+        TEST_ASSERT_TRUE(bp.admit(0, 7, q, 1000) == Action::SEND);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, bp.skipped());
+}
+
+void test_full_queue_skips_frame_for_that_client_only() {
+    WsBackpressure bp;
+    TEST_ASSERT_TRUE(bp.admit(0, 7, WS_CLIENT_QUEUE_MAX, 1000) == Action::SKIP);
+    TEST_ASSERT_TRUE(bp.admit(1, 8, 0, 1000) == Action::SEND);
+    TEST_ASSERT_EQUAL_UINT32(1, bp.skipped(0));
+    TEST_ASSERT_EQUAL_UINT32(0, bp.skipped(1));
+    TEST_ASSERT_EQUAL(WS_CLIENT_QUEUE_MAX, bp.queued(0));
+}
+
+void test_recovered_client_resumes_and_restarts_stall_clock() {
+    WsBackpressure bp;
+    bp.admit(0, 7, WS_CLIENT_QUEUE_MAX, 0);
+    bp.admit(0, 7, WS_CLIENT_QUEUE_MAX, WS_CLIENT_STALL_MS - 1);
+    TEST_ASSERT_TRUE(bp.admit(0, 7, 0, WS_CLIENT_STALL_MS) == Action::SEND);
+    // Full again: a fresh stall period starts now
+    TEST_ASSERT_TRUE(bp.admit(0, 7, WS_CLIENT_QUEUE_MAX, WS_CLIENT_STALL_MS + 1) == Action::SKIP);
+    TEST_ASSERT_TRUE(bp.admit(0, 7, WS_CLIENT_QUEUE_MAX, 2 * WS_CLIENT_STALL_MS) == Action::SKIP);
+    TEST_ASSERT_EQUAL_UINT32(0, bp.disconnects());
+}
+
+void test_client_full_for_stall_period_is_disconnected() {
+    WsBackpressure bp;
+    uint32_t t0 = 0xFFFFF000u;  // Across the millis() wrap
+    TEST_ASSERT_TRUE(bp.admit(2, 9, 5, t0) == Action::SKIP);
+    TEST_ASSERT_TRUE(bp.admit(2, 9, 5, t0 + WS_CLIENT_STALL_MS - 1) == Action::SKIP);
+    TEST_ASSERT_TRUE(bp.admit(2, 9, 5, t0 + WS_CLIENT_STALL_MS) == Action::DISCONNECT);
+    TEST_ASSERT_EQUAL_UINT32(1, bp.disconnects());
+}
+
+void test_new_client_in_slot_starts_clean() {
+    WsBackpressure bp;
+    bp.admit(0, 7, WS_CLIENT_QUEUE_MAX, 0);
+    // Client 7 left; client 11 reuses the slot with a full queue much later
+    TEST_ASSERT_TRUE(bp.admit(0, 11, WS_CLIENT_QUEUE_MAX, WS_CLIENT_STALL_MS + 5) == Action::SKIP);
+    TEST_ASSERT_EQUAL_UINT32(0, bp.disconnects());
+}
+
+void test_out_of_range_slot_never_sends() {
+    WsBackpressure bp;
+    TEST_ASSERT_TRUE(bp.admit(WS_MAX_CLIENTS, 1, 0, 0) == Action::SKIP);
+    TEST_ASSERT_EQUAL(0u, bp.queued(WS_MAX_CLIENTS));
+}
+
+// ── Fan-out simulation ────────────────────────────────────────────────────────
+
+using Frame = std::shared_ptr<std::vector<uint8_t>>;
+
+struct SimClient {
+    uint32_t          id;
+    uint32_t          drain_every_ms;  // 0 = never drains (dead link)
+    std::deque<Frame> queue;
+    uint32_t          received = 0;
+    uint32_t          newest   = 0;    // Sequence number of the last frame received
+    bool              open     = true;
+};
+
+void test_heap_stays_bounded_with_slow_and_dead_clients() {
+    WsBackpressure bp;
+    SimClient clients[WS_MAX_CLIENTS] = {
+        {1, 10, {}},      // LAN laptop
+        {2, 2500, {}},    // Phone on weak Wi-Fi: slower than the 2 s cadence
+        {3, 0, {}},       // Walked out of range
+        {4, 1000, {}},
+    };
+
+    size_t   peak_bytes = 0;
+    uint32_t seq        = 0;
+    for (uint32_t t = 0; t <= 60000; t += 10) {
+        for (auto& c : clients) {
+            if (c.open && c.drain_every_ms && t % c.drain_every_ms == 0 && !c.queue.empty()) {
+                c.newest = (*c.queue.front())[0];
+                c.queue.pop_front();
+                c.received++;
+            }
+        }
+        if (t % WS_BROADCAST_PERIOD_MS == 0) {
+            // Serialised once, shared by every client's queue
+            Frame f = std::make_shared<std::vector<uint8_t>>(WS_FRAME_MAX_SIZE, static_cast<uint8_t>(++seq));
+            for (uint8_t i = 0; i < WS_MAX_CLIENTS; ++i) {
+                SimClient& c = clients[i];
+                if (!c.open) continue;
+                Action a = bp.admit(i, c.id, c.queue.size(), t);
+                if (a == Action::SEND) c.queue.push_back(f);
+                if (a == Action::DISCONNECT) {
+                    c.open = false;
+                    c.queue.clear();
+                }
+            }
+        }
+        // Live frames: each distinct buffer counted once, however many queues hold it
+        std::set<const std::vector<uint8_t>*> live;
+        for (auto& c : clients) {
+            for (auto& f : c.queue) live.insert(f.get());
+        }
+        peak_bytes = std::max(peak_bytes, live.size() * WS_FRAME_MAX_SIZE);
+    }
+
+    TEST_ASSERT_TRUE(peak_bytes <= WS_MAX_CLIENTS * WS_CLIENT_QUEUE_MAX * WS_FRAME_MAX_SIZE);
+    TEST_ASSERT_FALSE(clients[2].open);                   // Dead link dropped
+    TEST_ASSERT_EQUAL_UINT32(1, bp.disconnects());
+    TEST_ASSERT_TRUE(clients[0].open && clients[1].open && clients[3].open);
+    TEST_ASSERT_EQUAL_UINT32(seq, clients[0].received + clients[0].queue.size());  // Fast client misses nothing
+    TEST_ASSERT_TRUE(bp.skipped(1) > 0);                  // Slow client skips...
+    TEST_ASSERT_TRUE(clients[1].newest >= seq - WS_CLIENT_QUEUE_MAX);  // ...but stays current
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_sends_while_queue_below_limit);
+    RUN_TEST(test_full_queue_skips_frame_for_that_client_only);
+    RUN_TEST(test_recovered_client_resumes_and_restarts_stall_clock);
+    RUN_TEST(test_client_full_for_stall_period_is_disconnected);
+    RUN_TEST(test_new_client_in_slot_starts_clean);
+    RUN_TEST(test_out_of_range_slot_never_sends);
+    RUN_TEST(test_heap_stays_bounded_with_slow_and_dead_clients);
+    return UNITY_END();
+}